@@ -0,0 +1,54 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../poseidon/src/xprecompiled.hpp"
+#include "../poseidon/easy/easy_http2_server.hpp"
+#include "../poseidon/utils.hpp"
+using namespace ::poseidon;
+
+static constexpr char bind_addr[] = "[::]:3808";
+static Easy_HTTP2_Server my_server;
+
+static void
+my_server_callback(const shptr<HTTP2_Server_Session>& session,
+                   Abstract_Fiber& fiber, Easy_HTTP_Event event,
+                   uint32_t stream_id, HTTP_C_Headers&& req,
+                   linear_buffer&& data)
+  {
+    (void) fiber;
+
+    switch(event)
+      {
+      case easy_http_open:
+        POSEIDON_LOG_ERROR(("example HTTP/2 server accepted connection from `$1`: $2"),
+                           session->remote_address(), session->alpn_protocol());
+        break;
+
+      case easy_http_message:
+        {
+          POSEIDON_LOG_ERROR(("example HTTP/2 server received request on stream $1: $2 $3"),
+                             stream_id, req.method_str, req.raw_path);
+
+          HTTP_S_Headers resp;
+          resp.status = http_status_ok;
+          resp.headers.emplace_back(&"Content-Type", &"text/plain");
+          session->http2_response(stream_id, req.method == http_HEAD, move(resp),
+                                  "example HTTP/2 server\n");
+        }
+        break;
+
+      case easy_http_close:
+        POSEIDON_LOG_ERROR(("example HTTP/2 server closed connection: $1"), data);
+        break;
+
+      default:
+        ASTERIA_TERMINATE(("shouldn't happen: event = $1"), event);
+      }
+  }
+
+void
+poseidon_module_main()
+  {
+    my_server.start(&bind_addr, my_server_callback);
+    POSEIDON_LOG_ERROR(("example HTTP/2 server started: $1"), bind_addr);
+  }
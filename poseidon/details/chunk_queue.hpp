@@ -0,0 +1,204 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_DETAILS_CHUNK_QUEUE_
+#define POSEIDON_DETAILS_CHUNK_QUEUE_
+
+#include "../fwd.hpp"
+#include <deque>
+#include <sys/uio.h>
+namespace poseidon {
+
+// This is a byte queue made of a chain of chunks. Small writes are copied into
+// segments of a fixed size, which are never reallocated or compacted, so data
+// that have been partially sent don't have to be moved. Large strings are
+// referenced by their reference counts instead of being copied. Chunks can be
+// gathered into an array of `iovec`s for `writev()`. Released segments are
+// freed, except the last one which is kept for reuse.
+class chunk_queue
+  {
+  public:
+    static constexpr size_t segment_size = 16384;
+    static constexpr size_t min_shared_size = 1024;
+
+  private:
+    struct X_Chunk
+      {
+        uniptr<char[]> seg;  // owned segment, or null
+        cow_string str;  // shared immutable string
+        const char* bptr;
+        const char* eptr;
+      };
+
+    ::std::deque<X_Chunk> m_chunks;
+    uniptr<char[]> m_spare;
+    size_t m_size = 0;
+    size_t m_nsegs = 0;
+
+  private:
+    void
+    do_recycle(uniptr<char[]>&& seg)
+      noexcept
+      {
+        if(!seg)
+          return;
+
+        if(this->m_spare) {
+          this->m_nsegs --;
+          seg.reset();
+        }
+        else
+          this->m_spare = move(seg);
+      }
+
+    uniptr<char[]>
+    do_allocate()
+      {
+        if(this->m_spare)
+          return move(this->m_spare);
+
+        uniptr<char[]> seg(new char[segment_size]);
+        this->m_nsegs ++;
+        return seg;
+      }
+
+  public:
+    chunk_queue()
+      noexcept
+      { }
+
+  public:
+    chunk_queue(const chunk_queue&) = delete;
+    chunk_queue& operator=(const chunk_queue&) & = delete;
+
+    // Gets the number of bytes in this queue.
+    size_t
+    size()
+      const noexcept
+      { return this->m_size;  }
+
+    bool
+    empty()
+      const noexcept
+      { return this->m_size == 0;  }
+
+    // Gets the number of bytes that have been allocated for segments, which
+    // doesn't include shared strings.
+    size_t
+    memory_size()
+      const noexcept
+      { return this->m_nsegs * segment_size;  }
+
+    // Copies bytes into the end of this queue.
+    // If this function throws an exception, there is no effect.
+    void
+    append(const char* data, size_t size)
+      {
+        if(size == 0)
+          return;
+
+        size_t old_count = this->m_chunks.size();
+        const char* old_eptr = old_count ? this->m_chunks.back().eptr : nullptr;
+        const char* rptr = data;
+        const char* rend = data + size;
+
+        try {
+          // Fill the last segment, if it's not shared.
+          if(old_count && this->m_chunks.back().seg) {
+            auto& back = this->m_chunks.back();
+            size_t n = ::std::min(static_cast<size_t>(back.seg.get() + segment_size - back.eptr),
+                                  static_cast<size_t>(rend - rptr));
+            ::memcpy(const_cast<char*>(back.eptr), rptr, n);
+            back.eptr += n;
+            rptr += n;
+          }
+
+          // Put remaining data into new segments.
+          while(rptr != rend) {
+            auto& back = this->m_chunks.emplace_back();
+            back.seg = this->do_allocate();
+            size_t n = ::std::min(segment_size, static_cast<size_t>(rend - rptr));
+            ::memcpy(back.seg.get(), rptr, n);
+            back.bptr = back.seg.get();
+            back.eptr = back.seg.get() + n;
+            rptr += n;
+          }
+        }
+        catch(...) {
+          while(this->m_chunks.size() > old_count) {
+            this->do_recycle(move(this->m_chunks.back().seg));
+            this->m_chunks.pop_back();
+          }
+          if(old_count)
+            this->m_chunks.back().eptr = old_eptr;
+          throw;
+        }
+
+        this->m_size += size;
+      }
+
+    // Appends a string to the end of this queue, starting from `pos`. If the
+    // string is large, it is referenced instead of being copied, and it will
+    // not be modified.
+    // If this function throws an exception, there is no effect.
+    void
+    append(const cow_string& str, size_t pos = 0)
+      {
+        ASTERIA_ASSERT(pos <= str.size());
+        size_t size = str.size() - pos;
+        if(size < min_shared_size) {
+          this->append(str.data() + pos, size);
+          return;
+        }
+
+        auto& back = this->m_chunks.emplace_back();
+        back.str = str;
+        back.bptr = back.str.data() + pos;
+        back.eptr = back.str.data() + back.str.size();
+        this->m_size += size;
+      }
+
+    // Fills `iov` with chunks from the beginning of this queue, and returns the
+    // number of elements that have been filled.
+    size_t
+    gather(::iovec* iov, size_t count)
+      const noexcept
+      {
+        size_t k = 0;
+        auto it = this->m_chunks.begin();
+        while((k != count) && (it != this->m_chunks.end())) {
+          iov[k].iov_base = const_cast<char*>(it->bptr);
+          iov[k].iov_len = static_cast<size_t>(it->eptr - it->bptr);
+          ++ k;
+          ++ it;
+        }
+        return k;
+      }
+
+    // Removes bytes from the beginning of this queue. Segments which have been
+    // consumed are released.
+    void
+    discard(size_t size)
+      noexcept
+      {
+        ASTERIA_ASSERT(size <= this->m_size);
+        this->m_size -= size;
+
+        size_t rem = size;
+        while(rem != 0) {
+          auto& front = this->m_chunks.front();
+          size_t n = ::std::min(static_cast<size_t>(front.eptr - front.bptr), rem);
+          front.bptr += n;
+          rem -= n;
+
+          if(front.bptr != front.eptr)
+            break;
+
+          this->do_recycle(move(front.seg));
+          this->m_chunks.pop_front();
+        }
+      }
+  };
+
+}  // namespace poseidon
+#endif
@@ -0,0 +1,57 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_DETAILS_FUTURE_COMPLETION_
+#define POSEIDON_DETAILS_FUTURE_COMPLETION_
+
+#include "../fwd.hpp"
+namespace poseidon {
+
+// This links a future to a completion callback, which may be invoked by
+// another thread, possibly after the future has been destroyed. The callback
+// holds a shared pointer to this object, and shall call `lock()` to get the
+// future, which is a null pointer if the future has gone away. The destructor
+// of the future shall call `detach()`, which waits for a running callback.
+template<typename xFuture>
+class future_completion
+  {
+  public:
+    using future_type = xFuture;
+
+  private:
+    plain_mutex m_mutex;
+    future_type* m_futr;
+
+  public:
+    explicit
+    future_completion(future_type* futr)
+      noexcept
+      : m_futr(futr)
+      { }
+
+  public:
+    future_completion(const future_completion&) = delete;
+    future_completion& operator=(const future_completion&) & = delete;
+
+    // Locks this object and gets the future. The future must not be accessed
+    // after `lock` has been unlocked.
+    future_type*
+    lock(plain_mutex::unique_lock& lock)
+      noexcept
+      {
+        lock.lock(this->m_mutex);
+        return this->m_futr;
+      }
+
+    // Detaches the future from its callback.
+    void
+    detach()
+      noexcept
+      {
+        plain_mutex::unique_lock lock(this->m_mutex);
+        this->m_futr = nullptr;
+      }
+  };
+
+}  // namespace poseidon
+#endif
@@ -0,0 +1,127 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_DETAILS_MPSC_QUEUE_
+#define POSEIDON_DETAILS_MPSC_QUEUE_
+
+#include "../fwd.hpp"
+namespace poseidon {
+
+// This is a lock-free queue with multiple producers and a single consumer.
+// Producers push values onto a stack, which the consumer takes over as a
+// whole and reverses, so values are delivered in FIFO order. A counter of
+// pending values tells whether a consumer is active: `push()` returns `true`
+// if the queue was idle, in which case the caller shall start a consumer,
+// and `pop()` returns `false` only after the last value has been consumed,
+// in which case the consumer shall exit. Hence there is at most one consumer
+// at a time, without any mutex.
+template<typename xValue>
+class mpsc_queue
+  {
+  public:
+    using value_type = xValue;
+
+  private:
+    struct X_Node
+      {
+        X_Node* next;
+        value_type value;
+      };
+
+    // shared fields between threads
+    atomic_acq_rel<X_Node*> m_head;
+    atomic_acq_rel<size_t> m_count;
+    cacheline_barrier xcb_1;
+
+    // private fields of the consumer
+    X_Node* m_batch = nullptr;
+    size_t m_done = 0;
+
+  private:
+    static
+    void
+    do_free_nodes(X_Node* node)
+      noexcept
+      {
+        while(node) {
+          auto next = node->next;
+          delete node;
+          node = next;
+        }
+      }
+
+  public:
+    mpsc_queue()
+      noexcept
+      { }
+
+  public:
+    mpsc_queue(const mpsc_queue&) = delete;
+    mpsc_queue& operator=(const mpsc_queue&) & = delete;
+
+    ~mpsc_queue()
+      {
+        do_free_nodes(this->m_batch);
+        do_free_nodes(this->m_head.load());
+      }
+
+    // Pushes a value. If the queue was idle, `true` is returned, and the
+    // caller is responsible for starting a consumer.
+    // If this function throws an exception, there is no effect.
+    // This function is thread-safe.
+    bool
+    push(value_type&& value)
+      {
+        auto node = new X_Node{ nullptr, move(value) };
+        bool was_idle = this->m_count.xadd(1U) == 0U;
+
+        node->next = this->m_head.load();
+        while(!this->m_head.cmpxchg_weak(node->next, node));
+        return was_idle;
+      }
+
+    // Checks whether the queue is idle, i.e. all values that have been pushed
+    // have also been popped, and the next push will return `true`. This is
+    // only meaningful after `pop()` has returned `false`.
+    // This function may only be called by the consumer.
+    bool
+    idle()
+      const noexcept
+      { return this->m_count.load() == 0U;  }
+
+    // Pops a value. If all values have been consumed, `false` is returned,
+    // and the consumer shall exit; a value which is pushed later will start
+    // another consumer.
+    // This function may only be called by the consumer.
+    bool
+    pop(value_type& value)
+      {
+        while(!this->m_batch) {
+          // Retire values that have been consumed. If none is pending, the
+          // queue becomes idle.
+          size_t done = ::std::exchange(this->m_done, 0U);
+          if(this->m_count.xadd(-done) == done)
+            return false;
+
+          // Take all values away. A producer increments the counter before
+          // pushing its value, so the stack may be empty momentarily.
+          auto node = this->m_head.xchg(nullptr);
+          while(node) {
+            auto next = node->next;
+            node->next = this->m_batch;
+            this->m_batch = node;
+            node = next;
+          }
+        }
+
+        auto node = this->m_batch;
+        this->m_batch = node->next;
+        value = move(node->value);
+        delete node;
+        this->m_done ++;
+        return true;
+      }
+  };
+
+}  // namespace poseidon
+#endif
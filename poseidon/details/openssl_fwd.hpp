@@ -33,9 +33,18 @@ struct SSL_CTX_deleter
       { ::SSL_CTX_free(p);  }
   };
 
+struct SSL_SESSION_deleter
+  {
+    void
+    operator()(::SSL_SESSION* p)
+      const noexcept
+      { ::SSL_SESSION_free(p);  }
+  };
+
 using uniptr_BIO = ::asteria::unique_ptr<::BIO, BIO_deleter>;
 using uniptr_SSL = ::asteria::unique_ptr<::SSL, SSL_deleter>;
 using uniptr_SSL_CTX = ::asteria::unique_ptr<::SSL_CTX, SSL_CTX_deleter>;
+using uniptr_SSL_SESSION = ::asteria::unique_ptr<::SSL_SESSION, SSL_SESSION_deleter>;
 
 }  // namespace poseidon
 #endif
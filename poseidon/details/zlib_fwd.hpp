@@ -23,7 +23,9 @@ class scoped_deflate_stream
     mutable ::z_stream m_strm[1];
 
   public:
-    scoped_deflate_stream(zlib_Format fmt, uint8_t wbits, int level = Z_DEFAULT_COMPRESSION)
+    scoped_deflate_stream(zlib_Format fmt, uint8_t wbits, int level = Z_DEFAULT_COMPRESSION,
+                          uint8_t mem_level = 9, ::alloc_func zalloc = nullptr,
+                          ::free_func zfree = nullptr)
       {
         if((fmt != zlib_deflate) && (fmt != zlib_raw) && (fmt != zlib_gzip))
           ::asteria::sprintf_and_throw<::std::invalid_argument>(
@@ -37,8 +39,12 @@ class scoped_deflate_stream
           ::asteria::sprintf_and_throw<::std::invalid_argument>(
                 "scoped_deflate_stream: compression level `%d` not valid", level);
 
-        this->m_strm->zalloc = nullptr;
-        this->m_strm->zfree = nullptr;
+        if((mem_level < 1) || (mem_level > 9))
+          ::asteria::sprintf_and_throw<::std::invalid_argument>(
+                "scoped_deflate_stream: memory level `%d` not valid", mem_level);
+
+        this->m_strm->zalloc = zalloc;
+        this->m_strm->zfree = zfree;
         this->m_strm->opaque = nullptr;
         this->m_strm->next_in = nullptr;
         this->m_strm->avail_in = 0;
@@ -49,7 +55,7 @@ class scoped_deflate_stream
         else if(fmt == zlib_gzip)
           fmt_wbits += 16;
 
-        if(::deflateInit2(this->m_strm, level, Z_DEFLATED, fmt_wbits, 9,
+        if(::deflateInit2(this->m_strm, level, Z_DEFLATED, fmt_wbits, mem_level,
                           Z_DEFAULT_STRATEGY) != Z_OK)
           ::asteria::sprintf_and_throw<::std::runtime_error>(
                 "scoped_deflate_stream: insufficient memory");
@@ -97,7 +103,8 @@ class scoped_inflate_stream
     mutable ::z_stream m_strm[1];
 
   public:
-    scoped_inflate_stream(zlib_Format fmt, uint8_t wbits)
+    scoped_inflate_stream(zlib_Format fmt, uint8_t wbits, ::alloc_func zalloc = nullptr,
+                          ::free_func zfree = nullptr)
       {
         if((fmt != zlib_deflate) && (fmt != zlib_raw) && (fmt != zlib_gzip))
           ::asteria::sprintf_and_throw<::std::invalid_argument>(
@@ -107,8 +114,8 @@ class scoped_inflate_stream
           ::asteria::sprintf_and_throw<::std::invalid_argument>(
                 "scoped_inflate_stream: window bits `%d` not valid", wbits);
 
-        this->m_strm->zalloc = nullptr;
-        this->m_strm->zfree = nullptr;
+        this->m_strm->zalloc = zalloc;
+        this->m_strm->zfree = zfree;
         this->m_strm->opaque = nullptr;
         this->m_strm->next_in = nullptr;
         this->m_strm->avail_in = 0;
@@ -0,0 +1,77 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_EASY_EASY_HTTP2_SERVER_
+#define POSEIDON_EASY_EASY_HTTP2_SERVER_
+
+#include "../fwd.hpp"
+#include "enums.hpp"
+#include "../socket/http2_server_session.hpp"
+namespace poseidon {
+
+class Easy_HTTP2_Server
+  {
+  public:
+    // This is the user-defined callback, where `session` points to an internal
+    // client session object, and if `event` is
+    // 1) `easy_http_open`, then `stream_id` is zero, and `req` and `data` are
+    //    empty; or
+    // 2) `easy_http_message`, then `req` and `data` are the headers and body
+    //    of a request message, respectively, and `stream_id` identifies the
+    //    stream where the response shall be sent; or
+    // 3) `easy_http_close`, then `stream_id` is zero, `req` is empty and
+    //    `data` is the error description.
+    //
+    // Requests on the same connection are delivered in the order in which they
+    // complete. Responses may be sent in any order.
+    //
+    // The server object owns all client session objects. As a recommendation,
+    // applications should store only `weak`s to client sessions, and call
+    // `.lock()` as needed. This server object stores a copy of the callback
+    // object, which is invoked accordingly in the main thread. The callback
+    // object is never copied, and is allowed to modify itself.
+    using callback_type = shared_function<
+            void
+             (const shptr<HTTP2_Server_Session>& session,
+              Abstract_Fiber& fiber,
+              Easy_HTTP_Event event,
+              uint32_t stream_id,
+              HTTP_C_Headers&& req,
+              linear_buffer&& data)>;
+
+  private:
+    struct X_Session_Table;
+    shptr<X_Session_Table> m_sessions;
+    shptr<TCP_Acceptor> m_acceptor;
+
+  public:
+    Easy_HTTP2_Server() noexcept = default;
+    Easy_HTTP2_Server(const Easy_HTTP2_Server&) = delete;
+    Easy_HTTP2_Server& operator=(const Easy_HTTP2_Server&) & = delete;
+    ~Easy_HTTP2_Server();
+
+    // Gets the local address of the listening socket. If the server is not
+    // active, `ipv6_unspecified` is returned.
+    const IPv6_Address&
+    local_address()
+      const noexcept;
+
+    // Starts listening the given address and port for incoming connections.
+    shptr<TCP_Acceptor>
+    start(const IPv6_Address& addr, const callback_type& callback);
+
+    shptr<TCP_Acceptor>
+    start(const cow_string& addr, const callback_type& callback);
+
+    shptr<TCP_Acceptor>
+    start(uint16_t port, const callback_type& callback);
+
+    // Shuts down the listening socket, if any. All existent clients are also
+    // disconnected immediately.
+    void
+    stop()
+      noexcept;
+  };
+
+}  // namespace poseidon
+#endif
@@ -20,6 +20,20 @@ class Easy_HTTPS_Server
     // 3) `easy_http_close`, then `req` is empty and `data` is the error
     //    description.
     //
+    // If payload streaming is enabled, a request is delivered as multiple
+    // events instead of a single `easy_http_message`:
+    // 1) `easy_http_headers`, then `req` is the headers of the request, and
+    //    `data` is empty; followed by
+    // 2) zero or more `easy_http_payload`, then `req` is empty, and `data` is
+    //    a fragment of the request payload; followed by
+    // 3) `easy_http_message`, then `req` is the headers of the request, and
+    //    `data` is empty.
+    // The `network.http.max_request_content_length` limit doesn't apply to
+    // streamed payloads. Instead, if fragments are not consumed in time and
+    // the number of pending bytes exceeds `network.poll.throttle_size`, the
+    // server stops reading from the client, until half of them have been
+    // consumed.
+    //
     // The server object owns all client session objects. As a recommendation,
     // applications should store only `weak`s to client sessions, and call
     // `.lock()` as needed. This server object stores a copy of the callback
@@ -37,6 +51,7 @@ class Easy_HTTPS_Server
     struct X_Session_Table;
     shptr<X_Session_Table> m_sessions;
     shptr<TCP_Acceptor> m_acceptor;
+    bool m_payload_streaming = false;
 
   public:
     Easy_HTTPS_Server() noexcept = default;
@@ -50,6 +65,13 @@ class Easy_HTTPS_Server
     local_address()
       const noexcept;
 
+    // Enables or disables payload streaming. This takes effect when the server
+    // is started.
+    void
+    set_payload_streaming(bool enabled)
+      noexcept
+      { this->m_payload_streaming = enabled;  }
+
     // Starts listening the given address and port for incoming connections.
     shptr<TCP_Acceptor>
     start(const IPv6_Address& addr, const callback_type& callback);
@@ -63,6 +63,12 @@ class Easy_WSS_Server
     shptr<TCP_Acceptor>
     start(uint16_t port, const callback_type& callback);
 
+    // Sends a message to all connected clients. The message is encoded only once,
+    // and compressed at most once for each size of the sliding window. This
+    // function returns the number of clients that the message has been sent to.
+    size_t
+    broadcast(const WebSocket_Broadcast_Frame& frame);
+
     // Shuts down the listening socket, if any. All existent clients are also
     // disconnected immediately.
     void
@@ -19,6 +19,8 @@ enum Easy_HTTP_Event : uint8_t
     easy_http_open     = 21,  // connection established
     easy_http_message  = 22,  // message received
     easy_http_close    = 23,  // connection closed
+    easy_http_headers  = 24,  // request headers received (streaming only)
+    easy_http_payload  = 25,  // request payload fragment received (streaming only)
   };
 
 enum Easy_WS_Event : uint8_t
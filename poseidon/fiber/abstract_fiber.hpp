@@ -16,6 +16,11 @@ class Abstract_Fiber
     mutable recursive_mutex m_sched_mutex;
     Fiber_Scheduler* m_scheduler;
     vfn<const shptr<Abstract_Future>&>* m_sched_yield_fn;
+    vfn<milliseconds>* m_sched_park_fn;
+
+    mutable plain_mutex m_park_mutex;
+    mutable bool m_park_permit;
+    wkptr<atomic_relaxed<steady_time>> m_park_waker;
 
   protected:
     // Constructs an inactive fiber.
@@ -53,6 +58,23 @@ class Abstract_Fiber
     void
     yield(const shptr<Abstract_Future>& futr_opt)
       const;
+
+    // Suspends execution of the current fiber until `unpark()` is called, or
+    // `timeout` has elapsed. Unlike `yield()`, a parked fiber is not subject to
+    // `fiber.warn_timeout` or `fiber.fail_timeout`. If `unpark()` has been
+    // called since the last call to this function, it returns immediately.
+    // Returns `true` if this fiber has been unparked, and `false` if the
+    // operation has timed out.
+    bool
+    park(milliseconds timeout)
+      const;
+
+    // Resumes a parked fiber. If the fiber is not parked, the next call to
+    // `park()` will return immediately.
+    // This function is thread-safe.
+    void
+    unpark()
+      noexcept;
   };
 
 }  // namespace poseidon
@@ -7,6 +7,7 @@
 #include "../fwd.hpp"
 #include "abstract_future.hpp"
 #include "../base/abstract_task.hpp"
+#include "../details/future_completion.hpp"
 #include "../socket/ipv6_address.hpp"
 namespace poseidon {
 
@@ -19,11 +20,16 @@ class DNS_Query_Future
     cow_string m_host;
     uint16_t m_port;
     cow_vector<IPv6_Address> m_res;
+    const char* m_error = nullptr;
+
+    shptr<future_completion<DNS_Query_Future>> m_completion;
 
   public:
     // Constructs a DNS query future. This object also functions as an
-    // asynchronous task which can be enqueued into an `Task_Scheduler`. This
-    // future will become ready once the DNS query is complete.
+    // asynchronous task which can be enqueued into an `Task_Scheduler`. The
+    // task only starts a lookup with `dns_resolver`, so it doesn't block the
+    // worker thread. This future will become ready once the DNS query is
+    // complete.
     DNS_Query_Future(const cow_string& host, uint16_t port);
 
   private:
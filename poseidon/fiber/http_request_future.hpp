@@ -0,0 +1,91 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_FIBER_HTTP_REQUEST_FUTURE_
+#define POSEIDON_FIBER_HTTP_REQUEST_FUTURE_
+
+#include "../fwd.hpp"
+#include "abstract_future.hpp"
+#include "../base/abstract_task.hpp"
+#include "../details/future_completion.hpp"
+#include "../http/http_c_headers.hpp"
+#include "../http/http_s_headers.hpp"
+namespace poseidon {
+
+class HTTP_Request_Future
+  :
+    public Abstract_Future,
+    public Abstract_Task
+  {
+  private:
+    HTTP_Connector* m_ctr;
+    HTTP_C_Headers m_req;
+    cow_string m_payload;
+    HTTP_S_Headers m_resp;
+    linear_buffer m_resp_payload;
+    cow_string m_error;
+
+    shptr<future_completion<HTTP_Request_Future>> m_completion;
+
+  public:
+    // Constructs a future for a single HTTP request. This object also functions
+    // as an asynchronous task, which can be enqueued into an `Task_Scheduler`.
+    // The task only passes the request to `connector`, which reuses an idle
+    // connection to the same origin if possible, so it doesn't block the worker
+    // thread. This future will become ready once a response has been received.
+    // See `HTTP_Connector::request()` for the meanings of `req` and `payload`.
+    HTTP_Request_Future(HTTP_Connector& connector, const HTTP_C_Headers& req,
+                        const cow_string& payload);
+
+  private:
+    virtual
+    void
+    do_on_abstract_future_initialize()
+      override;
+
+    virtual
+    void
+    do_on_abstract_task_execute()
+      override;
+
+  public:
+    HTTP_Request_Future(const HTTP_Request_Future&) = delete;
+    HTTP_Request_Future& operator=(const HTTP_Request_Future&) & = delete;
+    virtual ~HTTP_Request_Future();
+
+    // Gets the request to send. This field is set by the constructor.
+    const HTTP_C_Headers&
+    request()
+      const noexcept
+      { return this->m_req;  }
+
+    const cow_string&
+    request_payload()
+      const noexcept
+      { return this->m_payload;  }
+
+    // Gets the response headers after the operation has completed successfully.
+    // If `successful()` yields `false`, an exception is thrown, and there is
+    // no effect.
+    const HTTP_S_Headers&
+    response()
+      const
+      {
+        this->check_success();
+        return this->m_resp;
+      }
+
+    // Gets the response payload after the operation has completed successfully.
+    // If `successful()` yields `false`, an exception is thrown, and there is
+    // no effect.
+    const linear_buffer&
+    response_payload()
+      const
+      {
+        this->check_success();
+        return this->m_resp_payload;
+      }
+  };
+
+}  // namespace poseidon
+#endif
@@ -0,0 +1,133 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_FIBER_MONGO_CURSOR_FUTURE_
+#define POSEIDON_FIBER_MONGO_CURSOR_FUTURE_
+
+#include "../fwd.hpp"
+#include "abstract_future.hpp"
+#include "../base/abstract_task.hpp"
+#include "../mongo/mongo_value.hpp"
+namespace poseidon {
+
+class Mongo_Cursor_Future
+  :
+    public Abstract_Future,
+    public Abstract_Task
+  {
+  private:
+    Mongo_Connector* m_ctr;
+    uniptr<Mongo_Connection> m_conn;
+    Mongo_Document m_cmd;
+    uint32_t m_batch_size;
+    bool m_continued;
+    bool m_kill_cursor;
+    uint32_t m_server_id;
+    cow_string m_coll;
+    int64_t m_cursor_id;
+    cow_vector<Mongo_Document> m_res;
+    bool m_eof;
+
+  public:
+    // Constructs a future for a single Mongo command which returns a cursor,
+    // such as `find` or `aggregate`, whose result is read in batches. This
+    // object also functions as an asynchronous task, which can be enqueued into
+    // an `Task_Scheduler`. `batch_size` is set as `batchSize` of the command,
+    // unless the command has specified one, and of each `getMore` command. This
+    // future will become ready once the first batch has been fetched.
+    Mongo_Cursor_Future(Mongo_Connector& connector, uniptr<Mongo_Connection>&& conn_opt,
+                        const Mongo_Document& cmd, uint32_t batch_size = 1000);
+
+    Mongo_Cursor_Future(Mongo_Connector& connector, const Mongo_Document& cmd,
+                        uint32_t batch_size = 1000);
+
+    // Constructs a future for the next batch of documents from `prev`, which
+    // must have completed successfully and must not have reached the end of its
+    // result. The connection and the cursor are taken from `prev`, but the
+    // result of `prev` is not affected, so the next batch can be fetched while
+    // the current one is being processed. Commands on the cursor are sent to
+    // the server where it was created. This future will become ready once
+    // the next batch has been fetched. If `kill_cursor` is `true`, the cursor
+    // is closed with `killCursors` instead, and no document is fetched. If a
+    // future is destroyed before the end of its result, the connection is
+    // closed.
+    explicit
+    Mongo_Cursor_Future(const shptr<Mongo_Cursor_Future>& prev, bool kill_cursor = false);
+
+    // Appends all fields of `cmd` to `builder`, and sets `batch_size` as its
+    // `batchSize`. Commands such as `aggregate` take it in `cursor`, and others
+    // such as `find` take it at the top level. A `batchSize` from `cmd` is
+    // always preserved.
+    static
+    void
+    compose_command(Mongo_Document_Builder& builder, const Mongo_Document& cmd,
+                    uint32_t batch_size);
+
+  private:
+    virtual
+    void
+    do_on_abstract_future_initialize()
+      override;
+
+    virtual
+    void
+    do_on_abstract_future_finalize()
+      override;
+
+    virtual
+    void
+    do_on_abstract_task_execute()
+      override;
+
+  public:
+    Mongo_Cursor_Future(const Mongo_Cursor_Future&) = delete;
+    Mongo_Cursor_Future& operator=(const Mongo_Cursor_Future&) & = delete;
+    virtual ~Mongo_Cursor_Future();
+
+    // Gets the command to execute. This field is set by the constructor.
+    const Mongo_Document&
+    cmd()
+      const noexcept
+      { return this->m_cmd;  }
+
+    // Gets the maximum number of documents in a batch. This field is set by the
+    // constructor.
+    uint32_t
+    batch_size()
+      const noexcept
+      { return this->m_batch_size;  }
+
+    // Checks whether this future closes the cursor. This field is set by the
+    // constructor.
+    bool
+    kill_cursor()
+      const noexcept
+      { return this->m_kill_cursor;  }
+
+    // Gets all documents of this batch after the operation has completed
+    // successfully. If `successful()` yields `false`, an exception is thrown,
+    // and there is no effect.
+    const cow_vector<Mongo_Document>&
+    result()
+      const
+      {
+        this->check_success();
+        return this->m_res;
+      }
+
+    // Checks whether all documents have been fetched after the operation has
+    // completed successfully. If this function returns `false`, the next batch
+    // can be fetched by another future which is constructed from this one. If
+    // `successful()` yields `false`, an exception is thrown, and there is no
+    // effect.
+    bool
+    eof()
+      const
+      {
+        this->check_success();
+        return this->m_eof;
+      }
+  };
+
+}  // namespace poseidon
+#endif
@@ -8,6 +8,8 @@
 #include "abstract_future.hpp"
 #include "../base/abstract_task.hpp"
 #include "../mongo/mongo_value.hpp"
+#include "../mongo/mongo_result_columns.hpp"
+#include "../mongo/mongo_document_view.hpp"
 namespace poseidon {
 
 class Mongo_Query_Future
@@ -19,16 +21,27 @@ class Mongo_Query_Future
     Mongo_Connector* m_ctr;
     uniptr<Mongo_Connection> m_conn;
     Mongo_Document m_cmd;
+    Mongo_Result_Format m_format;
     cow_vector<Mongo_Document> m_res;
+    Mongo_Result_Columns m_res_columns;
+    cow_bstring m_res_bson;
+    cow_vector<::std::pair<size_t, uint32_t>> m_res_bson_ranges;
 
   public:
     // Constructs a future for a single Mongo command. This object also functions
     // as an asynchronous task, which can be enqueued into an `Task_Scheduler`.
-    // This future will become ready once the command is complete.
+    // This future will become ready once the command is complete. `format`
+    // specifies how documents are stored: If it is `mongo_result_documents`,
+    // documents are stored into `result()`; if it is `mongo_result_columns`,
+    // documents are stored in columnar format into `result_columns()`; if it is
+    // `mongo_result_bson`, documents are stored in BSON format, which can be
+    // accessed with `result_bson()` without conversion.
     Mongo_Query_Future(Mongo_Connector& connector, uniptr<Mongo_Connection>&& conn_opt,
-                       const Mongo_Document& cmd);
+                       const Mongo_Document& cmd,
+                       Mongo_Result_Format format = mongo_result_documents);
 
-    Mongo_Query_Future(Mongo_Connector& connector, const Mongo_Document& cmd);
+    Mongo_Query_Future(Mongo_Connector& connector, const Mongo_Document& cmd,
+                       Mongo_Result_Format format = mongo_result_documents);
 
   private:
     virtual
@@ -57,6 +70,13 @@ class Mongo_Query_Future
       const noexcept
       { return this->m_cmd;  }
 
+    // Gets the format in which documents are stored. This field is set by the
+    // constructor.
+    Mongo_Result_Format
+    format()
+      const noexcept
+      { return this->m_format;  }
+
     // Gets the result after the operation has completed successfully. If
     // `successful()` yields `false`, an exception is thrown, and there is no
     // effect.
@@ -67,6 +87,38 @@ class Mongo_Query_Future
         this->check_success();
         return this->m_res;
       }
+
+    // Gets the result in columnar format after the operation has completed
+    // successfully. This is empty unless `format()` yields
+    // `mongo_result_columns`. If `successful()` yields `false`, an exception is
+    // thrown, and there is no effect.
+    const Mongo_Result_Columns&
+    result_columns()
+      const
+      {
+        this->check_success();
+        return this->m_res_columns;
+      }
+
+    // Gets the number of documents in BSON format after the operation has
+    // completed successfully. This is zero unless `format()` yields
+    // `mongo_result_bson`. If `successful()` yields `false`, an exception is
+    // thrown, and there is no effect.
+    size_t
+    result_bson_count()
+      const
+      {
+        this->check_success();
+        return this->m_res_bson_ranges.size();
+      }
+
+    // Gets a view of a document in BSON format after the operation has
+    // completed successfully. The view is valid as long as this future. If
+    // `successful()` yields `false`, an exception is thrown, and there is no
+    // effect.
+    Mongo_Document_View
+    result_bson(size_t index)
+      const;
   };
 
 }  // namespace poseidon
@@ -0,0 +1,165 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_FIBER_MYSQL_BATCH_INSERT_FUTURE_
+#define POSEIDON_FIBER_MYSQL_BATCH_INSERT_FUTURE_
+
+#include "../fwd.hpp"
+#include "abstract_future.hpp"
+#include "../base/abstract_task.hpp"
+#include "../mysql/mysql_value.hpp"
+namespace poseidon {
+
+class MySQL_Batch_Insert_Future
+  :
+    public Abstract_Future,
+    public Abstract_Task
+  {
+  private:
+    MySQL_Connector* m_ctr;
+    uniptr<MySQL_Connection> m_conn;
+    cow_string m_table;
+    cow_vector<cow_string> m_columns;
+    cow_vector<cow_vector<MySQL_Value>> m_rows;
+    cow_vector<cow_string> m_update_columns;
+    uint32_t m_statement_count;
+    uint32_t m_warning_count;
+    uint64_t m_match_count;
+    uint64_t m_insert_id;
+
+  public:
+    // Constructs a future for inserting rows into a table. This object also
+    // functions as an asynchronous task, which can be enqueued into an
+    // `Task_Scheduler`. Rows are inserted with multi-row `INSERT` statements,
+    // which are split so each of them fits into `max_allowed_packet` of the
+    // server, and all of them are executed in a single transaction. `table`
+    // may be qualified with a database name, as in `db.tbl`. If
+    // `update_columns` is not empty, an `ON DUPLICATE KEY UPDATE` clause is
+    // appended, which replaces these columns with new values when there is a
+    // key conflict. This requires MySQL 8.0.19 or later. This future will
+    // become ready once all rows have been committed, or the transaction has
+    // been rolled back.
+    MySQL_Batch_Insert_Future(MySQL_Connector& connector, uniptr<MySQL_Connection>&& conn_opt,
+                              const cow_string& table, const cow_vector<cow_string>& columns,
+                              const cow_vector<cow_vector<MySQL_Value>>& rows,
+                              const cow_vector<cow_string>& update_columns = {});
+
+    MySQL_Batch_Insert_Future(MySQL_Connector& connector, const cow_string& table,
+                              const cow_vector<cow_string>& columns,
+                              const cow_vector<cow_vector<MySQL_Value>>& rows,
+                              const cow_vector<cow_string>& update_columns = {});
+
+    // Composes an `INSERT` statement for `nrows` rows, with a placeholder for
+    // each value. All names are quoted as identifiers. If a name is empty or
+    // contains a null character, or if `table` has more than one dot, an
+    // exception is thrown.
+    static
+    cow_string
+    compose_statement(const cow_string& table, const cow_vector<cow_string>& columns,
+                      const cow_vector<cow_string>& update_columns, size_t nrows);
+
+    // Counts rows from `rows[start]` for the next statement, which has no more
+    // than `max_rows` rows, and whose arguments have an estimated size of no
+    // more than `max_packet_size` bytes. A row that doesn't fit alone is sent
+    // in its own statement, which the server may reject. If `start` is not
+    // less than `rows.size()`, zero is returned.
+    static
+    size_t
+    count_statement_rows(const cow_vector<cow_vector<MySQL_Value>>& rows, size_t start,
+                         size_t max_rows, size_t max_packet_size)
+      noexcept;
+
+  private:
+    virtual
+    void
+    do_on_abstract_future_initialize()
+      override;
+
+    virtual
+    void
+    do_on_abstract_future_finalize()
+      override;
+
+    virtual
+    void
+    do_on_abstract_task_execute()
+      override;
+
+  public:
+    MySQL_Batch_Insert_Future(const MySQL_Batch_Insert_Future&) = delete;
+    MySQL_Batch_Insert_Future& operator=(const MySQL_Batch_Insert_Future&) & = delete;
+    virtual ~MySQL_Batch_Insert_Future();
+
+    // Gets the name of the table. This field is set by the constructor.
+    const cow_string&
+    table()
+      const noexcept
+      { return this->m_table;  }
+
+    // Gets the names of columns to insert. This field is set by the constructor.
+    const cow_vector<cow_string>&
+    columns()
+      const noexcept
+      { return this->m_columns;  }
+
+    // Gets the rows to insert. This field is set by the constructor.
+    const cow_vector<cow_vector<MySQL_Value>>&
+    rows()
+      const noexcept
+      { return this->m_rows;  }
+
+    // Gets the names of columns to update on key conflicts. This field is set
+    // by the constructor.
+    const cow_vector<cow_string>&
+    update_columns()
+      const noexcept
+      { return this->m_update_columns;  }
+
+    // Gets the number of `INSERT` statements that have been executed. If
+    // `successful()` yields `false`, an exception is thrown, and there is no
+    // effect.
+    uint32_t
+    statement_count()
+      const
+      {
+        this->check_success();
+        return this->m_statement_count;
+      }
+
+    // Gets the total number of warnings of all statements. This can indicate
+    // whether rows have been truncated. If `successful()` yields `false`, an
+    // exception is thrown, and there is no effect.
+    uint32_t
+    warning_count()
+      const
+      {
+        this->check_success();
+        return this->m_warning_count;
+      }
+
+    // Gets the total number of rows that have been matched by all statements.
+    // If a row is updated due to a key conflict, it's counted twice, as with
+    // `INSERT ... ON DUPLICATE KEY UPDATE`. If `successful()` yields `false`,
+    // an exception is thrown, and there is no effect.
+    uint64_t
+    match_count()
+      const
+      {
+        this->check_success();
+        return this->m_match_count;
+      }
+
+    // Gets the auto-increment ID of the first row that has been inserted by
+    // the first statement. If `successful()` yields `false`, an exception is
+    // thrown, and there is no effect.
+    uint64_t
+    insert_id()
+      const
+      {
+        this->check_success();
+        return this->m_insert_id;
+      }
+  };
+
+}  // namespace poseidon
+#endif
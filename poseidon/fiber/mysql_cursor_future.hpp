@@ -0,0 +1,151 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_FIBER_MYSQL_CURSOR_FUTURE_
+#define POSEIDON_FIBER_MYSQL_CURSOR_FUTURE_
+
+#include "../fwd.hpp"
+#include "abstract_future.hpp"
+#include "../base/abstract_task.hpp"
+#include "../mysql/mysql_value.hpp"
+namespace poseidon {
+
+class MySQL_Cursor_Future
+  :
+    public Abstract_Future,
+    public Abstract_Task
+  {
+  private:
+    MySQL_Connector* m_ctr;
+    uniptr<MySQL_Connection> m_conn;
+    cow_string m_stmt;
+    cow_vector<MySQL_Value> m_stmt_args;
+    uint32_t m_batch_size;
+    bool m_continued;
+    cow_vector<cow_string> m_result_fields;
+    cow_vector<cow_vector<MySQL_Value>> m_result_rows;
+    bool m_eof;
+
+  public:
+    // Constructs a future for a single MySQL statement, whose result is read
+    // in batches. This object also functions as an asynchronous task, which
+    // can be enqueued into an `Task_Scheduler`. The statement is executed with
+    // a read-only cursor on the server, which sends `batch_size` rows for each
+    // round trip. This future will become ready once the first batch has been
+    // fetched. If `conn_opt` is not null, it shall not be asynchronous.
+    MySQL_Cursor_Future(MySQL_Connector& connector, uniptr<MySQL_Connection>&& conn_opt,
+                        const cow_string& stmt, const cow_vector<MySQL_Value>& stmt_args,
+                        uint32_t batch_size = 1000);
+
+    MySQL_Cursor_Future(MySQL_Connector& connector, const cow_string& stmt,
+                        const cow_vector<MySQL_Value>& stmt_args, uint32_t batch_size = 1000);
+
+    // Constructs a future for the next batch of rows from `prev`, which must
+    // have completed successfully and must not have reached the end of its
+    // result. The connection is taken from `prev`. This future will become
+    // ready once the next batch has been fetched. If a future is destroyed
+    // before the end of its result, the connection is closed.
+    explicit
+    MySQL_Cursor_Future(const shptr<MySQL_Cursor_Future>& prev);
+
+  private:
+    virtual
+    void
+    do_on_abstract_future_initialize()
+      override;
+
+    virtual
+    void
+    do_on_abstract_future_finalize()
+      override;
+
+    virtual
+    void
+    do_on_abstract_task_execute()
+      override;
+
+  public:
+    MySQL_Cursor_Future(const MySQL_Cursor_Future&) = delete;
+    MySQL_Cursor_Future& operator=(const MySQL_Cursor_Future&) & = delete;
+    virtual ~MySQL_Cursor_Future();
+
+    // Gets the statement to execute. This field is set by the constructor.
+    const cow_string&
+    stmt()
+      const noexcept
+      { return this->m_stmt;  }
+
+    // Gets the arguments for the statement to execute. This field is set by
+    // the constructor.
+    const cow_vector<MySQL_Value>&
+    stmt_args()
+      const noexcept
+      { return this->m_stmt_args;  }
+
+    // Gets the maximum number of rows in a batch. This field is set by the
+    // constructor.
+    uint32_t
+    batch_size()
+      const noexcept
+      { return this->m_batch_size;  }
+
+    // Gets all result fields after the operation has completed successfully. If
+    // `successful()` yields `false`, an exception is thrown, and there is no
+    // effect.
+    const cow_vector<cow_string>&
+    result_fields()
+      const
+      {
+        this->check_success();
+        return this->m_result_fields;
+      }
+
+    // Gets all rows of this batch after the operation has completed
+    // successfully. If `successful()` yields `false`, an exception is thrown,
+    // and there is no effect.
+    const cow_vector<cow_vector<MySQL_Value>>&
+    result_rows()
+      const
+      {
+        this->check_success();
+        return this->m_result_rows;
+      }
+
+    // Gets the number of rows of this batch after the operation has completed
+    // successfully. If `successful()` yields `false`, an exception is thrown,
+    // and there is no effect.
+    size_t
+    result_row_count()
+      const
+      {
+        this->check_success();
+        return this->m_result_rows.size();
+      }
+
+    // Gets a single row of this batch after the operation has completed
+    // successfully. If `successful()` yields `false`, an exception is thrown,
+    // and there is no effect.
+    const cow_vector<MySQL_Value>&
+    result_row(size_t row_index)
+      const
+      {
+        this->check_success();
+        return this->m_result_rows.at(row_index);
+      }
+
+    // Checks whether all rows have been fetched after the operation has
+    // completed successfully. If this function returns `false`, the next batch
+    // can be fetched by another future which is constructed from this one. If
+    // `successful()` yields `false`, an exception is thrown, and there is no
+    // effect.
+    bool
+    eof()
+      const
+      {
+        this->check_success();
+        return this->m_eof;
+      }
+  };
+
+}  // namespace poseidon
+#endif
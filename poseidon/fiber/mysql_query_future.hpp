@@ -7,7 +7,9 @@
 #include "../fwd.hpp"
 #include "abstract_future.hpp"
 #include "../base/abstract_task.hpp"
+#include "../details/future_completion.hpp"
 #include "../mysql/mysql_value.hpp"
+#include "../mysql/mysql_result_columns.hpp"
 namespace poseidon {
 
 class MySQL_Query_Future
@@ -20,21 +22,33 @@ class MySQL_Query_Future
     uniptr<MySQL_Connection> m_conn;
     cow_string m_stmt;
     cow_vector<MySQL_Value> m_stmt_args;
+    bool m_columnar;
     uint32_t m_warning_count;
     uint64_t m_match_count;
     uint64_t m_insert_id;
     cow_vector<cow_string> m_result_fields;
     cow_vector<cow_vector<MySQL_Value>> m_result_rows;
+    MySQL_Result_Columns m_result_columns;
+    cow_string m_error;
+
+    shptr<future_completion<MySQL_Query_Future>> m_completion;
 
   public:
     // Constructs a future for a single MySQL statement. This object also functions
     // as an asynchronous task, which can be enqueued into an `Task_Scheduler`.
-    // This future will become ready once the query is complete.
+    // By default, the statement is prepared and executed by the task, which
+    // blocks its worker thread. If `asynchronous_queries` is enabled in
+    // 'main.conf', the task only passes the statement to `connector`, which
+    // executes it on an asynchronous connection with the text protocol instead.
+    // A connection from `conn_opt` that has already been connected is used in
+    // its own mode. This future will become ready once the query is complete. If `columnar` is `true`, rows are stored in columnar format
+    // into `result_columns()` instead of `result_rows()`.
     MySQL_Query_Future(MySQL_Connector& connector, uniptr<MySQL_Connection>&& conn_opt,
-                       const cow_string& stmt, const cow_vector<MySQL_Value>& stmt_args);
+                       const cow_string& stmt, const cow_vector<MySQL_Value>& stmt_args,
+                       bool columnar = false);
 
     MySQL_Query_Future(MySQL_Connector& connector, const cow_string& stmt,
-                       const cow_vector<MySQL_Value>& stmt_args);
+                       const cow_vector<MySQL_Value>& stmt_args, bool columnar = false);
 
   private:
     virtual
@@ -70,6 +84,13 @@ class MySQL_Query_Future
       const noexcept
       { return this->m_stmt_args;  }
 
+    // Checks whether rows are stored in columnar format. This field is set by
+    // the constructor.
+    bool
+    columnar()
+      const noexcept
+      { return this->m_columnar;  }
+
     // Gets the number of warnings of the last operation. This can indicate
     // whether an INSERT IGNORE operation fails due to a key conflict. If
     // `successful()` yields `false`, an exception is thrown, and there is no
@@ -181,6 +202,18 @@ class MySQL_Query_Future
         this->check_success();
         return this->m_result_rows.at(row_index).at(field_index);
       }
+
+    // Gets all rows in columnar format after the operation has completed
+    // successfully. This is empty unless `columnar()` yields `true`. If
+    // `successful()` yields `false`, an exception is thrown, and there is no
+    // effect.
+    const MySQL_Result_Columns&
+    result_columns()
+      const
+      {
+        this->check_success();
+        return this->m_result_columns;
+      }
   };
 
 }  // namespace poseidon
@@ -0,0 +1,83 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_FIBER_REDIS_COMMAND_FUTURE_
+#define POSEIDON_FIBER_REDIS_COMMAND_FUTURE_
+
+#include "../fwd.hpp"
+#include "abstract_future.hpp"
+#include "../base/abstract_task.hpp"
+#include "../details/future_completion.hpp"
+#include "../redis/redis_value.hpp"
+namespace poseidon {
+
+class Redis_Command_Future
+  :
+    public Abstract_Future,
+    public Abstract_Task
+  {
+  private:
+    shptr<Redis_Client_Session> m_session;
+    cow_vector<cow_string> m_cmd;
+    cow_string m_status;
+    Redis_Value m_res;
+    cow_string m_error;
+
+    shptr<future_completion<Redis_Command_Future>> m_completion;
+
+  public:
+    // Constructs a future for a single Redis command on an asynchronous client
+    // session. This object also functions as an asynchronous task, which can be
+    // enqueued into an `Task_Scheduler`. The task only sends the command, which
+    // may share the connection with other commands that are in flight. This
+    // future will become ready once the reply has been received.
+    Redis_Command_Future(const shptr<Redis_Client_Session>& session,
+                         const cow_vector<cow_string>& cmd);
+
+  private:
+    virtual
+    void
+    do_on_abstract_future_initialize()
+      override;
+
+    virtual
+    void
+    do_on_abstract_task_execute()
+      override;
+
+  public:
+    Redis_Command_Future(const Redis_Command_Future&) = delete;
+    Redis_Command_Future& operator=(const Redis_Command_Future&) & = delete;
+    virtual ~Redis_Command_Future();
+
+    // Gets the command to execute. This field is set by the constructor.
+    const cow_vector<cow_string>&
+    cmd()
+      const noexcept
+      { return this->m_cmd;  }
+
+    // Gets the result status after the operation has completed successfully.
+    // If `successful()` yields `false`, an exception is thrown, and there is
+    // no effect.
+    const cow_string&
+    status()
+      const
+      {
+        this->check_success();
+        return this->m_status;
+      }
+
+    // Gets the result value after the operation has completed successfully.
+    // If `successful()` yields `false`, an exception is thrown, and there is
+    // no effect.
+    const Redis_Value&
+    result()
+      const
+      {
+        this->check_success();
+        return this->m_res;
+      }
+  };
+
+}  // namespace poseidon
+#endif
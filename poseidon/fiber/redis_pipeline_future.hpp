@@ -0,0 +1,112 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_FIBER_REDIS_PIPELINE_FUTURE_
+#define POSEIDON_FIBER_REDIS_PIPELINE_FUTURE_
+
+#include "../fwd.hpp"
+#include "abstract_future.hpp"
+#include "../base/abstract_task.hpp"
+#include "../redis/redis_value.hpp"
+namespace poseidon {
+
+class Redis_Pipeline_Future
+  :
+    public Abstract_Future,
+    public Abstract_Task
+  {
+  private:
+    Redis_Connector* m_ctr;
+    uniptr<Redis_Connection> m_conn;
+    cow_vector<cow_vector<cow_string>> m_cmds;
+    cow_vector<cow_string> m_statuses;
+    cow_vector<Redis_Value> m_results;
+    cow_vector<cow_string> m_errors;
+
+  public:
+    // Constructs a future for a series of Redis commands. This object also
+    // functions as an asynchronous task, which can be enqueued into an
+    // `Task_Scheduler`. All commands are sent to the server in a batch, and
+    // all replies are received in one round trip. An error reply only fails
+    // its own command. This future will become ready once all replies have
+    // been received.
+    Redis_Pipeline_Future(Redis_Connector& connector, uniptr<Redis_Connection>&& conn_opt,
+                          const cow_vector<cow_vector<cow_string>>& cmds);
+
+    Redis_Pipeline_Future(Redis_Connector& connector, const cow_vector<cow_vector<cow_string>>& cmds);
+
+  private:
+    virtual
+    void
+    do_on_abstract_future_initialize()
+      override;
+
+    virtual
+    void
+    do_on_abstract_future_finalize()
+      override;
+
+    virtual
+    void
+    do_on_abstract_task_execute()
+      override;
+
+  public:
+    Redis_Pipeline_Future(const Redis_Pipeline_Future&) = delete;
+    Redis_Pipeline_Future& operator=(const Redis_Pipeline_Future&) & = delete;
+    virtual ~Redis_Pipeline_Future();
+
+    // Gets the commands to execute. This field is set by the constructor.
+    const cow_vector<cow_vector<cow_string>>&
+    cmds()
+      const noexcept
+      { return this->m_cmds;  }
+
+    // Gets the number of replies after the operation has completed successfully,
+    // which equals the number of commands. If `successful()` yields `false`, an
+    // exception is thrown, and there is no effect.
+    size_t
+    result_count()
+      const
+      {
+        this->check_success();
+        return this->m_results.size();
+      }
+
+    // Gets the result status of a single command after the operation has
+    // completed successfully. If `successful()` yields `false`, an exception is
+    // thrown, and there is no effect.
+    const cow_string&
+    status(size_t index)
+      const
+      {
+        this->check_success();
+        return this->m_statuses.at(index);
+      }
+
+    // Gets the result value of a single command after the operation has
+    // completed successfully. If `successful()` yields `false`, an exception is
+    // thrown, and there is no effect.
+    const Redis_Value&
+    result(size_t index)
+      const
+      {
+        this->check_success();
+        return this->m_results.at(index);
+      }
+
+    // Gets the error message of a single command after the operation has
+    // completed successfully. If the command has succeeded, an empty string is
+    // returned. If `successful()` yields `false`, an exception is thrown, and
+    // there is no effect.
+    const cow_string&
+    error(size_t index)
+      const
+      {
+        this->check_success();
+        return this->m_errors.at(index);
+      }
+  };
+
+}  // namespace poseidon
+#endif
@@ -0,0 +1,67 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_FIBER_REDIS_PUSH_FUTURE_
+#define POSEIDON_FIBER_REDIS_PUSH_FUTURE_
+
+#include "../fwd.hpp"
+#include "abstract_future.hpp"
+#include "../base/abstract_task.hpp"
+#include "../details/future_completion.hpp"
+#include "../redis/redis_value.hpp"
+namespace poseidon {
+
+class Redis_Push_Future
+  :
+    public Abstract_Future,
+    public Abstract_Task
+  {
+  private:
+    shptr<Redis_Client_Session> m_session;
+    Redis_Value m_message;
+    cow_string m_error;
+
+    shptr<future_completion<Redis_Push_Future>> m_completion;
+
+  public:
+    // Constructs a future for the next push message on an asynchronous client
+    // session, such as a message from a subscribed channel, or an invalidation
+    // from CLIENT TRACKING. This object also functions as an asynchronous task,
+    // which can be enqueued into an `Task_Scheduler`. This future will become
+    // ready once a message has been received, or the connection has been
+    // closed. Each future receives one message; a fiber that keeps listening
+    // shall create a new future for each message.
+    explicit
+    Redis_Push_Future(const shptr<Redis_Client_Session>& session);
+
+  private:
+    virtual
+    void
+    do_on_abstract_future_initialize()
+      override;
+
+    virtual
+    void
+    do_on_abstract_task_execute()
+      override;
+
+  public:
+    Redis_Push_Future(const Redis_Push_Future&) = delete;
+    Redis_Push_Future& operator=(const Redis_Push_Future&) & = delete;
+    virtual ~Redis_Push_Future();
+
+    // Gets the message after the operation has completed successfully, which
+    // is usually an array whose first element is the kind of the message. If
+    // `successful()` yields `false`, an exception is thrown, and there is no
+    // effect.
+    const Redis_Value&
+    message()
+      const
+      {
+        this->check_success();
+        return this->m_message;
+      }
+  };
+
+}  // namespace poseidon
+#endif
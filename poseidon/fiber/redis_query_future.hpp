@@ -7,6 +7,7 @@
 #include "../fwd.hpp"
 #include "abstract_future.hpp"
 #include "../base/abstract_task.hpp"
+#include "../details/future_completion.hpp"
 #include "../redis/redis_value.hpp"
 namespace poseidon {
 
@@ -21,11 +22,17 @@ class Redis_Query_Future
     cow_vector<cow_string> m_cmd;
     cow_string m_status;
     Redis_Value m_res;
+    cow_string m_error;
+
+    shptr<future_completion<Redis_Query_Future>> m_completion;
 
   public:
     // Constructs a future for a single Redis command. This object also functions
     // as an asynchronous task, which can be enqueued into an `Task_Scheduler`.
-    // This future will become ready once the query is complete.
+    // If `conn_opt` is null, the command is passed to `connector`, where it may
+    // be sent in a pipeline together with commands from other futures, and a
+    // `GET` command may be served by the near cache of `connector`. This
+    // future will become ready once the query is complete.
     Redis_Query_Future(Redis_Connector& connector, uniptr<Redis_Connection>&& conn_opt,
                        const cow_vector<cow_string>& cmd);
 
@@ -439,12 +439,19 @@ class Abstract_Inflator;
 class Abstract_Fiber;
 class Abstract_Future;
 class DNS_Query_Future;
+class HTTP_Request_Future;
 class Read_File_Future;
 class MySQL_Query_Future;
 class MySQL_Check_Table_Future;
+class MySQL_Batch_Insert_Future;
+class MySQL_Cursor_Future;
 class Mongo_Query_Future;
+class Mongo_Cursor_Future;
 class Redis_Query_Future;
 class Redis_Scan_and_Get_Future;
+class Redis_Pipeline_Future;
+class Redis_Command_Future;
+class Redis_Push_Future;
 
 // Socket types
 enum IP_Address_Class : uint8_t;
@@ -464,6 +471,7 @@ class WS_Server_Session;
 class WS_Client_Session;
 class WSS_Server_Session;
 class WSS_Client_Session;
+class HTTP2_Server_Session;
 class DNS_Connect_Task;
 
 // HTTP and WebSocket types
@@ -471,6 +479,8 @@ enum HTTP_Method : uint64_t;
 enum HTTP_Status : uint16_t;
 enum WS_Opcode : uint8_t;
 enum WS_Status : uint16_t;
+enum HTTP2_Error : uint32_t;
+enum HTTP_Content_Coding : uint8_t;
 class HTTP_Value;
 class HTTP_Field_Name;
 class HTTP_Header_Parser;
@@ -482,6 +492,10 @@ class HTTP_Response_Parser;
 struct WebSocket_Frame_Header;
 class WebSocket_Frame_Parser;
 class WebSocket_Deflator;
+class WebSocket_Broadcast_Frame;
+class HPACK_Decoder;
+class HPACK_Encoder;
+class HTTP_Compressor;
 
 // MySQL types
 enum MySQL_Column_Type : uint8_t;
@@ -490,22 +504,32 @@ enum MySQL_Engine_Type : uint8_t;
 enum MySQL_Value_Type : uint8_t;
 class MySQL_Value;
 class MySQL_Connection;
+class MySQL_Result_Columns;
 struct MySQL_Table_Column;
 struct MySQL_Table_Index;
 struct MySQL_Table_Structure;
 
 // MongoDB types
 enum Mongo_Value_Type : uint8_t;
+enum Mongo_Result_Format : uint8_t;
 class Mongo_Value;
 using Mongo_Array = cow_vector<Mongo_Value>;
 using Mongo_Document = cow_bivector<cow_string, Mongo_Value>;
 class Mongo_Connection;
+class Mongo_Result_Columns;
+class Mongo_Document_View;
+class Mongo_Document_Builder;
 
 // Redis types
 enum Redis_Value_Type : uint8_t;
+enum Redis_Reply_Type : uint8_t;
 class Redis_Value;
 using Redis_Array = cow_vector<Redis_Value>;
 class Redis_Connection;
+class Redis_Reply_Parser;
+class Redis_Client_Session;
+class Redis_TCP_Client_Session;
+class Redis_SSL_Client_Session;
 
 // Easy types
 // Being 'easy' means all callbacks are invoked in fibers and can perform
@@ -525,6 +549,7 @@ class Easy_SSL_Server;
 class Easy_HTTPS_Server;
 class Easy_HWSS_Server;
 class Easy_WSS_Server;
+class Easy_HTTP2_Server;
 class Easy_TCP_Client;
 class Easy_HTTP_Client;
 class Easy_WS_Client;
@@ -543,6 +568,8 @@ extern class Logger logger;
 extern class Timer_Scheduler timer_scheduler;
 extern class Task_Scheduler task_scheduler;
 extern class Network_Scheduler network_scheduler;
+extern class DNS_Resolver dns_resolver;
+extern class HTTP_Connector http_connector;
 extern class Fiber_Scheduler fiber_scheduler;
 extern class MySQL_Connector mysql_connector;
 extern class Mongo_Connector mongo_connector;
@@ -101,5 +101,30 @@ enum WS_Status : uint16_t
     ws_status_timeout               = 3008,
   };
 
+enum HTTP2_Error : uint32_t
+  {
+    http2_no_error              =  0,
+    http2_protocol_error        =  1,
+    http2_internal_error        =  2,
+    http2_flow_control_error    =  3,
+    http2_settings_timeout      =  4,
+    http2_stream_closed         =  5,
+    http2_frame_size_error      =  6,
+    http2_refused_stream        =  7,
+    http2_cancel                =  8,
+    http2_compression_error     =  9,
+    http2_connect_error         = 10,
+    http2_enhance_your_calm     = 11,
+    http2_inadequate_security   = 12,
+    http2_http_1_1_required     = 13,
+  };
+
+enum HTTP_Content_Coding : uint8_t
+  {
+    http_coding_identity  = 0,
+    http_coding_deflate   = 1,
+    http_coding_gzip      = 2,
+  };
+
 }  // namespace poseidon
 #endif
@@ -0,0 +1,71 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_HTTP_HPACK_DECODER_
+#define POSEIDON_HTTP_HPACK_DECODER_
+
+#include "../fwd.hpp"
+#include <deque>
+namespace poseidon {
+
+class HPACK_Decoder
+  {
+  private:
+    uint32_t m_max_table_size;
+    uint32_t m_table_size_limit;
+    uint32_t m_table_size = 0;
+    ::std::deque<pair<cow_string, cow_string>> m_table;
+
+  public:
+    // Constructs a decoder whose dynamic table is allowed to contain at most
+    // `max_table_size` bytes. This shall match `SETTINGS_HEADER_TABLE_SIZE` that
+    // has been sent to the peer, whose default value is 4096.
+    explicit
+    HPACK_Decoder(uint32_t max_table_size = 4096);
+
+  private:
+    void
+    do_evict_entries(uint32_t limit)
+      noexcept;
+
+    void
+    do_insert_entry(const cow_string& name, const cow_string& value);
+
+    void
+    do_get_entry(cow_string& name, cow_string* value_opt, uint64_t index)
+      const;
+
+  public:
+    HPACK_Decoder(const HPACK_Decoder&) = delete;
+    HPACK_Decoder& operator=(const HPACK_Decoder&) & = delete;
+    ~HPACK_Decoder();
+
+    // Gets the number of bytes in the dynamic table, as defined by RFC 7541.
+    uint32_t
+    table_size()
+      const noexcept
+      { return this->m_table_size;  }
+
+    // Gets the number of entries in the dynamic table.
+    size_t
+    table_entry_count()
+      const noexcept
+      { return this->m_table.size();  }
+
+    // Clears the dynamic table.
+    void
+    clear()
+      noexcept;
+
+    // Decodes a complete header block, and appends all decoded fields to
+    // `output`, in the order they appear in the block. Names are in lowercase,
+    // as required by HTTP/2. Header blocks must be decoded in the order they
+    // were sent, as they may update the dynamic table. If an error occurs, an
+    // exception is thrown, and the decoder is left in an unspecified state; the
+    // connection must be closed with `COMPRESSION_ERROR`.
+    void
+    decode(cow_bivector<cow_string, cow_string>& output, chars_view block);
+  };
+
+}  // namespace poseidon
+#endif
@@ -0,0 +1,43 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_HTTP_HPACK_ENCODER_
+#define POSEIDON_HTTP_HPACK_ENCODER_
+
+#include "../fwd.hpp"
+namespace poseidon {
+
+class HPACK_Encoder
+  {
+  public:
+    // Constructs an encoder. This encoder never inserts entries into the
+    // dynamic table of its peer, so it has no state, and is able to encode
+    // header blocks of multiple streams in any order. Fields that match
+    // entries in the static table are encoded as indices; all other fields are
+    // encoded as literals without indexing.
+    HPACK_Encoder()
+      noexcept = default;
+
+  public:
+    HPACK_Encoder(const HPACK_Encoder&) = delete;
+    HPACK_Encoder& operator=(const HPACK_Encoder&) & = delete;
+    ~HPACK_Encoder();
+
+    // Encodes a single field. `name` shall be in lowercase, and shall not be
+    // empty. Fields whose names are `cookie`, `set-cookie` or `authorization`
+    // are encoded as never indexed.
+    void
+    encode_field(tinyfmt& fmt, chars_view name, chars_view value)
+      const;
+
+    // Encodes a response header block. The `:status` pseudo-header is written
+    // first, followed by all other headers, whose names are converted to
+    // lowercase. Empty headers and connection-specific headers, which are not
+    // allowed by HTTP/2, are ignored.
+    void
+    encode_response(tinyfmt& fmt, const HTTP_S_Headers& resp)
+      const;
+  };
+
+}  // namespace poseidon
+#endif
@@ -0,0 +1,95 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_HTTP_HTTP_COMPRESSOR_
+#define POSEIDON_HTTP_HTTP_COMPRESSOR_
+
+#include "../fwd.hpp"
+#include "enums.hpp"
+#include "../base/abstract_deflator.hpp"
+namespace poseidon {
+
+class HTTP_Compressor
+  :
+    public Abstract_Deflator
+  {
+  private:
+    linear_buffer m_obuf;
+
+  public:
+    // Constructs a compressor for a response payload. `coding` shall be either
+    // `http_coding_deflate` or `http_coding_gzip`.
+    HTTP_Compressor(HTTP_Content_Coding coding, int level);
+
+  protected:
+    // These functions implement `Abstract_Deflator`.
+    virtual
+    char*
+    do_on_deflate_resize_output_buffer(size_t& size)
+      override;
+
+    virtual
+    void
+    do_on_deflate_truncate_output_buffer(size_t backup)
+      override;
+
+  public:
+    HTTP_Compressor(const HTTP_Compressor&) = delete;
+    HTTP_Compressor& operator=(const HTTP_Compressor&) & = delete;
+    virtual ~HTTP_Compressor();
+
+    // Gets the output buffer. Compressed data are appended to it, and callers
+    // are supposed to remove bytes that have been consumed.
+    const linear_buffer&
+    output_buffer()
+      const noexcept
+      { return this->m_obuf;  }
+
+    linear_buffer&
+    mut_output_buffer()
+      noexcept
+      { return this->m_obuf;  }
+
+    // Selects a content coding from the `Accept-Encoding` headers of a request.
+    // `gzip` is preferred to `deflate` if both are acceptable with the same
+    // quality value. Codings with a quality value of zero are not acceptable.
+    // If neither is acceptable, `http_coding_identity` is returned.
+    static
+    HTTP_Content_Coding
+    select_content_coding(const HTTP_C_Headers& req);
+
+    // Checks whether the payload of a response should be compressed. Partial
+    // responses, responses that already have `Content-Encoding`, that have no
+    // `Content-Type`, whose `Content-Type` denotes compressed data (such as
+    // images or archives), or whose payloads are too small to benefit from
+    // compression, are sent as is.
+    static
+    bool
+    is_response_compressible(const HTTP_S_Headers& resp, size_t length);
+
+    // Compresses the payload of a response. If the payload is not compressible,
+    // `false` is returned and there is no effect. If the payload is compressible
+    // but is not compressed, because the client doesn't accept any coding or
+    // compression doesn't help, `false` is returned and a `Vary` header is
+    // appended to `resp`. Otherwise, compressed data are stored into `output`,
+    // and `Content-Encoding` and `Vary` headers are appended to `resp`. A strong
+    // `ETag` of `resp` is converted to a weak one. If the response has a strong
+    // `ETag` and `cache_size` is not zero, compressed data are cached, and are
+    // reused if another response has the same `ETag` and the same payload.
+    static
+    bool
+    compress_response(cow_string& output, HTTP_S_Headers& resp, chars_view data,
+                      HTTP_Content_Coding coding, int level, size_t cache_size);
+
+    // Prepares headers of a chunked response, which shall be compressed as a
+    // stream. If the response is not compressible, `false` is returned and there
+    // is no effect. If `coding` is `http_coding_identity`, `false` is returned
+    // and a `Vary` header is appended to `resp`. Otherwise, `Content-Encoding`
+    // and `Vary` headers are appended to `resp`.
+    static
+    bool
+    prepare_chunked_response(HTTP_S_Headers& resp, HTTP_Content_Coding coding, int level);
+  };
+
+}  // namespace poseidon
+#endif
@@ -13,6 +13,7 @@ class HTTP_Request_Parser
   {
   private:
     int m_default_compression_level;
+    uint32_t m_compression_cache_size;
     uint32_t m_max_header_length;
     uint32_t m_max_content_length;
 
@@ -46,6 +47,11 @@ class HTTP_Request_Parser
       const noexcept
       { return this->m_default_compression_level;  }
 
+    uint32_t
+    compression_cache_size()
+      const noexcept
+      { return this->m_compression_cache_size;  }
+
     uint32_t
     max_header_length()
       const noexcept
@@ -0,0 +1,71 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_HTTP_WEBSOCKET_BROADCAST_FRAME_
+#define POSEIDON_HTTP_WEBSOCKET_BROADCAST_FRAME_
+
+#include "../fwd.hpp"
+#include "enums.hpp"
+namespace poseidon {
+
+class WebSocket_Broadcast_Frame
+  {
+  private:
+    WS_Opcode m_opcode;
+    size_t m_payload_size;
+    cow_string m_plain;
+
+    // Compressed frames are created on demand, one for each size of the
+    // sliding window, from 9 to 15 bits.
+    mutable plain_mutex m_pmce_mutex;
+    mutable uint32_t m_pmce_done = 0;
+    mutable cow_string m_pmce[16];
+
+  public:
+    // Encodes a message into a frame, which can then be sent to many clients
+    // with `WS_Server_Session::ws_send()` or `WSS_Server_Session::wss_send()`.
+    // `opcode` may be `ws_TEXT`, `ws_BINARY`, `ws_PING` or `ws_PONG`. The
+    // payload of a control frame shall not exceed 125 bytes. Frames from servers
+    // are not masked, so a frame can't be sent by a client.
+    WebSocket_Broadcast_Frame(WS_Opcode opcode, chars_view data);
+
+  public:
+    WebSocket_Broadcast_Frame(const WebSocket_Broadcast_Frame&) = delete;
+    WebSocket_Broadcast_Frame& operator=(const WebSocket_Broadcast_Frame&) & = delete;
+    ~WebSocket_Broadcast_Frame();
+
+    // Get frame properties.
+    WS_Opcode
+    opcode()
+      const noexcept
+      { return this->m_opcode;  }
+
+    size_t
+    payload_size()
+      const noexcept
+      { return this->m_payload_size;  }
+
+    // Gets the uncompressed frame, including its header.
+    const cow_string&
+    plain_frame()
+      const noexcept
+      { return this->m_plain;  }
+
+    // Gets a frame that has been compressed by a new deflate stream, with the
+    // given size of the sliding window, in number of bits. As the compressed
+    // payload doesn't depend on previous messages, it is valid for any client
+    // that has negotiated PMCE with a window size that is no smaller than
+    // `window_bits`. If context takeover is in effect, the client appends this
+    // message to its sliding window, so the compressor of the session has to
+    // be reset afterwards. The compression level of the first call for each
+    // window size is used.
+    // If the frame is a control frame, or if the payload is too small to be
+    // worth compressing, an empty string is returned.
+    // This function is thread-safe.
+    cow_string
+    compressed_frame(uint8_t window_bits, int level)
+      const;
+  };
+
+}  // namespace poseidon
+#endif
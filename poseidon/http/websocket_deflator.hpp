@@ -11,23 +11,45 @@ namespace poseidon {
 class WebSocket_Deflator
   {
   private:
+    int m_def_level;
+    uint8_t m_def_wbits;
+    uint8_t m_def_mem_level;
+    bool m_def_no_context_takeover;
+    uint8_t m_inf_wbits;
+    bool m_inf_no_context_takeover;
+    seconds m_idle_timeout;
+
     // deflator (send)
     mutable plain_mutex m_def_mtx;
-    scoped_deflate_stream m_def_strm;
+    uniptr<scoped_deflate_stream> m_def_strm;
     linear_buffer m_def_buf;
+    steady_time m_def_used;
+    bool m_def_busy = false;
     cacheline_barrier m_xcb_1;
 
     // inflator (recv)
     mutable plain_mutex m_inf_mtx;
-    scoped_inflate_stream m_inf_strm;
+    uniptr<scoped_inflate_stream> m_inf_strm;
     linear_buffer m_inf_buf;
+    linear_buffer m_inf_dict;
+    steady_time m_inf_used;
+    bool m_inf_busy = false;
 
   public:
     // Initializes a new deflator/inflator with PMCE arguments from `parser`. A
-    // previous WebSocket handshake shall have completed.
+    // previous WebSocket handshake shall have completed. zlib streams are not
+    // allocated until they are used, and their memory comes from a pool that
+    // is shared by all deflators.
     explicit
     WebSocket_Deflator(const WebSocket_Frame_Parser& parser);
 
+  private:
+    scoped_deflate_stream&
+    do_deflate_stream_nolock();
+
+    scoped_inflate_stream&
+    do_inflate_stream_nolock();
+
   public:
     WebSocket_Deflator(const WebSocket_Deflator&) = delete;
     WebSocket_Deflator& operator=(const WebSocket_Deflator&) & = delete;
@@ -43,7 +65,8 @@ class WebSocket_Deflator
       }
 
     // Resets the deflator state. This is used when `no_context_takeover` is in
-    // effect.
+    // effect, or after an error. The zlib stream is released, and will be
+    // rebuilt for the next message.
     void
     deflate_reset(plain_mutex::unique_lock& lock)
       noexcept;
@@ -53,7 +76,8 @@ class WebSocket_Deflator
     deflate_message_stream(plain_mutex::unique_lock& lock, chars_view data);
 
     // Completes this frame. This function flushes all pending output, removes
-    // the final `00 00 FF FF`.
+    // the final `00 00 FF FF`. If `no_context_takeover` is in effect, the zlib
+    // stream is released.
     void
     deflate_message_finish(plain_mutex::unique_lock& lock);
 
@@ -72,9 +96,20 @@ class WebSocket_Deflator
                            uint32_t max_message_length);
 
     // Completes this frame. This function appends a final `00 00 FF FF`, flushes
-    // all pending output.
+    // all pending output. If `no_context_takeover` is in effect, the zlib stream
+    // is released.
     void
     inflate_message_finish(plain_mutex::unique_lock& lock);
+
+    // Releases zlib streams and buffers that have not been used for the
+    // `network.http.websocket_deflate_idle_timeout` period in 'main.conf'. As a
+    // compressor may always start over, the deflate stream is simply destroyed.
+    // If context takeover is in effect for the inflate stream, its sliding
+    // window is saved, so it can be restored later. This function is called
+    // periodically by the timer thread, so there is usually no need to call it.
+    void
+    release_idle_streams(steady_time now)
+      noexcept;
   };
 
 }  // namespace poseidon
@@ -12,6 +12,9 @@ class WebSocket_Frame_Parser
   {
   private:
     int m_default_compression_level;
+    uint8_t m_deflate_mem_level;
+    uint8_t m_deflate_max_window_bits;
+    seconds m_deflate_idle_timeout;
     uint32_t m_max_message_length;
 
     WebSocket_Frame_Header m_frm_header;
@@ -41,7 +44,8 @@ class WebSocket_Frame_Parser
       struct {
         // 0
         WSHS_State m_wshs : 2;
-        uint8_t m_pmce_reserved : 2;
+        uint8_t m_pmce_reserved : 1;
+        uint8_t m_pmce_receive_no_context_takeover : 1;
         uint8_t m_pmce_compression_level_m2 : 3;
         uint8_t m_pmce_send_no_context_takeover : 1;
         // 1
@@ -73,6 +77,21 @@ class WebSocket_Frame_Parser
       const noexcept
       { return this->m_default_compression_level;  }
 
+    uint8_t
+    deflate_mem_level()
+      const noexcept
+      { return this->m_deflate_mem_level;  }
+
+    uint8_t
+    deflate_max_window_bits()
+      const noexcept
+      { return this->m_deflate_max_window_bits;  }
+
+    seconds
+    deflate_idle_timeout()
+      const noexcept
+      { return this->m_deflate_idle_timeout;  }
+
     uint32_t
     max_message_length()
       const noexcept
@@ -112,6 +131,11 @@ class WebSocket_Frame_Parser
       const noexcept
       { return this->m_pmce_send_no_context_takeover;  }
 
+    bool
+    pmce_receive_no_context_takeover()
+      const noexcept
+      { return this->m_pmce_receive_no_context_takeover;  }
+
     uint8_t
     pmce_send_window_bits()
       const noexcept
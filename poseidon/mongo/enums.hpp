@@ -21,5 +21,12 @@ enum Mongo_Value_Type : uint8_t
     mongo_value_datetime  = 9,  // BSON_TYPE_DATE_TIME
   };
 
+enum Mongo_Result_Format : uint8_t
+  {
+    mongo_result_documents  = 0,  // `Mongo_Document`
+    mongo_result_columns    = 1,  // `Mongo_Result_Columns`
+    mongo_result_bson       = 2,  // `Mongo_Document_View`
+  };
+
 }  // namespace poseidon
 #endif
@@ -48,10 +48,20 @@ class Mongo_Connection
     reset()
       noexcept;
 
+    // Selects a server for commands, like `execute_bson()` does, and returns
+    // its ID, which is never zero. A command which creates a cursor, and all
+    // subsequent commands on the cursor, such as `getMore` and `killCursors`,
+    // must be sent to the same server.
+    uint32_t
+    select_server();
+
     // Executes a command in BSON format with no option on the default database.
-    // It is recommended that you pass a `scoped_bson` object.
+    // If `server_id` is zero, a server is selected for each command; otherwise,
+    // the command is sent to the server with that ID, which shall have been
+    // returned by `select_server()`. It is recommended that you pass a
+    // `scoped_bson` object.
     void
-    execute_bson(const ::bson_t* bson_cmd);
+    execute_bson(const ::bson_t* bson_cmd, uint32_t server_id = 0);
 
     // Fetches a document from the reply to the last command. This function must
     // be be called after `execute_bson()`. If the command has produced a reply
@@ -63,10 +73,21 @@ class Mongo_Connection
     const ::bson_t*
     fetch_reply_bson_opt();
 
+    // Fetches the reply to the last command verbatim. This function must be
+    // called after `execute_bson()`. Unlike `fetch_reply_bson_opt()`, no cursor
+    // is created if the reply contains one, so the caller may send `getMore`
+    // commands by itself. The caller must not free the result `bson_t` object.
+    // If the reply has been fetched, a null pointer is returned.
+    const ::bson_t*
+    fetch_raw_reply_bson_opt();
+
     // Executes a command in BSON format with no option on the default database.
     // Reference: https://www.mongodb.com/docs/manual/reference/command/nav-crud/
     void
-    execute(const Mongo_Document& cmd);
+    execute(const Mongo_Document& cmd, uint32_t server_id = 0);
+
+    void
+    execute(const Mongo_Document_Builder& cmd, uint32_t server_id = 0);
 
     // Fetches a document from the reply to the last command. This function must
     // be called after `execute()`. `output` is cleared before fetching any data.
@@ -77,6 +98,14 @@ class Mongo_Connection
     // document to fetch, `false` is returned.
     bool
     fetch_reply(Mongo_Document& output);
+
+    // Fetches a document from the reply to the last command, like above, but
+    // without converting it. `output` refers to memory owned by this connection,
+    // and is valid until the next call to `fetch_reply()`, `execute()` or
+    // `reset()`. If there is no more document to fetch, `false` is returned,
+    // and `output` is unchanged.
+    bool
+    fetch_reply(Mongo_Document_View& output);
   };
 
 }  // namespace poseidon
@@ -0,0 +1,121 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_MONGO_MONGO_DOCUMENT_BUILDER_
+#define POSEIDON_MONGO_MONGO_DOCUMENT_BUILDER_
+
+#include "../fwd.hpp"
+#include "enums.hpp"
+#include "mongo_value.hpp"
+#include "mongo_document_view.hpp"
+#include "../details/mongo_fwd.hpp"
+#include <forward_list>
+namespace poseidon {
+
+// This class composes a BSON document by appending fields to it, without
+// creating a `Mongo_Document`. Arrays and nested documents are opened and
+// closed explicitly, and fields are always appended to the innermost one. In
+// an array, keys of fields are ignored, and elements are numbered from zero.
+// If an exception is thrown, the contents of the builder are unspecified, and
+// it should be cleared before being reused.
+class Mongo_Document_Builder
+  {
+  private:
+    struct X_Frame
+      {
+        ::bson_t temp;
+        bool array;
+        uint32_t next_index;
+      };
+
+    scoped_bson m_bson;
+    ::std::forward_list<X_Frame> m_frames;
+    size_t m_depth = 0;
+
+  private:
+    ::bson_t*
+    do_prepare_field(chars_view& key, char (&kbuf)[16]);
+
+  public:
+    // Creates an empty document.
+    Mongo_Document_Builder()
+      noexcept
+      { }
+
+  public:
+    Mongo_Document_Builder(const Mongo_Document_Builder&) = delete;
+    Mongo_Document_Builder& operator=(const Mongo_Document_Builder&) & = delete;
+    ~Mongo_Document_Builder();
+
+    // Discards all fields and closes all arrays and nested documents.
+    void
+    clear()
+      noexcept;
+
+    // Gets the number of open arrays and nested documents.
+    size_t
+    depth()
+      const noexcept
+      { return this->m_depth;  }
+
+    // Appends a field. If the value can't be appended, an exception is thrown.
+    void
+    append_null(chars_view key);
+
+    void
+    append_boolean(chars_view key, bool value);
+
+    void
+    append_integer(chars_view key, int64_t value);
+
+    void
+    append_double(chars_view key, double value);
+
+    void
+    append_utf8(chars_view key, chars_view str);
+
+    void
+    append_binary(chars_view key, const void* data, size_t size);
+
+    void
+    append_oid(chars_view key, const ::bson_oid_t& oid);
+
+    void
+    append_datetime(chars_view key, system_time tm);
+
+    // Appends a field with a `Mongo_Value`. Arrays and nested documents are
+    // appended recursively.
+    void
+    append_value(chars_view key, const Mongo_Value& value);
+
+    // Appends all fields in a `Mongo_Document`.
+    void
+    append_fields(const Mongo_Document& doc);
+
+    // Opens an array or a nested document. Subsequent fields will be appended
+    // to it, until it's closed.
+    void
+    open_array(chars_view key);
+
+    void
+    open_document(chars_view key);
+
+    // Closes the innermost array or nested document. If there is none, an
+    // exception is thrown.
+    void
+    close();
+
+    // Gets the composed document. If there are arrays or nested documents
+    // that have not been closed, an exception is thrown.
+    const ::bson_t*
+    bson()
+      const;
+
+    Mongo_Document_View
+    view()
+      const
+      { return Mongo_Document_View(this->bson());  }
+  };
+
+}  // namespace poseidon
+#endif
@@ -0,0 +1,147 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_MONGO_MONGO_DOCUMENT_VIEW_
+#define POSEIDON_MONGO_MONGO_DOCUMENT_VIEW_
+
+#include "../fwd.hpp"
+#include "enums.hpp"
+#include "mongo_value.hpp"
+#include "../details/mongo_fwd.hpp"
+namespace poseidon {
+
+// This is a read-only view of a BSON document, which does not own its data.
+// Fields are looked up and decoded lazily, without creating a `Mongo_Document`.
+// Strings and binaries are returned as pointers into the BSON buffer. Arrays
+// and nested documents are returned as views, where elements of an array are
+// fields whose names are subscripts as decimal strings. A view is valid only
+// as long as the buffer it refers to.
+class Mongo_Document_View
+  {
+  private:
+    const uint8_t* m_data;
+    uint32_t m_size;
+
+  private:
+    ::bson_iter_t
+    do_find_typed(chars_view key, Mongo_Value_Type type)
+      const;
+
+  public:
+    // Creates a view of an empty document.
+    Mongo_Document_View()
+      noexcept;
+
+    // Creates a view of a BSON object.
+    explicit
+    Mongo_Document_View(const ::bson_t* bson)
+      noexcept
+      {
+        this->m_data = ::bson_get_data(bson);
+        this->m_size = bson->len;
+      }
+
+    // Creates a view of a BSON document in a buffer. If the buffer does not
+    // look like a BSON document, an exception is thrown. Fields are not checked
+    // until they are accessed.
+    Mongo_Document_View(const uint8_t* data, size_t size);
+
+  public:
+    Mongo_Document_View(const Mongo_Document_View&) noexcept = default;
+    Mongo_Document_View& operator=(const Mongo_Document_View&) & noexcept = default;
+    ~Mongo_Document_View();
+
+    // Gets the BSON data, including the length prefix and the terminator.
+    const uint8_t*
+    data()
+      const noexcept
+      { return this->m_data;  }
+
+    uint32_t
+    size()
+      const noexcept
+      { return this->m_size;  }
+
+    // Initializes an iterator, so all fields can be visited with
+    // `bson_iter_next()`.
+    bool
+    iter_init(::bson_iter_t& iter)
+      const noexcept
+      { return ::bson_iter_init_from_data(&iter, this->m_data, this->m_size);  }
+
+    // Searches for a field by name. If the field is found, `iter` is set to it,
+    // and `true` is returned.
+    bool
+    find(::bson_iter_t& iter, chars_view key)
+      const noexcept;
+
+    // Checks whether a field exists.
+    bool
+    has_field(chars_view key)
+      const noexcept
+      {
+        ::bson_iter_t iter;
+        return this->find(iter, key);
+      }
+
+    // Gets the type of a field. If the field does not exist, or has a type that
+    // can't be represented by `Mongo_Value`, `mongo_value_null` is returned.
+    Mongo_Value_Type
+    field_type(chars_view key)
+      const noexcept;
+
+    // Gets the value of a field. If the field does not exist, or has another
+    // type, an exception is thrown. 32-bit and 64-bit integers are both
+    // accepted as integers.
+    bool
+    get_boolean(chars_view key)
+      const;
+
+    int64_t
+    get_integer(chars_view key)
+      const;
+
+    double
+    get_double(chars_view key)
+      const;
+
+    chars_view
+    get_utf8(chars_view key)
+      const;
+
+    chars_view
+    get_binary(chars_view key)
+      const;
+
+    Mongo_Document_View
+    get_array(chars_view key)
+      const;
+
+    Mongo_Document_View
+    get_document(chars_view key)
+      const;
+
+    const ::bson_oid_t&
+    get_oid(chars_view key)
+      const;
+
+    system_time
+    get_system_time(chars_view key)
+      const;
+
+    // Gets the value of a field as a `Mongo_Value`. Arrays and nested documents
+    // are copied recursively. If the field does not exist, a null value is
+    // returned.
+    Mongo_Value
+    get_value(chars_view key)
+      const;
+
+    // Copies all fields into a `Mongo_Document`. `output` is cleared before any
+    // field is copied.
+    void
+    to_document(Mongo_Document& output)
+      const;
+  };
+
+}  // namespace poseidon
+#endif
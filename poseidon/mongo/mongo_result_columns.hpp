@@ -0,0 +1,146 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_MONGO_MONGO_RESULT_COLUMNS_
+#define POSEIDON_MONGO_MONGO_RESULT_COLUMNS_
+
+#include "../fwd.hpp"
+#include "enums.hpp"
+#include "mongo_value.hpp"
+#include <vector>
+namespace poseidon {
+
+// This is a set of documents in columnar format, where each top-level field
+// becomes a column, and each document becomes a row. Each column is stored as
+// a plain array of its type, so a column can be scanned without visiting
+// individual values. Strings of all columns share a single string arena, and
+// each column has a bitmap where a set bit denotes a null or missing value.
+// The type of a column is determined by the first non-null value in it. As
+// documents have no schema, booleans, integers and doubles are promoted to a
+// common type. Other values must have the same type as their columns. Object
+// IDs are stored as 12 bytes. Arrays and nested documents are stored as their
+// string forms, as with `Mongo_Value::print_to()`.
+class Mongo_Result_Columns
+  {
+  private:
+    struct X_Column
+      {
+        cow_string name;
+        Mongo_Value_Type type;
+        ::std::vector<uint8_t> nulls;
+        ::std::vector<int64_t> integers;
+        ::std::vector<double> doubles;
+        ::std::vector<::std::pair<size_t, size_t>> strings;
+        ::std::vector<system_time> datetimes;
+      };
+
+    ::std::vector<X_Column> m_columns;
+    size_t m_row_count = 0;
+    cow_string m_arena;
+
+  public:
+    Mongo_Result_Columns()
+      noexcept
+      { }
+
+  public:
+    Mongo_Result_Columns(const Mongo_Result_Columns&) = default;
+    Mongo_Result_Columns(Mongo_Result_Columns&&) = default;
+    Mongo_Result_Columns& operator=(const Mongo_Result_Columns&) & = default;
+    Mongo_Result_Columns& operator=(Mongo_Result_Columns&&) & = default;
+    ~Mongo_Result_Columns();
+
+    // Clears all columns and rows.
+    void
+    clear()
+      noexcept;
+
+    // Appends a document as a row. A new column is created for each field
+    // which has not been seen before. If a value can't be stored into its
+    // column, an exception is thrown, and there is no effect.
+    void
+    append_document(const Mongo_Document& doc);
+
+    // Gets the number of columns.
+    size_t
+    column_count()
+      const noexcept
+      { return this->m_columns.size();  }
+
+    // Gets the number of rows.
+    size_t
+    row_count()
+      const noexcept
+      { return this->m_row_count;  }
+
+    // Gets the name of a column.
+    const cow_string&
+    column_name(size_t col)
+      const
+      { return this->m_columns.at(col).name;  }
+
+    // Searches for a column by name. If no such column exists, `SIZE_MAX` is
+    // returned.
+    size_t
+    find_column(chars_view name)
+      const noexcept;
+
+    // Gets the type of a column. If all values in a column are null, its type
+    // is `mongo_value_null`.
+    Mongo_Value_Type
+    column_type(size_t col)
+      const
+      { return this->m_columns.at(col).type;  }
+
+    // Gets the null bitmap of a column. The value in row `r` is null if the
+    // bit `1 << r % 8` of byte `r / 8` is set.
+    const uint8_t*
+    null_bitmap(size_t col)
+      const
+      { return this->m_columns.at(col).nulls.data();  }
+
+    // Checks whether a value is null or missing.
+    bool
+    is_null(size_t col, size_t row)
+      const;
+
+    // Gets the array of an integer or boolean column, which has `row_count()`
+    // elements. If the column is of another type, an exception is thrown.
+    const int64_t*
+    integer_data(size_t col)
+      const;
+
+    // Gets the array of a double column, which has `row_count()` elements. If
+    // the column is of another type, an exception is thrown.
+    const double*
+    double_data(size_t col)
+      const;
+
+    // Gets the array of a datetime column, which has `row_count()` elements.
+    // If the column is of another type, an exception is thrown.
+    const system_time*
+    datetime_data(size_t col)
+      const;
+
+    // Gets a value in a column which is stored in the string arena. A null
+    // value is an empty string. If the column is a boolean, integer, double or
+    // datetime column, an exception is thrown.
+    chars_view
+    string(size_t col, size_t row)
+      const;
+
+    // Gets the string arena, where strings of all columns are stored.
+    const cow_string&
+    arena()
+      const noexcept
+      { return this->m_arena;  }
+
+    // Gets a value as a `Mongo_Value`. Arrays and nested documents are
+    // returned as strings.
+    Mongo_Value
+    value(size_t col, size_t row)
+      const;
+  };
+
+}  // namespace poseidon
+#endif
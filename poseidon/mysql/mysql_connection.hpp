@@ -18,17 +18,59 @@ class MySQL_Connection
     cow_string m_password;
     bool m_connected;
     bool m_reset_clear;
+    bool m_async;
+    bool m_text_result;
+    uint8_t m_async_step;
 
     scoped_MYSQL m_mysql;
     uniptr_MYSQL_STMT m_stmt;
+    cow_string m_stmt_text;
     uniptr_MYSQL_RES m_meta;
     uniptr_MYSQL_RES m_res;
 
+    // Output buffers are bound once for each result set, and are reused for
+    // all rows.
+    struct X_Result_Column;
+    cow_vector<X_Result_Column> m_result_columns;
+    ::std::vector<::MYSQL_BIND> m_result_binds;
+    bool m_result_bound;
+
+    struct X_Cached_Statement;
+    cow_vector<X_Cached_Statement> m_stmt_cache;  // most recently used first
+    uint32_t m_stmt_cache_size;
+    bool m_keep_stmts;
+    uint64_t m_stmt_cache_hits;
+    uint64_t m_stmt_cache_misses;
+
+    cow_string m_async_user;
+    cow_string m_async_host;
+    uint16_t m_async_port;
+    cow_string m_async_database;
+    cow_string m_async_query;
+    shptr<Abstract_Socket> m_async_socket;
+
   public:
     // Sets connection parameters. This function does not attempt to connect
     // to the server, and is not blocking.
     MySQL_Connection(const cow_string& service_uri, const cow_string& password);
 
+  private:
+    void
+    do_parse_service_uri(cow_string& user, cow_string& host, uint16_t& port,
+                         cow_string& database)
+      const;
+
+    void
+    do_release_statement()
+      noexcept;
+
+    void
+    do_execute(const cow_string& stmt, const cow_vector<MySQL_Value>& args,
+               uint32_t prefetch_rows);
+
+    bool
+    do_bind_result();
+
   public:
     MySQL_Connection(const MySQL_Connection&) = delete;
     MySQL_Connection& operator=(const MySQL_Connection&) & = delete;
@@ -40,9 +82,67 @@ class MySQL_Connection
       const noexcept
       { return this->m_service_uri;  }
 
+    // Checks whether a connection to the server has been established.
+    bool
+    connected()
+      const noexcept
+      { return this->m_connected;  }
+
+    // Checks whether the connection has been established by
+    // `execute_nonblocking_start()`. Such a connection can only be used
+    // asynchronously, and vice versa.
+    bool
+    asynchronous()
+      const noexcept
+      { return this->m_async;  }
+
+    // Gets and sets the maximum number of prepared statements to keep. After a
+    // statement has been executed, it is kept in a cache, and will be reused if
+    // the same statement is executed again. Zero disables the cache.
+    uint32_t
+    statement_cache_size()
+      const noexcept
+      { return this->m_stmt_cache_size;  }
+
+    void
+    set_statement_cache_size(uint32_t size)
+      noexcept;
+
+    // Gets and sets whether cached statements are kept by `reset()`, so they
+    // can be reused by the next user of the connection. See `reset()` for
+    // details.
+    bool
+    keep_statements_on_reset()
+      const noexcept
+      { return this->m_keep_stmts;  }
+
+    void
+    set_keep_statements_on_reset(bool keep)
+      noexcept
+      { this->m_keep_stmts = keep;  }
+
+    // Gets the number of statements that have been taken from the cache, and
+    // the number of statements that have been prepared.
+    uint64_t
+    statement_cache_hits()
+      const noexcept
+      { return this->m_stmt_cache_hits;  }
+
+    uint64_t
+    statement_cache_misses()
+      const noexcept
+      { return this->m_stmt_cache_misses;  }
+
     // Resets the connection so it can be reused by another thread. This is a
     // blocking functions. DO NOT ATTEMPT TO REUSE THE CONNECTION IF THIS
     // FUNCTION RETURNS `false`.
+    // If the connection is asynchronous, this function waits for its socket.
+    // All session states are discarded, including cached statements, unless
+    // `keep_statements_on_reset()` yields `true` and there are cached
+    // statements, in which case the current transaction is rolled back and
+    // auto-commit is enabled, but other session states, such as user variables,
+    // session variables and temporary tables, are kept and will be seen by the
+    // next user. If the reset operation fails, the cache is cleared.
     // Returns whether the connection may be safely reused.
     bool
     reset()
@@ -56,6 +156,52 @@ class MySQL_Connection
     void
     execute(const cow_string& stmt, const cow_vector<MySQL_Value>& args);
 
+    // Executes a query with a read-only cursor on the server. `stmt` and `args`
+    // are the same as `execute()`. Instead of sending the entire result set at
+    // once, the server sends `prefetch_rows` rows for each round trip, so a
+    // large result set can be fetched without being buffered in memory. Other
+    // statements can't be executed until all rows have been fetched, or the
+    // result set will be discarded.
+    void
+    execute_cursor(const cow_string& stmt, const cow_vector<MySQL_Value>& args,
+                   uint32_t prefetch_rows);
+
+    // Starts executing a query without blocking. `stmt` and `args` are the
+    // same as `execute()`, but as prepared statements can't be executed
+    // asynchronously, arguments are substituted into the statement on the
+    // client side, where strings are written as hexadecimal literals, and those
+    // that are not valid UTF-8 are binary. The statement cache is not used, and
+    // results are received as text, which are converted according to the types
+    // of their fields. If a connection to the server has not been established
+    // yet, this function initiates a new connection before the query is
+    // executed. If the operation has completed, `true` is returned. Otherwise,
+    // `false` is returned, and `execute_nonblocking_continue()` shall be called
+    // when the socket becomes readable or writable. After the operation has
+    // completed, the entire result set will have been stored, so results can
+    // be fetched without blocking.
+    bool
+    execute_nonblocking_start(const cow_string& stmt, const cow_vector<MySQL_Value>& args);
+
+    // Starts resetting an asynchronous connection without blocking. This is the
+    // non-blocking counterpart of `reset()`. If the operation has completed,
+    // `true` is returned. Otherwise, `false` is returned, and `execute_nonblocking_continue()`
+    // shall be called when the socket becomes readable or writable. If an error
+    // occurs, an exception is thrown, and the connection can't be reused.
+    bool
+    reset_nonblocking_start();
+
+    // Continues an operation that has been started by `execute_nonblocking_start()`
+    // or `reset_nonblocking_start()`. The return value has the same meaning. If
+    // an error occurs, an exception is thrown, and the operation is aborted.
+    bool
+    execute_nonblocking_continue();
+
+    // Gets the socket descriptor of the connection. This function shall only be
+    // called after `execute_nonblocking_start()` has returned `false`.
+    int
+    nonblocking_fd()
+      const noexcept;
+
     // Gets the number of warnings on the current connection. This function is
     // primarily useful for statements that produce warnings upon success.
     uint32_t
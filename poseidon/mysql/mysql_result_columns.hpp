@@ -0,0 +1,147 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_MYSQL_MYSQL_RESULT_COLUMNS_
+#define POSEIDON_MYSQL_MYSQL_RESULT_COLUMNS_
+
+#include "../fwd.hpp"
+#include "enums.hpp"
+#include "mysql_value.hpp"
+#include <vector>
+namespace poseidon {
+
+// This is a result set in columnar format. Each column is stored as a plain
+// array of its type, so a column can be scanned without visiting individual
+// values. Blobs of all columns share a single string arena, and each column
+// has a bitmap where a set bit denotes a null value. A null value has a zero
+// element in the array of its column.
+// The type of a column is determined by the first non-null value in it. As
+// MySQL columns have fixed types, values of another type are rejected.
+class MySQL_Result_Columns
+  {
+  private:
+    struct X_Column
+      {
+        cow_string name;
+        MySQL_Value_Type type;
+        ::std::vector<uint8_t> nulls;
+        ::std::vector<int64_t> integers;
+        ::std::vector<double> doubles;
+        ::std::vector<::std::pair<size_t, size_t>> blobs;
+        ::std::vector<system_time> datetimes;
+      };
+
+    ::std::vector<X_Column> m_columns;
+    size_t m_row_count = 0;
+    cow_string m_arena;
+
+  private:
+    const X_Column&
+    do_check_column(size_t col, MySQL_Value_Type type)
+      const;
+
+  public:
+    MySQL_Result_Columns()
+      noexcept
+      { }
+
+  public:
+    MySQL_Result_Columns(const MySQL_Result_Columns&) = default;
+    MySQL_Result_Columns(MySQL_Result_Columns&&) = default;
+    MySQL_Result_Columns& operator=(const MySQL_Result_Columns&) & = default;
+    MySQL_Result_Columns& operator=(MySQL_Result_Columns&&) & = default;
+    ~MySQL_Result_Columns();
+
+    // Clears all columns and rows, and then sets names of columns.
+    void
+    reset(const cow_vector<cow_string>& names);
+
+    // Appends a row. The number of values in `row` shall equal the number of
+    // columns. If a value has a different type from its column, an exception
+    // is thrown, and there is no effect.
+    void
+    append_row(const cow_vector<MySQL_Value>& row);
+
+    // Gets the number of columns.
+    size_t
+    column_count()
+      const noexcept
+      { return this->m_columns.size();  }
+
+    // Gets the number of rows.
+    size_t
+    row_count()
+      const noexcept
+      { return this->m_row_count;  }
+
+    // Gets the name of a column.
+    const cow_string&
+    column_name(size_t col)
+      const
+      { return this->m_columns.at(col).name;  }
+
+    // Gets the type of a column. If all values in a column are null, its type
+    // is `mysql_value_null`.
+    MySQL_Value_Type
+    column_type(size_t col)
+      const
+      { return this->m_columns.at(col).type;  }
+
+    // Gets the null bitmap of a column. The value in row `r` is null if the
+    // bit `1 << r % 8` of byte `r / 8` is set.
+    const uint8_t*
+    null_bitmap(size_t col)
+      const
+      { return this->m_columns.at(col).nulls.data();  }
+
+    // Checks whether a value is null.
+    bool
+    is_null(size_t col, size_t row)
+      const;
+
+    // Gets the array of an integer column, which has `row_count()` elements.
+    // If the column is not an integer column, an exception is thrown.
+    const int64_t*
+    integer_data(size_t col)
+      const
+      { return this->do_check_column(col, mysql_value_integer).integers.data();  }
+
+    // Gets the array of a double column, which has `row_count()` elements. If
+    // the column is not a double column, an exception is thrown.
+    const double*
+    double_data(size_t col)
+      const
+      { return this->do_check_column(col, mysql_value_double).doubles.data();  }
+
+    // Gets the array of a datetime column, which has `row_count()` elements.
+    // If the column is not a datetime column, an exception is thrown.
+    const system_time*
+    datetime_data(size_t col)
+      const
+      { return this->do_check_column(col, mysql_value_datetime).datetimes.data();  }
+
+    // Gets a value in a blob column, which points into the string arena. A
+    // null value is an empty string. If the column is not a blob column, an
+    // exception is thrown.
+    chars_view
+    blob(size_t col, size_t row)
+      const
+      {
+        const auto& r = this->do_check_column(col, mysql_value_blob).blobs.at(row);
+        return chars_view(this->m_arena.data() + r.first, r.second);
+      }
+
+    // Gets the string arena, where blobs of all columns are stored.
+    const cow_string&
+    arena()
+      const noexcept
+      { return this->m_arena;  }
+
+    // Gets a value as a `MySQL_Value`.
+    MySQL_Value
+    value(size_t col, size_t row)
+      const;
+  };
+
+}  // namespace poseidon
+#endif
@@ -15,5 +15,13 @@ enum Redis_Value_Type : uint8_t
     redis_value_array     = 3,  // REDIS_REPLY_ARRAY
   };
 
+enum Redis_Reply_Type : uint8_t
+  {
+    redis_reply_value     = 0,  // data, possibly nil
+    redis_reply_status    = 1,  // simple string
+    redis_reply_error     = 2,  // simple or blob error
+    redis_reply_push      = 3,  // out-of-band message (RESP3)
+  };
+
 }  // namespace poseidon
 #endif
@@ -7,6 +7,7 @@
 #include "../fwd.hpp"
 #include "enums.hpp"
 #include "../details/redis_fwd.hpp"
+#include <deque>
 namespace poseidon {
 
 class Redis_Connection
@@ -20,13 +21,23 @@ class Redis_Connection
     bool m_reset_clear;
 
     uniptr_redisContext m_redis;
-    uniptr_redisReply m_reply;
+    ::std::deque<uniptr_redisReply> m_replies;
 
   public:
     // Sets connection parameters. This function does not attempt to connect
     // to the server, and is not blocking.
     Redis_Connection(const cow_string& service_uri, const cow_string& password);
 
+  private:
+    void
+    do_connect_if_needed();
+
+    void
+    do_append_command(const cow_vector<cow_string>& cmd);
+
+    void
+    do_get_reply();
+
   public:
     Redis_Connection(const Redis_Connection&) = delete;
     Redis_Connection& operator=(const Redis_Connection&) & = delete;
@@ -46,13 +57,22 @@ class Redis_Connection
     reset()
       noexcept;
 
-    // Executes a command as an array of strings.
+    // Executes a command as an array of strings. If the server replies with
+    // an error, an exception is thrown.
     void
     execute(const cow_vector<cow_string>& cmd);
 
-    // Gets the reply of the previous command. `status` and `value` are cleared
-    // before any operation. If the reply has been saved into either `status` or
-    // `value`, `true` is returned. If there is no reply, `false` is returned.
+    // Executes a series of commands in a pipeline. All commands are sent in a
+    // batch, and then all replies are received, so this function takes only
+    // one round trip. Errors from the server are not checked here.
+    void
+    execute_pipeline(const cow_vector<cow_vector<cow_string>>& cmds);
+
+    // Gets the reply of the next command, in the order of execution. `status`
+    // and `value` are cleared before any operation. If the reply has been saved
+    // into either `status` or `value`, `true` is returned. If there is no more
+    // reply, `false` is returned. If the reply is an error, it's removed, and
+    // an exception is thrown.
     bool
     fetch_reply(cow_string& status, Redis_Value& value);
   };
@@ -0,0 +1,99 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_REDIS_REDIS_REPLY_PARSER_
+#define POSEIDON_REDIS_REDIS_REPLY_PARSER_
+
+#include "../fwd.hpp"
+#include "enums.hpp"
+#include "redis_value.hpp"
+#include <deque>
+namespace poseidon {
+
+// This is a parser for replies in the Redis serialization protocol, which
+// accepts both RESP2 and RESP3. RESP3 types that `Redis_Value` can't hold are
+// converted: maps become arrays of alternating keys and values, sets become
+// arrays, booleans become integers, and doubles and big numbers become strings.
+// Attributes are ignored.
+class Redis_Reply_Parser
+  {
+  private:
+    Redis_Reply_Type m_type = redis_reply_value;
+    cow_string m_status;
+    Redis_Value m_value;
+    bool m_error = false;
+
+    // These are the states of a partial reply. An aggregate type is parsed
+    // into `psa` of a frame. An attribute is parsed into an element of
+    // `m_attrs` and discarded, after which the real value is parsed into
+    // `resume`. `m_pval` points to the value being parsed, and is null if no
+    // reply is in progress.
+    struct X_Frame
+      {
+        Redis_Array* psa;
+        size_t count;
+        Redis_Value* resume;
+      };
+
+    ::std::vector<X_Frame> m_stack;
+    ::std::deque<Redis_Array> m_attrs;
+    Redis_Value* m_pval = nullptr;
+
+  public:
+    // Constructs a parser for incoming replies.
+    Redis_Reply_Parser()
+      noexcept;
+
+  public:
+    Redis_Reply_Parser(const Redis_Reply_Parser&) = delete;
+    Redis_Reply_Parser& operator=(const Redis_Reply_Parser&) & = delete;
+    ~Redis_Reply_Parser();
+
+    // Checks whether an error has occurred. Once an error has occurred, all
+    // further data are rejected, and the connection shall be closed.
+    bool
+    error()
+      const noexcept
+      { return this->m_error;  }
+
+    // Gets the type of the last reply.
+    Redis_Reply_Type
+    reply_type()
+      const noexcept
+      { return this->m_type;  }
+
+    // Gets the status string or error message of the last reply.
+    const cow_string&
+    status()
+      const noexcept
+      { return this->m_status;  }
+
+    cow_string&
+    mut_status()
+      noexcept
+      { return this->m_status;  }
+
+    // Gets the value of the last reply, which is nil for statuses and errors.
+    // If a reply is incomplete, its value is unspecified.
+    const Redis_Value&
+    value()
+      const noexcept
+      { return this->m_value;  }
+
+    Redis_Value&
+    mut_value()
+      noexcept
+      { return this->m_value;  }
+
+    // Parses a reply from `data`. If a complete reply has been parsed, it is
+    // removed from `data`, and `true` is returned. If the reply is incomplete,
+    // the elements that have been parsed are removed from `data` and kept in
+    // this parser, and `false` is returned, so the reply will be resumed when
+    // more data arrive. If an error has occurred, `data` is left intact, and
+    // `false` is returned; `error()` shall be checked in this case.
+    bool
+    parse_reply_from_stream(linear_buffer& data);
+  };
+
+}  // namespace poseidon
+#endif
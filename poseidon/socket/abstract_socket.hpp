@@ -7,6 +7,7 @@
 #include "../fwd.hpp"
 #include "enums.hpp"
 #include "ipv6_address.hpp"
+#include "../details/chunk_queue.hpp"
 namespace poseidon {
 
 class Abstract_Socket
@@ -29,7 +30,17 @@ class Abstract_Socket
     Network_Scheduler* m_scheduler;
     linear_buffer m_sched_read_queue;
     linear_buffer m_sched_write_queue;
+    chunk_queue m_sched_write_chunks;
     bool m_sched_throttled = false;
+    bool m_sched_read_paused = false;
+    uint32_t m_sched_read_size = 0x4000;
+
+  private:
+    // Returns storage of the read queue to the pool of the current thread,
+    // keeping only unconsumed data. This is called by the network scheduler
+    // after I/O events have been processed.
+    void
+    do_abstract_socket_release_read_queue();
 
   protected:
     // Take ownership of an existent IPv6 socket. [server-side constructor]
@@ -69,6 +80,28 @@ class Abstract_Socket
     do_abstract_socket_lock_write_queue(recursive_mutex::unique_lock& lock)
       noexcept;
 
+    // Stream sockets may use a chunked write queue instead, which can be
+    // flushed with `writev()`. It's protected by the same mutex.
+    chunk_queue&
+    do_abstract_socket_lock_write_chunks(recursive_mutex::unique_lock& lock)
+      noexcept;
+
+    // Reserves space after the end of the read queue for the next read, and
+    // returns its size. If the read queue is short of space, a buffer is
+    // borrowed from a pool of the current thread, so idle sockets don't pin
+    // read buffers. The size adapts to `last_nread`, which is the number of
+    // bytes from the previous read, or zero if there was none. Callers shall
+    // have locked the read queue.
+    size_t
+    do_abstract_socket_reserve_read_queue(size_t last_nread);
+
+    // Checks whether reading has been paused by `Network_Scheduler::
+    // pause_reading()`. Callers shall have locked the read queue.
+    bool
+    do_abstract_socket_read_paused()
+      const noexcept
+      { return this->m_sched_read_paused;  }
+
     // This callback is invoked by the network thread when incoming data are
     // available, and is intended to be overriden by derived classes.
     virtual
@@ -125,6 +158,13 @@ class Abstract_Socket
     remote_address()
       const noexcept;
 
+    // Get the number of bytes that have been enqueued but not sent yet, and
+    // the number of bytes that have been allocated for them.
+    // This function is thread-safe.
+    pair<size_t, size_t>
+    pending_write_size()
+      const;
+
     // Shut the socket down without flushing unsent data nor sending any
     // protocol-specific notifications, useful for abandoning an abnormal
     // connection. Be advised that data loss or corruption may happen.
@@ -20,10 +20,15 @@ class DNS_Connect_Task
     uint16_t m_port;
 
   public:
-    // Performs asynchronous DNS lookup. If at least one address is found,
-    // `connect()` is called on `socket`. If both IPv4 and IPv6 addresses are
-    // found, an IPv4 address is preferred to an IPv6 address. If no address can
-    // be found, the socket is closed immediately.
+    // Performs asynchronous DNS lookup with `dns_resolver`, which doesn't block
+    // the worker thread. If at least one address is found, `connect()` is
+    // called on `socket`. If multiple addresses are found for a stream socket,
+    // connections are attempted in parallel as in Happy Eyeballs (RFC 8305),
+    // alternating between IPv6 and IPv4, and starting one after another with
+    // `network.dns.connection_attempt_delay`; the first connection that is
+    // established replaces the one of `socket` and the others are closed. If
+    // no connection can be initiated, `socket` is closed, and a closure
+    // notification is delivered.
     DNS_Connect_Task(Network_Scheduler& scheduler, const shptr<Abstract_Socket>& socket,
                      const cow_string& host, uint16_t port);
 
@@ -27,6 +27,12 @@ enum Socket_State : uint8_t
     socket_closed       = 3,  // TCP, SSL, UDP
   };
 
+enum UDP_Drop_Policy : uint8_t
+  {
+    udp_drop_newest  = 0,  // drop packets that are being enqueued
+    udp_drop_oldest  = 1,  // drop packets from the head of the queue
+  };
+
 enum HTTP_Payload_Type : uint8_t
   {
     http_payload_normal   = 0,
@@ -0,0 +1,182 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_SOCKET_HTTP2_SERVER_SESSION_
+#define POSEIDON_SOCKET_HTTP2_SERVER_SESSION_
+
+#include "../fwd.hpp"
+#include "enums.hpp"
+#include "ssl_socket.hpp"
+#include "../http/http_c_headers.hpp"
+#include "../http/http_s_headers.hpp"
+#include "../http/hpack_decoder.hpp"
+#include "../http/hpack_encoder.hpp"
+namespace poseidon {
+
+class HTTP2_Server_Session
+  :
+    public virtual SSL_Socket
+  {
+  private:
+    uint32_t m_max_header_length;
+    uint32_t m_max_content_length;
+    uint32_t m_max_concurrent_streams;
+
+    HPACK_Decoder m_hpack_dec;
+    HPACK_Encoder m_hpack_enc;
+    bool m_preface_done = false;
+    bool m_goaway_sent = false;
+    uint32_t m_last_stream_id = 0;
+    uint32_t m_cont_stream_id = 0;
+    uint8_t m_cont_flags = 0;
+    linear_buffer m_cont_block;
+
+    uint32_t m_peer_max_frame_size = 16384;
+    uint32_t m_peer_initial_window_size = 65535;
+    int64_t m_send_window = 65535;
+    uint32_t m_recv_unacked = 0;
+
+    struct X_Stream_Table;
+    uniptr<X_Stream_Table> m_streams;
+
+  public:
+    // Constructs a socket for incoming connections. The `h2` protocol is
+    // offered during the TLS handshake via ALPN. A client which has not
+    // negotiated `h2` is still accepted if it starts with the HTTP/2 preface.
+    HTTP2_Server_Session();
+
+  private:
+    bool
+    do_http2_send_frame(uint8_t type, uint8_t flags, uint32_t stream_id, chars_view payload);
+
+    bool
+    do_http2_send_headers(uint32_t stream_id, const HTTP_S_Headers& resp, bool end_stream);
+
+    bool
+    do_http2_send_data(uint32_t stream_id, chars_view data, bool end_stream);
+
+    bool
+    do_http2_flush_stream(uint32_t stream_id);
+
+    void
+    do_http2_flush_all_streams();
+
+    void
+    do_http2_reset_stream(uint32_t stream_id, HTTP2_Error error);
+
+    void
+    do_http2_connection_error(HTTP2_Error error, const char* desc);
+
+    void
+    do_http2_process_header_block(uint32_t stream_id, bool end_stream);
+
+    void
+    do_http2_end_of_request(uint32_t stream_id);
+
+    void
+    do_http2_process_frame(uint8_t type, uint8_t flags, uint32_t stream_id, chars_view payload);
+
+  protected:
+    // This function implements `SSL_Socket`.
+    virtual
+    void
+    do_on_ssl_stream(linear_buffer& data, bool eof)
+      override;
+
+    // This callback is invoked by the network thread after all headers of a
+    // request have been received, just before the payload of it. `stream_id`
+    // identifies the request, and shall be passed to response functions.
+    // `end_stream` indicates whether the request has no payload. Pseudo-header
+    // fields have been translated into fields of `req`.
+    // The default implementation merely prints a message.
+    virtual
+    void
+    do_on_http2_request_headers(uint32_t stream_id, HTTP_C_Headers& req, bool end_stream);
+
+    // This callback is invoked by the network thread for each fragment of the
+    // request payload that has been received. As with `SSL_Connection::
+    // do_on_ssl_stream()`, the argument buffer contains all data that have been
+    // accumulated so far and callees are supposed to remove bytes that have been
+    // processed.
+    // The default implementation leaves all data alone for consumption by
+    // `do_on_http2_request_finish()`. For security reasons, the length of the
+    // payload body is checked; an error is reported if it exceeds the
+    // `network.http.max_request_content_length` limit in 'main.conf'.
+    virtual
+    void
+    do_on_http2_request_payload_stream(uint32_t stream_id, linear_buffer& data);
+
+    // This callback is invoked by the network thread at the end of a request
+    // message. Arguments have the same semantics with the other callbacks.
+    virtual
+    void
+    do_on_http2_request_finish(uint32_t stream_id, HTTP_C_Headers&& req, linear_buffer&& data)
+      = 0;
+
+    // This callback is invoked when a request is malformed, or when the request
+    // payload is rejected. Unlike HTTP/1.1, responses in HTTP/2 are not ordered,
+    // but the stream is kept open so an error response can be sent. Further
+    // data of this request are discarded.
+    virtual
+    void
+    do_on_http2_request_error(uint32_t stream_id, HTTP_Status status)
+      = 0;
+
+  public:
+    HTTP2_Server_Session(const HTTP2_Server_Session&) = delete;
+    HTTP2_Server_Session& operator=(const HTTP2_Server_Session&) & = delete;
+    virtual ~HTTP2_Server_Session();
+
+    // Sends a headers-only response, which terminates the stream.
+    // If the stream has been closed or reset by the client, `false` is returned
+    // and there is no effect.
+    // If this function throws an exception, there is no effect.
+    // This function is thread-safe.
+    bool
+    http2_response_headers_only(uint32_t stream_id, HTTP_S_Headers&& resp);
+
+    // Sends a simple response, possibly with a complete payload. Callers should
+    // not supply `Content-Length` or `Transfer-Encoding` headers, as they
+    // will be rewritten. If `resp.status` equals 1xx, 204 or 304, the HTTP
+    // specification requires that the response shall have no message payload, in
+    // which case `data` is ignored. Data that can't be sent due to flow control
+    // are queued, and will be sent when the client grants more credit.
+    // If the stream has been closed or reset by the client, `false` is returned
+    // and there is no effect.
+    // If this function throws an exception, there is no effect.
+    // This function is thread-safe.
+    bool
+    http2_response(uint32_t stream_id, bool method_was_head, HTTP_S_Headers&& resp,
+                   chars_view data);
+
+    // Send a response with a streamed payload, which may contain multiple
+    // fragments. These functions are named after their HTTP/1.1 counterparts,
+    // but no chunked encoding is involved; each fragment is sent as DATA frames.
+    // Empty fragments are ignored by `http2_chunked_response_send()`.
+    // If the stream has been closed or reset by the client, `false` is returned
+    // and there is no effect.
+    // If these function throw an exception, there is no effect.
+    // These functions are thread-safe.
+    bool
+    http2_chunked_response_start(uint32_t stream_id, HTTP_S_Headers&& resp);
+
+    bool
+    http2_chunked_response_send(uint32_t stream_id, chars_view data);
+
+    bool
+    http2_chunked_response_finish(uint32_t stream_id);
+
+    // Resets a stream. Pending data of this stream are discarded.
+    // This function is thread-safe.
+    bool
+    http2_reset_stream(uint32_t stream_id, HTTP2_Error error = http2_cancel);
+
+    // Sends a GOAWAY frame and shuts down the connection.
+    // This function is thread-safe.
+    bool
+    http2_shut_down(HTTP2_Error error = http2_no_error)
+      noexcept;
+  };
+
+}  // namespace poseidon
+#endif
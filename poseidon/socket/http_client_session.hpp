@@ -37,6 +37,15 @@ class HTTP_Client_Session
       const noexcept
       { return this->m_upgrade_ack.load();  }
 
+    // Checks whether the connection will be closed after the current response,
+    // as requested by the server, or as implied by HTTP/1.0. This function may
+    // be called by `do_on_http_response_finish()` to determine whether the connection
+    // can be reused for another request.
+    bool
+    do_should_close_after_response()
+      const noexcept
+      { return this->m_resp_parser.should_close_after_payload();  }
+
     // This callback is invoked by the network thread after all headers of a
     // response have been received, just before the payload of it. Returning
     // `http_payload_normal` indicates that the response has a payload whose
@@ -19,10 +19,20 @@ class HTTPS_Server_Session
     HTTP_Request_Parser m_req_parser;
     atomic_relaxed<bool> m_upgrade_ack;
 
+    // These are protected by the write queue lock. `m_resp_codings` contains
+    // a content coding for each request that is awaiting a response, in the
+    // order of the requests.
+    linear_buffer m_resp_codings;
+    uniptr<HTTP_Compressor> m_chunk_compr;
+
   public:
     // Constructs a socket for incoming connections.
     HTTPS_Server_Session();
 
+  private:
+    HTTP_Content_Coding
+    do_https_front_content_coding();
+
   protected:
     // These function implement `SSL_Socket`.
     virtual
@@ -123,6 +133,12 @@ class HTTPS_Server_Session
     // will be rewritten. If `resp.status` equals 1xx, 204 or 304, the HTTP
     // specification requires that the response shall have no message payload, in
     // which case `data` and `size` are ignored.
+    // If the client has sent an `Accept-Encoding` header, the payload may be
+    // compressed with gzip or deflate. Responses that already have a
+    // `Content-Encoding` header are sent as is. Responses to HEAD requests get
+    // the same headers as those to GET requests, so `data` shall still be the
+    // payload that would be sent. See `HTTP_Compressor::compress_response()`
+    // for details.
     // If this function throws an exception, there is no effect.
     // This function is thread-safe.
     bool
@@ -135,7 +151,9 @@ class HTTPS_Server_Session
     // `https_chunked_response_send()`. These functions do very little error
     // checking. Calling `https_chunked_response_send()` or
     // `https_chunked_response_finish()` when no chunked response is active is
-    // likely to corrupt the connection.
+    // likely to corrupt the connection. As with `https_response()`, the payload
+    // may be compressed, in which case each chunk is flushed on its own, so
+    // data are not held back by the compressor.
     // If these function throw an exception, there is no effect.
     // These functions are thread-safe.
     bool
@@ -0,0 +1,159 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_SOCKET_REDIS_CLIENT_SESSION_
+#define POSEIDON_SOCKET_REDIS_CLIENT_SESSION_
+
+#include "../fwd.hpp"
+#include "enums.hpp"
+#include "../redis/redis_reply_parser.hpp"
+#include <deque>
+#include <unordered_set>
+namespace poseidon {
+
+// This is the protocol part of an asynchronous Redis client, which is shared
+// by `Redis_TCP_Client_Session` and `Redis_SSL_Client_Session`. Commands are
+// sent in RESP3, and replies are matched with commands in order, so multiple
+// commands may be in flight on one connection. Push messages, such as those
+// from SUBSCRIBE and CLIENT TRACKING, are delivered separately. In RESP3, the
+// confirmations of SUBSCRIBE and similar commands are push messages, one for
+// each channel; they complete the command instead, after all of them have
+// arrived, and the callback receives the last one.
+class Redis_Client_Session
+  {
+  public:
+    // This is the callback for commands, where `status` and `value` are the
+    // reply of the command, and `error` is a description of the error if the
+    // command has failed. The callback is invoked by the network thread, and
+    // shall not block.
+    using callback_type = shared_function<
+            void
+             (cow_string&& status,
+              Redis_Value&& value,
+              const char* error)>;
+
+    // This is the callback for push messages, where `message` is the message,
+    // and `error` is a description of the error if the connection has been
+    // closed. The callback shall return `true` if it has taken the message, or
+    // `false` without touching it if its receiver has gone away, in which case
+    // the message is passed to the next waiter, or queued. The callback shall
+    // not block.
+    using push_callback_type = shared_function<
+            bool
+             (Redis_Value&& message,
+              const char* error)>;
+
+  private:
+    cow_string m_user;
+    cow_string m_password;
+    uint32_t m_database;
+
+    // This describes a command that is awaiting its reply. For SUBSCRIBE and
+    // similar commands, `sub_kind` is non-zero, and `sub_replies` is the number
+    // of confirmations that are still expected, which is zero if it's unknown
+    // until all previous commands have completed.
+    struct X_Pending_Command
+      {
+        callback_type callback;
+        uint8_t sub_kind;
+        bool unsub;
+        uint32_t sub_replies;
+      };
+
+    // These fields are protected by the socket.
+    Redis_Reply_Parser m_parser;
+    uint32_t m_handshake_replies = 0;
+    ::std::deque<X_Pending_Command> m_pending;
+    ::std::unordered_set<phcow_string, phcow_string::hash> m_subscriptions[3];
+    ::std::deque<Redis_Value> m_push_queue;
+    ::std::deque<push_callback_type> m_push_waiters;
+    bool m_closed = false;
+
+  protected:
+    // Sets authentication parameters. If `password` is empty, no `AUTH` is
+    // performed. If `database` is zero, no `SELECT` is performed.
+    Redis_Client_Session(const cow_string& user, const cow_string& password,
+                         uint32_t database);
+
+  private:
+    void
+    do_redis_deliver_push(Redis_Value&& message);
+
+    bool
+    do_redis_confirm_subscription(Redis_Value& message);
+
+  protected:
+    // Locks the socket, which also protects the state of this object. This
+    // shall be implemented by the socket class.
+    virtual
+    void
+    do_redis_lock_socket(recursive_mutex::unique_lock& lock)
+      = 0;
+
+    // Enqueues some bytes for sending. This shall be implemented by the socket
+    // class, with the semantics of `TCP_Socket::tcp_send()`.
+    virtual
+    bool
+    do_redis_send(const cow_string& data)
+      = 0;
+
+    // Closes the connection due to a protocol error. This shall be implemented
+    // by the socket class.
+    virtual
+    void
+    do_redis_shut_down()
+      noexcept
+      = 0;
+
+    // Enqueues handshake commands. This shall be called by the constructor of
+    // the socket class, before any other command.
+    void
+    do_redis_handshake();
+
+    // Processes incoming data. This shall be called by the stream callback of
+    // the socket class.
+    void
+    do_redis_on_stream(linear_buffer& data);
+
+    // Fails all pending commands and push waiters. This shall be called by the
+    // socket class after the connection has been closed.
+    void
+    do_redis_on_closed(int err)
+      noexcept;
+
+    // This callback is invoked by the network thread when a push message has
+    // been received.
+    // The default implementation passes it to the oldest waiter of
+    // `redis_wait_push()` that takes it; if there is none, it is queued for the
+    // next one. If too many messages have been queued, the oldest one is
+    // discarded.
+    virtual
+    void
+    do_on_redis_push(Redis_Value&& message);
+
+  public:
+    Redis_Client_Session(const Redis_Client_Session&) = delete;
+    Redis_Client_Session& operator=(const Redis_Client_Session&) & = delete;
+    virtual ~Redis_Client_Session();
+
+    // Sends a command. Commands may be sent before the connection has been
+    // established. If this function returns `true`, `callback` will be invoked
+    // exactly once with the reply, or with an error if the connection is
+    // closed before the reply arrives. If this function returns `false`, the
+    // connection will have been closed, and `callback` will not be invoked.
+    // If this function throws an exception, there is no effect.
+    // This function is thread-safe.
+    bool
+    redis_execute(const cow_vector<cow_string>& cmd, const callback_type& callback);
+
+    // Waits for the next push message. If a message has been queued, `callback`
+    // is invoked immediately by the calling thread; if the connection has been
+    // closed, `callback` is invoked immediately with an error; otherwise it is
+    // invoked by the network thread later.
+    // This function is thread-safe.
+    void
+    redis_wait_push(const push_callback_type& callback);
+  };
+
+}  // namespace poseidon
+#endif
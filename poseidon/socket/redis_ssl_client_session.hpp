@@ -0,0 +1,62 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_SOCKET_REDIS_SSL_CLIENT_SESSION_
+#define POSEIDON_SOCKET_REDIS_SSL_CLIENT_SESSION_
+
+#include "../fwd.hpp"
+#include "enums.hpp"
+#include "ssl_socket.hpp"
+#include "redis_client_session.hpp"
+namespace poseidon {
+
+class Redis_SSL_Client_Session
+  :
+    public virtual SSL_Socket,
+    public Redis_Client_Session
+  {
+  public:
+    // Constructs a socket for outgoing connections. Handshake commands are
+    // enqueued before any other command. The caller is responsible for
+    // connecting this socket, for example with a `DNS_Connect_Task`.
+    Redis_SSL_Client_Session(const cow_string& user, const cow_string& password,
+                             uint32_t database);
+
+  protected:
+    // This function implements `Abstract_Socket`.
+    virtual
+    void
+    do_abstract_socket_on_closed()
+      override;
+
+    // This function implements `SSL_Socket`.
+    virtual
+    void
+    do_on_ssl_stream(linear_buffer& data, bool eof)
+      override;
+
+    // These functions implement `Redis_Client_Session`.
+    virtual
+    void
+    do_redis_lock_socket(recursive_mutex::unique_lock& lock)
+      override;
+
+    virtual
+    bool
+    do_redis_send(const cow_string& data)
+      override;
+
+    virtual
+    void
+    do_redis_shut_down()
+      noexcept
+      override;
+
+  public:
+    Redis_SSL_Client_Session(const Redis_SSL_Client_Session&) = delete;
+    Redis_SSL_Client_Session& operator=(const Redis_SSL_Client_Session&) & = delete;
+    virtual ~Redis_SSL_Client_Session();
+  };
+
+}  // namespace poseidon
+#endif
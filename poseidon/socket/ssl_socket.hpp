@@ -21,8 +21,18 @@ class SSL_Socket
     friend class HTTPS_Client_Session;
 
     uniptr_SSL m_ssl;
+    cow_string m_alpn_proto_list;
     ::taxon::Value m_session_user_data;
 
+    static
+    int
+    do_ssl_alpn_select(::SSL* ssl, const unsigned char** out, unsigned char* outlen,
+                       const unsigned char* in, unsigned int inlen, void* arg);
+
+    static
+    int
+    do_ssl_new_session(::SSL* ssl, ::SSL_SESSION* session);
+
   protected:
     // Takes ownership of an accepted socket, using SSL configuration from
     // `scheduler`. [server-side constructor]
@@ -34,6 +44,21 @@ class SSL_Socket
     SSL_Socket(const Network_Scheduler& scheduler);
 
   protected:
+    // Sets application-layer protocols that may be negotiated with ALPN, in
+    // descending order of preference. For server-side sockets, the first one
+    // which is also offered by the client is selected; if there is none, ALPN
+    // is not acknowledged. For client-side sockets, these are offered to the
+    // server. This function must be called before the TLS handshake.
+    void
+    do_ssl_set_alpn_protocols(const cow_vector<cow_string>& protos);
+
+    // Sets a session to resume, which has been obtained from a previous
+    // connection to the same server. This avoids a full TLS handshake if the
+    // server accepts it. This function must be called before the TLS handshake
+    // of a client-side socket.
+    void
+    do_ssl_set_session(::SSL_SESSION* session);
+
     // These callbacks implement `Abstract_Socket`.
     virtual
     void
@@ -57,6 +82,15 @@ class SSL_Socket
     void
     do_on_ssl_connected();
 
+    // This callback is invoked by the network thread when a client-side socket
+    // has received a session that may be resumed later, which can happen more
+    // than once on a connection. Callees that need to keep `session` shall
+    // increment its reference count.
+    // The default implementation does nothing.
+    virtual
+    void
+    do_on_ssl_new_session(::SSL_SESSION* session);
+
     // This callback is invoked by the network thread when some bytes have been
     // received, and is intended to be overriden by derived classes.
     // The argument contains all data that have been accumulated so far. Callees
@@ -82,6 +116,12 @@ class SSL_Socket
       noexcept
       { return this->m_session_user_data;  }
 
+    // Gets the application-layer protocol that has been negotiated with ALPN.
+    // If ALPN has not been negotiated, an empty string is returned.
+    cow_string
+    alpn_protocol()
+      const;
+
     // Gets the maximum segment size (MSS) for outgoing packets.
     uint32_t
     max_segment_size()
@@ -19,6 +19,10 @@ class TCP_Socket
 
     ::taxon::Value m_session_user_data;
 
+  private:
+    bool
+    do_tcp_send(chars_view data, const cow_string* str);
+
   protected:
     // Takes ownership of an accepted socket. [server-side constructor]
     explicit
@@ -90,6 +94,14 @@ class TCP_Socket
     bool
     tcp_send(chars_view data);
 
+    // Enqueues a string for sending. This function is similar to `tcp_send()`,
+    // but if the string is large and can't be sent immediately, it is shared
+    // with the write queue instead of being copied, and it will not be
+    // modified.
+    // This function is thread-safe.
+    bool
+    tcp_send_shared(const cow_string& data);
+
     // Shuts the socket down gracefully. Errors during the shutdown operation
     // are ignored.
     // This function is thread-safe.
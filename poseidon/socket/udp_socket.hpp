@@ -17,6 +17,13 @@ class UDP_Socket
     friend class Network_Scheduler;
 
     IPv6_Address m_from_addr;
+    atomic_relaxed<bool> m_gso_failed;
+
+    // send queue; protected by the write queue mutex
+    uint32_t m_send_queue_size;
+    UDP_Drop_Policy m_drop_policy;
+    atomic_relaxed<uint64_t> m_dropped_packets;
+    atomic_relaxed<uint64_t> m_dropped_bytes;
 
   protected:
     // Creates a socket that is bound onto `addr`. [server-side constructor]
@@ -26,6 +33,11 @@ class UDP_Socket
     // Creates an unbound socket. [client-side constructor]
     UDP_Socket();
 
+  private:
+    bool
+    do_enqueue_packet_nolock(linear_buffer& queue, const IPv6_Address& addr,
+                             chars_view data);
+
   protected:
     // These callbacks implement `Abstract_Socket`.
     virtual
@@ -46,7 +58,11 @@ class UDP_Socket
     // This callback is invoked by the network thread when a packet has been
     // received, and is intended to be overriden by derived classes.
     // These arguments compose a complete packet. The `data` object may be reused
-    // for subsequent packets.
+    // for subsequent packets. Packets are received in batches, with at most
+    // `network.udp.receive_batch_size` packets per system call, and `data` is
+    // sized to fit the packet. If `network.udp.enable_gro` is set, packets that
+    // have been coalesced by the kernel are split again before this callback,
+    // so they are delivered one by one as usual.
     virtual
     void
     do_on_udp_packet(IPv6_Address&& addr, linear_buffer&& data)
@@ -74,15 +90,52 @@ class UDP_Socket
     void
     leave_multicast_group(const IPv6_Address& maddr, const cow_string& ifname);
 
+    // Sets the maximum number of bytes of packets to keep in the send queue of
+    // this socket, and how to drop packets if the queue is full. If `size` is
+    // zero, the queue is disabled, and packets that can't be sent immediately
+    // are dropped. Packets that have been enqueued are not affected.
+    // The default values are `network.udp.send_queue_size` and `network.udp.
+    // drop_policy` in 'main.conf'.
+    // This function is thread-safe.
+    void
+    udp_set_send_queue(uint32_t size, UDP_Drop_Policy policy);
+
+    // Get the number of packets and bytes that have been dropped, because the
+    // system send buffer and the send queue were both full.
+    // These functions are thread-safe.
+    uint64_t
+    udp_dropped_packets()
+      const noexcept
+      { return this->m_dropped_packets.load();  }
+
+    uint64_t
+    udp_dropped_bytes()
+      const noexcept
+      { return this->m_dropped_bytes.load();  }
+
     // Enqueues a packet for sending.
     // If this function returns `true`, data will have been enqueued; however it
     // is not guaranteed that they will arrive at the destination host. It should
     // also be noted that UDP packets may be truncated if they are too large, which
-    // is not considered errors; overflowed data are dropped silently.
+    // is not considered errors; overflowed data are dropped silently. If the
+    // system send buffer is full, the packet is appended to the send queue, and
+    // will be sent when the socket becomes writable again. If the send queue is
+    // also full, a packet is dropped according to the drop policy.
     // If this function throws an exception, there is no effect.
     // This function is thread-safe.
     bool
     udp_send(const IPv6_Address& addr, chars_view data);
+
+    // Enqueues packets for sending, as if by calling `udp_send()` for each of
+    // them, but with fewer system calls. All packets are sent to `addr`. If
+    // `network.udp.enable_gso` is set, consecutive packets of the same size are
+    // combined into a super-packet, which is segmented by the kernel or by the
+    // network interface. If GSO turns out to be unsupported by the kernel, it is
+    // disabled for this socket.
+    // Returns the number of packets that have been sent or enqueued.
+    // This function is thread-safe.
+    size_t
+    udp_send_batch(const IPv6_Address& addr, const chars_view* data, size_t count);
   };
 
 }  // namespace poseidon
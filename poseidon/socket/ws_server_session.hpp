@@ -120,6 +120,14 @@ class WS_Server_Session
     bool
     ws_send(WS_Opcode opcode, chars_view data);
 
+    // Sends a frame that has been encoded by `WebSocket_Broadcast_Frame`, so the
+    // same message can be sent to many clients without being encoded again. If
+    // PMCE is active, the frame is sent compressed if possible. If the WebSocket
+    // handshake has not completed, no data is sent and `false` is returned.
+    // This function is thread-safe.
+    bool
+    ws_send(const WebSocket_Broadcast_Frame& frame);
+
     // Sends a CLOSE frame with an optional error message, then shuts down the
     // connection. `status` may be a standard status code, or an integer within
     // [1000,4999]. Any other value is sanitized to 1008. The reason string will
@@ -0,0 +1,350 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../easy/easy_http2_server.hpp"
+#include "../../socket/tcp_acceptor.hpp"
+#include "../../static/network_scheduler.hpp"
+#include "../../fiber/abstract_fiber.hpp"
+#include "../../static/fiber_scheduler.hpp"
+#include "../../details/mpsc_queue.hpp"
+#include "../../utils.hpp"
+#include <unordered_map>
+namespace poseidon {
+namespace {
+
+struct Event
+  {
+    Easy_HTTP_Event type;
+    uint32_t stream_id = 0;
+    HTTP_C_Headers req;
+    linear_buffer data;
+    HTTP_Status status = http_status_null;
+  };
+
+struct Event_Queue
+  {
+    // shared fields between threads
+    mpsc_queue<Event> events;
+    plain_mutex fiber_mutex;
+    shptr<Abstract_Fiber> fiber;
+  };
+
+struct Session_Table
+  {
+    // read-only fields; no locking needed
+    seconds park_timeout = 0s;
+
+    // This table owns all sessions. It is only accessed when a connection is
+    // accepted or closed; events are passed via queues in sessions.
+    mutable plain_mutex mutex;
+    ::std::unordered_map<volatile HTTP2_Server_Session*, shptr<HTTP2_Server_Session>> session_map;
+  };
+
+struct Final_Fiber final : Abstract_Fiber
+  {
+    Easy_HTTP2_Server::callback_type m_callback;
+    wkptr<Session_Table> m_wsessions;
+    shptr<HTTP2_Server_Session> m_session;
+    Event_Queue* m_queue;
+
+    Final_Fiber(const Easy_HTTP2_Server::callback_type& callback,
+                const shptr<Session_Table>& sessions,
+                const shptr<HTTP2_Server_Session>& session, Event_Queue* queue)
+      :
+        m_callback(callback), m_wsessions(sessions), m_session(session),
+        m_queue(queue)
+      { }
+
+    void
+    do_detach()
+      noexcept
+      {
+        // Break the reference cycle. After this, a new event will launch a
+        // new fiber.
+        plain_mutex::unique_lock lock(this->m_queue->fiber_mutex);
+        this->m_queue->fiber = nullptr;
+      }
+
+    bool
+    do_park_idle(seconds timeout)
+      {
+        try {
+          // Wait for the next event. If it arrives in time, the network thread
+          // will unpark this fiber instead of launching a new one.
+          if((timeout > 0s) && this->park(timeout))
+            return true;
+        }
+        catch(exception& stdex) {
+          POSEIDON_LOG_ERROR(("Unhandled exception: $1"), stdex);
+        }
+
+        // Exit to release the stack, unless an event has arrived in the
+        // meantime.
+        plain_mutex::unique_lock lock(this->m_queue->fiber_mutex);
+        if(!this->m_queue->events.idle())
+          return true;
+
+        this->m_queue->fiber = nullptr;
+        return false;
+      }
+
+    virtual
+    void
+    do_on_abstract_fiber_execute()
+      override
+      {
+        for(;;) {
+          // The event callback may stop this server, so we have to check for
+          // expiry in every iteration.
+          auto sessions = this->m_wsessions.lock();
+          if(!sessions) {
+            this->do_detach();
+            return;
+          }
+
+          // Pop an event and invoke the user-defined callback here in the
+          // main thread. Exceptions are ignored. If no event is pending, park
+          // this fiber until the next one.
+          Event event;
+          if(!this->m_queue->events.pop(event)) {
+            // Don't keep the server alive when parked.
+            seconds park_timeout = sessions->park_timeout;
+            sessions = nullptr;
+
+            if(this->do_park_idle(park_timeout))
+              continue;
+
+            return;
+          }
+
+          if(ASTERIA_UNEXPECT(event.type == easy_http_close)) {
+            // This will be the last event on this session. `m_session` keeps
+            // it alive until this fiber exits.
+            plain_mutex::unique_lock lock(sessions->mutex);
+            sessions->session_map.erase(this->m_session.get());
+          }
+
+          const auto& session = this->m_session;
+          try {
+            if(event.status != http_status_null) {
+              // Send a bad request response. Other streams are not affected.
+              HTTP_S_Headers resp;
+              resp.status = event.status;
+              session->http2_response(event.stream_id, false, move(resp), "");
+            }
+            else
+              this->m_callback(session, *this, event.type, event.stream_id, move(event.req),
+                               move(event.data));
+          }
+          catch(exception& stdex) {
+            // Shut the connection down without a message.
+            POSEIDON_LOG_ERROR(("Unhandled exception: $1"), stdex);
+            session->quick_shut_down();
+          }
+
+          if(ASTERIA_UNEXPECT(event.type == easy_http_close)) {
+            // There will be no more events.
+            this->do_detach();
+            return;
+          }
+        }
+      }
+  };
+
+struct Final_Session final : HTTP2_Server_Session
+  {
+    Easy_HTTP2_Server::callback_type m_callback;
+    wkptr<Session_Table> m_wsessions;
+    wkptr<Final_Session> m_wself;
+    Event_Queue m_queue;
+
+    Final_Session(unique_posix_fd&& fd,
+                  const Easy_HTTP2_Server::callback_type& callback,
+                  const shptr<Session_Table>& sessions)
+      :
+        SSL_Socket(move(fd), network_scheduler), HTTP2_Server_Session(),
+        m_callback(callback), m_wsessions(sessions)
+      { }
+
+    void
+    do_push_event_common(Event&& event)
+      {
+        auto sessions = this->m_wsessions.lock();
+        if(!sessions)
+          return;
+
+        auto self = this->m_wself.lock();
+        if(!self)
+          return;
+
+        // We are in the network thread here.
+        try {
+          if(this->m_queue.events.push(move(event))) {
+            // Resume the fiber if it is parked, or create a new one if none
+            // exists.
+            plain_mutex::unique_lock lock(this->m_queue.fiber_mutex);
+            if(this->m_queue.fiber)
+              this->m_queue.fiber->unpark();
+            else {
+              auto fiber = new_sh<Final_Fiber>(this->m_callback, sessions, self, &(this->m_queue));
+              fiber_scheduler.launch(fiber);
+              this->m_queue.fiber = fiber;
+            }
+          }
+        }
+        catch(exception& stdex) {
+          POSEIDON_LOG_ERROR(("Could not push network event: $1"), stdex);
+          plain_mutex::unique_lock lock(sessions->mutex);
+          sessions->session_map.erase(this);
+          lock.unlock();
+          this->quick_shut_down();
+        }
+      }
+
+    virtual
+    void
+    do_on_ssl_connected()
+      override
+      {
+        Event event;
+        event.type = easy_http_open;
+        this->do_push_event_common(move(event));
+      }
+
+    virtual
+    void
+    do_on_http2_request_finish(uint32_t stream_id, HTTP_C_Headers&& req, linear_buffer&& data)
+      override
+      {
+        Event event;
+        event.type = easy_http_message;
+        event.stream_id = stream_id;
+        event.req = move(req);
+        event.data = move(data);
+        this->do_push_event_common(move(event));
+      }
+
+    virtual
+    void
+    do_on_http2_request_error(uint32_t stream_id, HTTP_Status status)
+      override
+      {
+        Event event;
+        event.type = easy_http_message;
+        event.stream_id = stream_id;
+        event.status = status;
+        this->do_push_event_common(move(event));
+      }
+
+    virtual
+    void
+    do_abstract_socket_on_closed()
+      override
+      {
+        char sbuf[1024];
+        int err_code = errno;
+        const char* err_str = ::strerror_r(err_code, sbuf, sizeof(sbuf));
+
+        Event event;
+        event.type = easy_http_close;
+        event.data.puts(err_str);
+        this->do_push_event_common(move(event));
+      }
+  };
+
+struct Final_Acceptor final : TCP_Acceptor
+  {
+    Easy_HTTP2_Server::callback_type m_callback;
+    wkptr<Session_Table> m_wsessions;
+
+    Final_Acceptor(const IPv6_Address& addr,
+                   const Easy_HTTP2_Server::callback_type& callback,
+                   const shptr<Session_Table>& sessions)
+      :
+        TCP_Acceptor(addr),
+        m_callback(callback), m_wsessions(sessions)
+      {
+      }
+
+    virtual
+    shptr<Abstract_Socket>
+    do_accept_socket_opt(IPv6_Address&& addr, unique_posix_fd&& fd)
+      override
+      {
+        auto sessions = this->m_wsessions.lock();
+        if(!sessions)
+          return nullptr;
+
+        auto session = new_sh<Final_Session>(move(fd), this->m_callback, sessions);
+        session->m_wself = session;
+        (void) addr;
+
+        // We are in the network thread here.
+        plain_mutex::unique_lock lock(sessions->mutex);
+
+        auto r = sessions->session_map.try_emplace(session.get(), session);
+        ASTERIA_ASSERT(r.second);
+        return session;
+      }
+  };
+
+}  // namespace
+
+POSEIDON_HIDDEN_X_STRUCT(Easy_HTTP2_Server,
+  Session_Table);
+
+Easy_HTTP2_Server::
+~Easy_HTTP2_Server()
+  {
+  }
+
+const IPv6_Address&
+Easy_HTTP2_Server::
+local_address()
+  const noexcept
+  {
+    if(!this->m_acceptor)
+      return ipv6_unspecified;
+
+    return this->m_acceptor->local_address();
+  }
+
+shptr<TCP_Acceptor>
+Easy_HTTP2_Server::
+start(const IPv6_Address& addr, const callback_type& callback)
+  {
+    auto sessions = new_sh<X_Session_Table>();
+    sessions->park_timeout = fiber_scheduler.park_timeout();
+    auto acceptor = new_sh<Final_Acceptor>(addr, callback, sessions);
+
+    network_scheduler.insert_weak(acceptor);
+    this->m_sessions = move(sessions);
+    this->m_acceptor = acceptor;
+    return acceptor;
+  }
+
+shptr<TCP_Acceptor>
+Easy_HTTP2_Server::
+start(const cow_string& addr, const callback_type& callback)
+  {
+    return this->start(IPv6_Address(addr), callback);
+  }
+
+shptr<TCP_Acceptor>
+Easy_HTTP2_Server::
+start(uint16_t port, const callback_type& callback)
+  {
+    return this->start(IPv6_Address(ipv6_unspecified, port), callback);
+  }
+
+void
+Easy_HTTP2_Server::
+stop()
+  noexcept
+  {
+    this->m_sessions = nullptr;
+    this->m_acceptor = nullptr;
+  }
+
+}  // namespace poseidon
@@ -7,8 +7,8 @@
 #include "../../static/network_scheduler.hpp"
 #include "../../fiber/abstract_fiber.hpp"
 #include "../../static/fiber_scheduler.hpp"
+#include "../../details/mpsc_queue.hpp"
 #include "../../utils.hpp"
-#include <deque>
 #include <unordered_map>
 namespace poseidon {
 namespace {
@@ -18,6 +18,7 @@ struct Event
     Easy_HTTP_Event type;
     HTTP_C_Headers req;
     linear_buffer data;
+    shptr<linear_buffer> chunk;
     bool eot = false;
     bool method_was_head = false;
     HTTP_Status status = http_status_null;
@@ -25,34 +26,77 @@ struct Event
 
 struct Event_Queue
   {
-    // read-only fields; no locking needed
-    shptr<HTTP_Server_Session> session;
-    cacheline_barrier xcb_1;
-
     // shared fields between threads
-    ::std::deque<Event> events;
-    bool fiber_active = false;
+    mpsc_queue<Event> events;
+    plain_mutex fiber_mutex;
+    shptr<Abstract_Fiber> fiber;
+    plain_mutex chunk_mutex;
+    shptr<linear_buffer> open_chunk;
+    size_t chunk_bytes = 0;
+    bool read_paused = false;
   };
 
 struct Session_Table
   {
+    // read-only fields; no locking needed
+    bool payload_streaming = false;
+    uint32_t throttle_size = 0;
+    seconds park_timeout = 0s;
+
+    // This table owns all sessions. It is only accessed when a connection is
+    // accepted or closed; events are passed via queues in sessions.
     mutable plain_mutex mutex;
-    ::std::unordered_map<volatile HTTP_Server_Session*, Event_Queue> session_map;
+    ::std::unordered_map<volatile HTTP_Server_Session*, shptr<HTTP_Server_Session>> session_map;
   };
 
 struct Final_Fiber final : Abstract_Fiber
   {
     Easy_HTTP_Server::callback_type m_callback;
     wkptr<Session_Table> m_wsessions;
-    volatile HTTP_Server_Session* m_refptr;
+    shptr<HTTP_Server_Session> m_session;
+    Event_Queue* m_queue;
 
     Final_Fiber(const Easy_HTTP_Server::callback_type& callback,
                 const shptr<Session_Table>& sessions,
-                volatile HTTP_Server_Session* refptr)
+                const shptr<HTTP_Server_Session>& session, Event_Queue* queue)
       :
-        m_callback(callback), m_wsessions(sessions), m_refptr(refptr)
+        m_callback(callback), m_wsessions(sessions), m_session(session),
+        m_queue(queue)
       { }
 
+    void
+    do_detach()
+      noexcept
+      {
+        // Break the reference cycle. After this, a new event will launch a
+        // new fiber.
+        plain_mutex::unique_lock lock(this->m_queue->fiber_mutex);
+        this->m_queue->fiber = nullptr;
+      }
+
+    bool
+    do_park_idle(seconds timeout)
+      {
+        try {
+          // Wait for the next event. If it arrives in time, the network thread
+          // will unpark this fiber instead of launching a new one.
+          if((timeout > 0s) && this->park(timeout))
+            return true;
+        }
+        catch(exception& stdex) {
+          POSEIDON_LOG_ERROR(("Unhandled exception: $1"), stdex);
+        }
+
+        // Exit to release the stack, unless an event has arrived in the
+        // meantime.
+        plain_mutex::unique_lock lock(this->m_queue->fiber_mutex);
+        if(!this->m_queue->events.idle())
+          return true;
+
+        this->m_queue->fiber = nullptr;
+        return false;
+      }
+
     virtual
     void
     do_on_abstract_fiber_execute()
@@ -62,40 +106,58 @@ struct Final_Fiber final : Abstract_Fiber
           // The event callback may stop this server, so we have to check for
           // expiry in every iteration.
           auto sessions = this->m_wsessions.lock();
-          if(!sessions)
+          if(!sessions) {
+            this->do_detach();
             return;
+          }
 
           // Pop an event and invoke the user-defined callback here in the
-          // main thread. Exceptions are ignored.
-          plain_mutex::unique_lock lock(sessions->mutex);
+          // main thread. Exceptions are ignored. If no event is pending, park
+          // this fiber until the next one.
+          Event event;
+          if(!this->m_queue->events.pop(event)) {
+            // Don't keep the server alive when parked.
+            seconds park_timeout = sessions->park_timeout;
+            sessions = nullptr;
 
-          auto session_iter = sessions->session_map.find(this->m_refptr);
-          if(session_iter == sessions->session_map.end())
-            return;
+            if(this->do_park_idle(park_timeout))
+              continue;
 
-          if(session_iter->second.events.empty()) {
-            // Terminate now.
-            session_iter->second.fiber_active = false;
             return;
           }
 
-          // After `sessions->mutex` is unlocked, other threads may modify
-          // `sessions->session_map` and invalidate all iterators, so maintain a
-          // reference outside it for safety.
-          auto queue = &(session_iter->second);
-          ASTERIA_ASSERT(queue->fiber_active);
-          auto session = queue->session;
-          auto event = move(queue->events.front());
-          queue->events.pop_front();
+          if(event.type == easy_http_payload) {
+            // Take data away from the chunk. If it is still open, further data
+            // will go into a new one.
+            plain_mutex::unique_lock lock(this->m_queue->chunk_mutex);
+            if(this->m_queue->open_chunk == event.chunk)
+              this->m_queue->open_chunk = nullptr;
+
+            event.data.swap(*(event.chunk));
+            this->m_queue->chunk_bytes -= event.data.size();
+
+            // If reading has been paused because of too many pending bytes,
+            // resume it when half of them have been consumed.
+            bool resume_reading = false;
+            if(this->m_queue->read_paused
+               && (this->m_queue->chunk_bytes <= sessions->throttle_size / 2)) {
+              this->m_queue->read_paused = false;
+              resume_reading = true;
+            }
+            lock.unlock();
+
+            if(resume_reading)
+              network_scheduler.pause_reading(*(this->m_session), false);
+          }
 
           if(ASTERIA_UNEXPECT(event.type == easy_http_close)) {
-            // This will be the last event on this session.
-            queue = nullptr;
-            sessions->session_map.erase(session_iter);
+            // This will be the last event on this session. `m_session` keeps
+            // it alive until this fiber exits.
+            plain_mutex::unique_lock lock(sessions->mutex);
+            sessions->session_map.erase(this->m_session.get());
           }
-          session_iter = sessions->session_map.end();
-          lock.unlock();
 
+          const auto& session = this->m_session;
           try {
             if(event.status != http_status_null) {
               // Send a bad request response.
@@ -118,6 +180,12 @@ struct Final_Fiber final : Abstract_Fiber
             POSEIDON_LOG_ERROR(("Unhandled exception: $1"), stdex);
             session->quick_shut_down();
           }
+
+          if(ASTERIA_UNEXPECT(event.type == easy_http_close)) {
+            // There will be no more events.
+            this->do_detach();
+            return;
+          }
         }
       }
   };
@@ -126,13 +194,17 @@ struct Final_Session final : HTTP_Server_Session
   {
     Easy_HTTP_Server::callback_type m_callback;
     wkptr<Session_Table> m_wsessions;
+    wkptr<Final_Session> m_wself;
+    bool m_payload_streaming;
+    Event_Queue m_queue;
 
     Final_Session(unique_posix_fd&& fd,
                   const Easy_HTTP_Server::callback_type& callback,
                   const shptr<Session_Table>& sessions)
       :
         TCP_Socket(move(fd)), HTTP_Server_Session(),
-        m_callback(callback), m_wsessions(sessions)
+        m_callback(callback), m_wsessions(sessions),
+        m_payload_streaming(sessions->payload_streaming)
       { }
 
     void
@@ -142,26 +214,37 @@ struct Final_Session final : HTTP_Server_Session
         if(!sessions)
           return;
 
-        // We are in the network thread here.
-        plain_mutex::unique_lock lock(sessions->mutex);
-
-        auto session_iter = sessions->session_map.find(this);
-        if(session_iter == sessions->session_map.end())
+        auto self = this->m_wself.lock();
+        if(!self)
           return;
 
+        if(event.type != easy_http_payload) {
+          // Close the current chunk, so data after this event will not be
+          // delivered before it.
+          plain_mutex::unique_lock lock(this->m_queue.chunk_mutex);
+          this->m_queue.open_chunk = nullptr;
+        }
+
+        // We are in the network thread here.
         try {
-          if(!session_iter->second.fiber_active) {
-            // Create a new fiber, if none is active. The fiber shall only reset
-            // `m_fiber_private_buffer` if no event is pending.
-            fiber_scheduler.launch(new_sh<Final_Fiber>(this->m_callback, sessions, this));
-            session_iter->second.fiber_active = true;
+          if(this->m_queue.events.push(move(event))) {
+            // Resume the fiber if it is parked, or create a new one if none
+            // exists.
+            plain_mutex::unique_lock lock(this->m_queue.fiber_mutex);
+            if(this->m_queue.fiber)
+              this->m_queue.fiber->unpark();
+            else {
+              auto fiber = new_sh<Final_Fiber>(this->m_callback, sessions, self, &(this->m_queue));
+              fiber_scheduler.launch(fiber);
+              this->m_queue.fiber = fiber;
+            }
           }
-
-          session_iter->second.events.push_back(move(event));
         }
         catch(exception& stdex) {
           POSEIDON_LOG_ERROR(("Could not push network event: $1"), stdex);
-          sessions->session_map.erase(session_iter);
+          plain_mutex::unique_lock lock(sessions->mutex);
+          sessions->session_map.erase(this);
+          lock.unlock();
           this->quick_shut_down();
         }
       }
@@ -176,6 +259,74 @@ struct Final_Session final : HTTP_Server_Session
         this->do_push_event_common(move(event));
       }
 
+    virtual
+    HTTP_Payload_Type
+    do_on_http_request_headers(HTTP_C_Headers& req, bool eot)
+      override
+      {
+        auto payload_type = this->HTTP_Server_Session::do_on_http_request_headers(req, eot);
+        if(!this->m_payload_streaming || req.is_proxy)
+          return payload_type;
+
+        Event event;
+        event.type = easy_http_headers;
+        event.req = req;
+        this->do_push_event_common(move(event));
+        return payload_type;
+      }
+
+    virtual
+    void
+    do_on_http_request_payload_stream(linear_buffer& data)
+      override
+      {
+        if(!this->m_payload_streaming) {
+          this->HTTP_Server_Session::do_on_http_request_payload_stream(data);
+          return;
+        }
+
+        // Take all data away, so the request payload will not accumulate.
+        if(data.empty())
+          return;
+
+        auto sessions = this->m_wsessions.lock();
+        if(!sessions)
+          return;
+
+        // We are in the network thread here.
+        plain_mutex::unique_lock lock(this->m_queue.chunk_mutex);
+
+        // If the consumer can't keep up with the client, stop reading until
+        // some data have been consumed. We are in the network thread and the
+        // socket has been locked, so this will not deadlock.
+        this->m_queue.chunk_bytes += data.size();
+        if(!this->m_queue.read_paused && (this->m_queue.chunk_bytes > sessions->throttle_size)) {
+          this->m_queue.read_paused = true;
+          network_scheduler.pause_reading(*this, true);
+        }
+
+        if(this->m_queue.open_chunk) {
+          // The last chunk has not been taken by the fiber yet, so append data
+          // to it, and there is no need to push another event.
+          this->m_queue.open_chunk->putn(data.data(), data.size());
+          data.clear();
+          return;
+        }
+
+        // Copy data into a new chunk, so the payload buffer stays with the
+        // parser and can be reused, and the chunk only holds what it needs.
+        auto chunk = new_sh<linear_buffer>();
+        chunk->putn(data.data(), data.size());
+        data.clear();
+        this->m_queue.open_chunk = chunk;
+        lock.unlock();
+
+        Event event;
+        event.type = easy_http_payload;
+        event.chunk = move(chunk);
+        this->do_push_event_common(move(event));
+      }
+
     virtual
     void
     do_on_http_request_finish(HTTP_C_Headers&& req, linear_buffer&& data, bool eot)
@@ -195,6 +346,7 @@ struct Final_Session final : HTTP_Server_Session
       override
       {
         Event event;
+        event.type = easy_http_message;
         event.eot = true;
         event.method_was_head = method_was_head;
         event.status = status;
@@ -241,14 +393,14 @@ struct Final_Acceptor final : TCP_Acceptor
           return nullptr;
 
         auto session = new_sh<Final_Session>(move(fd), this->m_callback, sessions);
+        session->m_wself = session;
         (void) addr;
 
         // We are in the network thread here.
         plain_mutex::unique_lock lock(sessions->mutex);
 
-        auto r = sessions->session_map.try_emplace(session.get());
+        auto r = sessions->session_map.try_emplace(session.get(), session);
         ASTERIA_ASSERT(r.second);
-        r.first->second.session = session;
         return session;
       }
   };
@@ -279,6 +431,9 @@ Easy_HTTP_Server::
 start(const IPv6_Address& addr, const callback_type& callback)
   {
     auto sessions = new_sh<X_Session_Table>();
+    sessions->park_timeout = fiber_scheduler.park_timeout();
+    sessions->payload_streaming = this->m_payload_streaming;
+    sessions->throttle_size = network_scheduler.throttle_size();
     auto acceptor = new_sh<Final_Acceptor>(addr, callback, sessions);
 
     network_scheduler.insert_weak(acceptor);
@@ -178,9 +178,13 @@ struct Final_Socket final : TCP_Socket
     do_on_tcp_stream(linear_buffer& data, bool eof)
       override
       {
+        // `data` is the read queue of the socket, whose storage may have been
+        // borrowed from the network thread, so copy data out instead of taking
+        // it away.
         Event event;
         event.type = easy_stream_data;
-        event.data.swap(data);
+        event.data.putn(data.data(), data.size());
+        data.clear();
         event.code = eof;
         this->do_push_event_common(move(event));
       }
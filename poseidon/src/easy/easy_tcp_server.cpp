@@ -7,8 +7,8 @@
 #include "../../static/network_scheduler.hpp"
 #include "../../fiber/abstract_fiber.hpp"
 #include "../../static/fiber_scheduler.hpp"
+#include "../../details/mpsc_queue.hpp"
 #include "../../utils.hpp"
-#include <deque>
 #include <unordered_map>
 namespace poseidon {
 namespace {
@@ -17,42 +17,86 @@ struct Event
   {
     Easy_Stream_Event type;
     linear_buffer data;
+    shptr<linear_buffer> chunk;
     int code = 0;
   };
 
 struct Event_Queue
   {
-    // read-only fields; no locking needed
-    shptr<TCP_Socket> socket;
-    cacheline_barrier xcb_1;
-
     // fiber-private fields; no locking needed
     linear_buffer data_stream;
-    cacheline_barrier xcb_2;
+    cacheline_barrier xcb_1;
 
     // shared fields between threads
-    ::std::deque<Event> events;
-    bool fiber_active = false;
+    mpsc_queue<Event> events;
+    plain_mutex fiber_mutex;
+    shptr<Abstract_Fiber> fiber;
+    plain_mutex chunk_mutex;
+    shptr<linear_buffer> open_chunk;
+    size_t chunk_bytes = 0;
+    bool read_paused = false;
   };
 
 struct Session_Table
   {
+    // read-only fields; no locking needed
+    uint32_t throttle_size = 0;
+    seconds park_timeout = 0s;
+
+    // This table owns all sockets. It is only accessed when a connection is
+    // accepted or closed; events are passed via queues in sockets.
     mutable plain_mutex mutex;
-    ::std::unordered_map<volatile TCP_Socket*, Event_Queue> session_map;
+    ::std::unordered_map<volatile TCP_Socket*, shptr<TCP_Socket>> session_map;
   };
 
 struct Final_Fiber final : Abstract_Fiber
   {
     Easy_TCP_Server::callback_type m_callback;
     wkptr<Session_Table> m_wsessions;
-    volatile TCP_Socket* m_refptr;
+    shptr<TCP_Socket> m_socket;
+    Event_Queue* m_queue;
 
     Final_Fiber(const Easy_TCP_Server::callback_type& callback,
-                const shptr<Session_Table>& sessions, volatile TCP_Socket* refptr)
+                const shptr<Session_Table>& sessions, const shptr<TCP_Socket>& socket,
+                Event_Queue* queue)
       :
-        m_callback(callback), m_wsessions(sessions), m_refptr(refptr)
+        m_callback(callback), m_wsessions(sessions), m_socket(socket),
+        m_queue(queue)
       { }
 
+    void
+    do_detach()
+      noexcept
+      {
+        // Break the reference cycle. After this, a new event will launch a
+        // new fiber.
+        plain_mutex::unique_lock lock(this->m_queue->fiber_mutex);
+        this->m_queue->fiber = nullptr;
+      }
+
+    bool
+    do_park_idle(seconds timeout)
+      {
+        try {
+          // Wait for the next event. If it arrives in time, the network thread
+          // will unpark this fiber instead of launching a new one.
+          if((timeout > 0s) && this->park(timeout))
+            return true;
+        }
+        catch(exception& stdex) {
+          POSEIDON_LOG_ERROR(("Unhandled exception: $1"), stdex);
+        }
+
+        // Exit to release the stack, unless an event has arrived in the
+        // meantime.
+        plain_mutex::unique_lock lock(this->m_queue->fiber_mutex);
+        if(!this->m_queue->events.idle())
+          return true;
+
+        this->m_queue->fiber = nullptr;
+        return false;
+      }
+
     virtual
     void
     do_on_abstract_fiber_execute()
@@ -62,39 +106,56 @@ struct Final_Fiber final : Abstract_Fiber
           // The event callback may stop this server, so we have to check for
           // expiry in every iteration.
           auto sessions = this->m_wsessions.lock();
-          if(!sessions)
+          if(!sessions) {
+            this->do_detach();
             return;
+          }
 
           // Pop an event and invoke the user-defined callback here in the
-          // main thread. Exceptions are ignored.
-          plain_mutex::unique_lock lock(sessions->mutex);
+          // main thread. Exceptions are ignored. If no event is pending, park
+          // this fiber until the next one.
+          Event event;
+          if(!this->m_queue->events.pop(event)) {
+            // Don't keep the server alive when parked.
+            seconds park_timeout = sessions->park_timeout;
+            sessions = nullptr;
 
-          auto session_iter = sessions->session_map.find(this->m_refptr);
-          if(session_iter == sessions->session_map.end())
-            return;
+            if(this->do_park_idle(park_timeout))
+              continue;
 
-          if(session_iter->second.events.empty()) {
-            // Terminate now.
-            session_iter->second.fiber_active = false;
             return;
           }
 
-          // After `sessions->mutex` is unlocked, other threads may modify
-          // `sessions->session_map` and invalidate all iterators, so maintain a
-          // reference outside it for safety.
-          auto queue = &(session_iter->second);
-          ASTERIA_ASSERT(queue->fiber_active);
-          auto socket = queue->socket;
-          auto event = move(queue->events.front());
-          queue->events.pop_front();
-
           if(ASTERIA_UNEXPECT(event.type == easy_stream_close)) {
-            // This will be the last event on this socket.
-            queue = nullptr;
-            sessions->session_map.erase(session_iter);
+            // This will be the last event on this socket. `m_socket` keeps it
+            // alive until this fiber exits.
+            plain_mutex::unique_lock lock(sessions->mutex);
+            sessions->session_map.erase(this->m_socket.get());
+          }
+
+          if(event.type == easy_stream_data) {
+            // Take data away from the chunk. If it is still open, further data
+            // will go into a new one.
+            plain_mutex::unique_lock lock(this->m_queue->chunk_mutex);
+            if(this->m_queue->open_chunk == event.chunk)
+              this->m_queue->open_chunk = nullptr;
+
+            event.data.swap(*(event.chunk));
+            this->m_queue->chunk_bytes -= event.data.size();
+
+            // If reading has been paused because of too many pending bytes,
+            // resume it when half of them have been consumed.
+            bool resume_reading = false;
+            if(this->m_queue->read_paused
+               && (this->m_queue->chunk_bytes <= sessions->throttle_size / 2)) {
+              this->m_queue->read_paused = false;
+              resume_reading = true;
+            }
+            lock.unlock();
+
+            if(resume_reading)
+              network_scheduler.pause_reading(*(this->m_socket), false);
           }
-          session_iter = sessions->session_map.end();
-          lock.unlock();
 
           try {
             // `easy_stream_data` is really special. We append new data to
@@ -102,17 +163,23 @@ struct Final_Fiber final : Abstract_Fiber
             // `event.data`. `data_stream` may be consumed partially by user code,
             // and shall be preserved across callbacks.
             if(event.type == easy_stream_data)
-              this->m_callback(socket, *this, event.type,
-                     splice_buffers(queue->data_stream, move(event.data)), event.code);
+              this->m_callback(this->m_socket, *this, event.type,
+                     splice_buffers(this->m_queue->data_stream, move(event.data)), event.code);
             else
-              this->m_callback(socket, *this, event.type, event.data, event.code);
+              this->m_callback(this->m_socket, *this, event.type, event.data, event.code);
           }
           catch(exception& stdex) {
             // Shut the connection down asynchronously. Pending output data
             // are discarded, but the user-defined callback will still be called
             // for remaining input data, in case there is something useful.
             POSEIDON_LOG_ERROR(("Unhandled exception: $1"), stdex);
-            socket->quick_shut_down();
+            this->m_socket->quick_shut_down();
+          }
+
+          if(ASTERIA_UNEXPECT(event.type == easy_stream_close)) {
+            // There will be no more events.
+            this->do_detach();
+            return;
           }
         }
       }
@@ -122,6 +189,8 @@ struct Final_Socket final : TCP_Socket
   {
     Easy_TCP_Server::callback_type m_callback;
     wkptr<Session_Table> m_wsessions;
+    wkptr<Final_Socket> m_wself;
+    Event_Queue m_queue;
 
     Final_Socket(unique_posix_fd&& fd,
                  const Easy_TCP_Server::callback_type& callback,
@@ -138,26 +207,30 @@ struct Final_Socket final : TCP_Socket
         if(!sessions)
           return;
 
-        // We are in the network thread here.
-        plain_mutex::unique_lock lock(sessions->mutex);
-
-        auto session_iter = sessions->session_map.find(this);
-        if(session_iter == sessions->session_map.end())
+        auto self = this->m_wself.lock();
+        if(!self)
           return;
 
+        // We are in the network thread here.
         try {
-          if(!session_iter->second.fiber_active) {
-            // Create a new fiber, if none is active. The fiber shall only reset
-            // `m_fiber_private_buffer` if no event is pending.
-            fiber_scheduler.launch(new_sh<Final_Fiber>(this->m_callback, sessions, this));
-            session_iter->second.fiber_active = true;
+          if(this->m_queue.events.push(move(event))) {
+            // Resume the fiber if it is parked, or create a new one if none
+            // exists.
+            plain_mutex::unique_lock lock(this->m_queue.fiber_mutex);
+            if(this->m_queue.fiber)
+              this->m_queue.fiber->unpark();
+            else {
+              auto fiber = new_sh<Final_Fiber>(this->m_callback, sessions, self, &(this->m_queue));
+              fiber_scheduler.launch(fiber);
+              this->m_queue.fiber = fiber;
+            }
           }
-
-          session_iter->second.events.push_back(move(event));
         }
         catch(exception& stdex) {
           POSEIDON_LOG_ERROR(("Could not push network event: $1"), stdex);
-          sessions->session_map.erase(session_iter);
+          plain_mutex::unique_lock lock(sessions->mutex);
+          sessions->session_map.erase(this);
+          lock.unlock();
           this->quick_shut_down();
         }
       }
@@ -177,9 +250,42 @@ struct Final_Socket final : TCP_Socket
     do_on_tcp_stream(linear_buffer& data, bool eof)
       override
       {
+        auto sessions = this->m_wsessions.lock();
+        if(!sessions)
+          return;
+
+        // We are in the network thread here.
+        plain_mutex::unique_lock lock(this->m_queue.chunk_mutex);
+
+        // If the consumer can't keep up with the client, stop reading until
+        // some data have been consumed. We are in the network thread and the
+        // socket has been locked, so this will not deadlock.
+        this->m_queue.chunk_bytes += data.size();
+        if(!this->m_queue.read_paused && (this->m_queue.chunk_bytes > sessions->throttle_size)) {
+          this->m_queue.read_paused = true;
+          network_scheduler.pause_reading(*this, true);
+        }
+
+        if(this->m_queue.open_chunk && !eof) {
+          // The last chunk has not been taken by the fiber yet, so append data
+          // to it, and there is no need to push another event.
+          this->m_queue.open_chunk->putn(data.data(), data.size());
+          data.clear();
+          return;
+        }
+
+        // Start a new chunk. The end of stream closes it. `data` is the read
+        // queue of the socket, whose storage may have been borrowed from the
+        // network thread, so copy data out instead of taking it away.
+        auto chunk = new_sh<linear_buffer>();
+        chunk->putn(data.data(), data.size());
+        data.clear();
+        this->m_queue.open_chunk = eof ? nullptr : chunk;
+        lock.unlock();
+
         Event event;
         event.type = easy_stream_data;
-        event.data.swap(data);
+        event.chunk = move(chunk);
         event.code = eof;
         this->do_push_event_common(move(event));
       }
@@ -224,14 +330,14 @@ struct Final_Acceptor final : TCP_Acceptor
           return nullptr;
 
         auto socket = new_sh<Final_Socket>(move(fd), this->m_callback, sessions);
+        socket->m_wself = socket;
         (void) addr;
 
         // We are in the network thread here.
         plain_mutex::unique_lock lock(sessions->mutex);
 
-        auto r = sessions->session_map.try_emplace(socket.get());
+        auto r = sessions->session_map.try_emplace(socket.get(), socket);
         ASTERIA_ASSERT(r.second);
-        r.first->second.socket = socket;
         return socket;
       }
   };
@@ -262,6 +368,8 @@ Easy_TCP_Server::
 start(const IPv6_Address& addr, const callback_type& callback)
   {
     auto sessions = new_sh<X_Session_Table>();
+    sessions->park_timeout = fiber_scheduler.park_timeout();
+    sessions->throttle_size = network_scheduler.throttle_size();
     auto acceptor = new_sh<Final_Acceptor>(addr, callback, sessions);
 
     network_scheduler.insert_weak(acceptor);
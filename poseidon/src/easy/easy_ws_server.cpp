@@ -7,9 +7,10 @@
 #include "../../static/network_scheduler.hpp"
 #include "../../fiber/abstract_fiber.hpp"
 #include "../../static/fiber_scheduler.hpp"
+#include "../../details/mpsc_queue.hpp"
 #include "../../utils.hpp"
-#include <deque>
 #include <unordered_map>
+#include <vector>
 namespace poseidon {
 namespace {
 
@@ -21,34 +22,71 @@ struct Event
 
 struct Event_Queue
   {
-    // read-only fields; no locking needed
-    shptr<WS_Server_Session> session;
-    cacheline_barrier xcb_1;
-
     // shared fields between threads
-    ::std::deque<Event> events;
-    bool fiber_active = false;
+    mpsc_queue<Event> events;
+    plain_mutex fiber_mutex;
+    shptr<Abstract_Fiber> fiber;
   };
 
 struct Session_Table
   {
+    // read-only fields; no locking needed
+    seconds park_timeout = 0s;
+
+    // This table owns all sessions. It is only accessed when a connection is
+    // accepted or closed; events are passed via queues in sessions.
     mutable plain_mutex mutex;
-    ::std::unordered_map<volatile WS_Server_Session*, Event_Queue> session_map;
+    ::std::unordered_map<volatile WS_Server_Session*, shptr<WS_Server_Session>> session_map;
   };
 
 struct Final_Fiber final : Abstract_Fiber
   {
     Easy_WS_Server::callback_type m_callback;
     wkptr<Session_Table> m_wsessions;
-    volatile WS_Server_Session* m_refptr;
+    shptr<WS_Server_Session> m_session;
+    Event_Queue* m_queue;
 
     Final_Fiber(const Easy_WS_Server::callback_type& callback,
                 const shptr<Session_Table>& sessions,
-                volatile WS_Server_Session* refptr)
+                const shptr<WS_Server_Session>& session, Event_Queue* queue)
       :
-        m_callback(callback), m_wsessions(sessions), m_refptr(refptr)
+        m_callback(callback), m_wsessions(sessions), m_session(session),
+        m_queue(queue)
       { }
 
+    void
+    do_detach()
+      noexcept
+      {
+        // Break the reference cycle. After this, a new event will launch a
+        // new fiber.
+        plain_mutex::unique_lock lock(this->m_queue->fiber_mutex);
+        this->m_queue->fiber = nullptr;
+      }
+
+    bool
+    do_park_idle(seconds timeout)
+      {
+        try {
+          // Wait for the next event. If it arrives in time, the network thread
+          // will unpark this fiber instead of launching a new one.
+          if((timeout > 0s) && this->park(timeout))
+            return true;
+        }
+        catch(exception& stdex) {
+          POSEIDON_LOG_ERROR(("Unhandled exception: $1"), stdex);
+        }
+
+        // Exit to release the stack, unless an event has arrived in the
+        // meantime.
+        plain_mutex::unique_lock lock(this->m_queue->fiber_mutex);
+        if(!this->m_queue->events.idle())
+          return true;
+
+        this->m_queue->fiber = nullptr;
+        return false;
+      }
+
     virtual
     void
     do_on_abstract_fiber_execute()
@@ -58,40 +96,34 @@ struct Final_Fiber final : Abstract_Fiber
           // The event callback may stop this server, so we have to check for
           // expiry in every iteration.
           auto sessions = this->m_wsessions.lock();
-          if(!sessions)
+          if(!sessions) {
+            this->do_detach();
             return;
+          }
 
           // Pop an event and invoke the user-defined callback here in the
-          // main thread. Exceptions are ignored.
-          plain_mutex::unique_lock lock(sessions->mutex);
+          // main thread. Exceptions are ignored. If no event is pending, park
+          // this fiber until the next one.
+          Event event;
+          if(!this->m_queue->events.pop(event)) {
+            // Don't keep the server alive when parked.
+            seconds park_timeout = sessions->park_timeout;
+            sessions = nullptr;
 
-          auto session_iter = sessions->session_map.find(this->m_refptr);
-          if(session_iter == sessions->session_map.end())
-            return;
+            if(this->do_park_idle(park_timeout))
+              continue;
 
-          if(session_iter->second.events.empty()) {
-            // Terminate now.
-            session_iter->second.fiber_active = false;
             return;
           }
 
-          // After `sessions->mutex` is unlocked, other threads may modify
-          // `sessions->session_map` and invalidate all iterators, so maintain a
-          // reference outside it for safety.
-          auto queue = &(session_iter->second);
-          ASTERIA_ASSERT(queue->fiber_active);
-          auto session = queue->session;
-          auto event = move(queue->events.front());
-          queue->events.pop_front();
-
           if(ASTERIA_UNEXPECT(event.type == easy_ws_close)) {
-            // This will be the last event on this session.
-            queue = nullptr;
-            sessions->session_map.erase(session_iter);
+            // This will be the last event on this session. `m_session` keeps
+            // it alive until this fiber exits.
+            plain_mutex::unique_lock lock(sessions->mutex);
+            sessions->session_map.erase(this->m_session.get());
           }
-          session_iter = sessions->session_map.end();
-          lock.unlock();
 
+          const auto& session = this->m_session;
           try {
             // Process a message.
             this->m_callback(session, *this, event.type, move(event.data));
@@ -101,6 +133,12 @@ struct Final_Fiber final : Abstract_Fiber
             POSEIDON_LOG_ERROR(("Unhandled exception: $1"), stdex);
             session->ws_shut_down(ws_status_unexpected_error);
           }
+
+          if(ASTERIA_UNEXPECT(event.type == easy_ws_close)) {
+            // There will be no more events.
+            this->do_detach();
+            return;
+          }
         }
       }
   };
@@ -109,6 +147,8 @@ struct Final_Session final : WS_Server_Session
   {
     Easy_WS_Server::callback_type m_callback;
     wkptr<Session_Table> m_wsessions;
+    wkptr<Final_Session> m_wself;
+    Event_Queue m_queue;
 
     Final_Session(unique_posix_fd&& fd,
                   const Easy_WS_Server::callback_type& callback,
@@ -125,26 +165,30 @@ struct Final_Session final : WS_Server_Session
         if(!sessions)
           return;
 
-        // We are in the network thread here.
-        plain_mutex::unique_lock lock(sessions->mutex);
-
-        auto session_iter = sessions->session_map.find(this);
-        if(session_iter == sessions->session_map.end())
+        auto self = this->m_wself.lock();
+        if(!self)
           return;
 
+        // We are in the network thread here.
         try {
-          if(!session_iter->second.fiber_active) {
-            // Create a new fiber, if none is active. The fiber shall only reset
-            // `m_fiber_private_buffer` if no event is pending.
-            fiber_scheduler.launch(new_sh<Final_Fiber>(this->m_callback, sessions, this));
-            session_iter->second.fiber_active = true;
+          if(this->m_queue.events.push(move(event))) {
+            // Resume the fiber if it is parked, or create a new one if none
+            // exists.
+            plain_mutex::unique_lock lock(this->m_queue.fiber_mutex);
+            if(this->m_queue.fiber)
+              this->m_queue.fiber->unpark();
+            else {
+              auto fiber = new_sh<Final_Fiber>(this->m_callback, sessions, self, &(this->m_queue));
+              fiber_scheduler.launch(fiber);
+              this->m_queue.fiber = fiber;
+            }
           }
-
-          session_iter->second.events.push_back(move(event));
         }
         catch(exception& stdex) {
           POSEIDON_LOG_ERROR(("Could not push network event: $1"), stdex);
-          sessions->session_map.erase(session_iter);
+          plain_mutex::unique_lock lock(sessions->mutex);
+          sessions->session_map.erase(this);
+          lock.unlock();
           this->quick_shut_down();
         }
       }
@@ -220,14 +264,14 @@ struct Final_Acceptor final : TCP_Acceptor
           return nullptr;
 
         auto session = new_sh<Final_Session>(move(fd), this->m_callback, sessions);
+        session->m_wself = session;
         (void) addr;
 
         // We are in the network thread here.
         plain_mutex::unique_lock lock(sessions->mutex);
 
-        auto r = sessions->session_map.try_emplace(session.get());
+        auto r = sessions->session_map.try_emplace(session.get(), session);
         ASTERIA_ASSERT(r.second);
-        r.first->second.session = session;
         return session;
       }
   };
@@ -258,6 +302,7 @@ Easy_WS_Server::
 start(const IPv6_Address& addr, const callback_type& callback)
   {
     auto sessions = new_sh<X_Session_Table>();
+    sessions->park_timeout = fiber_scheduler.park_timeout();
     auto acceptor = new_sh<Final_Acceptor>(addr, callback, sessions);
 
     network_scheduler.insert_weak(acceptor);
@@ -280,6 +325,30 @@ start(uint16_t port, const callback_type& callback)
     return this->start(IPv6_Address(ipv6_unspecified, port), callback);
   }
 
+size_t
+Easy_WS_Server::
+broadcast(const WebSocket_Broadcast_Frame& frame)
+  {
+    if(!this->m_sessions)
+      return 0;
+
+    // Take a snapshot of all sessions, so the table is not locked when data are
+    // being sent, which requires the I/O mutex of each session.
+    ::std::vector<shptr<WS_Server_Session>> sessions;
+    plain_mutex::unique_lock lock(this->m_sessions->mutex);
+    sessions.reserve(this->m_sessions->session_map.size());
+    for(const auto& r : this->m_sessions->session_map)
+      sessions.emplace_back(r.second);
+    lock.unlock();
+
+    size_t count = 0;
+    for(const auto& session : sessions)
+      if(session->ws_send(frame))
+        count ++;
+
+    return count;
+  }
+
 void
 Easy_WS_Server::
 stop()
@@ -12,6 +12,8 @@ Abstract_Fiber()
   {
     this->m_scheduler = reinterpret_cast<Fiber_Scheduler*>(-1);
     this->m_sched_yield_fn = nullptr;
+    this->m_sched_park_fn = nullptr;
+    this->m_park_permit = false;
   }
 
 Abstract_Fiber::
@@ -27,4 +29,29 @@ yield(const shptr<Abstract_Future>& futr_opt)
     (* this->m_sched_yield_fn) (futr_opt);
   }
 
+bool
+Abstract_Fiber::
+park(milliseconds timeout)
+  const
+  {
+    (* this->m_sched_park_fn) (timeout);
+
+    // Consume the permit, if any.
+    plain_mutex::unique_lock lock(this->m_park_mutex);
+    return ::std::exchange(this->m_park_permit, false);
+  }
+
+void
+Abstract_Fiber::
+unpark()
+  noexcept
+  {
+    plain_mutex::unique_lock lock(this->m_park_mutex);
+    this->m_park_permit = true;
+
+    // If the fiber is parked, wake it up.
+    if(auto timep = this->m_park_waker.lock())
+      timep->store(steady_clock::now());
+  }
+
 }  // namespace poseidon
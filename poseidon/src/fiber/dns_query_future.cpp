@@ -3,9 +3,8 @@
 
 #include "../xprecompiled.hpp"
 #include "../../fiber/dns_query_future.hpp"
+#include "../../static/dns_resolver.hpp"
 #include "../../utils.hpp"
-#include <sys/socket.h>
-#include <netdb.h>
 namespace poseidon {
 
 DNS_Query_Future::
@@ -18,58 +17,55 @@ DNS_Query_Future(const cow_string& host, uint16_t port)
 DNS_Query_Future::
 ~DNS_Query_Future()
   {
+    if(this->m_completion)
+      this->m_completion->detach();
   }
 
 void
 DNS_Query_Future::
 do_on_abstract_future_initialize()
   {
-    // Perform DNS query. This will block the worker thread.
-    ::addrinfo* res = nullptr;
-    ::asteria::unique_ptr<::addrinfo, vfn<::addrinfo*>> guard(res, ::freeaddrinfo);
-
-    ::addrinfo hints = { };
-    hints.ai_flags = AI_V4MAPPED | AI_ADDRCONFIG | AI_NUMERICSERV;
-    int err = ::getaddrinfo(this->m_host.safe_c_str(), nullptr, &hints, &res);
-    if(err == 0)
-      guard.reset(res);
-    else
-      POSEIDON_THROW((
-          "Could not resolve host `$1`",
-          "[`getaddrinfo()` failed: $2]"),
-          this->m_host, ::gai_strerror(err));
-
-    for(res = guard;  res;  res = res->ai_next) {
-      IPv6_Address addr;
-      if(res->ai_family == AF_INET) {
-        // IPv4
-        auto sa = reinterpret_cast<::sockaddr_in*>(res->ai_addr);
-        ::memcpy(addr.mut_data(), ipv4_unspecified.data(), 12);
-        ::memcpy(addr.mut_data() + 12, &(sa->sin_addr), 4);
-        addr.set_port(this->m_port);
-      }
-      else if(res->ai_family == AF_INET6) {
-        // IPv6
-        auto sa = reinterpret_cast<::sockaddr_in6*>(res->ai_addr);
-        ::memcpy(addr.mut_data(), &(sa->sin6_addr), 16);
-        addr.set_port(this->m_port);
-      }
-      else
-        continue;
-
-      if(is_any_of(addr, this->m_res))
-        continue;
-
-      POSEIDON_LOG_DEBUG(("Received DNS record: `$1` => `$2`"), this->m_host, addr);
-      this->m_res.push_back(addr);
-    }
+    if(this->m_error)
+      POSEIDON_THROW(("Could not resolve host `$1`: $2"), this->m_host, this->m_error);
   }
 
 void
 DNS_Query_Future::
 do_on_abstract_task_execute()
   {
-    this->do_abstract_future_initialize_once();
+    auto completion = new_sh<future_completion<DNS_Query_Future>>(this);
+    this->m_completion = completion;
+
+    try {
+      dns_resolver.resolve(this->m_host,
+        [completion](const cow_vector<IPv6_Address>& addrs, const char* error)
+          {
+            plain_mutex::unique_lock lock;
+            auto futr = completion->lock(lock);
+            if(!futr)
+              return;
+
+            futr->m_error = error;
+
+            for(const auto& addr : addrs) {
+              IPv6_Address res(addr, futr->m_port);
+              if(is_any_of(res, futr->m_res))
+                continue;
+
+              POSEIDON_LOG_DEBUG(("Received DNS record: `$1` => `$2`"), futr->m_host, res);
+              futr->m_res.push_back(res);
+            }
+
+            futr->do_abstract_future_initialize_once();
+          });
+    }
+    catch(exception& stdex) {
+      POSEIDON_LOG_ERROR(("DNS lookup error: $1"), stdex);
+      plain_mutex::unique_lock lock;
+      completion->lock(lock);
+      this->m_error = "resolver error";
+      this->do_abstract_future_initialize_once();
+    }
   }
 
 }  // namespace poseidon
@@ -0,0 +1,67 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../fiber/http_request_future.hpp"
+#include "../../static/http_connector.hpp"
+#include "../../utils.hpp"
+namespace poseidon {
+
+HTTP_Request_Future::
+HTTP_Request_Future(HTTP_Connector& connector, const HTTP_C_Headers& req,
+                    const cow_string& payload)
+  {
+    this->m_ctr = &connector;
+    this->m_req = req;
+    this->m_payload = payload;
+  }
+
+HTTP_Request_Future::
+~HTTP_Request_Future()
+  {
+    if(this->m_completion)
+      this->m_completion->detach();
+  }
+
+void
+HTTP_Request_Future::
+do_on_abstract_future_initialize()
+  {
+    if(this->m_error != "")
+      POSEIDON_THROW(("Could not send HTTP request to `$1`: $2"), this->m_req.raw_host, this->m_error);
+  }
+
+void
+HTTP_Request_Future::
+do_on_abstract_task_execute()
+  {
+    auto completion = new_sh<future_completion<HTTP_Request_Future>>(this);
+    this->m_completion = completion;
+
+    try {
+      this->m_ctr->request(this->m_req, this->m_payload,
+        [completion](HTTP_S_Headers&& resp, linear_buffer&& data, const char* error)
+          {
+            plain_mutex::unique_lock lock;
+            auto futr = completion->lock(lock);
+            if(!futr)
+              return;
+
+            if(error)
+              futr->m_error = error;
+
+            futr->m_resp = move(resp);
+            futr->m_resp_payload = move(data);
+            futr->do_abstract_future_initialize_once();
+          });
+    }
+    catch(exception& stdex) {
+      POSEIDON_LOG_ERROR(("HTTP request error: $1"), stdex);
+      plain_mutex::unique_lock lock;
+      completion->lock(lock);
+      this->m_error = stdex.what();
+      this->do_abstract_future_initialize_once();
+    }
+  }
+
+}  // namespace poseidon
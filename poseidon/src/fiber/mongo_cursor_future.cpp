@@ -0,0 +1,215 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../fiber/mongo_cursor_future.hpp"
+#include "../../mongo/mongo_connection.hpp"
+#include "../../mongo/mongo_document_view.hpp"
+#include "../../mongo/mongo_document_builder.hpp"
+#include "../../static/mongo_connector.hpp"
+#include "../../utils.hpp"
+namespace poseidon {
+
+Mongo_Cursor_Future::
+Mongo_Cursor_Future(Mongo_Connector& connector, uniptr<Mongo_Connection>&& conn_opt,
+                    const Mongo_Document& cmd, uint32_t batch_size)
+  {
+    this->m_ctr = &connector;
+    this->m_conn = move(conn_opt);
+    this->m_cmd = cmd;
+    this->m_batch_size = ::std::max(batch_size, 1U);
+    this->m_continued = false;
+    this->m_kill_cursor = false;
+    this->m_server_id = 0;
+    this->m_cursor_id = 0;
+    this->m_eof = true;
+  }
+
+Mongo_Cursor_Future::
+Mongo_Cursor_Future(Mongo_Connector& connector, const Mongo_Document& cmd,
+                    uint32_t batch_size)
+  {
+    this->m_ctr = &connector;
+    this->m_cmd = cmd;
+    this->m_batch_size = ::std::max(batch_size, 1U);
+    this->m_continued = false;
+    this->m_kill_cursor = false;
+    this->m_server_id = 0;
+    this->m_cursor_id = 0;
+    this->m_eof = true;
+  }
+
+Mongo_Cursor_Future::
+Mongo_Cursor_Future(const shptr<Mongo_Cursor_Future>& prev, bool kill_cursor)
+  {
+    if(!prev)
+      POSEIDON_THROW(("Null Mongo cursor future pointer"));
+
+    if(!prev->successful() || prev->m_eof || !prev->m_conn)
+      POSEIDON_THROW(("Mongo cursor future has no more documents to fetch"));
+
+    this->m_ctr = prev->m_ctr;
+    this->m_conn = move(prev->m_conn);
+    this->m_cmd = prev->m_cmd;
+    this->m_batch_size = prev->m_batch_size;
+    this->m_continued = true;
+    this->m_kill_cursor = kill_cursor;
+    this->m_server_id = prev->m_server_id;
+    this->m_coll = prev->m_coll;
+    this->m_cursor_id = prev->m_cursor_id;
+    this->m_eof = true;
+  }
+
+Mongo_Cursor_Future::
+~Mongo_Cursor_Future()
+  {
+  }
+
+void
+Mongo_Cursor_Future::
+compose_command(Mongo_Document_Builder& builder, const Mongo_Document& cmd,
+                uint32_t batch_size)
+  {
+    bool has_cursor = false;
+    bool has_batch_size = false;
+
+    for(const auto& field : cmd)
+      if((field.first == "cursor") && field.second.is_document()) {
+        bool has_nested_batch_size = false;
+        builder.open_document(field.first);
+        for(const auto& r : field.second.as_document()) {
+          builder.append_value(r.first, r.second);
+          if(r.first == "batchSize")
+            has_nested_batch_size = true;
+        }
+
+        if(!has_nested_batch_size)
+          builder.append_integer(&"batchSize", batch_size);
+
+        builder.close();
+        has_cursor = true;
+      }
+      else {
+        builder.append_value(field.first, field.second);
+        if(field.first == "batchSize")
+          has_batch_size = true;
+      }
+
+    if(!has_cursor && !has_batch_size)
+      builder.append_integer(&"batchSize", batch_size);
+  }
+
+void
+Mongo_Cursor_Future::
+do_on_abstract_future_initialize()
+  {
+    if(this->m_kill_cursor) {
+      // Close the cursor on the server. The reply is not interesting.
+      scoped_bson bson_cmd;
+      ::bson_t cursors;
+      bool success = ::bson_append_utf8(bson_cmd, "killCursors", -1, this->m_coll.c_str(),
+                                        clamp_cast<int>(this->m_coll.ssize(), 0, INT_MAX))
+                     && ::bson_append_array_unsafe_begin(bson_cmd, "cursors", -1, &cursors)
+                     && ::bson_append_int64(&cursors, "0", -1, this->m_cursor_id)
+                     && ::bson_append_array_end(bson_cmd, &cursors);
+      if(!success)
+        POSEIDON_THROW(("Failed to compose BSON command"));
+
+      this->m_conn->execute_bson(bson_cmd, this->m_server_id);
+      this->m_conn->fetch_raw_reply_bson_opt();
+      return;
+    }
+
+    if(!this->m_continued) {
+      if(!this->m_conn)
+        this->m_conn = this->m_ctr->allocate_default_connection();
+
+      // Cursors only exist on the server where they were created, so all
+      // commands are sent there.
+      this->m_server_id = this->m_conn->select_server();
+
+      Mongo_Document_Builder builder;
+      compose_command(builder, this->m_cmd, this->m_batch_size);
+      this->m_conn->execute(builder, this->m_server_id);
+    }
+    else {
+      // Cursor IDs are always 64-bit integers.
+      scoped_bson bson_cmd;
+      bool success = ::bson_append_int64(bson_cmd, "getMore", -1, this->m_cursor_id)
+                     && ::bson_append_utf8(bson_cmd, "collection", -1, this->m_coll.c_str(),
+                                           clamp_cast<int>(this->m_coll.ssize(), 0, INT_MAX))
+                     && ::bson_append_int64(bson_cmd, "batchSize", -1, this->m_batch_size);
+      if(!success)
+        POSEIDON_THROW(("Failed to compose BSON command"));
+
+      this->m_conn->execute_bson(bson_cmd, this->m_server_id);
+    }
+
+    // Parse the reply directly. The cursor in the reply is not passed to the
+    // driver, so `getMore` commands are sent only when requested.
+    auto bson_reply = this->m_conn->fetch_raw_reply_bson_opt();
+    if(!bson_reply)
+      POSEIDON_THROW(("No reply from Mongo server"));
+
+    Mongo_Document_View cursor = Mongo_Document_View(bson_reply).get_document(&"cursor");
+    this->m_cursor_id = cursor.get_integer(&"id");
+
+    if(!this->m_continued) {
+      // The namespace is `<database>.<collection>`.
+      chars_view ns = cursor.get_utf8(&"ns");
+      auto dot = static_cast<const char*>(::memchr(ns.p, '.', ns.n));
+      if(!dot)
+        POSEIDON_THROW(("Invalid Mongo cursor namespace `$1`"), ns);
+
+      this->m_coll.assign(dot + 1, static_cast<size_t>(ns.p + ns.n - dot - 1));
+    }
+
+    Mongo_Document_View batch = cursor.get_array(this->m_continued ? "nextBatch" : "firstBatch");
+    ::bson_iter_t iter;
+    if(!batch.iter_init(iter))
+      POSEIDON_THROW(("Failed to parse BSON reply from server"));
+
+    while(::bson_iter_next(&iter)) {
+      if(!BSON_ITER_HOLDS_DOCUMENT(&iter))
+        continue;
+
+      uint32_t len;
+      const uint8_t* bytes;
+      ::bson_iter_document(&iter, &len, &bytes);
+      Mongo_Document_View(bytes, len).to_document(this->m_res.emplace_back());
+    }
+
+    // A cursor ID of zero means the cursor has been exhausted and closed.
+    if(this->m_cursor_id == 0)
+      return;
+
+    // There may be more documents, so keep the connection for the next batch.
+    // This has to be the last operation, as `do_on_abstract_future_finalize()`
+    // checks it.
+    this->m_eof = false;
+  }
+
+void
+Mongo_Cursor_Future::
+do_on_abstract_future_finalize()
+  {
+    // If there are more documents, the connection may be taken by another
+    // future at any time, so don't touch it.
+    if(!this->m_eof)
+      return;
+
+    if(!this->m_conn)
+      return;
+
+    if(this->m_conn->reset())
+      this->m_ctr->pool_connection(move(this->m_conn));
+  }
+
+void
+Mongo_Cursor_Future::
+do_on_abstract_task_execute()
+  {
+    this->do_abstract_future_initialize_once();
+  }
+
+}  // namespace poseidon
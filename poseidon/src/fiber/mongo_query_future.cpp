@@ -10,18 +10,21 @@ namespace poseidon {
 
 Mongo_Query_Future::
 Mongo_Query_Future(Mongo_Connector& connector, uniptr<Mongo_Connection>&& conn_opt,
-                   const Mongo_Document& cmd)
+                   const Mongo_Document& cmd, Mongo_Result_Format format)
   {
     this->m_ctr = &connector;
     this->m_conn = move(conn_opt);
     this->m_cmd = cmd;
+    this->m_format = format;
   }
 
 Mongo_Query_Future::
-Mongo_Query_Future(Mongo_Connector& connector, const Mongo_Document& cmd)
+Mongo_Query_Future(Mongo_Connector& connector, const Mongo_Document& cmd,
+                   Mongo_Result_Format format)
   {
     this->m_ctr = &connector;
     this->m_cmd = cmd;
+    this->m_format = format;
   }
 
 Mongo_Query_Future::
@@ -39,8 +42,40 @@ do_on_abstract_future_initialize()
     this->m_conn->execute(this->m_cmd);
 
     Mongo_Document doc;
-    while(this->m_conn->fetch_reply(doc))
-      this->m_res.push_back(move(doc));
+    const ::bson_t* bson;
+    switch(this->m_format)
+      {
+      case mongo_result_documents:
+        while(this->m_conn->fetch_reply(doc))
+          this->m_res.push_back(move(doc));
+        break;
+
+      case mongo_result_columns:
+        while(this->m_conn->fetch_reply(doc))
+          this->m_res_columns.append_document(doc);
+        break;
+
+      case mongo_result_bson:
+        // Copy documents verbatim. They will be parsed on demand.
+        while((bson = this->m_conn->fetch_reply_bson_opt()) != nullptr) {
+          this->m_res_bson_ranges.emplace_back(this->m_res_bson.size(), bson->len);
+          this->m_res_bson.append(::bson_get_data(bson), bson->len);
+        }
+        break;
+
+      default:
+        POSEIDON_THROW(("Invalid Mongo result format `$1`"), this->m_format);
+      }
+  }
+
+Mongo_Document_View
+Mongo_Query_Future::
+result_bson(size_t index)
+  const
+  {
+    this->check_success();
+    const auto& r = this->m_res_bson_ranges.at(index);
+    return Mongo_Document_View(this->m_res_bson.data() + r.first, r.second);
   }
 
 void
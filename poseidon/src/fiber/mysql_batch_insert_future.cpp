@@ -0,0 +1,294 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../fiber/mysql_batch_insert_future.hpp"
+#include "../../mysql/mysql_connection.hpp"
+#include "../../static/mysql_connector.hpp"
+#include "../../utils.hpp"
+namespace poseidon {
+namespace {
+
+// This is the maximum number of placeholders in a prepared statement, as
+// imposed by the protocol.
+constexpr size_t max_placeholders = 65535;
+
+// This is reserved for the packet header and other fields which are not
+// arguments.
+constexpr size_t packet_overhead = 1024;
+
+size_t
+do_estimate_row_size(const cow_vector<MySQL_Value>& row)
+  noexcept
+  {
+    // Each argument takes two bytes for its type, and one bit in the null
+    // bitmap. Values are encoded in the binary protocol.
+    size_t size = row.size() * 2 + row.size() / 8 + 1;
+
+    for(const auto& value : row)
+      switch(value.type())
+        {
+        case mysql_value_null:
+          break;
+
+        case mysql_value_integer:
+        case mysql_value_double:
+          size += 8;
+          break;
+
+        case mysql_value_blob:
+          size += value.as_blob_size() + 9;
+          break;
+
+        case mysql_value_datetime:
+          size += 12;
+          break;
+
+        default:
+          ASTERIA_TERMINATE(("Corrupted MySQL value type `$1`"), value.type());
+        }
+
+    return size;
+  }
+
+void
+do_append_identifier(tinyfmt& fmt, chars_view name)
+  {
+    // Quote the name with backticks, and double backticks in it.
+    if(name.n == 0)
+      POSEIDON_THROW(("Empty MySQL identifier"));
+
+    if(::memchr(name.p, 0, name.n))
+      POSEIDON_THROW(("MySQL identifier `$1` contains null characters"), name);
+
+    fmt << '`';
+    for(size_t k = 0;  k != name.n;  ++k) {
+      if(name.p[k] == '`')
+        fmt << '`';
+      fmt << name.p[k];
+    }
+    fmt << '`';
+  }
+
+void
+do_append_table_name(tinyfmt& fmt, const cow_string& table)
+  {
+    // A table name may be qualified with a database name, as in `db.tbl`,
+    // and each part is quoted separately.
+    const char* bp = table.data();
+    const char* const ep = bp + table.size();
+    const char* dp = ::std::find(bp, ep, '.');
+    if(::std::find(dp + (dp != ep), ep, '.') != ep)
+      POSEIDON_THROW(("Invalid MySQL table name `$1`"), table);
+
+    do_append_identifier(fmt, chars_view(bp, static_cast<size_t>(dp - bp)));
+    if(dp == ep)
+      return;
+
+    fmt << '.';
+    do_append_identifier(fmt, chars_view(dp + 1, static_cast<size_t>(ep - dp - 1)));
+  }
+
+}  // namespace
+
+MySQL_Batch_Insert_Future::
+MySQL_Batch_Insert_Future(MySQL_Connector& connector, uniptr<MySQL_Connection>&& conn_opt,
+                          const cow_string& table, const cow_vector<cow_string>& columns,
+                          const cow_vector<cow_vector<MySQL_Value>>& rows,
+                          const cow_vector<cow_string>& update_columns)
+  {
+    this->m_ctr = &connector;
+    this->m_conn = move(conn_opt);
+    this->m_table = table;
+    this->m_columns = columns;
+    this->m_rows = rows;
+    this->m_update_columns = update_columns;
+  }
+
+MySQL_Batch_Insert_Future::
+MySQL_Batch_Insert_Future(MySQL_Connector& connector, const cow_string& table,
+                          const cow_vector<cow_string>& columns,
+                          const cow_vector<cow_vector<MySQL_Value>>& rows,
+                          const cow_vector<cow_string>& update_columns)
+  {
+    this->m_ctr = &connector;
+    this->m_table = table;
+    this->m_columns = columns;
+    this->m_rows = rows;
+    this->m_update_columns = update_columns;
+  }
+
+MySQL_Batch_Insert_Future::
+~MySQL_Batch_Insert_Future()
+  {
+  }
+
+cow_string
+MySQL_Batch_Insert_Future::
+compose_statement(const cow_string& table, const cow_vector<cow_string>& columns,
+                  const cow_vector<cow_string>& update_columns, size_t nrows)
+  {
+    if(columns.empty())
+      POSEIDON_THROW(("No column to insert into MySQL table `$1`"), table);
+
+    if(nrows == 0)
+      POSEIDON_THROW(("No row to insert into MySQL table `$1`"), table);
+
+    tinyfmt_str sql;
+    sql << "INSERT INTO ";
+    do_append_table_name(sql, table);
+    sql << " (";
+
+    for(size_t k = 0;  k != columns.size();  ++k) {
+      if(k != 0)
+        sql << ", ";
+      do_append_identifier(sql, columns[k]);
+    }
+
+    sql << ")\n  VALUES ";
+
+    for(size_t r = 0;  r != nrows;  ++r) {
+      if(r != 0)
+        sql << ", ";
+
+      sql << "(?";
+      for(size_t k = 1;  k != columns.size();  ++k)
+        sql << ", ?";
+      sql << ")";
+    }
+
+    // New values are referenced with a row alias, as `VALUES()` has been
+    // deprecated since MySQL 8.0.20.
+    for(size_t k = 0;  k != update_columns.size();  ++k) {
+      if(k == 0)
+        sql << " AS `new`\n  ON DUPLICATE KEY UPDATE ";
+      else
+        sql << ", ";
+
+      do_append_identifier(sql, update_columns[k]);
+      sql << " = `new`.";
+      do_append_identifier(sql, update_columns[k]);
+    }
+
+    return sql.extract_string();
+  }
+
+size_t
+MySQL_Batch_Insert_Future::
+count_statement_rows(const cow_vector<cow_vector<MySQL_Value>>& rows, size_t start,
+                     size_t max_rows, size_t max_packet_size)
+  noexcept
+  {
+    size_t nrows = 0;
+    size_t packet_size = 0;
+
+    while((start + nrows < rows.size()) && (nrows < max_rows)) {
+      // The first row is always taken, even if it's too large. The sum is
+      // compared instead of the remaining size, which would wrap around in
+      // this case.
+      size_t row_size = do_estimate_row_size(rows[start + nrows]);
+      if((nrows != 0) && (packet_size + row_size > max_packet_size))
+        break;
+
+      nrows ++;
+      packet_size += row_size;
+    }
+    return nrows;
+  }
+
+void
+MySQL_Batch_Insert_Future::
+do_on_abstract_future_initialize()
+  {
+    if(this->m_table.empty())
+      POSEIDON_THROW(("Empty MySQL table name"));
+
+    if(this->m_columns.empty())
+      POSEIDON_THROW(("No column to insert into MySQL table `$1`"), this->m_table);
+
+    for(const auto& row : this->m_rows)
+      if(row.size() != this->m_columns.size())
+        POSEIDON_THROW((
+            "Number of values mismatches number of columns (`$1` != `$2`)"),
+            row.size(), this->m_columns.size());
+
+    this->m_statement_count = 0;
+    this->m_warning_count = 0;
+    this->m_match_count = 0;
+    this->m_insert_id = 0;
+
+    if(this->m_rows.empty())
+      return;
+
+    if(!this->m_conn)
+      this->m_conn = this->m_ctr->allocate_default_connection();
+
+    // Get the packet size limit of the server. Each statement, including its
+    // arguments, must fit into a single packet.
+    const cow_vector<MySQL_Value> no_args;
+    this->m_conn->execute(&"SELECT @@max_allowed_packet", no_args);
+
+    cow_vector<MySQL_Value> limit_row;
+    if(!this->m_conn->fetch_row(limit_row) || limit_row.empty() || !limit_row[0].is_integer())
+      POSEIDON_THROW(("Could not get `max_allowed_packet` from MySQL server"));
+
+    int64_t limit = ::std::min<int64_t>(limit_row[0].as_integer(), INT32_MAX);
+    limit = ::std::max<int64_t>(limit, packet_overhead * 2);
+    size_t max_packet_size = static_cast<size_t>(limit) - packet_overhead;
+    size_t max_rows = max_placeholders / this->m_columns.size();
+
+    // Disable auto-commit, which starts a transaction. If an exception is
+    // thrown, the transaction will be rolled back when the connection is reset
+    // by `do_on_abstract_future_finalize()`.
+    this->m_conn->execute(&"SET autocommit = 0", no_args);
+
+    size_t row_index = 0;
+    cow_vector<MySQL_Value> args;
+
+    while(row_index != this->m_rows.size()) {
+      // Take as many rows as possible.
+      size_t nrows = count_statement_rows(this->m_rows, row_index, max_rows, max_packet_size);
+      args.clear();
+      for(size_t k = 0;  k != nrows;  ++k)
+        for(const auto& value : this->m_rows[row_index + k])
+          args.push_back(value);
+
+      row_index += nrows;
+
+      // Statements with the same number of rows share the same text, so they
+      // can be reused from the statement cache.
+      cow_string sql = compose_statement(this->m_table, this->m_columns,
+                                         this->m_update_columns, nrows);
+      POSEIDON_LOG_TRACE(("Inserting $1 rows into MySQL table `$2`"), nrows, this->m_table);
+      this->m_conn->execute(sql, args);
+
+      if(this->m_statement_count == 0)
+        this->m_insert_id = this->m_conn->insert_id();
+
+      this->m_statement_count ++;
+      this->m_warning_count += this->m_conn->warning_count();
+      this->m_match_count += this->m_conn->match_count();
+    }
+
+    this->m_conn->execute(&"COMMIT", no_args);
+  }
+
+void
+MySQL_Batch_Insert_Future::
+do_on_abstract_future_finalize()
+  {
+    if(!this->m_conn)
+      return;
+
+    if(this->m_conn->reset())
+      this->m_ctr->pool_connection(move(this->m_conn));
+  }
+
+void
+MySQL_Batch_Insert_Future::
+do_on_abstract_task_execute()
+  {
+    this->do_abstract_future_initialize_once();
+  }
+
+}  // namespace poseidon
@@ -0,0 +1,113 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../fiber/mysql_cursor_future.hpp"
+#include "../../mysql/mysql_connection.hpp"
+#include "../../static/mysql_connector.hpp"
+#include "../../utils.hpp"
+namespace poseidon {
+
+MySQL_Cursor_Future::
+MySQL_Cursor_Future(MySQL_Connector& connector, uniptr<MySQL_Connection>&& conn_opt,
+                    const cow_string& stmt, const cow_vector<MySQL_Value>& stmt_args,
+                    uint32_t batch_size)
+  {
+    this->m_ctr = &connector;
+    this->m_conn = move(conn_opt);
+    this->m_stmt = stmt;
+    this->m_stmt_args = stmt_args;
+    this->m_batch_size = ::std::max(batch_size, 1U);
+    this->m_continued = false;
+    this->m_eof = true;
+  }
+
+MySQL_Cursor_Future::
+MySQL_Cursor_Future(MySQL_Connector& connector, const cow_string& stmt,
+                    const cow_vector<MySQL_Value>& stmt_args, uint32_t batch_size)
+  {
+    this->m_ctr = &connector;
+    this->m_stmt = stmt;
+    this->m_stmt_args = stmt_args;
+    this->m_batch_size = ::std::max(batch_size, 1U);
+    this->m_continued = false;
+    this->m_eof = true;
+  }
+
+MySQL_Cursor_Future::
+MySQL_Cursor_Future(const shptr<MySQL_Cursor_Future>& prev)
+  {
+    if(!prev)
+      POSEIDON_THROW(("Null MySQL cursor future pointer"));
+
+    if(!prev->successful() || prev->m_eof || !prev->m_conn)
+      POSEIDON_THROW(("MySQL cursor future has no more rows to fetch"));
+
+    this->m_ctr = prev->m_ctr;
+    this->m_conn = move(prev->m_conn);
+    this->m_stmt = prev->m_stmt;
+    this->m_stmt_args = prev->m_stmt_args;
+    this->m_batch_size = prev->m_batch_size;
+    this->m_continued = true;
+    this->m_result_fields = prev->m_result_fields;
+    this->m_eof = true;
+  }
+
+MySQL_Cursor_Future::
+~MySQL_Cursor_Future()
+  {
+  }
+
+void
+MySQL_Cursor_Future::
+do_on_abstract_future_initialize()
+  {
+    if(!this->m_continued) {
+      if(!this->m_conn)
+        this->m_conn = this->m_ctr->allocate_default_connection();
+
+      // Open a cursor, which sends a batch for each round trip.
+      this->m_conn->execute_cursor(this->m_stmt, this->m_stmt_args, this->m_batch_size);
+      this->m_conn->fetch_fields(this->m_result_fields);
+    }
+
+    // Don't trust `m_batch_size`, which may be arbitrarily large.
+    this->m_result_rows.reserve(::std::min<size_t>(this->m_batch_size, 1024));
+
+    cow_vector<MySQL_Value> row;
+    while(this->m_result_rows.size() < this->m_batch_size)
+      if(this->m_conn->fetch_row(row))
+        this->m_result_rows.push_back(move(row));
+      else
+        return;
+
+    // There may be more rows, so keep the connection for the next batch. This
+    // has to be the last operation, as `do_on_abstract_future_finalize()`
+    // checks it.
+    this->m_eof = false;
+  }
+
+void
+MySQL_Cursor_Future::
+do_on_abstract_future_finalize()
+  {
+    // If there are more rows, the connection may be taken by another future at
+    // any time, so don't touch it.
+    if(!this->m_eof)
+      return;
+
+    if(!this->m_conn)
+      return;
+
+    if(this->m_conn->reset())
+      this->m_ctr->pool_connection(move(this->m_conn));
+  }
+
+void
+MySQL_Cursor_Future::
+do_on_abstract_task_execute()
+  {
+    this->do_abstract_future_initialize_once();
+  }
+
+}  // namespace poseidon
@@ -10,36 +10,46 @@ namespace poseidon {
 
 MySQL_Query_Future::
 MySQL_Query_Future(MySQL_Connector& connector, uniptr<MySQL_Connection>&& conn_opt,
-                   const cow_string& stmt, const cow_vector<MySQL_Value>& stmt_args)
+                   const cow_string& stmt, const cow_vector<MySQL_Value>& stmt_args,
+                   bool columnar)
   {
     this->m_ctr = &connector;
     this->m_conn = move(conn_opt);
     this->m_stmt = stmt;
     this->m_stmt_args = stmt_args;
+    this->m_columnar = columnar;
   }
 
 MySQL_Query_Future::
 MySQL_Query_Future(MySQL_Connector& connector, const cow_string& stmt,
-                   const cow_vector<MySQL_Value>& stmt_args)
+                   const cow_vector<MySQL_Value>& stmt_args, bool columnar)
   {
     this->m_ctr = &connector;
     this->m_stmt = stmt;
     this->m_stmt_args = stmt_args;
+    this->m_columnar = columnar;
   }
 
 MySQL_Query_Future::
 ~MySQL_Query_Future()
   {
+    if(this->m_completion)
+      this->m_completion->detach();
   }
 
 void
 MySQL_Query_Future::
 do_on_abstract_future_initialize()
   {
-    if(!this->m_conn)
-      this->m_conn = this->m_ctr->allocate_default_connection();
+    if(this->m_error != "")
+      POSEIDON_THROW(("Could not execute MySQL statement: $1"), this->m_error);
+
+    if(!this->m_completion) {
+      if(!this->m_conn)
+        this->m_conn = this->m_ctr->allocate_default_connection();
 
-    this->m_conn->execute(this->m_stmt, this->m_stmt_args);
+      this->m_conn->execute(this->m_stmt, this->m_stmt_args);
+    }
 
     this->m_warning_count = this->m_conn->warning_count();
     this->m_match_count = this->m_conn->match_count();
@@ -47,8 +57,15 @@ do_on_abstract_future_initialize()
     this->m_conn->fetch_fields(this->m_result_fields);
 
     cow_vector<MySQL_Value> row;
-    while(this->m_conn->fetch_row(row))
-      this->m_result_rows.push_back(move(row));
+    if(this->m_columnar) {
+      // Values are copied into columns, and `row` is reused.
+      this->m_result_columns.reset(this->m_result_fields);
+      while(this->m_conn->fetch_row(row))
+        this->m_result_columns.append_row(row);
+    }
+    else
+      while(this->m_conn->fetch_row(row))
+        this->m_result_rows.push_back(move(row));
   }
 
 void
@@ -58,7 +75,11 @@ do_on_abstract_future_finalize()
     if(!this->m_conn)
       return;
 
-    if(this->m_conn->reset())
+    // An asynchronous connection is completed by the network thread, which
+    // must not block, so it is reset by the network scheduler instead.
+    if(this->m_conn->asynchronous())
+      this->m_ctr->pool_connection_async(move(this->m_conn));
+    else if(this->m_conn->reset())
       this->m_ctr->pool_connection(move(this->m_conn));
   }
 
@@ -66,7 +87,43 @@ void
 MySQL_Query_Future::
 do_on_abstract_task_execute()
   {
-    this->do_abstract_future_initialize_once();
+    // Asynchronous execution uses the text protocol, which must have been
+    // enabled explicitly, unless the connection is already asynchronous.
+    bool async = (this->m_conn && this->m_conn->connected())
+                 ? this->m_conn->asynchronous()
+                 : this->m_ctr->asynchronous_queries();
+    if(!async) {
+      // Execute the statement in this thread.
+      this->do_abstract_future_initialize_once();
+      return;
+    }
+
+    auto completion = new_sh<future_completion<MySQL_Query_Future>>(this);
+    this->m_completion = completion;
+
+    try {
+      this->m_ctr->execute_async(move(this->m_conn), this->m_stmt, this->m_stmt_args,
+        [completion](uniptr<MySQL_Connection>&& conn, const char* error)
+          {
+            plain_mutex::unique_lock lock;
+            auto futr = completion->lock(lock);
+            if(!futr)
+              return;
+
+            if(error)
+              futr->m_error = error;
+
+            futr->m_conn = move(conn);
+            futr->do_abstract_future_initialize_once();
+          });
+    }
+    catch(exception& stdex) {
+      POSEIDON_LOG_ERROR(("MySQL query error: $1"), stdex);
+      plain_mutex::unique_lock lock;
+      completion->lock(lock);
+      this->m_error = stdex.what();
+      this->do_abstract_future_initialize_once();
+    }
   }
 
 }  // namespace poseidon
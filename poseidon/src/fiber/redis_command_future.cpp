@@ -0,0 +1,69 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../fiber/redis_command_future.hpp"
+#include "../../socket/redis_client_session.hpp"
+#include "../../utils.hpp"
+namespace poseidon {
+
+Redis_Command_Future::
+Redis_Command_Future(const shptr<Redis_Client_Session>& session,
+                     const cow_vector<cow_string>& cmd)
+  {
+    this->m_session = session;
+    this->m_cmd = cmd;
+  }
+
+Redis_Command_Future::
+~Redis_Command_Future()
+  {
+    if(this->m_completion)
+      this->m_completion->detach();
+  }
+
+void
+Redis_Command_Future::
+do_on_abstract_future_initialize()
+  {
+    if(this->m_error != "")
+      POSEIDON_THROW(("Could not execute Redis command: $1"), this->m_error);
+  }
+
+void
+Redis_Command_Future::
+do_on_abstract_task_execute()
+  {
+    auto completion = new_sh<future_completion<Redis_Command_Future>>(this);
+    this->m_completion = completion;
+
+    try {
+      bool sent = this->m_session->redis_execute(this->m_cmd,
+        [completion](cow_string&& status, Redis_Value&& value, const char* error)
+          {
+            plain_mutex::unique_lock lock;
+            auto futr = completion->lock(lock);
+            if(!futr)
+              return;
+
+            if(error)
+              futr->m_error = error;
+
+            futr->m_status = move(status);
+            futr->m_res = move(value);
+            futr->do_abstract_future_initialize_once();
+          });
+
+      if(!sent)
+        POSEIDON_THROW(("Redis connection closed"));
+    }
+    catch(exception& stdex) {
+      POSEIDON_LOG_ERROR(("Redis command error: $1"), stdex);
+      plain_mutex::unique_lock lock;
+      completion->lock(lock);
+      this->m_error = stdex.what();
+      this->do_abstract_future_initialize_once();
+    }
+  }
+
+}  // namespace poseidon
@@ -0,0 +1,81 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../fiber/redis_pipeline_future.hpp"
+#include "../../redis/redis_connection.hpp"
+#include "../../static/redis_connector.hpp"
+#include "../../utils.hpp"
+namespace poseidon {
+
+Redis_Pipeline_Future::
+Redis_Pipeline_Future(Redis_Connector& connector, uniptr<Redis_Connection>&& conn_opt,
+                      const cow_vector<cow_vector<cow_string>>& cmds)
+  {
+    this->m_ctr = &connector;
+    this->m_conn = move(conn_opt);
+    this->m_cmds = cmds;
+  }
+
+Redis_Pipeline_Future::
+Redis_Pipeline_Future(Redis_Connector& connector, const cow_vector<cow_vector<cow_string>>& cmds)
+  {
+    this->m_ctr = &connector;
+    this->m_cmds = cmds;
+  }
+
+Redis_Pipeline_Future::
+~Redis_Pipeline_Future()
+  {
+  }
+
+void
+Redis_Pipeline_Future::
+do_on_abstract_future_initialize()
+  {
+    if(!this->m_conn)
+      this->m_conn = this->m_ctr->allocate_default_connection();
+
+    this->m_conn->execute_pipeline(this->m_cmds);
+
+    // There is exactly one reply for each command.
+    this->m_statuses.reserve(this->m_cmds.size());
+    this->m_results.reserve(this->m_cmds.size());
+    this->m_errors.reserve(this->m_cmds.size());
+
+    cow_string status;
+    Redis_Value value;
+    for(size_t k = 0;  k != this->m_cmds.size();  ++k) {
+      cow_string error;
+      try {
+        this->m_conn->fetch_reply(status, value);
+      }
+      catch(exception& stdex) {
+        error = stdex.what();
+      }
+
+      this->m_statuses.push_back(move(status));
+      this->m_results.push_back(move(value));
+      this->m_errors.push_back(move(error));
+    }
+  }
+
+void
+Redis_Pipeline_Future::
+do_on_abstract_future_finalize()
+  {
+    if(!this->m_conn)
+      return;
+
+    if(this->m_conn->reset())
+      this->m_ctr->pool_connection(move(this->m_conn));
+  }
+
+void
+Redis_Pipeline_Future::
+do_on_abstract_task_execute()
+  {
+    this->do_abstract_future_initialize_once();
+  }
+
+}  // namespace poseidon
@@ -0,0 +1,64 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../fiber/redis_push_future.hpp"
+#include "../../socket/redis_client_session.hpp"
+#include "../../utils.hpp"
+namespace poseidon {
+
+Redis_Push_Future::
+Redis_Push_Future(const shptr<Redis_Client_Session>& session)
+  {
+    this->m_session = session;
+  }
+
+Redis_Push_Future::
+~Redis_Push_Future()
+  {
+    if(this->m_completion)
+      this->m_completion->detach();
+  }
+
+void
+Redis_Push_Future::
+do_on_abstract_future_initialize()
+  {
+    if(this->m_error != "")
+      POSEIDON_THROW(("Could not receive Redis push message: $1"), this->m_error);
+  }
+
+void
+Redis_Push_Future::
+do_on_abstract_task_execute()
+  {
+    auto completion = new_sh<future_completion<Redis_Push_Future>>(this);
+    this->m_completion = completion;
+
+    try {
+      this->m_session->redis_wait_push(
+        [completion](Redis_Value&& message, const char* error)
+          {
+            plain_mutex::unique_lock lock;
+            auto futr = completion->lock(lock);
+            if(!futr)
+              return false;
+
+            if(error)
+              futr->m_error = error;
+
+            futr->m_message = move(message);
+            futr->do_abstract_future_initialize_once();
+            return true;
+          });
+    }
+    catch(exception& stdex) {
+      POSEIDON_LOG_ERROR(("Redis push error: $1"), stdex);
+      plain_mutex::unique_lock lock;
+      completion->lock(lock);
+      this->m_error = stdex.what();
+      this->do_abstract_future_initialize_once();
+    }
+  }
+
+}  // namespace poseidon
@@ -27,19 +27,22 @@ Redis_Query_Future(Redis_Connector& connector, const cow_vector<cow_string>& cmd
 Redis_Query_Future::
 ~Redis_Query_Future()
   {
+    if(this->m_completion)
+      this->m_completion->detach();
   }
 
 void
 Redis_Query_Future::
 do_on_abstract_future_initialize()
   {
-    if(!this->m_conn)
-      this->m_conn = this->m_ctr->allocate_default_connection();
+    if(this->m_error != "")
+      POSEIDON_THROW(("Could not execute Redis command: $1"), this->m_error);
 
-    this->m_conn->execute(this->m_cmd);
+    if(this->m_completion)
+      return;
 
-    // We don't do pipelining, so it's assumed that there is exactly one
-    // reply for this command.
+    // There is exactly one reply for this command.
+    this->m_conn->execute(this->m_cmd);
     this->m_conn->fetch_reply(this->m_status, this->m_res);
   }
 
@@ -58,7 +61,56 @@ void
 Redis_Query_Future::
 do_on_abstract_task_execute()
   {
-    this->do_abstract_future_initialize_once();
+    if(this->m_conn) {
+      // Execute the command in this thread.
+      this->do_abstract_future_initialize_once();
+      return;
+    }
+
+    auto completion = new_sh<future_completion<Redis_Query_Future>>(this);
+    this->m_completion = completion;
+
+    try {
+      // `GET` may be served by the near cache.
+      uint64_t serial = 0;
+      if((this->m_cmd.size() == 2)
+         && ::asteria::ascii_ci_equal(this->m_cmd[0].data(), this->m_cmd[0].size(), "GET", 3)
+         && this->m_ctr->cache_lookup(this->m_res, serial, this->m_cmd[1])) {
+        this->do_abstract_future_initialize_once();
+        return;
+      }
+
+      cow_string key;
+      if(serial != 0)
+        key = this->m_cmd[1];
+
+      this->m_ctr->execute_pipelined(this->m_cmd,
+        [completion, ctr = this->m_ctr, key, serial]
+           (cow_string&& status, Redis_Value&& value, const char* error)
+          {
+            if(!error)
+              ctr->cache_store(key, serial, value);
+
+            plain_mutex::unique_lock lock;
+            auto futr = completion->lock(lock);
+            if(!futr)
+              return;
+
+            if(error)
+              futr->m_error = error;
+
+            futr->m_status = move(status);
+            futr->m_res = move(value);
+            futr->do_abstract_future_initialize_once();
+          });
+    }
+    catch(exception& stdex) {
+      POSEIDON_LOG_ERROR(("Redis query error: $1"), stdex);
+      plain_mutex::unique_lock lock;
+      completion->lock(lock);
+      this->m_error = stdex.what();
+      this->do_abstract_future_initialize_once();
+    }
   }
 
 }  // namespace poseidon
@@ -9,6 +9,8 @@
 #include "../static/timer_scheduler.hpp"
 #include "../static/task_scheduler.hpp"
 #include "../static/network_scheduler.hpp"
+#include "../static/dns_resolver.hpp"
+#include "../static/http_connector.hpp"
 #include "../static/mysql_connector.hpp"
 #include "../static/mongo_connector.hpp"
 #include "../static/redis_connector.hpp"
@@ -49,6 +51,8 @@ Logger logger;
 Timer_Scheduler timer_scheduler;
 Task_Scheduler task_scheduler;
 Network_Scheduler network_scheduler;
+DNS_Resolver dns_resolver;
+HTTP_Connector http_connector;
 Fiber_Scheduler fiber_scheduler;
 MySQL_Connector mysql_connector;
 Mongo_Connector mongo_connector;
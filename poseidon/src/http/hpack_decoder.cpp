@@ -0,0 +1,276 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../http/hpack_decoder.hpp"
+#include "../../details/hpack_tables.hpp"
+#include "../../utils.hpp"
+namespace poseidon {
+namespace {
+
+struct Huffman_Decoding_Table
+  {
+    uint32_t first_code[32];
+    uint16_t count[32];
+    uint16_t offset[32];
+    uint16_t symbols[257];
+  };
+
+const Huffman_Decoding_Table&
+do_get_huffman_table()
+  noexcept
+  {
+    static const Huffman_Decoding_Table s_table = []
+      {
+        Huffman_Decoding_Table table = { };
+
+        // The HPACK Huffman code is canonical. Codes of the same length are
+        // consecutive integers, in ascending order of symbols.
+        for(uint32_t sym = 0;  sym != 257;  ++sym)
+          table.count[hpack_huffman_code_lengths[sym]] ++;
+
+        uint32_t code = 0;
+        uint32_t offset = 0;
+        for(uint32_t len = 1;  len != 32;  ++len) {
+          table.first_code[len] = code;
+          table.offset[len] = static_cast<uint16_t>(offset);
+          code = (code + table.count[len]) << 1;
+          offset += table.count[len];
+        }
+
+        uint16_t next[32];
+        ::memcpy(next, table.offset, sizeof(next));
+        for(uint32_t sym = 0;  sym != 257;  ++sym)
+          table.symbols[next[hpack_huffman_code_lengths[sym]] ++] = static_cast<uint16_t>(sym);
+
+        return table;
+      }();
+
+    return s_table;
+  }
+
+void
+do_huffman_decode(cow_string& str, const unsigned char* bptr, size_t len)
+  {
+    const auto& table = do_get_huffman_table();
+    uint32_t code = 0;
+    uint32_t bits = 0;
+
+    for(size_t k = 0;  k != len;  ++k)
+      for(int b = 7;  b >= 0;  --b) {
+        code = code << 1 | (bptr[k] >> b & 1U);
+        bits ++;
+
+        // If `code` is less than `first_code[bits]`, `rel` wraps around and
+        // can't be less than `count[bits]`.
+        uint32_t rel = code - table.first_code[bits];
+        if(rel < table.count[bits]) {
+          uint32_t sym = table.symbols[table.offset[bits] + rel];
+          if(sym == 256)
+            POSEIDON_THROW(("HPACK string contains EOS"));
+
+          str.push_back(static_cast<char>(sym));
+          code = 0;
+          bits = 0;
+        }
+        else if(bits >= 30)
+          POSEIDON_THROW(("Invalid HPACK Huffman code"));
+      }
+
+    // Padding shall be the most significant bits of EOS, which are all ones,
+    // and shall not be longer than 7 bits.
+    if((bits > 7) || (code != (1U << bits) - 1U))
+      POSEIDON_THROW(("Invalid HPACK Huffman padding"));
+  }
+
+uint64_t
+do_decode_integer(const unsigned char*& bptr, const unsigned char* eptr, uint32_t prefix_bits)
+  {
+    if(bptr == eptr)
+      POSEIDON_THROW(("HPACK integer truncated"));
+
+    uint32_t mask = (1U << prefix_bits) - 1U;
+    uint64_t value = *bptr & mask;
+    bptr ++;
+    if(value != mask)
+      return value;
+
+    uint32_t shift = 0;
+    for(;;) {
+      if(bptr == eptr)
+        POSEIDON_THROW(("HPACK integer truncated"));
+
+      if(shift > 56)
+        POSEIDON_THROW(("HPACK integer too large"));
+
+      uint32_t byte = *bptr;
+      bptr ++;
+      value += static_cast<uint64_t>(byte & 0x7FU) << shift;
+      shift += 7;
+
+      if((byte & 0x80U) == 0)
+        return value;
+    }
+  }
+
+void
+do_decode_string(cow_string& str, const unsigned char*& bptr, const unsigned char* eptr)
+  {
+    if(bptr == eptr)
+      POSEIDON_THROW(("HPACK string truncated"));
+
+    bool huffman = *bptr & 0x80U;
+    uint64_t len = do_decode_integer(bptr, eptr, 7);
+    if(len > static_cast<uint64_t>(eptr - bptr))
+      POSEIDON_THROW(("HPACK string truncated"));
+
+    str.clear();
+    if(huffman)
+      do_huffman_decode(str, bptr, static_cast<size_t>(len));
+    else
+      str.append(reinterpret_cast<const char*>(bptr), static_cast<size_t>(len));
+
+    bptr += len;
+  }
+
+}  // namespace
+
+HPACK_Decoder::
+HPACK_Decoder(uint32_t max_table_size)
+  {
+    this->m_max_table_size = max_table_size;
+    this->m_table_size_limit = max_table_size;
+  }
+
+HPACK_Decoder::
+~HPACK_Decoder()
+  {
+  }
+
+void
+HPACK_Decoder::
+do_evict_entries(uint32_t limit)
+  noexcept
+  {
+    while(!this->m_table.empty() && (this->m_table_size > limit)) {
+      const auto& back = this->m_table.back();
+      this->m_table_size -= static_cast<uint32_t>(back.first.size() + back.second.size() + 32);
+      this->m_table.pop_back();
+    }
+  }
+
+void
+HPACK_Decoder::
+do_insert_entry(const cow_string& name, const cow_string& value)
+  {
+    // An entry that is larger than the table itself causes the table to be
+    // emptied, and is not inserted. This is not an error.
+    size_t size = name.size() + value.size() + 32;
+    if(size > this->m_table_size_limit) {
+      this->do_evict_entries(0);
+      return;
+    }
+
+    this->do_evict_entries(this->m_table_size_limit - static_cast<uint32_t>(size));
+    this->m_table.emplace_front(name, value);
+    this->m_table_size += static_cast<uint32_t>(size);
+  }
+
+void
+HPACK_Decoder::
+do_get_entry(cow_string& name, cow_string* value_opt, uint64_t index)
+  const
+  {
+    if(index == 0)
+      POSEIDON_THROW(("HPACK index zero is not allowed"));
+
+    if(index <= hpack_static_table_size) {
+      // static table
+      const auto& entry = hpack_static_table[index];
+      name = ::asteria::sref(entry.name);
+      if(value_opt)
+        *value_opt = ::asteria::sref(entry.value);
+      return;
+    }
+
+    index -= hpack_static_table_size + 1;
+    if(index >= this->m_table.size())
+      POSEIDON_THROW(("HPACK index out of range"));
+
+    // dynamic table
+    const auto& entry = this->m_table[static_cast<size_t>(index)];
+    name = entry.first;
+    if(value_opt)
+      *value_opt = entry.second;
+  }
+
+void
+HPACK_Decoder::
+clear()
+  noexcept
+  {
+    this->m_table.clear();
+    this->m_table_size = 0;
+    this->m_table_size_limit = this->m_max_table_size;
+  }
+
+void
+HPACK_Decoder::
+decode(cow_bivector<cow_string, cow_string>& output, chars_view block)
+  {
+    auto bptr = reinterpret_cast<const unsigned char*>(block.p);
+    const auto eptr = bptr + block.n;
+    bool field_seen = false;
+    cow_string name, value;
+    uint64_t index;
+
+    while(bptr != eptr) {
+      if(*bptr & 0x80U) {
+        // Indexed Header Field Representation
+        index = do_decode_integer(bptr, eptr, 7);
+        this->do_get_entry(name, &value, index);
+      }
+      else if(*bptr & 0x40U) {
+        // Literal Header Field with Incremental Indexing
+        index = do_decode_integer(bptr, eptr, 6);
+        if(index != 0)
+          this->do_get_entry(name, nullptr, index);
+        else
+          do_decode_string(name, bptr, eptr);
+
+        do_decode_string(value, bptr, eptr);
+        this->do_insert_entry(name, value);
+      }
+      else if(*bptr & 0x20U) {
+        // Dynamic Table Size Update; this must occur at the beginning of a
+        // header block.
+        if(field_seen)
+          POSEIDON_THROW(("HPACK dynamic table size update after header field"));
+
+        index = do_decode_integer(bptr, eptr, 5);
+        if(index > this->m_max_table_size)
+          POSEIDON_THROW((
+              "HPACK dynamic table size too large: `$1` > `$2`"),
+              index, this->m_max_table_size);
+
+        this->m_table_size_limit = static_cast<uint32_t>(index);
+        this->do_evict_entries(this->m_table_size_limit);
+        continue;
+      }
+      else {
+        // Literal Header Field without Indexing, or Never Indexed
+        index = do_decode_integer(bptr, eptr, 4);
+        if(index != 0)
+          this->do_get_entry(name, nullptr, index);
+        else
+          do_decode_string(name, bptr, eptr);
+
+        do_decode_string(value, bptr, eptr);
+      }
+
+      output.emplace_back(name, value);
+      field_seen = true;
+    }
+  }
+
+}  // namespace poseidon
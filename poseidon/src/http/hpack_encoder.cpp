@@ -0,0 +1,133 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../http/hpack_encoder.hpp"
+#include "../../http/http_s_headers.hpp"
+#include "../../details/hpack_tables.hpp"
+#include "../../utils.hpp"
+namespace poseidon {
+namespace {
+
+void
+do_encode_integer(tinyfmt& fmt, uint32_t prefix_bits, uint32_t flags, uint64_t value)
+  {
+    uint32_t mask = (1U << prefix_bits) - 1U;
+    if(value < mask) {
+      fmt.putc(static_cast<char>(flags | static_cast<uint32_t>(value)));
+      return;
+    }
+
+    fmt.putc(static_cast<char>(flags | mask));
+    value -= mask;
+    while(value >= 0x80U) {
+      fmt.putc(static_cast<char>((value & 0x7FU) | 0x80U));
+      value >>= 7;
+    }
+    fmt.putc(static_cast<char>(value));
+  }
+
+void
+do_encode_string(tinyfmt& fmt, chars_view str)
+  {
+    // Huffman coding is not used. Strings are written literally.
+    do_encode_integer(fmt, 7, 0x00, str.n);
+    fmt.putn(str.p, str.n);
+  }
+
+uint32_t
+do_find_static_entry(bool& value_matches, chars_view name, chars_view value)
+  noexcept
+  {
+    // Pseudo-headers and common headers are all in the static table, so this
+    // is the fast path. The first matching name is returned if no value
+    // matches.
+    uint32_t name_index = 0;
+    value_matches = false;
+
+    for(uint32_t index = 1;  index <= hpack_static_table_size;  ++index) {
+      const auto& entry = hpack_static_table[index];
+      if((entry.name[0] != name.p[0]) || (entry.name != name))
+        continue;
+
+      if(entry.value == value) {
+        value_matches = true;
+        return index;
+      }
+
+      if(name_index == 0)
+        name_index = index;
+    }
+
+    return name_index;
+  }
+
+}  // namespace
+
+HPACK_Encoder::
+~HPACK_Encoder()
+  {
+  }
+
+void
+HPACK_Encoder::
+encode_field(tinyfmt& fmt, chars_view name, chars_view value)
+  const
+  {
+    if(name.n == 0)
+      POSEIDON_THROW(("Empty HPACK field name"));
+
+    bool value_matches;
+    uint32_t index = do_find_static_entry(value_matches, name, value);
+    if(value_matches) {
+      // Indexed Header Field Representation
+      do_encode_integer(fmt, 7, 0x80, index);
+      return;
+    }
+
+    // Sensitive fields are never indexed, so intermediaries will not compress
+    // them, either.
+    uint32_t flags = 0x00;
+    if((name == "cookie") || (name == "set-cookie") || (name == "authorization"))
+      flags = 0x10;
+
+    // Literal Header Field without Indexing, or Never Indexed
+    do_encode_integer(fmt, 4, flags, index);
+    if(index == 0)
+      do_encode_string(fmt, name);
+    do_encode_string(fmt, value);
+  }
+
+void
+HPACK_Encoder::
+encode_response(tinyfmt& fmt, const HTTP_S_Headers& resp)
+  const
+  {
+    ::asteria::ascii_numput nump;
+    nump.put_DU(resp.status);
+    this->encode_field(fmt, ":status", chars_view(nump.data(), nump.size()));
+
+    cow_string name;
+    for(const auto& hr : resp.headers) {
+      if(hr.first.empty())
+        continue;
+
+      // Connection-specific headers are not allowed in HTTP/2. See RFC 9113,
+      // 8.2.2 Connection-Specific Header Fields.
+      if((hr.first == "Connection") || (hr.first == "Keep-Alive")
+         || (hr.first == "Proxy-Connection") || (hr.first == "Transfer-Encoding")
+         || (hr.first == "Upgrade"))
+        continue;
+
+      // HTTP/2 requires that names be in lowercase.
+      name = hr.first.str();
+      char* ptr = name.mut_data();
+      for(size_t k = 0;  k != name.size();  ++k)
+        if((ptr[k] >= 'A') && (ptr[k] <= 'Z'))
+          ptr[k] = static_cast<char>(ptr[k] | 0x20);
+
+      this->encode_field(fmt, name, hr.second.as_string());
+    }
+  }
+
+}  // namespace poseidon
@@ -0,0 +1,365 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../http/http_compressor.hpp"
+#include "../../http/http_c_headers.hpp"
+#include "../../http/http_s_headers.hpp"
+#include "../../http/http_header_parser.hpp"
+#include "../../utils.hpp"
+#include <openssl/sha.h>
+#include <list>
+#include <unordered_map>
+namespace poseidon {
+namespace {
+
+// Payloads that are smaller than this are not compressed. The gzip header and
+// trailer take 18 bytes, and the overhead of `Content-Encoding` and `Vary`
+// would outweigh the gain.
+constexpr size_t s_min_compressible_length = 256;
+
+zlib_Format
+do_zlib_format_of(HTTP_Content_Coding coding)
+  {
+    switch(coding)
+      {
+      case http_coding_deflate:
+        return zlib_deflate;
+
+      case http_coding_gzip:
+        return zlib_gzip;
+
+      default:
+        POSEIDON_THROW(("Content coding `$1` not compressible"), static_cast<int>(coding));
+      }
+  }
+
+bool
+do_ci_prefix(chars_view str, chars_view prefix)
+  noexcept
+  {
+    return (str.n >= prefix.n) && ::asteria::ascii_ci_equal(str.p, prefix.n, prefix.p, prefix.n);
+  }
+
+bool
+do_is_precompressed_type(chars_view type)
+  noexcept
+  {
+    // SVG is text, although its type starts with `image/`.
+    if(do_ci_prefix(type, "image/"))
+      return !do_ci_prefix(type, "image/svg+xml");
+
+    static constexpr char prefixes[][32] =
+      {
+        "video/", "audio/", "font/woff", "application/zip",
+        "application/gzip", "application/x-gzip", "application/x-bzip2",
+        "application/x-xz", "application/x-7z-compressed",
+        "application/x-rar-compressed", "application/zstd",
+        "application/octet-stream",
+      };
+
+    for(const auto& prefix : prefixes)
+      if(do_ci_prefix(type, chars_view(prefix, ::strlen(prefix))))
+        return true;
+
+    return false;
+  }
+
+void
+do_append_vary_header(HTTP_S_Headers& resp)
+  {
+    // Caches must not serve a representation that has been selected for a
+    // client to another that accepts different codings, whether it has been
+    // compressed or not.
+    resp.headers.emplace_back(&"Vary", &"Accept-Encoding");
+  }
+
+void
+do_append_coding_headers(HTTP_S_Headers& resp, HTTP_Content_Coding coding)
+  {
+    if(coding == http_coding_gzip)
+      resp.headers.emplace_back(&"Content-Encoding", &"gzip");
+    else
+      resp.headers.emplace_back(&"Content-Encoding", &"deflate");
+
+    do_append_vary_header(resp);
+
+    // A compressed representation is not byte-for-byte identical to the
+    // original one, so a strong validator must not be shared by them.
+    for(auto& hr : resp.headers)
+      if((hr.first == "ETag") && (hr.second.as_string().size() >= 2)
+         && (hr.second.as_string()[0] == '\"')) {
+        cow_string etag = &"W/";
+        etag.append(hr.second.as_string());
+        hr.second = move(etag);
+      }
+  }
+
+struct Cache_Entry
+  {
+    phcow_string key;
+    size_t source_size;
+    cow_string data;
+  };
+
+struct Compression_Cache
+  {
+    plain_mutex mutex;
+    ::std::list<Cache_Entry> lru_list;  // most recently used first
+    ::std::unordered_map<phcow_string, ::std::list<Cache_Entry>::iterator,
+                         phcow_string::hash> index;
+    size_t total_size = 0;
+
+    void
+    do_evict(size_t limit)
+      noexcept
+      {
+        while(!this->lru_list.empty() && (this->total_size > limit)) {
+          auto& back = this->lru_list.back();
+          this->total_size -= back.key.size() + back.data.size();
+          this->index.erase(back.key);
+          this->lru_list.pop_back();
+        }
+      }
+
+    bool
+    find(cow_string& data, const phcow_string& key, size_t source_size)
+      {
+        plain_mutex::unique_lock lock(this->mutex);
+        auto it = this->index.find(key);
+        if(it == this->index.end())
+          return false;
+
+        // The length is also checked, in case of a collision of checksums.
+        if(it->second->source_size != source_size) {
+          this->total_size -= it->second->key.size() + it->second->data.size();
+          this->lru_list.erase(it->second);
+          this->index.erase(it);
+          return false;
+        }
+
+        this->lru_list.splice(this->lru_list.begin(), this->lru_list, it->second);
+        data = it->second->data;
+        return true;
+      }
+
+    void
+    insert(const phcow_string& key, size_t source_size, const cow_string& data,
+           size_t limit)
+      {
+        size_t size = key.size() + data.size();
+        if(size > limit / 8)
+          return;
+
+        plain_mutex::unique_lock lock(this->mutex);
+        auto it = this->index.find(key);
+        if(it != this->index.end()) {
+          this->total_size -= it->second->key.size() + it->second->data.size();
+          this->lru_list.erase(it->second);
+          this->index.erase(it);
+        }
+
+        this->do_evict(limit - size);
+        this->lru_list.push_front({ key, source_size, data });
+        this->total_size += size;
+
+        try {
+          this->index.emplace(key, this->lru_list.begin());
+        }
+        catch(...) {
+          this->total_size -= size;
+          this->lru_list.pop_front();
+          throw;
+        }
+      }
+  };
+
+Compression_Cache s_cache;
+
+}  // namespace
+
+HTTP_Compressor::
+HTTP_Compressor(HTTP_Content_Coding coding, int level)
+  :
+    Abstract_Deflator(do_zlib_format_of(coding), level)
+  {
+  }
+
+HTTP_Compressor::
+~HTTP_Compressor()
+  {
+  }
+
+char*
+HTTP_Compressor::
+do_on_deflate_resize_output_buffer(size_t& size)
+  {
+    size = this->m_obuf.reserve_after_end(size);
+    char* ptr = this->m_obuf.mut_end();
+    this->m_obuf.accept(size);
+    return ptr;
+  }
+
+void
+HTTP_Compressor::
+do_on_deflate_truncate_output_buffer(size_t backup)
+  {
+    this->m_obuf.unaccept(backup);
+  }
+
+HTTP_Content_Coding
+HTTP_Compressor::
+select_content_coding(const HTTP_C_Headers& req)
+  {
+    // Quality values are in thousandths; negative values mean 'unspecified'.
+    int gzip_q = -1, deflate_q = -1, any_q = -1;
+    HTTP_Header_Parser hparser;
+
+    for(const auto& hr : req.headers)
+      if(hr.first == "Accept-Encoding") {
+        hparser.reload(hr.second.as_string());
+        while(hparser.next_element()) {
+          int* qptr;
+          if((hparser.current_name() == "gzip") || (hparser.current_name() == "x-gzip"))
+            qptr = &gzip_q;
+          else if(hparser.current_name() == "deflate")
+            qptr = &deflate_q;
+          else if(hparser.current_name() == "*")
+            qptr = &any_q;
+          else
+            continue;
+
+          // Reference: https://datatracker.ietf.org/doc/html/rfc9110#name-quality-values
+          int q = 1000;
+          while(hparser.next_attribute())
+            if((hparser.current_name() == "q") && hparser.current_value().is_double()) {
+              double value = hparser.current_value().as_double();
+              q = (value >= 0) ? static_cast<int>(::std::min(value, 1.0) * 1000 + 0.5) : 0;
+            }
+
+          *qptr = ::std::max(*qptr, q);
+        }
+      }
+
+    // Codings that are not listed explicitly are covered by `*`.
+    if(gzip_q < 0)
+      gzip_q = any_q;
+
+    if(deflate_q < 0)
+      deflate_q = any_q;
+
+    if((gzip_q > 0) && (gzip_q >= deflate_q))
+      return http_coding_gzip;
+
+    if(deflate_q > 0)
+      return http_coding_deflate;
+
+    return http_coding_identity;
+  }
+
+bool
+HTTP_Compressor::
+is_response_compressible(const HTTP_S_Headers& resp, size_t length)
+  {
+    if(length < s_min_compressible_length)
+      return false;
+
+    // A partial response is a byte range of the identity representation, and
+    // can't be compressed on its own.
+    if(resp.status == http_status_partial_content)
+      return false;
+
+    bool type_ok = false;
+    for(const auto& hr : resp.headers)
+      if((hr.first == "Content-Encoding") || (hr.first == "Content-Range"))
+        return false;
+      else if(hr.first == "Content-Type") {
+        // Strip parameters such as `charset`.
+        const auto& str = hr.second.as_string();
+        size_t len = ::std::min(str.find(';'), str.size());
+        while((len != 0) && is_any_of(str[len - 1], { ' ', '\t' }))
+          len --;
+
+        if((len == 0) || do_is_precompressed_type(chars_view(str.data(), len)))
+          return false;
+
+        type_ok = true;
+      }
+
+    return type_ok;
+  }
+
+bool
+HTTP_Compressor::
+compress_response(cow_string& output, HTTP_S_Headers& resp, chars_view data,
+                  HTTP_Content_Coding coding, int level, size_t cache_size)
+  {
+    if((level == 0) || !is_response_compressible(resp, data.n))
+      return false;
+
+    if(coding == http_coding_identity) {
+      do_append_vary_header(resp);
+      return false;
+    }
+
+    // Look for a cached representation. Only responses with a strong `ETag`
+    // are cached, as weak validators are not precise enough. The same `ETag`
+    // may be sent for different resources, so the key is the content coding,
+    // followed by the SHA-256 checksum of the payload, followed by the `ETag`.
+    phcow_string cache_key;
+    if(cache_size != 0)
+      for(const auto& hr : resp.headers)
+        if((hr.first == "ETag") && (hr.second.as_string().size() >= 2)
+           && (hr.second.as_string()[0] == '\"')) {
+          unsigned char checksum[SHA256_DIGEST_LENGTH];
+          ::SHA256(reinterpret_cast<const unsigned char*>(data.p), data.n, checksum);
+
+          cow_string key;
+          key.push_back(static_cast<char>('0' + coding));
+          key.append(reinterpret_cast<const char*>(checksum), sizeof(checksum));
+          key.append(hr.second.as_string());
+          cache_key = move(key);
+          break;
+        }
+
+    if(cache_key.empty() || !s_cache.find(output, cache_key, data.n)) {
+      HTTP_Compressor compr(coding, level);
+      const char* ptr = data.p;
+      const char* end = ptr + data.n;
+      while(ptr != end)
+        ptr += compr.deflate(chars_view(ptr, static_cast<size_t>(end - ptr)));
+      compr.finish();
+
+      // Don't bother if compression didn't help.
+      if(compr.m_obuf.size() >= data.n) {
+        do_append_vary_header(resp);
+        return false;
+      }
+
+      output.assign(compr.m_obuf.data(), compr.m_obuf.size());
+      if(!cache_key.empty())
+        s_cache.insert(cache_key, data.n, output, cache_size);
+    }
+
+    do_append_coding_headers(resp, coding);
+    return true;
+  }
+
+bool
+HTTP_Compressor::
+prepare_chunked_response(HTTP_S_Headers& resp, HTTP_Content_Coding coding, int level)
+  {
+    // The length of a chunked payload is unknown, so assume it's large enough.
+    if((level == 0) || !is_response_compressible(resp, SIZE_MAX))
+      return false;
+
+    if(coding == http_coding_identity) {
+      do_append_vary_header(resp);
+      return false;
+    }
+
+    do_append_coding_headers(resp, coding);
+    return true;
+  }
+
+}  // namespace poseidon
@@ -121,9 +121,8 @@ HTTP_Request_Parser::s_settings[1] =
             return 2;
           }
 
-          uri.insert(0, 1, 'a');
-          if(parse_network_reference(ref, uri) != uri.size()) {
-            ps->http_errno = HPE_INVALID_HOST;
+          if(parse_request_target(ref, uri) != uri.size()) {
+            ps->http_errno = HPE_INVALID_PATH;
             return 2;
           }
 
@@ -211,6 +210,8 @@ HTTP_Request_Parser()
     auto conf_file = main_config.copy();
     this->m_default_compression_level = static_cast<int>(conf_file.get_integer_opt(
                                 &"network.http.default_compression_level", 0, 9).value_or(6));
+    this->m_compression_cache_size = static_cast<uint32_t>(conf_file.get_integer_opt(
+                       &"network.http.compression_cache_size", 0, 1073741824).value_or(16777216));
     this->m_max_header_length = static_cast<uint32_t>(conf_file.get_integer_opt(
                            &"network.http.max_header_length", 256, 16777216).value_or(262144));
     this->m_max_content_length = static_cast<uint32_t>(conf_file.get_integer_opt(
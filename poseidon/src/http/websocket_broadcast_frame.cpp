@@ -0,0 +1,126 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../http/websocket_broadcast_frame.hpp"
+#include "../../http/websocket_frame_header.hpp"
+#include "../../details/zlib_fwd.hpp"
+#include "../../utils.hpp"
+namespace poseidon {
+namespace {
+
+// Messages are compressed by new streams, which have no history to refer to,
+// so this is the same threshold as `ws_send()` without context takeover.
+constexpr size_t s_compression_threshold = 1024;
+
+}  // namespace
+
+WebSocket_Broadcast_Frame::
+WebSocket_Broadcast_Frame(WS_Opcode opcode, chars_view data)
+  {
+    switch(static_cast<uint32_t>(opcode))
+      {
+      case ws_TEXT:
+      case ws_BINARY:
+        break;
+
+      case ws_PING:
+      case ws_PONG:
+        if(data.n > 125)
+          POSEIDON_THROW(("Control frame too large: `$1` > `125`"), data.n);
+        break;
+
+      default:
+        POSEIDON_THROW(("WebSocket opcode `$1` not broadcastable"), opcode);
+      }
+
+    this->m_opcode = opcode;
+    this->m_payload_size = data.n;
+
+    // FIN + opcode
+    WebSocket_Frame_Header header;
+    header.fin = 1;
+    header.opcode = opcode;
+    header.payload_len = data.n;
+
+    tinyfmt_str fmt;
+    header.encode(fmt);
+    fmt.putn(data.p, data.n);
+    this->m_plain = fmt.extract_string();
+  }
+
+WebSocket_Broadcast_Frame::
+~WebSocket_Broadcast_Frame()
+  {
+  }
+
+cow_string
+WebSocket_Broadcast_Frame::
+compressed_frame(uint8_t window_bits, int level)
+  const
+  {
+    if(is_none_of(this->m_opcode, { ws_TEXT, ws_BINARY }))
+      return { };
+
+    if(this->m_payload_size < s_compression_threshold)
+      return { };
+
+    if((window_bits < 9) || (window_bits > 15))
+      POSEIDON_THROW(("Window bits `$1` not valid"), window_bits);
+
+    plain_mutex::unique_lock lock(this->m_pmce_mutex);
+    if(this->m_pmce_done >> window_bits & 1)
+      return this->m_pmce[window_bits];
+
+    // Get the payload from the uncompressed frame.
+    const char* in_ptr = this->m_plain.data() + this->m_plain.size() - this->m_payload_size;
+    const char* in_end = in_ptr + this->m_payload_size;
+
+    scoped_deflate_stream strm(zlib_raw, window_bits, level);
+    linear_buffer obuf;
+    int err;
+
+    do {
+      // Allocate an output buffer and write compressed data there.
+      size_t out_size = obuf.reserve_after_end(1024);
+      char* out_ptr = obuf.mut_end();
+      strm.set_buffers(out_ptr, out_ptr + out_size, in_ptr, in_end);
+      err = ::deflate(strm, Z_SYNC_FLUSH);
+
+      strm.get_buffers(out_ptr, in_ptr);
+      obuf.accept(static_cast<size_t>(out_ptr - obuf.mut_end()));
+
+      if(is_none_of(err, { Z_OK, Z_BUF_ERROR }))
+        POSEIDON_THROW((
+            "Failed to compress WebSocket message; zlib error: $1",
+            "[`deflate()` returned `$2`]"),
+            strm.msg(), err);
+    }
+    while(err == Z_OK);
+
+    if((obuf.size() >= 4)
+       && (::memcmp(obuf.end() - 4, "\x00\x00\xFF\xFF", 4) == 0))
+      obuf.unaccept(4);
+
+    // If compression doesn't help, don't bother.
+    cow_string frame;
+    if(obuf.size() < this->m_payload_size) {
+      // FIN + RSV1 + opcode
+      WebSocket_Frame_Header header;
+      header.fin = 1;
+      header.rsv1 = 1;
+      header.opcode = this->m_opcode;
+      header.payload_len = obuf.size();
+
+      tinyfmt_str fmt;
+      header.encode(fmt);
+      fmt.putn(obuf.data(), obuf.size());
+      frame = fmt.extract_string();
+    }
+
+    this->m_pmce[window_bits] = frame;
+    this->m_pmce_done |= 1U << window_bits;
+    return frame;
+  }
+
+}  // namespace poseidon
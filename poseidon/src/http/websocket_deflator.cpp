@@ -4,20 +4,199 @@
 #include "../xprecompiled.hpp"
 #include "../../http/websocket_deflator.hpp"
 #include "../../http/websocket_frame_parser.hpp"
+#include "../../base/abstract_timer.hpp"
+#include "../../static/timer_scheduler.hpp"
 #include "../../utils.hpp"
+#include <unordered_set>
 namespace poseidon {
+namespace {
+
+// zlib allocates a few large blocks for each stream, whose sizes are determined
+// by window bits and memory levels. As streams are released and rebuilt very
+// frequently, freed blocks are kept in buckets of the same size, up to a limit
+// of the total size, and are shared by all deflators.
+constexpr size_t s_pool_max_bytes = 32 << 20;  // 32 MiB
+constexpr size_t s_pool_max_buckets = 32;
+
+struct alignas(16) Pooled_Block
+  {
+    size_t size;
+    Pooled_Block* next;
+  };
+
+struct Pool_Bucket
+  {
+    size_t size;
+    Pooled_Block* head;
+  };
+
+struct zlib_Memory_Pool
+  {
+    plain_mutex mutex;
+    size_t cached_bytes = 0;
+    size_t bucket_count = 0;
+    Pool_Bucket buckets[s_pool_max_buckets];
+  };
+
+zlib_Memory_Pool s_pool;
+
+::voidpf
+do_zlib_alloc(::voidpf /*opaque*/, ::uInt items, ::uInt size)
+  {
+    size_t bytes = static_cast<size_t>(items) * size;
+
+    plain_mutex::unique_lock lock(s_pool.mutex);
+    for(size_t k = 0;  k != s_pool.bucket_count;  ++k)
+      if(s_pool.buckets[k].size == bytes) {
+        auto block = s_pool.buckets[k].head;
+        if(!block)
+          break;
+
+        // Reuse a cached block.
+        s_pool.buckets[k].head = block->next;
+        s_pool.cached_bytes -= bytes;
+        return block + 1;
+      }
+    lock.unlock();
+
+    // zlib expects a null pointer if no memory can be allocated.
+    auto block = static_cast<Pooled_Block*>(::malloc(sizeof(Pooled_Block) + bytes));
+    if(!block)
+      return nullptr;
+
+    block->size = bytes;
+    return block + 1;
+  }
+
+void
+do_zlib_free(::voidpf /*opaque*/, ::voidpf ptr)
+  {
+    auto block = static_cast<Pooled_Block*>(ptr) - 1;
+
+    plain_mutex::unique_lock lock(s_pool.mutex);
+    if(s_pool.cached_bytes + block->size <= s_pool_max_bytes) {
+      size_t k = 0;
+      while((k != s_pool.bucket_count) && (s_pool.buckets[k].size != block->size))
+        k ++;
+
+      if((k == s_pool.bucket_count) && (k != s_pool_max_buckets)) {
+        s_pool.buckets[k].size = block->size;
+        s_pool.buckets[k].head = nullptr;
+        s_pool.bucket_count ++;
+      }
+
+      if(k != s_pool.bucket_count) {
+        // Keep this block for reuse.
+        block->next = s_pool.buckets[k].head;
+        s_pool.buckets[k].head = block;
+        s_pool.cached_bytes += block->size;
+        return;
+      }
+    }
+    lock.unlock();
+
+    ::free(block);
+  }
+
+struct Deflator_Registry
+  {
+    plain_mutex mutex;
+    ::std::unordered_set<WebSocket_Deflator*> deflators;
+    shptr<Abstract_Timer> timer;
+  };
+
+Deflator_Registry s_registry;
+
+struct Final_Timer final : Abstract_Timer
+  {
+    virtual
+    void
+    do_abstract_timer_on_tick(steady_time now)
+      override
+      {
+        plain_mutex::unique_lock lock(s_registry.mutex);
+        for(auto deflator : s_registry.deflators)
+          deflator->release_idle_streams(now);
+      }
+  };
+
+}  // namespace
 
 WebSocket_Deflator::
 WebSocket_Deflator(const WebSocket_Frame_Parser& parser)
-  :
-    m_def_strm(zlib_raw, parser.pmce_send_window_bits(), parser.pmce_compression_level()),
-    m_inf_strm(zlib_raw, parser.pmce_receive_window_bits())
   {
+    this->m_def_level = parser.pmce_compression_level();
+    this->m_def_wbits = parser.pmce_send_window_bits();
+    this->m_def_mem_level = parser.deflate_mem_level();
+    this->m_def_no_context_takeover = parser.pmce_send_no_context_takeover();
+    this->m_inf_wbits = parser.pmce_receive_window_bits();
+    this->m_inf_no_context_takeover = parser.pmce_receive_no_context_takeover();
+    this->m_idle_timeout = parser.deflate_idle_timeout();
+
+    if(this->m_idle_timeout != 0s) {
+      // Register this deflator, so its zlib streams will be released if it
+      // stays idle for too long.
+      plain_mutex::unique_lock lock(s_registry.mutex);
+      if(!s_registry.timer) {
+        auto timer = new_sh<Final_Timer>();
+        timer_scheduler.insert_weak(timer, 5s, 5s);
+        s_registry.timer = move(timer);
+      }
+      s_registry.deflators.insert(this);
+    }
   }
 
 WebSocket_Deflator::
 ~WebSocket_Deflator()
   {
+    if(this->m_idle_timeout != 0s) {
+      plain_mutex::unique_lock lock(s_registry.mutex);
+      s_registry.deflators.erase(this);
+    }
+  }
+
+scoped_deflate_stream&
+WebSocket_Deflator::
+do_deflate_stream_nolock()
+  {
+    if(!this->m_def_strm)
+      this->m_def_strm = new_uni<scoped_deflate_stream>(zlib_raw, this->m_def_wbits,
+                                       this->m_def_level, this->m_def_mem_level,
+                                       do_zlib_alloc, do_zlib_free);
+
+    this->m_def_used = steady_clock::now();
+    return *(this->m_def_strm);
+  }
+
+scoped_inflate_stream&
+WebSocket_Deflator::
+do_inflate_stream_nolock()
+  {
+    if(!this->m_inf_strm) {
+      auto strm = new_uni<scoped_inflate_stream>(zlib_raw, this->m_inf_wbits,
+                                                 do_zlib_alloc, do_zlib_free);
+
+      if(this->m_inf_dict.size() != 0) {
+        // Restore the sliding window that was saved when this stream was
+        // released, as the peer may reference data in it.
+        int err = ::inflateSetDictionary(*strm,
+                      reinterpret_cast<const ::Bytef*>(this->m_inf_dict.data()),
+                      static_cast<::uInt>(this->m_inf_dict.size()));
+
+        if(err != Z_OK)
+          POSEIDON_THROW((
+              "Failed to restore WebSocket inflator; zlib error: $1",
+              "[`inflateSetDictionary()` returned `$2`]"),
+              strm->msg(), err);
+
+        ::asteria::exchange(this->m_inf_dict);
+      }
+
+      this->m_inf_strm = move(strm);
+    }
+
+    this->m_inf_used = steady_clock::now();
+    return *(this->m_inf_strm);
   }
 
 void
@@ -26,7 +205,8 @@ deflate_reset(plain_mutex::unique_lock& lock)
   noexcept
   {
     lock.lock(this->m_def_mtx);
-    ::deflateReset(this->m_def_strm);
+    this->m_def_strm.reset();
+    this->m_def_busy = false;
   }
 
 void
@@ -37,6 +217,8 @@ deflate_message_stream(plain_mutex::unique_lock& lock, chars_view data)
       return;
 
     lock.lock(this->m_def_mtx);
+    auto& strm = this->do_deflate_stream_nolock();
+    this->m_def_busy = true;
     int err;
     const char* in_ptr = data.p;
     const char* in_end = in_ptr + data.n;
@@ -45,17 +227,17 @@ deflate_message_stream(plain_mutex::unique_lock& lock, chars_view data)
       // Allocate an output buffer and write compressed data there.
       size_t out_size = this->m_def_buf.reserve_after_end(1024);
       char* out_ptr = this->m_def_buf.mut_end();
-      this->m_def_strm.set_buffers(out_ptr, out_ptr + out_size, in_ptr, in_end);
-      err = ::deflate(this->m_def_strm, Z_NO_FLUSH);
+      strm.set_buffers(out_ptr, out_ptr + out_size, in_ptr, in_end);
+      err = ::deflate(strm, Z_NO_FLUSH);
 
-      this->m_def_strm.get_buffers(out_ptr, in_ptr);
+      strm.get_buffers(out_ptr, in_ptr);
       this->m_def_buf.accept(static_cast<size_t>(out_ptr - this->m_def_buf.mut_end()));
 
       if(is_none_of(err, { Z_OK, Z_BUF_ERROR }))
         POSEIDON_THROW((
             "Failed to compress WebSocket message; zlib error: $1",
             "[`deflate()` returned `$2`]"),
-            this->m_def_strm.msg(), err);
+            strm.msg(), err);
     }
     while((in_ptr != in_end) && (err == Z_OK));
   }
@@ -65,6 +247,7 @@ WebSocket_Deflator::
 deflate_message_finish(plain_mutex::unique_lock& lock)
   {
     lock.lock(this->m_def_mtx);
+    auto& strm = this->do_deflate_stream_nolock();
     int err;
     const char* in_ptr = "";
     const char* in_end = in_ptr;
@@ -73,23 +256,29 @@ deflate_message_finish(plain_mutex::unique_lock& lock)
       // Allocate an output buffer and write compressed data there.
       size_t out_size = this->m_def_buf.reserve_after_end(16);
       char* out_ptr = this->m_def_buf.mut_end();
-      this->m_def_strm.set_buffers(out_ptr, out_ptr + out_size, in_ptr, in_end);
-      err = ::deflate(this->m_def_strm, Z_SYNC_FLUSH);
+      strm.set_buffers(out_ptr, out_ptr + out_size, in_ptr, in_end);
+      err = ::deflate(strm, Z_SYNC_FLUSH);
 
-      this->m_def_strm.get_buffers(out_ptr, in_ptr);
+      strm.get_buffers(out_ptr, in_ptr);
       this->m_def_buf.accept(static_cast<size_t>(out_ptr - this->m_def_buf.mut_end()));
 
       if(is_none_of(err, { Z_OK, Z_BUF_ERROR }))
         POSEIDON_THROW((
             "Failed to compress WebSocket message; zlib error: $1",
             "[`deflate()` returned `$2`]"),
-            this->m_def_strm.msg(), err);
+            strm.msg(), err);
     }
     while(err == Z_OK);
 
     if((this->m_def_buf.size() >= 4)
        && (::memcmp(this->m_def_buf.end() - 4, "\x00\x00\xFF\xFF", 4) == 0))
       this->m_def_buf.unaccept(4);
+
+    // Without context takeover, the next message will be compressed by a new
+    // stream, so there is no need to keep this one.
+    this->m_def_busy = false;
+    if(this->m_def_no_context_takeover)
+      this->m_def_strm.reset();
   }
 
 void
@@ -101,6 +290,8 @@ inflate_message_stream(plain_mutex::unique_lock& lock, chars_view data,
       return;
 
     lock.lock(this->m_inf_mtx);
+    auto& strm = this->do_inflate_stream_nolock();
+    this->m_inf_busy = true;
     int err;
     const char* in_ptr = data.p;
     const char* in_end = in_ptr + data.n;
@@ -109,17 +300,17 @@ inflate_message_stream(plain_mutex::unique_lock& lock, chars_view data,
       // Allocate an output buffer and write compressed data there.
       size_t out_size = this->m_inf_buf.reserve_after_end(1024);
       char* out_ptr = this->m_inf_buf.mut_end();
-      this->m_inf_strm.set_buffers(out_ptr, out_ptr + out_size, in_ptr, in_end);
-      err = ::inflate(this->m_inf_strm, Z_SYNC_FLUSH);
+      strm.set_buffers(out_ptr, out_ptr + out_size, in_ptr, in_end);
+      err = ::inflate(strm, Z_SYNC_FLUSH);
 
-      this->m_inf_strm.get_buffers(out_ptr, in_ptr);
+      strm.get_buffers(out_ptr, in_ptr);
       this->m_inf_buf.accept(static_cast<size_t>(out_ptr - this->m_inf_buf.mut_end()));
 
       if(is_none_of(err, { Z_OK, Z_BUF_ERROR }))
         POSEIDON_THROW((
             "Failed to decompress WebSocket message; zlib error: $1",
             "[`inflate()` returned `$2`]"),
-            this->m_inf_strm.msg(), err);
+            strm.msg(), err);
 
       if(this->m_inf_buf.size() > max_message_length)
         POSEIDON_THROW((
@@ -134,6 +325,7 @@ WebSocket_Deflator::
 inflate_message_finish(plain_mutex::unique_lock& lock)
   {
     lock.lock(this->m_inf_mtx);
+    auto& strm = this->do_inflate_stream_nolock();
     int err;
     const char* in_ptr = "\x00\x00\xFF\xFF";
     const char* in_end = in_ptr + 4;
@@ -142,19 +334,65 @@ inflate_message_finish(plain_mutex::unique_lock& lock)
       // Allocate an output buffer and write compressed data there.
       size_t out_size = this->m_inf_buf.reserve_after_end(16);
       char* out_ptr = this->m_inf_buf.mut_end();
-      this->m_inf_strm.set_buffers(out_ptr, out_ptr + out_size, in_ptr, in_end);
-      err = ::inflate(this->m_inf_strm, Z_SYNC_FLUSH);
+      strm.set_buffers(out_ptr, out_ptr + out_size, in_ptr, in_end);
+      err = ::inflate(strm, Z_SYNC_FLUSH);
 
-      this->m_inf_strm.get_buffers(out_ptr, in_ptr);
+      strm.get_buffers(out_ptr, in_ptr);
       this->m_inf_buf.accept(static_cast<size_t>(out_ptr - this->m_inf_buf.mut_end()));
 
       if(is_none_of(err, { Z_OK, Z_BUF_ERROR }))
         POSEIDON_THROW((
             "Failed to decompress WebSocket message; zlib error: $1",
             "[`inflate()` returned `$2`]"),
-            this->m_inf_strm.msg(), err);
+            strm.msg(), err);
     }
     while(err == Z_OK);
+
+    // Without context takeover, the peer will not reference data in previous
+    // messages, so there is no need to keep this stream.
+    this->m_inf_busy = false;
+    if(this->m_inf_no_context_takeover)
+      this->m_inf_strm.reset();
+  }
+
+void
+WebSocket_Deflator::
+release_idle_streams(steady_time now)
+  noexcept
+  {
+    if(this->m_idle_timeout == 0s)
+      return;
+
+    plain_mutex::unique_lock def_lock(this->m_def_mtx);
+    if(!this->m_def_busy && (now - this->m_def_used >= this->m_idle_timeout)) {
+      this->m_def_strm.reset();
+      ::asteria::exchange(this->m_def_buf);
+    }
+    def_lock.unlock();
+
+    plain_mutex::unique_lock inf_lock(this->m_inf_mtx);
+    if(this->m_inf_busy || (now - this->m_inf_used < this->m_idle_timeout))
+      return;
+
+    if(this->m_inf_strm && !this->m_inf_no_context_takeover)
+      try {
+        // Save the sliding window, which is no larger than what has been
+        // decompressed so far.
+        ::uInt dict_len = 0;
+        ::inflateGetDictionary(*(this->m_inf_strm), nullptr, &dict_len);
+        this->m_inf_dict.clear();
+        this->m_inf_dict.reserve_after_end(dict_len);
+        ::inflateGetDictionary(*(this->m_inf_strm),
+                               reinterpret_cast<::Bytef*>(this->m_inf_dict.mut_end()), &dict_len);
+        this->m_inf_dict.accept(dict_len);
+      }
+      catch(exception& stdex) {
+        POSEIDON_LOG_WARN(("Could not save WebSocket inflator window: $1"), stdex);
+        return;
+      }
+
+    this->m_inf_strm.reset();
+    ::asteria::exchange(this->m_inf_buf);
   }
 
 }  // namespace poseidon
@@ -59,7 +59,8 @@ struct PerMessage_Deflate
     int client_max_window_bits = 15;
 
     void
-    use_permessage_deflate(HTTP_Header_Parser& hparser, int default_compression_level)
+    use_permessage_deflate(HTTP_Header_Parser& hparser, int default_compression_level,
+                           int max_window_bits)
       {
         if(this->compression_level != 0)
           return;
@@ -108,17 +109,21 @@ struct PerMessage_Deflate
             this->server_max_window_bits = static_cast<int>(value);
           }
           else if(hparser.current_name() == "client_max_window_bits") {
-            if(hparser.current_value().is_null())
-              continue;
-
             // `client_max_window_bits`:
             // States the maximum size of the LZ77 sliding window that the client
-            // will use, in number of bits.
-            int64_t value = hparser.current_value().as_integer();
-            if((value < 9) || (value > 15))
-              return;
+            // will use, in number of bits. If no value is given, the client
+            // merely indicates that it supports this parameter, so the server
+            // may still request a smaller window to save memory.
+            int64_t value = 15;
+            if(!hparser.current_value().is_null()) {
+              value = hparser.current_value().as_integer();
+              if((value < 9) || (value > 15))
+                return;
+            }
 
             this->client_max_window_bits = static_cast<int>(value);
+            if(this->client_max_window_bits > max_window_bits)
+              this->client_max_window_bits = max_window_bits;
           }
           else
             return;
@@ -136,6 +141,12 @@ WebSocket_Frame_Parser()
     auto conf_file = main_config.copy();
     this->m_default_compression_level = static_cast<int>(conf_file.get_integer_opt(
                                 &"network.http.default_compression_level", 0, 9).value_or(6));
+    this->m_deflate_mem_level = static_cast<uint8_t>(conf_file.get_integer_opt(
+                                &"network.http.websocket_deflate_mem_level", 1, 9).value_or(8));
+    this->m_deflate_max_window_bits = static_cast<uint8_t>(conf_file.get_integer_opt(
+                          &"network.http.websocket_deflate_max_window_bits", 9, 15).value_or(15));
+    this->m_deflate_idle_timeout = seconds(static_cast<int>(conf_file.get_integer_opt(
+                        &"network.http.websocket_deflate_idle_timeout", 0, 86400).value_or(30)));
     this->m_max_message_length = static_cast<uint32_t>(conf_file.get_integer_opt(
                      &"network.http.max_websocket_message_length", 256, 16777216).value_or(1048576));
   }
@@ -187,8 +198,13 @@ create_handshake_request(HTTP_C_Headers& req)
     Sec_WebSocket sec_ws;
     sec_ws.make_key_str(this);
     req.headers.emplace_back(&"Sec-WebSocket-Key", cow_string(sec_ws.key_str, 24));
-    req.headers.emplace_back(&"Sec-WebSocket-Extensions",
-                             &"permessage-deflate; client_max_window_bits");
+    // If the window size is capped, ask the server to use a smaller window, so
+    // our inflator takes less memory.
+    tinyfmt_str pmce_fmt;
+    pmce_fmt << "permessage-deflate; client_max_window_bits";
+    if(this->m_deflate_max_window_bits != 15)
+      pmce_fmt << "; server_max_window_bits=" << static_cast<int>(this->m_deflate_max_window_bits);
+    req.headers.emplace_back(&"Sec-WebSocket-Extensions", pmce_fmt.extract_string());
 
     // Await the response. This cannot fail, so `m_wsf` is not updated.
     this->m_wshs = wshs_c_req_sent;
@@ -261,7 +277,8 @@ accept_handshake_request(HTTP_S_Headers& resp, const HTTP_C_Headers& req)
         hparser.reload(hr.second.as_string());
         while(hparser.next_element())
           if(hparser.current_name() == "permessage-deflate")
-            pmce.use_permessage_deflate(hparser, this->m_default_compression_level);
+            pmce.use_permessage_deflate(hparser, this->m_default_compression_level,
+                                        this->m_deflate_max_window_bits);
       }
 
     if(!upgrade_ok || !ws_version_ok || !sec_ws.key_str[0]) {
@@ -306,10 +323,13 @@ accept_handshake_request(HTTP_S_Headers& resp, const HTTP_C_Headers& req)
       resp.headers.emplace_back(&"Sec-WebSocket-Extensions", pmce_fmt.extract_string());
 
       // Accept PMCE parameters.
+      // A compressor may always use a window smaller than the negotiated one.
       this->m_pmce_reserved = 0;
+      this->m_pmce_receive_no_context_takeover = pmce.client_no_context_takeover;
       this->m_pmce_compression_level_m2 = clamp(pmce.compression_level - 2, 1, 7) & 7;
       this->m_pmce_send_no_context_takeover = pmce.server_no_context_takeover;
-      this->m_pmce_send_window_bits = pmce.server_max_window_bits & 15;
+      this->m_pmce_send_window_bits = ::std::min(pmce.server_max_window_bits,
+                                                 static_cast<int>(this->m_deflate_max_window_bits)) & 15;
       this->m_pmce_receive_window_bits = pmce.client_max_window_bits & 15;
     }
 
@@ -362,7 +382,8 @@ accept_handshake_response(const HTTP_S_Headers& resp)
         hparser.reload(hr.second.as_string());
         while(hparser.next_element())
           if(hparser.current_name() == "permessage-deflate")
-            pmce.use_permessage_deflate(hparser, this->m_default_compression_level);
+            pmce.use_permessage_deflate(hparser, this->m_default_compression_level,
+                                        this->m_deflate_max_window_bits);
           else
             return;  // unknown extension; fail
       }
@@ -385,10 +406,13 @@ accept_handshake_response(const HTTP_S_Headers& resp)
 
     if(pmce.compression_level != 0) {
       // Accept PMCE parameters.
+      // A compressor may always use a window smaller than the negotiated one.
       this->m_pmce_reserved = 0;
+      this->m_pmce_receive_no_context_takeover = pmce.server_no_context_takeover;
       this->m_pmce_compression_level_m2 = clamp(pmce.compression_level - 2, 1, 7) & 7;
       this->m_pmce_send_no_context_takeover = pmce.client_no_context_takeover;
-      this->m_pmce_send_window_bits = pmce.client_max_window_bits & 15;
+      this->m_pmce_send_window_bits = ::std::min(pmce.client_max_window_bits,
+                                                 static_cast<int>(this->m_deflate_max_window_bits)) & 15;
       this->m_pmce_receive_window_bits = pmce.server_max_window_bits & 15;
     }
 
@@ -9,6 +9,8 @@
 #include "../static/timer_scheduler.hpp"
 #include "../static/task_scheduler.hpp"
 #include "../static/network_scheduler.hpp"
+#include "../static/dns_resolver.hpp"
+#include "../static/http_connector.hpp"
 #include "../static/mysql_connector.hpp"
 #include "../static/mongo_connector.hpp"
 #include "../static/redis_connector.hpp"
@@ -535,6 +537,8 @@ main(int argc, char** argv)
     redis_connector.reload(main_config.copy());
 
     network_scheduler.reload(main_config.copy());
+    dns_resolver.reload(main_config.copy());
+    http_connector.reload(main_config.copy());
     fiber_scheduler.reload(main_config.copy());
 
     do_create_threads();
@@ -3,8 +3,9 @@
 
 #include "../xprecompiled.hpp"
 #include "../../mongo/mongo_connection.hpp"
+#include "../../mongo/mongo_document_view.hpp"
+#include "../../mongo/mongo_document_builder.hpp"
 #include "../../utils.hpp"
-#include <forward_list>
 namespace poseidon {
 
 Mongo_Connection::
@@ -61,9 +62,29 @@ reset()
     return true;
   }
 
+uint32_t
+Mongo_Connection::
+select_server()
+  {
+    // `mongoc_client_command_simple()` selects the primary with no read
+    // preference, which is also selected for writes.
+    ::bson_error_t error;
+    ::mongoc_server_description_t* sd = ::mongoc_client_select_server(this->m_mongo, true,
+                                                                      nullptr, &error);
+    if(!sd)
+      POSEIDON_THROW((
+          "Could not select Mongo server: ERROR $1.$2: $3",
+          "[`mongoc_client_select_server()` failed]"),
+          error.domain, error.code, error.message);
+
+    uint32_t server_id = ::mongoc_server_description_id(sd);
+    ::mongoc_server_description_destroy(sd);
+    return server_id;
+  }
+
 void
 Mongo_Connection::
-execute_bson(const ::bson_t* bson_cmd)
+execute_bson(const ::bson_t* bson_cmd, uint32_t server_id)
   {
     if(!bson_cmd || (bson_cmd->len == 0))
       POSEIDON_THROW(("Null or empty BSON query"));
@@ -77,12 +98,22 @@ execute_bson(const ::bson_t* bson_cmd)
     // the reply object, so destroy it first.
     ::bson_destroy(this->m_reply);
     ::bson_error_t error;
-    if(!::mongoc_client_command_simple(this->m_mongo, this->m_db.c_str(), bson_cmd,
-                                       nullptr, this->m_reply, &error))
-      POSEIDON_THROW((
-          "MongoDB command failed: ERROR $1.$2: $3",
-          "[`mongoc_client_command_simple()` failed]"),
-          error.domain, error.code, error.message);
+    if(server_id == 0) {
+      if(!::mongoc_client_command_simple(this->m_mongo, this->m_db.c_str(), bson_cmd,
+                                         nullptr, this->m_reply, &error))
+        POSEIDON_THROW((
+            "MongoDB command failed: ERROR $1.$2: $3",
+            "[`mongoc_client_command_simple()` failed]"),
+            error.domain, error.code, error.message);
+    }
+    else {
+      if(!::mongoc_client_command_simple_with_server_id(this->m_mongo, this->m_db.c_str(),
+                                         bson_cmd, nullptr, server_id, this->m_reply, &error))
+        POSEIDON_THROW((
+            "MongoDB command failed: ERROR $1.$2: $3",
+            "[`mongoc_client_command_simple_with_server_id()` failed]"),
+            error.domain, error.code, error.message);
+    }
 
     // This will be checked in `fetch_reply_bson_opt()`.
     this->m_reply_available = true;
@@ -90,162 +121,26 @@ execute_bson(const ::bson_t* bson_cmd)
 
 void
 Mongo_Connection::
-execute(const Mongo_Document& cmd)
+execute(const Mongo_Document_Builder& cmd, uint32_t server_id)
   {
-    // Pack the command into a BSON object.
-    struct xFrame
-      {
-        const Mongo_Array* psa;
-        const Mongo_Document* pso;
-        size_t rpos;
-        decltype(::bson_append_array_end)* append_end_fn;
-        ::bson_t temp;
-      };
-
-    scoped_bson bson_cmd;
-    ::std::forward_list<xFrame> stack;
-    bool success = true;
-    const Mongo_Array* cur_a = nullptr;
-    const Mongo_Document* cur_o = &cmd;
-    size_t cur_rpos = cmd.size();
-
-  do_unpack_loop_:
-    while(success && (cur_rpos != 0)) {
-      ::bson_t* pbson = stack.empty() ? bson_cmd : &(stack.front().temp);
-      ::asteria::ascii_numput array_key_nump;
-      const char* key;
-      int key_len;
-      const Mongo_Value* pval;
-
-      if(cur_a) {
-        // array; keys are subscripts as decimal strings.
-        size_t pos = cur_a->size() - cur_rpos;
-        cur_rpos --;
-        array_key_nump.put_DU(pos);
-        key = array_key_nump.data();
-        key_len = static_cast<int>(array_key_nump.size());
-        pval = &(cur_a->at(pos));
-      }
-      else {
-        // documents
-        size_t pos = cur_o->size() - cur_rpos;
-        cur_rpos --;
-        key = cur_o->at(pos).first.data();
-        key_len = clamp_cast<int>(cur_o->at(pos).first.ssize(), 0, INT_MAX);
-        pval = &(cur_o->at(pos).second);
-      }
-
-      switch(pval->type())
-        {
-        case mongo_value_null:
-          success = ::bson_append_null(pbson, key, key_len);
-          break;
-
-        case mongo_value_boolean:
-          success = ::bson_append_bool(pbson, key, key_len, pval->as_boolean());
-          break;
-
-        case mongo_value_integer:
-          success = (pval->as_integer() == static_cast<int32_t>(pval->as_integer()))
-                    ? ::bson_append_int32(pbson, key, key_len, static_cast<int32_t>(pval->as_integer()))
-                    : ::bson_append_int64(pbson, key, key_len, pval->as_integer());
-          break;
-
-        case mongo_value_double:
-          success = ::bson_append_double(pbson, key, key_len, pval->as_double());
-          break;
-
-        case mongo_value_utf8:
-          success = (pval->as_utf8_length() <= INT_MAX)
-                    && ::bson_append_utf8(pbson, key, key_len, pval->as_utf8_c_str(),
-                                          static_cast<int>(pval->as_utf8_length()));
-          break;
-
-        case mongo_value_binary:
-          success = (pval->as_binary_size() <= UINT_MAX)
-                    && ::bson_append_binary(pbson, key, key_len, BSON_SUBTYPE_BINARY,
-                                            pval->as_binary_data(),
-                                            static_cast<unsigned>(pval->as_binary_size()));
-          break;
-
-        case mongo_value_array:
-          {
-            auto& frm = stack.emplace_front();
-            success = ::bson_append_array_unsafe_begin(pbson, key, key_len, &(frm.temp));
-            if(success) {
-              // open
-              frm.psa = cur_a;
-              frm.pso = cur_o;
-              frm.rpos = cur_rpos;
-              frm.append_end_fn = ::bson_append_array_end;
-              cur_a = &(pval->as_array());
-              cur_o = nullptr;
-              cur_rpos = cur_a->size();
-              goto do_unpack_loop_;
-            }
-
-            // invalid; shouldn't happen, but be tolerant anyway.
-            stack.pop_front();
-          }
-          break;
-
-        case mongo_value_document:
-          {
-            auto& frm = stack.emplace_front();
-            success = ::bson_append_document_begin(pbson, key, key_len, &(frm.temp));
-            if(success) {
-              // open
-              frm.psa = cur_a;
-              frm.pso = cur_o;
-              frm.rpos = cur_rpos;
-              frm.append_end_fn = ::bson_append_document_end;
-              cur_a = nullptr;
-              cur_o = &(pval->as_document());
-              cur_rpos = cur_o->size();
-              goto do_unpack_loop_;
-            }
-
-            // invalid; shouldn't happen, but be tolerant anyway.
-            stack.pop_front();
-          }
-          break;
-
-        case mongo_value_oid:
-          success = ::bson_append_oid(pbson, key, key_len, &(pval->as_oid()));
-          break;
-
-        case mongo_value_datetime:
-          success = ::bson_append_date_time(pbson, key, key_len,
-                        duration_cast<milliseconds>(pval->as_system_time().time_since_epoch()).count());
-          break;
-
-        default:
-          ASTERIA_TERMINATE(("Corrupted value type `$1`"), pval->m_stor.index());
-        }
-    }
-
-    if(success && !stack.empty()) {
-      ::std::forward_list<xFrame> top;
-      top.splice_after(top.before_begin(), stack, stack.before_begin());
-      auto& frm = top.front();
-      success = (* frm.append_end_fn) (stack.empty() ? bson_cmd : &(stack.front().temp), &(frm.temp));
-      cur_a = frm.psa;
-      cur_o = frm.pso;
-      cur_rpos = frm.rpos;
-      goto do_unpack_loop_;
-    }
-
-    if(!success)
-      POSEIDON_THROW(("Failed to compose BSON command"));
-
     ::bson_error_t error;
-    if(!::bson_validate_with_error(bson_cmd, BSON_VALIDATE_UTF8, &error))
+    if(!::bson_validate_with_error(cmd.bson(), BSON_VALIDATE_UTF8, &error))
       POSEIDON_THROW((
           "Invalid BSON command: $1",
           "[`bson_validate_with_error()` failed]"),
           error.message);
 
-    return this->execute_bson(bson_cmd);
+    return this->execute_bson(cmd.bson(), server_id);
+  }
+
+void
+Mongo_Connection::
+execute(const Mongo_Document& cmd, uint32_t server_id)
+  {
+    // Pack the command into a BSON object.
+    Mongo_Document_Builder builder;
+    builder.append_fields(cmd);
+    return this->execute(builder, server_id);
   }
 
 const ::bson_t*
@@ -287,6 +182,29 @@ fetch_reply_bson_opt()
     return bson_output;
   }
 
+const ::bson_t*
+Mongo_Connection::
+fetch_raw_reply_bson_opt()
+  {
+    if(!this->m_reply_available)
+      return nullptr;
+
+    this->m_reply_available = false;
+    return this->m_reply;
+  }
+
+bool
+Mongo_Connection::
+fetch_reply(Mongo_Document_View& output)
+  {
+    auto bson_output = this->fetch_reply_bson_opt();
+    if(!bson_output)
+      return false;
+
+    output = Mongo_Document_View(bson_output);
+    return true;
+  }
+
 bool
 Mongo_Connection::
 fetch_reply(Mongo_Document& output)
@@ -298,127 +216,7 @@ fetch_reply(Mongo_Document& output)
       return false;
 
     // Parse the reply and store the result into `output`.
-    struct xFrame
-      {
-        Mongo_Value* parent;
-        ::bson_iter_t parent_iter;
-      };
-
-    ::std::forward_list<xFrame> stack;
-    Mongo_Array* top_a = nullptr;
-    Mongo_Document* top_o = &output;
-
-    ::bson_iter_t top_iter;
-    if(!::bson_iter_init(&top_iter, bson_output))
-      POSEIDON_THROW(("Failed to parse BSON reply from server"));
-
-  do_pack_loop_:
-    while(::bson_iter_next(&top_iter)) {
-      Mongo_Value* pval;
-      const char* str;
-      const unsigned char* bytes;
-      uint32_t type, len;
-      milliseconds dur;
-
-      if(top_a) {
-        // array
-        pval = &(top_a->emplace_back());
-      }
-      else {
-        // document
-        str = reinterpret_cast<const char*>(top_iter.raw + top_iter.key);
-        len = top_iter.d1 - top_iter.key - 1;
-
-        auto& pair = top_o->emplace_back();
-        pair.first.append(str, len);
-        pval = &(pair.second);
-      }
-
-      type = ::bson_iter_type_unsafe(&top_iter);
-      switch(type)
-        {
-        case BSON_TYPE_NULL:
-          break;
-
-        case BSON_TYPE_BOOL:
-          pval->open_boolean() = ::bson_iter_bool_unsafe(&top_iter);
-          break;
-
-        case BSON_TYPE_INT32:
-          pval->open_integer() = ::bson_iter_int32_unsafe(&top_iter);
-          break;
-
-        case BSON_TYPE_INT64:
-          pval->open_integer() = ::bson_iter_int64_unsafe(&top_iter);
-          break;
-
-        case BSON_TYPE_DOUBLE:
-          pval->open_double() = ::bson_iter_double_unsafe(&top_iter);
-          break;
-
-        case BSON_TYPE_UTF8:
-          str = ::bson_iter_utf8(&top_iter, &len);
-          pval->open_utf8().append(str, len);
-          break;
-
-        case BSON_TYPE_BINARY:
-          ::bson_iter_binary(&top_iter, nullptr, &len, &bytes);
-          pval->open_binary().append(bytes, len);
-          break;
-
-        case BSON_TYPE_ARRAY:
-        case BSON_TYPE_DOCUMENT:
-          switch(type)
-            {
-            case BSON_TYPE_ARRAY:
-              ::bson_iter_array(&top_iter, &len, &bytes);
-              pval->open_array();
-              break;
-
-            case BSON_TYPE_DOCUMENT:
-              ::bson_iter_document(&top_iter, &len, &bytes);
-              pval->open_document();
-              break;
-            }
-
-          if(len > 5) {
-            auto& frm = stack.emplace_front();
-            frm.parent = pval;
-            frm.parent_iter = top_iter;
-
-            if(::bson_iter_init_from_data(&top_iter, bytes, len)) {
-              // open
-              top_a = pval->m_stor.mut_ptr<Mongo_Array>();
-              top_o = pval->m_stor.mut_ptr<Mongo_Document>();
-              goto do_pack_loop_;
-            }
-
-            // invalid; shouldn't happen, but be tolerant anyway.
-            top_iter = frm.parent_iter;
-            stack.pop_front();
-          }
-          break;
-
-        case BSON_TYPE_OID:
-          pval->open_oid() = *::bson_iter_oid_unsafe(&top_iter);
-          break;
-
-        case BSON_TYPE_DATE_TIME:
-          dur = milliseconds(::bson_iter_date_time(&top_iter));
-          pval->open_datetime() = system_time() + dur;
-          break;
-        }
-    }
-
-    if(!stack.empty()) {
-      auto& frm = stack.front();
-      top_a = frm.parent->m_stor.mut_ptr<Mongo_Array>();
-      top_o = frm.parent->m_stor.mut_ptr<Mongo_Document>();
-      top_iter = frm.parent_iter;
-      stack.pop_front();
-      goto do_pack_loop_;
-    }
-
+    Mongo_Document_View(bson_output).to_document(output);
     return true;
   }
 
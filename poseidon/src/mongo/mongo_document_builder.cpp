@@ -0,0 +1,310 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../mongo/mongo_document_builder.hpp"
+#include "../../utils.hpp"
+namespace poseidon {
+
+Mongo_Document_Builder::
+~Mongo_Document_Builder()
+  {
+  }
+
+::bson_t*
+Mongo_Document_Builder::
+do_prepare_field(chars_view& key, char (&kbuf)[16])
+  {
+    if(this->m_frames.empty()) {
+      if(key.n > INT_MAX)
+        POSEIDON_THROW(("Mongo field name too long (length `$1`)"), key.n);
+
+      return this->m_bson;
+    }
+
+    auto& frm = this->m_frames.front();
+    if(frm.array) {
+      // array; keys are subscripts as decimal strings.
+      const char* str;
+      size_t len = ::bson_uint32_to_string(frm.next_index, &str, kbuf, sizeof(kbuf));
+      key = chars_view(str, len);
+      frm.next_index ++;
+    }
+    else if(key.n > INT_MAX)
+      POSEIDON_THROW(("Mongo field name too long (length `$1`)"), key.n);
+
+    return &(frm.temp);
+  }
+
+void
+Mongo_Document_Builder::
+clear()
+  noexcept
+  {
+    this->m_frames.clear();
+    this->m_depth = 0;
+
+    ::bson_destroy(this->m_bson);
+    ::bson_init(this->m_bson);
+  }
+
+void
+Mongo_Document_Builder::
+append_null(chars_view key)
+  {
+    char kbuf[16];
+    ::bson_t* parent = this->do_prepare_field(key, kbuf);
+    if(!::bson_append_null(parent, key.p, static_cast<int>(key.n)))
+      POSEIDON_THROW(("Could not append Mongo field `$1`"), key);
+  }
+
+void
+Mongo_Document_Builder::
+append_boolean(chars_view key, bool value)
+  {
+    char kbuf[16];
+    ::bson_t* parent = this->do_prepare_field(key, kbuf);
+    if(!::bson_append_bool(parent, key.p, static_cast<int>(key.n), value))
+      POSEIDON_THROW(("Could not append Mongo field `$1`"), key);
+  }
+
+void
+Mongo_Document_Builder::
+append_integer(chars_view key, int64_t value)
+  {
+    char kbuf[16];
+    ::bson_t* parent = this->do_prepare_field(key, kbuf);
+    bool success = (value == static_cast<int32_t>(value))
+                   ? ::bson_append_int32(parent, key.p, static_cast<int>(key.n),
+                                         static_cast<int32_t>(value))
+                   : ::bson_append_int64(parent, key.p, static_cast<int>(key.n), value);
+    if(!success)
+      POSEIDON_THROW(("Could not append Mongo field `$1`"), key);
+  }
+
+void
+Mongo_Document_Builder::
+append_double(chars_view key, double value)
+  {
+    char kbuf[16];
+    ::bson_t* parent = this->do_prepare_field(key, kbuf);
+    if(!::bson_append_double(parent, key.p, static_cast<int>(key.n), value))
+      POSEIDON_THROW(("Could not append Mongo field `$1`"), key);
+  }
+
+void
+Mongo_Document_Builder::
+append_utf8(chars_view key, chars_view str)
+  {
+    char kbuf[16];
+    ::bson_t* parent = this->do_prepare_field(key, kbuf);
+    if((str.n > INT_MAX)
+       || !::bson_append_utf8(parent, key.p, static_cast<int>(key.n), str.p,
+                              static_cast<int>(str.n)))
+      POSEIDON_THROW(("Could not append Mongo field `$1`"), key);
+  }
+
+void
+Mongo_Document_Builder::
+append_binary(chars_view key, const void* data, size_t size)
+  {
+    char kbuf[16];
+    ::bson_t* parent = this->do_prepare_field(key, kbuf);
+    if((size > UINT_MAX)
+       || !::bson_append_binary(parent, key.p, static_cast<int>(key.n), BSON_SUBTYPE_BINARY,
+                                static_cast<const uint8_t*>(data), static_cast<unsigned>(size)))
+      POSEIDON_THROW(("Could not append Mongo field `$1`"), key);
+  }
+
+void
+Mongo_Document_Builder::
+append_oid(chars_view key, const ::bson_oid_t& oid)
+  {
+    char kbuf[16];
+    ::bson_t* parent = this->do_prepare_field(key, kbuf);
+    if(!::bson_append_oid(parent, key.p, static_cast<int>(key.n), &oid))
+      POSEIDON_THROW(("Could not append Mongo field `$1`"), key);
+  }
+
+void
+Mongo_Document_Builder::
+append_datetime(chars_view key, system_time tm)
+  {
+    char kbuf[16];
+    ::bson_t* parent = this->do_prepare_field(key, kbuf);
+    if(!::bson_append_date_time(parent, key.p, static_cast<int>(key.n),
+                   duration_cast<milliseconds>(tm.time_since_epoch()).count()))
+      POSEIDON_THROW(("Could not append Mongo field `$1`"), key);
+  }
+
+void
+Mongo_Document_Builder::
+append_value(chars_view key, const Mongo_Value& value)
+  {
+    // Append values without recursion. Arrays and nested documents are opened
+    // and closed on this builder, and their positions are saved here.
+    struct xFrame
+      {
+        const Mongo_Array* psa;
+        const Mongo_Document* pso;
+        size_t pos;
+      };
+
+    ::std::vector<xFrame> stack;
+    const Mongo_Value* pval = &value;
+
+    for(;;) {
+      switch(pval->type())
+        {
+        case mongo_value_null:
+          this->append_null(key);
+          break;
+
+        case mongo_value_boolean:
+          this->append_boolean(key, pval->as_boolean());
+          break;
+
+        case mongo_value_integer:
+          this->append_integer(key, pval->as_integer());
+          break;
+
+        case mongo_value_double:
+          this->append_double(key, pval->as_double());
+          break;
+
+        case mongo_value_utf8:
+          this->append_utf8(key, pval->as_utf8());
+          break;
+
+        case mongo_value_binary:
+          this->append_binary(key, pval->as_binary_data(), pval->as_binary_size());
+          break;
+
+        case mongo_value_array:
+          this->open_array(key);
+          stack.push_back({ &(pval->as_array()), nullptr, 0 });
+          break;
+
+        case mongo_value_document:
+          this->open_document(key);
+          stack.push_back({ nullptr, &(pval->as_document()), 0 });
+          break;
+
+        case mongo_value_oid:
+          this->append_oid(key, pval->as_oid());
+          break;
+
+        case mongo_value_datetime:
+          this->append_datetime(key, pval->as_system_time());
+          break;
+
+        default:
+          ASTERIA_TERMINATE(("Corrupted value type `$1`"), pval->type());
+        }
+
+      // Get the next value, closing arrays and documents that have finished.
+      for(;;) {
+        if(stack.empty())
+          return;
+
+        auto& frm = stack.back();
+        if(frm.psa && (frm.pos != frm.psa->size())) {
+          // array
+          key = chars_view();
+          pval = &(frm.psa->at(frm.pos));
+          frm.pos ++;
+          break;
+        }
+
+        if(frm.pso && (frm.pos != frm.pso->size())) {
+          // document
+          key = frm.pso->at(frm.pos).first;
+          pval = &(frm.pso->at(frm.pos).second);
+          frm.pos ++;
+          break;
+        }
+
+        this->close();
+        stack.pop_back();
+      }
+    }
+  }
+
+void
+Mongo_Document_Builder::
+append_fields(const Mongo_Document& doc)
+  {
+    for(const auto& field : doc)
+      this->append_value(field.first, field.second);
+  }
+
+void
+Mongo_Document_Builder::
+open_array(chars_view key)
+  {
+    char kbuf[16];
+    ::bson_t* parent = this->do_prepare_field(key, kbuf);
+    auto& frm = this->m_frames.emplace_front();
+    frm.array = true;
+    frm.next_index = 0;
+
+    if(!::bson_append_array_unsafe_begin(parent, key.p, static_cast<int>(key.n), &(frm.temp))) {
+      this->m_frames.pop_front();
+      POSEIDON_THROW(("Could not append Mongo field `$1`"), key);
+    }
+
+    this->m_depth ++;
+  }
+
+void
+Mongo_Document_Builder::
+open_document(chars_view key)
+  {
+    char kbuf[16];
+    ::bson_t* parent = this->do_prepare_field(key, kbuf);
+    auto& frm = this->m_frames.emplace_front();
+    frm.array = false;
+    frm.next_index = 0;
+
+    if(!::bson_append_document_begin(parent, key.p, static_cast<int>(key.n), &(frm.temp))) {
+      this->m_frames.pop_front();
+      POSEIDON_THROW(("Could not append Mongo field `$1`"), key);
+    }
+
+    this->m_depth ++;
+  }
+
+void
+Mongo_Document_Builder::
+close()
+  {
+    if(this->m_frames.empty())
+      POSEIDON_THROW(("No Mongo array or document to close"));
+
+    ::std::forward_list<X_Frame> top;
+    top.splice_after(top.before_begin(), this->m_frames, this->m_frames.before_begin());
+    this->m_depth --;
+
+    auto& frm = top.front();
+    ::bson_t* parent = this->m_frames.empty() ? this->m_bson : &(this->m_frames.front().temp);
+    bool success = frm.array
+                   ? ::bson_append_array_end(parent, &(frm.temp))
+                   : ::bson_append_document_end(parent, &(frm.temp));
+    if(!success)
+      POSEIDON_THROW(("Could not close Mongo array or document"));
+  }
+
+const ::bson_t*
+Mongo_Document_Builder::
+bson()
+  const
+  {
+    if(this->m_depth != 0)
+      POSEIDON_THROW((
+          "Mongo document incomplete (`$1` arrays or documents not closed)"),
+          this->m_depth);
+
+    return this->m_bson;
+  }
+
+}  // namespace poseidon
@@ -0,0 +1,411 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../mongo/mongo_document_view.hpp"
+#include "../../utils.hpp"
+#include <forward_list>
+namespace poseidon {
+namespace {
+
+constexpr uint8_t s_empty_bson[5] = { 5, 0, 0, 0, 0 };
+
+Mongo_Value_Type
+do_value_type_of(const ::bson_iter_t& iter)
+  noexcept
+  {
+    switch(static_cast<uint32_t>(::bson_iter_type(&iter)))
+      {
+      case BSON_TYPE_BOOL:
+        return mongo_value_boolean;
+
+      case BSON_TYPE_INT32:
+      case BSON_TYPE_INT64:
+        return mongo_value_integer;
+
+      case BSON_TYPE_DOUBLE:
+        return mongo_value_double;
+
+      case BSON_TYPE_UTF8:
+        return mongo_value_utf8;
+
+      case BSON_TYPE_BINARY:
+        return mongo_value_binary;
+
+      case BSON_TYPE_ARRAY:
+        return mongo_value_array;
+
+      case BSON_TYPE_DOCUMENT:
+        return mongo_value_document;
+
+      case BSON_TYPE_OID:
+        return mongo_value_oid;
+
+      case BSON_TYPE_DATE_TIME:
+        return mongo_value_datetime;
+
+      default:
+        return mongo_value_null;
+      }
+  }
+
+void
+do_unpack(Mongo_Array* top_a, Mongo_Document* top_o, ::bson_iter_t top_iter)
+  {
+    // Copy fields into a container, without recursion.
+    struct xFrame
+      {
+        Mongo_Value* parent;
+        ::bson_iter_t parent_iter;
+      };
+
+    ::std::forward_list<xFrame> stack;
+
+  do_pack_loop_:
+    while(::bson_iter_next(&top_iter)) {
+      Mongo_Value* pval;
+      const char* str;
+      const unsigned char* bytes;
+      uint32_t type, len;
+      milliseconds dur;
+
+      if(top_a) {
+        // array
+        pval = &(top_a->emplace_back());
+      }
+      else {
+        // document
+        str = reinterpret_cast<const char*>(top_iter.raw + top_iter.key);
+        len = top_iter.d1 - top_iter.key - 1;
+
+        auto& pair = top_o->emplace_back();
+        pair.first.append(str, len);
+        pval = &(pair.second);
+      }
+
+      type = ::bson_iter_type_unsafe(&top_iter);
+      switch(type)
+        {
+        case BSON_TYPE_NULL:
+          break;
+
+        case BSON_TYPE_BOOL:
+          pval->open_boolean() = ::bson_iter_bool_unsafe(&top_iter);
+          break;
+
+        case BSON_TYPE_INT32:
+          pval->open_integer() = ::bson_iter_int32_unsafe(&top_iter);
+          break;
+
+        case BSON_TYPE_INT64:
+          pval->open_integer() = ::bson_iter_int64_unsafe(&top_iter);
+          break;
+
+        case BSON_TYPE_DOUBLE:
+          pval->open_double() = ::bson_iter_double_unsafe(&top_iter);
+          break;
+
+        case BSON_TYPE_UTF8:
+          str = ::bson_iter_utf8(&top_iter, &len);
+          pval->open_utf8().append(str, len);
+          break;
+
+        case BSON_TYPE_BINARY:
+          ::bson_iter_binary(&top_iter, nullptr, &len, &bytes);
+          pval->open_binary().append(bytes, len);
+          break;
+
+        case BSON_TYPE_ARRAY:
+        case BSON_TYPE_DOCUMENT:
+          switch(type)
+            {
+            case BSON_TYPE_ARRAY:
+              ::bson_iter_array(&top_iter, &len, &bytes);
+              pval->open_array();
+              break;
+
+            case BSON_TYPE_DOCUMENT:
+              ::bson_iter_document(&top_iter, &len, &bytes);
+              pval->open_document();
+              break;
+            }
+
+          if(len > 5) {
+            auto& frm = stack.emplace_front();
+            frm.parent = pval;
+            frm.parent_iter = top_iter;
+
+            if(::bson_iter_init_from_data(&top_iter, bytes, len)) {
+              // open
+              top_a = pval->is_array() ? &(pval->open_array()) : nullptr;
+              top_o = pval->is_document() ? &(pval->open_document()) : nullptr;
+              goto do_pack_loop_;
+            }
+
+            // invalid; shouldn't happen, but be tolerant anyway.
+            top_iter = frm.parent_iter;
+            stack.pop_front();
+          }
+          break;
+
+        case BSON_TYPE_OID:
+          pval->open_oid() = *::bson_iter_oid_unsafe(&top_iter);
+          break;
+
+        case BSON_TYPE_DATE_TIME:
+          dur = milliseconds(::bson_iter_date_time(&top_iter));
+          pval->open_datetime() = system_time() + dur;
+          break;
+        }
+    }
+
+    if(!stack.empty()) {
+      auto& frm = stack.front();
+      top_a = frm.parent->is_array() ? &(frm.parent->open_array()) : nullptr;
+      top_o = frm.parent->is_document() ? &(frm.parent->open_document()) : nullptr;
+      top_iter = frm.parent_iter;
+      stack.pop_front();
+      goto do_pack_loop_;
+    }
+  }
+
+}  // namespace
+
+Mongo_Document_View::
+Mongo_Document_View()
+  noexcept
+  {
+    this->m_data = s_empty_bson;
+    this->m_size = sizeof(s_empty_bson);
+  }
+
+Mongo_Document_View::
+Mongo_Document_View(const uint8_t* data, size_t size)
+  {
+    // A document starts with its length as a 32-bit little-endian integer,
+    // and ends with a null byte.
+    if((size < 5) || (size > INT32_MAX) || (data[size - 1] != 0)
+       || (::asteria::load_le<uint32_t>(data) != size))
+      POSEIDON_THROW(("Invalid BSON document (size `$1`)"), size);
+
+    this->m_data = data;
+    this->m_size = static_cast<uint32_t>(size);
+  }
+
+Mongo_Document_View::
+~Mongo_Document_View()
+  {
+  }
+
+bool
+Mongo_Document_View::
+find(::bson_iter_t& iter, chars_view key)
+  const noexcept
+  {
+    if(!this->iter_init(iter))
+      return false;
+
+    return ::bson_iter_find_w_len(&iter, key.p, clamp_cast<int>(key.n, 0, INT_MAX));
+  }
+
+Mongo_Value_Type
+Mongo_Document_View::
+field_type(chars_view key)
+  const noexcept
+  {
+    ::bson_iter_t iter;
+    if(!this->find(iter, key))
+      return mongo_value_null;
+
+    return do_value_type_of(iter);
+  }
+
+::bson_iter_t
+Mongo_Document_View::
+do_find_typed(chars_view key, Mongo_Value_Type type)
+  const
+  {
+    ::bson_iter_t iter;
+    if(!this->find(iter, key))
+      POSEIDON_THROW(("Mongo field `$1` not found"), key);
+
+    if(do_value_type_of(iter) != type)
+      POSEIDON_THROW((
+          "Mongo field `$1` has type `$2`, not `$3`"),
+          key, do_value_type_of(iter), type);
+
+    return iter;
+  }
+
+bool
+Mongo_Document_View::
+get_boolean(chars_view key)
+  const
+  {
+    ::bson_iter_t iter = this->do_find_typed(key, mongo_value_boolean);
+    return ::bson_iter_bool_unsafe(&iter);
+  }
+
+int64_t
+Mongo_Document_View::
+get_integer(chars_view key)
+  const
+  {
+    ::bson_iter_t iter = this->do_find_typed(key, mongo_value_integer);
+    return ::bson_iter_as_int64(&iter);
+  }
+
+double
+Mongo_Document_View::
+get_double(chars_view key)
+  const
+  {
+    ::bson_iter_t iter = this->do_find_typed(key, mongo_value_double);
+    return ::bson_iter_double_unsafe(&iter);
+  }
+
+chars_view
+Mongo_Document_View::
+get_utf8(chars_view key)
+  const
+  {
+    ::bson_iter_t iter = this->do_find_typed(key, mongo_value_utf8);
+    uint32_t len;
+    const char* str = ::bson_iter_utf8(&iter, &len);
+    return chars_view(str, len);
+  }
+
+chars_view
+Mongo_Document_View::
+get_binary(chars_view key)
+  const
+  {
+    ::bson_iter_t iter = this->do_find_typed(key, mongo_value_binary);
+    uint32_t len;
+    const uint8_t* bytes;
+    ::bson_iter_binary(&iter, nullptr, &len, &bytes);
+    return chars_view(reinterpret_cast<const char*>(bytes), len);
+  }
+
+Mongo_Document_View
+Mongo_Document_View::
+get_array(chars_view key)
+  const
+  {
+    ::bson_iter_t iter = this->do_find_typed(key, mongo_value_array);
+    uint32_t len;
+    const uint8_t* bytes;
+    ::bson_iter_array(&iter, &len, &bytes);
+    return Mongo_Document_View(bytes, len);
+  }
+
+Mongo_Document_View
+Mongo_Document_View::
+get_document(chars_view key)
+  const
+  {
+    ::bson_iter_t iter = this->do_find_typed(key, mongo_value_document);
+    uint32_t len;
+    const uint8_t* bytes;
+    ::bson_iter_document(&iter, &len, &bytes);
+    return Mongo_Document_View(bytes, len);
+  }
+
+const ::bson_oid_t&
+Mongo_Document_View::
+get_oid(chars_view key)
+  const
+  {
+    ::bson_iter_t iter = this->do_find_typed(key, mongo_value_oid);
+    return *::bson_iter_oid_unsafe(&iter);
+  }
+
+system_time
+Mongo_Document_View::
+get_system_time(chars_view key)
+  const
+  {
+    ::bson_iter_t iter = this->do_find_typed(key, mongo_value_datetime);
+    return system_time() + milliseconds(::bson_iter_date_time(&iter));
+  }
+
+Mongo_Value
+Mongo_Document_View::
+get_value(chars_view key)
+  const
+  {
+    Mongo_Value value;
+    ::bson_iter_t iter, child;
+    const char* str;
+    const uint8_t* bytes;
+    uint32_t len;
+    if(!this->find(iter, key))
+      return value;
+
+    switch(do_value_type_of(iter))
+      {
+      case mongo_value_null:
+        break;
+
+      case mongo_value_boolean:
+        value.open_boolean() = ::bson_iter_bool_unsafe(&iter);
+        break;
+
+      case mongo_value_integer:
+        value.open_integer() = ::bson_iter_as_int64(&iter);
+        break;
+
+      case mongo_value_double:
+        value.open_double() = ::bson_iter_double_unsafe(&iter);
+        break;
+
+      case mongo_value_utf8:
+        str = ::bson_iter_utf8(&iter, &len);
+        value.open_utf8().append(str, len);
+        break;
+
+      case mongo_value_binary:
+        ::bson_iter_binary(&iter, nullptr, &len, &bytes);
+        value.open_binary().append(bytes, len);
+        break;
+
+      case mongo_value_array:
+        if(::bson_iter_recurse(&iter, &child))
+          do_unpack(&(value.open_array()), nullptr, child);
+        break;
+
+      case mongo_value_document:
+        if(::bson_iter_recurse(&iter, &child))
+          do_unpack(nullptr, &(value.open_document()), child);
+        break;
+
+      case mongo_value_oid:
+        value.open_oid() = *::bson_iter_oid_unsafe(&iter);
+        break;
+
+      case mongo_value_datetime:
+        value.open_datetime() = system_time() + milliseconds(::bson_iter_date_time(&iter));
+        break;
+
+      default:
+        ASTERIA_TERMINATE(("Corrupted Mongo value type `$1`"), do_value_type_of(iter));
+      }
+
+    return value;
+  }
+
+void
+Mongo_Document_View::
+to_document(Mongo_Document& output)
+  const
+  {
+    output.clear();
+
+    ::bson_iter_t iter;
+    if(!this->iter_init(iter))
+      POSEIDON_THROW(("Failed to parse BSON document"));
+
+    do_unpack(nullptr, &output, iter);
+  }
+
+}  // namespace poseidon
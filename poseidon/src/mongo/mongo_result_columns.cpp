@@ -0,0 +1,383 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../mongo/mongo_result_columns.hpp"
+#include "../../utils.hpp"
+namespace poseidon {
+namespace {
+
+enum Storage : uint8_t
+  {
+    storage_none      = 0,
+    storage_integer   = 1,
+    storage_double    = 2,
+    storage_string    = 3,
+    storage_datetime  = 4,
+  };
+
+Storage
+do_storage_of(Mongo_Value_Type type)
+  noexcept
+  {
+    switch(type)
+      {
+      case mongo_value_boolean:
+      case mongo_value_integer:
+        return storage_integer;
+
+      case mongo_value_double:
+        return storage_double;
+
+      case mongo_value_utf8:
+      case mongo_value_binary:
+      case mongo_value_array:
+      case mongo_value_document:
+      case mongo_value_oid:
+        return storage_string;
+
+      case mongo_value_datetime:
+        return storage_datetime;
+
+      default:
+        return storage_none;
+      }
+  }
+
+bool
+do_is_numeric(Storage storage)
+  noexcept
+  {
+    return (storage == storage_integer) || (storage == storage_double);
+  }
+
+void
+do_append_string(cow_string& arena, const Mongo_Value& value)
+  {
+    switch(value.type())
+      {
+      case mongo_value_utf8:
+        arena.append(value.as_utf8());
+        break;
+
+      case mongo_value_binary:
+        arena.append(reinterpret_cast<const char*>(value.as_binary_data()),
+                     value.as_binary_size());
+        break;
+
+      case mongo_value_oid:
+        arena.append(reinterpret_cast<const char*>(value.as_oid().bytes),
+                     sizeof(value.as_oid().bytes));
+        break;
+
+      default:
+        {
+          // Arrays and nested documents are stored as their string forms.
+          tinyfmt_str fmt;
+          fmt << value;
+          arena.append(fmt.get_string());
+        }
+        break;
+      }
+  }
+
+}  // namespace
+
+Mongo_Result_Columns::
+~Mongo_Result_Columns()
+  {
+  }
+
+void
+Mongo_Result_Columns::
+clear()
+  noexcept
+  {
+    this->m_columns.clear();
+    this->m_row_count = 0;
+    this->m_arena.clear();
+  }
+
+void
+Mongo_Result_Columns::
+append_document(const Mongo_Document& doc)
+  {
+    // Match fields with columns. Fields usually come in the same order in all
+    // documents, so the column after the previous one is checked first. Fields
+    // that have not been seen before will become new columns.
+    ::std::vector<const Mongo_Value*> cells(this->m_columns.size());
+    ::std::vector<cow_string> new_names;
+    size_t hint = 0;
+
+    for(const auto& field : doc) {
+      size_t col = SIZE_MAX;
+      if((hint < this->m_columns.size()) && (this->m_columns[hint].name == field.first))
+        col = hint;
+      else
+        col = this->find_column(field.first);
+
+      if(col == SIZE_MAX) {
+        for(size_t k = 0;  k != new_names.size();  ++k)
+          if(new_names[k] == field.first)
+            col = this->m_columns.size() + k;
+
+        if(col == SIZE_MAX) {
+          col = this->m_columns.size() + new_names.size();
+          new_names.push_back(field.first);
+          cells.push_back(nullptr);
+        }
+      }
+
+      cells[col] = &(field.second);
+      hint = col + 1;
+    }
+
+    // Check types before making any changes.
+    for(size_t col = 0;  col != this->m_columns.size();  ++col) {
+      const auto& column = this->m_columns[col];
+      const Mongo_Value* value = cells[col];
+      if(!value || value->is_null() || (column.type == mongo_value_null))
+        continue;
+
+      // Booleans, integers and doubles can be promoted.
+      if(do_is_numeric(do_storage_of(column.type))
+         && do_is_numeric(do_storage_of(value->type())))
+        continue;
+
+      if(column.type != value->type())
+        POSEIDON_THROW((
+            "Mongo column `$1` has type `$2`, but value has type `$3`"),
+            column.name, column.type, value->type());
+    }
+
+    // Previous values of new columns are all missing.
+    for(auto& name : new_names) {
+      auto& column = this->m_columns.emplace_back();
+      column.name = move(name);
+      column.type = mongo_value_null;
+      column.nulls.resize((this->m_row_count + 7) / 8, 0xFF);
+    }
+
+    size_t row_index = this->m_row_count;
+    for(size_t col = 0;  col != this->m_columns.size();  ++col) {
+      auto& column = this->m_columns[col];
+      const Mongo_Value* value = cells[col];
+      bool null = !value || value->is_null();
+
+      if(column.nulls.size() <= row_index / 8)
+        column.nulls.push_back(0);
+
+      uint8_t mask = static_cast<uint8_t>(1U << row_index % 8);
+      if(null)
+        column.nulls[row_index / 8] |= mask;
+      else
+        column.nulls[row_index / 8] &= static_cast<uint8_t>(~mask);
+
+      if(!null && (column.type == mongo_value_null)) {
+        // This is the first non-null value, which determines the type of this
+        // column. Previous values are all nulls.
+        column.type = value->type();
+        switch(do_storage_of(column.type))
+          {
+          case storage_integer:
+            column.integers.resize(row_index);
+            break;
+
+          case storage_double:
+            column.doubles.resize(row_index);
+            break;
+
+          case storage_string:
+            column.strings.resize(row_index);
+            break;
+
+          case storage_datetime:
+            column.datetimes.resize(row_index);
+            break;
+
+          default:
+            ASTERIA_TERMINATE(("Corrupted Mongo value type `$1`"), column.type);
+          }
+      }
+      else if(!null && value->is_double() && (do_storage_of(column.type) == storage_integer)) {
+        // Promote this column to double.
+        column.doubles.assign(column.integers.begin(), column.integers.end());
+        column.integers.clear();
+        column.type = mongo_value_double;
+      }
+      else if(!null && value->is_integer() && (column.type == mongo_value_boolean))
+        column.type = mongo_value_integer;
+
+      switch(do_storage_of(column.type))
+        {
+        case storage_none:
+          break;
+
+        case storage_integer:
+          if(null)
+            column.integers.push_back(0);
+          else if(value->is_boolean())
+            column.integers.push_back(value->as_boolean());
+          else
+            column.integers.push_back(value->as_integer());
+          break;
+
+        case storage_double:
+          if(null)
+            column.doubles.push_back(0);
+          else if(value->is_boolean())
+            column.doubles.push_back(value->as_boolean());
+          else if(value->is_integer())
+            column.doubles.push_back(static_cast<double>(value->as_integer()));
+          else
+            column.doubles.push_back(value->as_double());
+          break;
+
+        case storage_string:
+          if(null)
+            column.strings.emplace_back(this->m_arena.size(), 0U);
+          else {
+            size_t offset = this->m_arena.size();
+            do_append_string(this->m_arena, *value);
+            column.strings.emplace_back(offset, this->m_arena.size() - offset);
+          }
+          break;
+
+        case storage_datetime:
+          column.datetimes.push_back(null ? system_time() : value->as_system_time());
+          break;
+
+        default:
+          ASTERIA_TERMINATE(("Corrupted Mongo value type `$1`"), column.type);
+        }
+    }
+
+    this->m_row_count ++;
+  }
+
+size_t
+Mongo_Result_Columns::
+find_column(chars_view name)
+  const noexcept
+  {
+    for(size_t col = 0;  col != this->m_columns.size();  ++col)
+      if(chars_view(this->m_columns[col].name) == name)
+        return col;
+
+    return SIZE_MAX;
+  }
+
+bool
+Mongo_Result_Columns::
+is_null(size_t col, size_t row)
+  const
+  {
+    const auto& column = this->m_columns.at(col);
+    if(row >= this->m_row_count)
+      POSEIDON_THROW((
+          "Mongo row index out of range (`$1` >= `$2`)"),
+          row, this->m_row_count);
+
+    return column.nulls[row / 8] >> row % 8 & 1;
+  }
+
+const int64_t*
+Mongo_Result_Columns::
+integer_data(size_t col)
+  const
+  {
+    const auto& column = this->m_columns.at(col);
+    if(do_storage_of(column.type) != storage_integer)
+      POSEIDON_THROW(("Mongo column `$1` has type `$2`"), column.name, column.type);
+
+    return column.integers.data();
+  }
+
+const double*
+Mongo_Result_Columns::
+double_data(size_t col)
+  const
+  {
+    const auto& column = this->m_columns.at(col);
+    if(do_storage_of(column.type) != storage_double)
+      POSEIDON_THROW(("Mongo column `$1` has type `$2`"), column.name, column.type);
+
+    return column.doubles.data();
+  }
+
+const system_time*
+Mongo_Result_Columns::
+datetime_data(size_t col)
+  const
+  {
+    const auto& column = this->m_columns.at(col);
+    if(do_storage_of(column.type) != storage_datetime)
+      POSEIDON_THROW(("Mongo column `$1` has type `$2`"), column.name, column.type);
+
+    return column.datetimes.data();
+  }
+
+chars_view
+Mongo_Result_Columns::
+string(size_t col, size_t row)
+  const
+  {
+    const auto& column = this->m_columns.at(col);
+    if(do_storage_of(column.type) != storage_string)
+      POSEIDON_THROW(("Mongo column `$1` has type `$2`"), column.name, column.type);
+
+    const auto& r = column.strings.at(row);
+    return chars_view(this->m_arena.data() + r.first, r.second);
+  }
+
+Mongo_Value
+Mongo_Result_Columns::
+value(size_t col, size_t row)
+  const
+  {
+    if(this->is_null(col, row))
+      return nullptr;
+
+    const auto& column = this->m_columns[col];
+    switch(column.type)
+      {
+      case mongo_value_boolean:
+        return column.integers[row] != 0;
+
+      case mongo_value_integer:
+        return column.integers[row];
+
+      case mongo_value_double:
+        return column.doubles[row];
+
+      case mongo_value_binary:
+        {
+          chars_view str = this->string(col, row);
+          return cow_bstring(reinterpret_cast<const unsigned char*>(str.p), str.n);
+        }
+
+      case mongo_value_oid:
+        {
+          chars_view str = this->string(col, row);
+          ::bson_oid_t oid;
+          ::memcpy(oid.bytes, str.p, sizeof(oid.bytes));
+          return oid;
+        }
+
+      case mongo_value_utf8:
+      case mongo_value_array:
+      case mongo_value_document:
+        {
+          chars_view str = this->string(col, row);
+          return cow_string(str.p, str.n);
+        }
+
+      case mongo_value_datetime:
+        return column.datetimes[row];
+
+      default:
+        ASTERIA_TERMINATE(("Corrupted Mongo value type `$1`"), column.type);
+      }
+  }
+
+}  // namespace poseidon
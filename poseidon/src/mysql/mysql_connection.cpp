@@ -5,7 +5,185 @@
 #include "../../mysql/mysql_connection.hpp"
 #include "../../mysql/mysql_value.hpp"
 #include "../../utils.hpp"
+#include <poll.h>
 namespace poseidon {
+namespace {
+
+struct Cached_Statement
+  {
+    cow_string text;
+    uniptr_MYSQL_STMT stmt;
+  };
+
+struct Result_Column
+  {
+    ::MYSQL_TIME time;
+    int64_t integer;
+    double dbl;
+    cow_string blob;
+  };
+
+enum : uint8_t
+  {
+    async_idle     = 0,
+    async_connect  = 1,
+    async_query    = 2,
+    async_store    = 3,
+    async_reset    = 4,
+  };
+
+void
+do_append_literal(tinyfmt& fmt, const MySQL_Value& value)
+  {
+    if(!value.is_blob()) {
+      // Numbers and timestamps have no characters that need escaping.
+      fmt << value;
+      return;
+    }
+
+    // Strings are written as hexadecimal literals, which don't depend on the
+    // character set of the connection or the `NO_BACKSLASH_ESCAPES` mode. Valid
+    // UTF-8 strings are given an introducer, so they are compared as text, and
+    // others are binary.
+    const auto& str = value.as_blob();
+    size_t offset = 0;
+    char32_t cp;
+    while(offset != str.size())
+      if(!::asteria::utf8_decode(cp, str, offset))
+        break;
+
+    if(offset == str.size())
+      fmt.putn("_utf8mb4 X'", 11);
+    else
+      fmt.putn("X'", 2);
+
+    static constexpr char xdigits[] = "0123456789ABCDEF";
+    for(char ch : str) {
+      fmt.putc(xdigits[static_cast<unsigned char>(ch) >> 4]);
+      fmt.putc(xdigits[static_cast<unsigned char>(ch) & 15]);
+    }
+    fmt.putc('\'');
+  }
+
+void
+do_compose_query(tinyfmt& fmt, const cow_string& stmt, const cow_vector<MySQL_Value>& args)
+  {
+    // Replace placeholders with arguments. Question marks in quoted strings,
+    // quoted identifiers and comments are not placeholders.
+    const char* bptr = stmt.data();
+    const char* eptr = stmt.data() + stmt.size();
+    const char* base = bptr;
+    size_t nargs = 0;
+    char quote = 0;
+
+    while(bptr != eptr) {
+      char ch = *bptr;
+      if(quote == '-') {
+        // `-- comment` or `# comment`
+        if(ch == '\n')
+          quote = 0;
+      }
+      else if(quote == '*') {
+        // `/* comment */`
+        if((ch == '*') && (eptr - bptr >= 2) && (bptr[1] == '/')) {
+          quote = 0;
+          bptr ++;
+        }
+      }
+      else if(quote != 0) {
+        // a quoted string or identifier
+        if((ch == '\\') && (quote != '`') && (eptr - bptr >= 2))
+          bptr ++;
+        else if(ch == quote)
+          quote = 0;
+      }
+      else if(is_any_of(ch, { '\'', '\"', '`' }))
+        quote = ch;
+      else if(ch == '#')
+        quote = '-';
+      else if((ch == '-') && (eptr - bptr >= 3) && (bptr[1] == '-')
+              && ::isspace(static_cast<unsigned char>(bptr[2])))
+        quote = '-';
+      else if((ch == '/') && (eptr - bptr >= 2) && (bptr[1] == '*')) {
+        quote = '*';
+        bptr ++;
+      }
+      else if(ch == '?') {
+        if(nargs >= args.size())
+          POSEIDON_THROW((
+              "No enough arguments for MySQL statement (`$1` < `$2`)"),
+              args.size(), nargs + 1);
+
+        fmt.putn(base, static_cast<size_t>(bptr - base));
+        do_append_literal(fmt, args[nargs]);
+        nargs ++;
+        base = bptr + 1;
+      }
+      bptr ++;
+    }
+
+    fmt.putn(base, static_cast<size_t>(eptr - base));
+  }
+
+void
+do_parse_text_value(MySQL_Value& value, uint32_t field_type, const char* str, size_t len)
+  {
+    char temp[32];
+    switch(field_type)
+      {
+      case MYSQL_TYPE_NULL:
+        value.clear();
+        break;
+
+      case MYSQL_TYPE_TINY:
+      case MYSQL_TYPE_SHORT:
+      case MYSQL_TYPE_INT24:
+      case MYSQL_TYPE_LONG:
+      case MYSQL_TYPE_LONGLONG:
+        value.open_integer() = ::strtoll_l(str, nullptr, 10, c_locale);
+        break;
+
+      case MYSQL_TYPE_FLOAT:
+      case MYSQL_TYPE_DOUBLE:
+        value.open_double() = ::strtod_l(str, nullptr, c_locale);
+        break;
+
+      case MYSQL_TYPE_TIMESTAMP:
+      case MYSQL_TYPE_DATETIME:
+      case MYSQL_TYPE_DATE:
+        // `1994-11-06 08:49:37.123`, with an optional fraction, or `1994-11-06`
+        // without time. Fractions of seconds are discarded.
+        if(len == 10) {
+          ::memcpy(temp, str, 10);
+          ::memcpy(temp + 10, " 00:00:00", 10);
+        }
+        else if(len >= 19) {
+          ::memcpy(temp, str, 19);
+          temp[19] = 0;
+        }
+        else
+          temp[0] = 0;
+
+        if(value.open_datetime().parse_git_partial(temp) == 19)
+          break;
+
+        // If the value can't be parsed, return it as a string.
+        value.open_blob().assign(str, len);
+        break;
+
+      default:
+        value.open_blob().assign(str, len);
+        break;
+      }
+  }
+
+}  // namespace
+
+POSEIDON_HIDDEN_X_STRUCT(MySQL_Connection,
+  Cached_Statement);
+
+POSEIDON_HIDDEN_X_STRUCT(MySQL_Connection,
+  Result_Column);
 
 MySQL_Connection::
 MySQL_Connection(const cow_string& service_uri, const cow_string& password)
@@ -14,6 +192,15 @@ MySQL_Connection(const cow_string& service_uri, const cow_string& password)
     this->m_password = password;
     this->m_connected = false;
     this->m_reset_clear = true;
+    this->m_stmt_cache_size = 0;
+    this->m_keep_stmts = false;
+    this->m_stmt_cache_hits = 0;
+    this->m_stmt_cache_misses = 0;
+    this->m_async = false;
+    this->m_text_result = false;
+    this->m_result_bound = false;
+    this->m_async_step = async_idle;
+    this->m_async_port = 0;
   }
 
 MySQL_Connection::
@@ -21,58 +208,153 @@ MySQL_Connection::
   {
   }
 
-bool
+void
 MySQL_Connection::
-reset()
+do_parse_service_uri(cow_string& user, cow_string& host, uint16_t& port,
+                     cow_string& database)
+  const
+  {
+    // Parse the service URI in a hacky way.
+    user = &"root";
+    host = &"localhost";
+    port = 3306;
+    database = &"";
+
+    cow_string uri = this->m_service_uri;
+    size_t t = uri.find_of("@/");
+    if((t != cow_string::npos) && (uri[t] == '@')) {
+      user.assign(uri, 0, t);
+      uri.erase(0, t + 1);
+    }
+
+    Network_Reference ref;
+    if(parse_network_reference(ref, uri) != uri.size())
+      POSEIDON_THROW((
+          "Invalid MySQL service URI `$1`",
+          "[`parse_network_reference()` failed]"),
+          this->m_service_uri);
+
+    if(ref.host.n != 0)
+      host.assign(ref.host.p, ref.host.n);
+
+    if(ref.port.n != 0)
+      port = ref.port_num;
+
+    if(ref.path.n != 0)
+      database.assign(ref.path.p + 1, ref.path.n - 1);
+  }
+
+void
+MySQL_Connection::
+do_release_statement()
   noexcept
   {
     // Discard the current result set.
     this->m_res.reset();
     this->m_meta.reset();
-    this->m_stmt.reset();
+    this->m_text_result = false;
+    this->m_result_bound = false;
+
+    uniptr_MYSQL_STMT stmt = move(this->m_stmt);
+    cow_string text = move(this->m_stmt_text);
+    if(!stmt || text.empty() || (this->m_stmt_cache_size == 0))
+      return;
+
+    // Discard pending rows, so the statement can be executed again. If this
+    // operation fails, the statement is closed.
+    if(::mysql_stmt_free_result(stmt) != 0)
+      return;
+
+    try {
+      X_Cached_Statement elem;
+      elem.text = move(text);
+      elem.stmt = move(stmt);
+      this->m_stmt_cache.insert(this->m_stmt_cache.begin(), move(elem));
+    }
+    catch(exception& stdex) {
+      POSEIDON_LOG_WARN(("Could not cache MySQL statement: $1"), stdex);
+      return;
+    }
 
-    // Reset the connection on the server. This is a blocking function.
-    bool error = this->m_connected && (::mysql_reset_connection(this->m_mysql) != 0);
-    this->m_reset_clear = !error;
-    return !error;
+    // Close least recently used statements.
+    while(this->m_stmt_cache.size() > this->m_stmt_cache_size)
+      this->m_stmt_cache.pop_back();
   }
 
 void
 MySQL_Connection::
-execute(const cow_string& stmt, const cow_vector<MySQL_Value>& args)
+set_statement_cache_size(uint32_t size)
+  noexcept
   {
-    if(stmt.empty())
-      POSEIDON_THROW(("Empty SQL statement"));
+    this->m_stmt_cache_size = size;
 
-    if(!this->m_connected) {
-      // Parse the service URI in a hacky way.
-      cow_string user = &"root";
-      cow_string host = &"localhost";
-      uint16_t port = 3306;
-      cow_string database = &"";
-
-      cow_string uri = this->m_service_uri;
-      size_t t = uri.find_of("@/");
-      if((t != cow_string::npos) && (uri[t] == '@')) {
-        user.assign(uri, 0, t);
-        uri.erase(0, t + 1);
+    while(this->m_stmt_cache.size() > size)
+      this->m_stmt_cache.pop_back();
+  }
+
+bool
+MySQL_Connection::
+reset()
+  noexcept
+  {
+    // Discard the current result set.
+    this->do_release_statement();
+
+    // Reset the connection on the server. This is a blocking function. A full
+    // reset releases all prepared statements on the server, so the cache is
+    // cleared beforehand, unless the user has opted to keep them.
+    bool error = false;
+    if(this->m_async_step != async_idle)
+      error = true;
+    else if(this->m_connected && this->m_async) {
+      this->m_stmt_cache.clear();
+
+      // The socket is non-blocking, so wait for it. If the server doesn't
+      // respond in time, the reply may arrive later and confuse the next
+      // statement, so the connection can't be reused.
+      ::net_async_status status;
+      while((status = ::mysql_reset_connection_nonblocking(this->m_mysql)) == NET_ASYNC_NOT_READY) {
+        ::pollfd pfd = { this->nonblocking_fd(), POLLIN, 0 };
+        if(::poll(&pfd, 1, 10000) <= 0) {
+          POSEIDON_LOG_WARN(("Timed out resetting MySQL connection to `$1`"), this->m_service_uri);
+          status = NET_ASYNC_ERROR;
+          break;
+        }
       }
+      error = status != NET_ASYNC_COMPLETE;
+    }
+    else if(this->m_connected && this->m_keep_stmts && !this->m_stmt_cache.empty()) {
+      error = (::mysql_rollback(this->m_mysql) != 0)
+              || (::mysql_autocommit(this->m_mysql, true) != 0);
+      if(error)
+        this->m_stmt_cache.clear();
+    }
+    else if(this->m_connected) {
+      this->m_stmt_cache.clear();
+      error = ::mysql_reset_connection(this->m_mysql) != 0;
+    }
 
-      Network_Reference ref;
-      if(parse_network_reference(ref, uri) != uri.size())
-        POSEIDON_THROW((
-            "Invalid MySQL service URI `$1`",
-            "[`parse_network_reference()` failed]"),
-            this->m_service_uri);
+    this->m_reset_clear = !error;
+    return !error;
+  }
 
-      if(ref.host.n != 0)
-        host.assign(ref.host.p, ref.host.n);
+void
+MySQL_Connection::
+do_execute(const cow_string& stmt, const cow_vector<MySQL_Value>& args,
+           uint32_t prefetch_rows)
+  {
+    if(stmt.empty())
+      POSEIDON_THROW(("Empty SQL statement"));
 
-      if(ref.port.n != 0)
-        port = ref.port_num;
+    if(this->m_async || (this->m_async_step != async_idle))
+      POSEIDON_THROW((
+          "MySQL connection to `$1` is asynchronous"),
+          this->m_service_uri);
 
-      if(ref.path.n != 0)
-        database.assign(ref.path.p + 1, ref.path.n - 1);
+    if(!this->m_connected) {
+      cow_string user, host, database;
+      uint16_t port;
+      this->do_parse_service_uri(user, host, port, database);
 
       // Try connecting to the server.
       if(!::mysql_real_connect(this->m_mysql, host.c_str(), user.c_str(),
@@ -84,23 +366,46 @@ execute(const cow_string& stmt, const cow_vector<MySQL_Value>& args)
             this->m_service_uri, ::mysql_errno(this->m_mysql),
             ::mysql_error(this->m_mysql));
 
+      // Statements from a previous connection are no longer valid.
+      this->m_stmt_cache.clear();
+
       cow_string().swap(this->m_password);
       this->m_connected = true;
       POSEIDON_LOG_INFO(("Connected to MySQL server `$1`"), this->m_service_uri);
     }
 
-    // Create a prepared statement.
-    if(!this->m_stmt.reset(::mysql_stmt_init(this->m_mysql)))
-      POSEIDON_THROW((
-          "Could not create MySQL statement: ERROR $1: $2",
-          "[`mysql_stmt_init()` failed]"),
-          ::mysql_errno(this->m_mysql), ::mysql_error(this->m_mysql));
+    // Return the previous statement to the cache.
+    this->do_release_statement();
 
-    if(::mysql_stmt_prepare(this->m_stmt, stmt.safe_c_str(), stmt.length()) != 0)
-      POSEIDON_THROW((
-          "Could not prepare MySQL statement: ERROR $1: $2",
-          "[`mysql_stmt_prepare()` failed]"),
-          ::mysql_stmt_errno(this->m_stmt), ::mysql_stmt_error(this->m_stmt));
+    // Look for a prepared statement in the cache.
+    for(auto pos = this->m_stmt_cache.mut_begin();  pos != this->m_stmt_cache.end();  ++pos)
+      if(pos->text == stmt) {
+        this->m_stmt = move(pos->stmt);
+        this->m_stmt_cache.erase(pos);
+        break;
+      }
+
+    if(this->m_stmt)
+      this->m_stmt_cache_hits ++;
+    else {
+      // Create a prepared statement.
+      this->m_stmt_cache_misses ++;
+
+      if(!this->m_stmt.reset(::mysql_stmt_init(this->m_mysql)))
+        POSEIDON_THROW((
+            "Could not create MySQL statement: ERROR $1: $2",
+            "[`mysql_stmt_init()` failed]"),
+            ::mysql_errno(this->m_mysql), ::mysql_error(this->m_mysql));
+
+      if(::mysql_stmt_prepare(this->m_stmt, stmt.safe_c_str(), stmt.length()) != 0)
+        POSEIDON_THROW((
+            "Could not prepare MySQL statement: ERROR $1: $2",
+            "[`mysql_stmt_prepare()` failed]"),
+            ::mysql_stmt_errno(this->m_stmt), ::mysql_stmt_error(this->m_stmt));
+    }
+
+    // Only prepared statements may be cached.
+    this->m_stmt_text = stmt;
 
     // Bind arguments.
     unsigned long nparams = ::mysql_stmt_param_count(this->m_stmt);
@@ -175,8 +480,29 @@ execute(const cow_string& stmt, const cow_vector<MySQL_Value>& args)
     // Discard the current result set.
     this->m_res.reset();
     this->m_meta.reset();
+    this->m_result_bound = false;
     this->m_reset_clear = false;
 
+    // A cached statement may have been executed with a cursor, so the cursor
+    // type is always set.
+    unsigned long cursor_type = CURSOR_TYPE_NO_CURSOR;
+    unsigned long prefetch = prefetch_rows;
+    if(prefetch_rows != 0)
+      cursor_type = CURSOR_TYPE_READ_ONLY;
+
+    if(::mysql_stmt_attr_set(this->m_stmt, STMT_ATTR_CURSOR_TYPE, &cursor_type) != 0)
+      POSEIDON_THROW((
+          "Could not set cursor type of MySQL statement: ERROR $1: $2",
+          "[`mysql_stmt_attr_set()` failed]"),
+          ::mysql_stmt_errno(this->m_stmt), ::mysql_stmt_error(this->m_stmt));
+
+    if(prefetch_rows != 0)
+      if(::mysql_stmt_attr_set(this->m_stmt, STMT_ATTR_PREFETCH_ROWS, &prefetch) != 0)
+        POSEIDON_THROW((
+            "Could not set prefetch size of MySQL statement: ERROR $1: $2",
+            "[`mysql_stmt_attr_set()` failed]"),
+            ::mysql_stmt_errno(this->m_stmt), ::mysql_stmt_error(this->m_stmt));
+
     // Execute the bound statement. While this function is blocking, we don't
     // fetch its result here; it's done in `fetch()`.
     if(::mysql_stmt_execute(this->m_stmt) != 0)
@@ -186,6 +512,250 @@ execute(const cow_string& stmt, const cow_vector<MySQL_Value>& args)
           ::mysql_stmt_errno(this->m_stmt), ::mysql_stmt_error(this->m_stmt));
   }
 
+bool
+MySQL_Connection::
+do_bind_result()
+  {
+    ::MYSQL_FIELD* meta_fields = nullptr;
+    size_t nfields = ::mysql_stmt_field_count(this->m_stmt);
+
+    if(!this->m_meta)
+      this->m_meta.reset(::mysql_stmt_result_metadata(this->m_stmt));
+
+    if(this->m_meta)
+      meta_fields = ::mysql_fetch_fields(this->m_meta);
+
+    // Buffers are kept across result sets, so they only grow.
+    if(this->m_result_columns.size() < nfields)
+      this->m_result_columns.resize(nfields);
+
+    this->m_result_binds.clear();
+    this->m_result_binds.resize(nfields);
+
+    for(size_t col = 0;  col != nfields;  ++col) {
+      // Prepare output buffers. When there is no metadata o we can't know the
+      // type of this field, the output is written as an omnipotent string.
+      auto& bind = this->m_result_binds[col];
+      auto& rcol = this->m_result_columns.mut(col);
+      uint32_t field_type = meta_fields ? meta_fields[col].type : MYSQL_TYPE_BLOB;
+      switch(field_type)
+        {
+        case MYSQL_TYPE_NULL:
+          bind.buffer_type = MYSQL_TYPE_NULL;
+          bind.buffer = nullptr;
+          bind.buffer_length = 0;
+          break;
+
+        case MYSQL_TYPE_TINY:
+        case MYSQL_TYPE_SHORT:
+        case MYSQL_TYPE_INT24:
+        case MYSQL_TYPE_LONG:
+        case MYSQL_TYPE_LONGLONG:
+          bind.buffer_type = MYSQL_TYPE_LONGLONG;
+          bind.buffer = &(rcol.integer);
+          bind.buffer_length = sizeof(int64_t);
+          break;
+
+        case MYSQL_TYPE_FLOAT:
+        case MYSQL_TYPE_DOUBLE:
+          bind.buffer_type = MYSQL_TYPE_DOUBLE;
+          bind.buffer = &(rcol.dbl);
+          bind.buffer_length = sizeof(double);
+          break;
+
+        case MYSQL_TYPE_TIMESTAMP:
+        case MYSQL_TYPE_DATETIME:
+        case MYSQL_TYPE_DATE:
+        case MYSQL_TYPE_TIME:
+          bind.buffer_type = MYSQL_TYPE_DATETIME;
+          bind.buffer = &(rcol.time);
+          bind.buffer_length = sizeof(::MYSQL_TIME);
+          break;
+
+        default:
+          bind.buffer_type = MYSQL_TYPE_LONG_BLOB;
+          if(rcol.blob.size() < 255)
+            rcol.blob.resize(255);
+          bind.buffer = rcol.blob.mut_data();
+          bind.buffer_length = rcol.blob.size();
+          break;
+        }
+
+      // XXX: What are these fields used for? Why aren't they used by default?
+      bind.length = &(bind.length_value);
+      bind.error = &(bind.error_value);
+      bind.is_null = &(bind.is_null_value);
+    }
+
+    if(::mysql_stmt_bind_result(this->m_stmt, this->m_result_binds.data()) != 0)
+      return false;
+
+    this->m_result_bound = true;
+    return true;
+  }
+
+void
+MySQL_Connection::
+execute(const cow_string& stmt, const cow_vector<MySQL_Value>& args)
+  {
+    this->do_execute(stmt, args, 0);
+  }
+
+void
+MySQL_Connection::
+execute_cursor(const cow_string& stmt, const cow_vector<MySQL_Value>& args,
+               uint32_t prefetch_rows)
+  {
+    this->do_execute(stmt, args, ::std::max(prefetch_rows, 1U));
+  }
+
+bool
+MySQL_Connection::
+execute_nonblocking_start(const cow_string& stmt, const cow_vector<MySQL_Value>& args)
+  {
+    if(stmt.empty())
+      POSEIDON_THROW(("Empty SQL statement"));
+
+    if((this->m_connected && !this->m_async) || (this->m_async_step != async_idle))
+      POSEIDON_THROW((
+          "MySQL connection to `$1` is not available for asynchronous use"),
+          this->m_service_uri);
+
+    tinyfmt_str fmt;
+    do_compose_query(fmt, stmt, args);
+    cow_string query = fmt.extract_string();
+
+    if(!this->m_connected)
+      this->do_parse_service_uri(this->m_async_user, this->m_async_host,
+                                 this->m_async_port, this->m_async_database);
+
+    // Discard the current result set.
+    this->do_release_statement();
+    this->m_reset_clear = false;
+
+    this->m_async_query.swap(query);
+    this->m_async_step = this->m_connected ? async_query : async_connect;
+    return this->execute_nonblocking_continue();
+  }
+
+bool
+MySQL_Connection::
+reset_nonblocking_start()
+  {
+    if((this->m_connected && !this->m_async) || (this->m_async_step != async_idle))
+      POSEIDON_THROW((
+          "MySQL connection to `$1` is not available for asynchronous use"),
+          this->m_service_uri);
+
+    // Discard the current result set.
+    this->do_release_statement();
+
+    if(!this->m_connected) {
+      this->m_reset_clear = true;
+      return true;
+    }
+
+    this->m_async_step = async_reset;
+    return this->execute_nonblocking_continue();
+  }
+
+bool
+MySQL_Connection::
+execute_nonblocking_continue()
+  {
+    ::net_async_status status;
+    ::MYSQL_RES* res = nullptr;
+
+    switch(this->m_async_step)
+      {
+      case async_connect:
+        status = ::mysql_real_connect_nonblocking(this->m_mysql,
+                     this->m_async_host.c_str(), this->m_async_user.c_str(),
+                     this->m_password.c_str(), this->m_async_database.c_str(),
+                     this->m_async_port, nullptr, CLIENT_COMPRESS | CLIENT_FOUND_ROWS);
+        if(status == NET_ASYNC_NOT_READY)
+          return false;
+
+        if(status != NET_ASYNC_COMPLETE) {
+          this->m_async_step = async_idle;
+          POSEIDON_THROW((
+              "Could not connect to MySQL server `$1`: ERROR $2: $3",
+              "[`mysql_real_connect_nonblocking()` failed]"),
+              this->m_service_uri, ::mysql_errno(this->m_mysql),
+              ::mysql_error(this->m_mysql));
+        }
+
+        cow_string().swap(this->m_password);
+        this->m_connected = true;
+        this->m_async = true;
+        this->m_async_step = async_query;
+        POSEIDON_LOG_INFO(("Connected to MySQL server `$1`"), this->m_service_uri);
+        // fallthrough
+
+      case async_query:
+        status = ::mysql_real_query_nonblocking(this->m_mysql, this->m_async_query.data(),
+                                                this->m_async_query.size());
+        if(status == NET_ASYNC_NOT_READY)
+          return false;
+
+        if(status != NET_ASYNC_COMPLETE) {
+          this->m_async_step = async_idle;
+          POSEIDON_THROW((
+              "Could not execute MySQL statement: ERROR $1: $2",
+              "[`mysql_real_query_nonblocking()` failed]"),
+              ::mysql_errno(this->m_mysql), ::mysql_error(this->m_mysql));
+        }
+
+        this->m_async_step = async_store;
+        // fallthrough
+
+      case async_store:
+        // Statements without results yield a null pointer.
+        status = ::mysql_store_result_nonblocking(this->m_mysql, &res);
+        if(status == NET_ASYNC_NOT_READY)
+          return false;
+
+        this->m_res.reset(res);
+        this->m_async_step = async_idle;
+
+        if(status != NET_ASYNC_COMPLETE)
+          POSEIDON_THROW((
+              "Could not fetch MySQL result: ERROR $1: $2",
+              "[`mysql_store_result_nonblocking()` failed]"),
+              ::mysql_errno(this->m_mysql), ::mysql_error(this->m_mysql));
+
+        this->m_text_result = true;
+        return true;
+
+      case async_reset:
+        status = ::mysql_reset_connection_nonblocking(this->m_mysql);
+        if(status == NET_ASYNC_NOT_READY)
+          return false;
+
+        this->m_async_step = async_idle;
+
+        if(status != NET_ASYNC_COMPLETE)
+          POSEIDON_THROW((
+              "Could not reset MySQL connection: ERROR $1: $2",
+              "[`mysql_reset_connection_nonblocking()` failed]"),
+              ::mysql_errno(this->m_mysql), ::mysql_error(this->m_mysql));
+
+        this->m_reset_clear = true;
+        return true;
+
+      default:
+        POSEIDON_THROW(("No asynchronous MySQL operation in progress"));
+      }
+  }
+
+int
+MySQL_Connection::
+nonblocking_fd()
+  const noexcept
+  {
+    return static_cast<::MYSQL*>(this->m_mysql)->net.fd;
+  }
+
 uint32_t
 MySQL_Connection::
 warning_count()
@@ -199,6 +769,9 @@ MySQL_Connection::
 match_count()
   const noexcept
   {
+    if(this->m_text_result)
+      return ::mysql_affected_rows(this->m_mysql);
+
     if(!this->m_stmt)
       return 0;
 
@@ -211,6 +784,9 @@ MySQL_Connection::
 insert_id()
   const noexcept
   {
+    if(this->m_text_result)
+      return ::mysql_insert_id(this->m_mysql);
+
     if(!this->m_stmt)
       return 0;
 
@@ -223,6 +799,20 @@ fetch_fields(cow_vector<cow_string>& output)
   {
     output.clear();
 
+    if(this->m_text_result) {
+      if(!this->m_res)
+        return false;
+
+      ::MYSQL_FIELD* res_fields = ::mysql_fetch_fields(this->m_res);
+      size_t nfields = ::mysql_num_fields(this->m_res);
+
+      output.resize(nfields);
+      for(size_t col = 0;  col != nfields;  ++col)
+        output.mut(col).assign(res_fields[col].name, res_fields[col].name_length);
+
+      return true;
+    }
+
     if(!this->m_stmt)
       return false;
 
@@ -250,78 +840,32 @@ fetch_row(cow_vector<MySQL_Value>& output)
   {
     output.clear();
 
-    if(!this->m_stmt)
-      return false;
-
-    ::MYSQL_FIELD* meta_fields = nullptr;
-    size_t nfields = ::mysql_stmt_field_count(this->m_stmt);
-    ::std::vector<::MYSQL_BIND> binds(nfields);
+    if(this->m_text_result) {
+      // The result set has been stored, so this will not block.
+      if(!this->m_res)
+        return false;
 
-    if(!this->m_meta)
-      this->m_meta.reset(::mysql_stmt_result_metadata(this->m_stmt));
-
-    if(this->m_meta)
-      meta_fields = ::mysql_fetch_fields(this->m_meta);
+      ::MYSQL_ROW res_row = ::mysql_fetch_row(this->m_res);
+      if(!res_row)
+        return false;
 
-    struct timespec ts;
-    struct tm tm;
-    ::std::vector<::MYSQL_TIME> time_buf;
+      ::MYSQL_FIELD* res_fields = ::mysql_fetch_fields(this->m_res);
+      unsigned long* lengths = ::mysql_fetch_lengths(this->m_res);
+      size_t nfields = ::mysql_num_fields(this->m_res);
 
-    output.resize(nfields);
-    for(size_t col = 0;  col != nfields;  ++col) {
-      // Prepare output buffers. When there is no metadata o we can't know the
-      // type of this field, the output is written as an omnipotent string.
-      uint32_t field_type = meta_fields ? meta_fields[col].type : MYSQL_TYPE_BLOB;
-      switch(field_type)
-        {
-        case MYSQL_TYPE_NULL:
-          binds[col].buffer_type = MYSQL_TYPE_NULL;
-          binds[col].buffer = nullptr;
-          binds[col].buffer_length = 0;
-          break;
+      output.resize(nfields);
+      for(size_t col = 0;  col != nfields;  ++col)
+        if(res_row[col])
+          do_parse_text_value(output.mut(col), res_fields[col].type, res_row[col],
+                              lengths[col]);
 
-        case MYSQL_TYPE_TINY:
-        case MYSQL_TYPE_SHORT:
-        case MYSQL_TYPE_INT24:
-        case MYSQL_TYPE_LONG:
-        case MYSQL_TYPE_LONGLONG:
-          binds[col].buffer_type = MYSQL_TYPE_LONGLONG;
-          binds[col].buffer = &(output.mut(col).open_integer());
-          binds[col].buffer_length = sizeof(int64_t);
-          break;
-
-        case MYSQL_TYPE_FLOAT:
-        case MYSQL_TYPE_DOUBLE:
-          binds[col].buffer_type = MYSQL_TYPE_DOUBLE;
-          binds[col].buffer = &(output.mut(col).open_double());
-          binds[col].buffer_length = sizeof(double);
-          break;
-
-        case MYSQL_TYPE_TIMESTAMP:
-        case MYSQL_TYPE_DATETIME:
-        case MYSQL_TYPE_DATE:
-        case MYSQL_TYPE_TIME:
-          binds[col].buffer_type = MYSQL_TYPE_DATETIME;
-          time_buf.resize(nfields);
-          binds[col].buffer = &(time_buf[col]);
-          binds[col].buffer_length = sizeof(::MYSQL_TIME);
-          break;
-
-        default:
-          binds[col].buffer_type = MYSQL_TYPE_LONG_BLOB;
-          output.mut(col).open_blob().resize(255);
-          binds[col].buffer = output.mut(col).open_blob().mut_data();
-          binds[col].buffer_length = output.mut(col).open_blob().size();
-          break;
-        }
-
-      // XXX: What are these fields used for? Why aren't they used by default?
-      binds[col].length = &(binds[col].length_value);
-      binds[col].error = &(binds[col].error_value);
-      binds[col].is_null = &(binds[col].is_null_value);
+      return true;
     }
 
-    if(::mysql_stmt_bind_result(this->m_stmt, binds.data()) != 0)
+    if(!this->m_stmt)
+      return false;
+
+    if(!this->m_result_bound && !this->do_bind_result())
       return false;
 
     int status = ::mysql_stmt_fetch(this->m_stmt);
@@ -334,41 +878,58 @@ fetch_row(cow_vector<MySQL_Value>& output)
     if(status == MYSQL_NO_DATA)
       return false;
 
-    for(unsigned col = 0;  col != output.size();  ++col)
-      if(binds[col].is_null_value) {
-        // Set it to an explicit `NULL`.
-        output.mut(col).clear();
+    struct timespec ts;
+    struct tm tm;
+    bool rebind = false;
+
+    output.resize(this->m_result_binds.size());
+    for(unsigned col = 0;  col != output.size();  ++col) {
+      auto& bind = this->m_result_binds[col];
+      auto& rcol = this->m_result_columns.mut(col);
+
+      if(bind.is_null_value) {
+        // Leave it as an explicit `NULL`.
       }
-      else if(binds[col].buffer_type == MYSQL_TYPE_DATETIME) {
+      else if(bind.buffer_type == MYSQL_TYPE_LONGLONG)
+        output.mut(col).open_integer() = rcol.integer;
+      else if(bind.buffer_type == MYSQL_TYPE_DOUBLE)
+        output.mut(col).open_double() = rcol.dbl;
+      else if(bind.buffer_type == MYSQL_TYPE_DATETIME) {
         // Assemble the timestamp.
-        tm.tm_year = static_cast<int>(time_buf[col].year - 1900);
-        tm.tm_mon = static_cast<int>(time_buf[col].month - 1);
-        tm.tm_mday = static_cast<int>(time_buf[col].day);
-        tm.tm_hour = static_cast<int>(time_buf[col].hour);
-        tm.tm_min = static_cast<int>(time_buf[col].minute);
-        tm.tm_sec = static_cast<int>(time_buf[col].second);
-        ts.tv_nsec = static_cast<long>(time_buf[col].second_part / 1000 * 1000000);
-
-        if(time_buf[col].second_part % 100 == 0)  // no hacked time zone?
+        tm.tm_year = static_cast<int>(rcol.time.year - 1900);
+        tm.tm_mon = static_cast<int>(rcol.time.month - 1);
+        tm.tm_mday = static_cast<int>(rcol.time.day);
+        tm.tm_hour = static_cast<int>(rcol.time.hour);
+        tm.tm_min = static_cast<int>(rcol.time.minute);
+        tm.tm_sec = static_cast<int>(rcol.time.second);
+        ts.tv_nsec = static_cast<long>(rcol.time.second_part / 1000 * 1000000);
+
+        if(rcol.time.second_part % 100 == 0)  // no hacked time zone?
           ts.tv_sec = ::timelocal(&tm);
         else {
           ts.tv_sec = ::timegm(&tm);
-          ts.tv_sec -= static_cast<::time_t>(time_buf[col].second_part % 100 * 1800) - 54000;
+          ts.tv_sec -= static_cast<::time_t>(rcol.time.second_part % 100 * 1800) - 54000;
         }
 
         output.mut(col).open_datetime() = system_time_from_timespec(ts);
       }
-      else if(binds[col].buffer_type == MYSQL_TYPE_LONG_BLOB) {
-        // Resize the buffer to the actual length.
-        output.mut(col).open_blob().resize(binds[col].length_value);
-        if(binds[col].buffer_length < binds[col].length_value) {
-          // This indicates that the previous size was too small, and we have to
-          // fetch the data again.
-          binds[col].buffer = output.mut(col).open_blob().mut_data();
-          binds[col].buffer_length = binds[col].length_value;
-          ::mysql_stmt_fetch_column(this->m_stmt, &(binds[col]), col, 0);
+      else if(bind.buffer_type == MYSQL_TYPE_LONG_BLOB) {
+        if(bind.buffer_length < bind.length_value) {
+          // This indicates that the buffer was too small, and we have to fetch
+          // the data again. The buffer is enlarged for subsequent rows.
+          rcol.blob.resize(bind.length_value);
+          bind.buffer = rcol.blob.mut_data();
+          bind.buffer_length = rcol.blob.size();
+          ::mysql_stmt_fetch_column(this->m_stmt, &bind, col, 0);
+          rebind = true;
         }
+
+        output.mut(col).open_blob().assign(rcol.blob.data(), bind.length_value);
       }
+    }
+
+    if(rebind && (::mysql_stmt_bind_result(this->m_stmt, this->m_result_binds.data()) != 0))
+      this->m_result_bound = false;
 
     return true;
   }
@@ -0,0 +1,182 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../mysql/mysql_result_columns.hpp"
+#include "../../utils.hpp"
+namespace poseidon {
+
+MySQL_Result_Columns::
+~MySQL_Result_Columns()
+  {
+  }
+
+const MySQL_Result_Columns::X_Column&
+MySQL_Result_Columns::
+do_check_column(size_t col, MySQL_Value_Type type)
+  const
+  {
+    const auto& column = this->m_columns.at(col);
+    if(column.type != type)
+      POSEIDON_THROW((
+          "MySQL column `$1` has type `$2`, not `$3`"),
+          column.name, column.type, type);
+
+    return column;
+  }
+
+void
+MySQL_Result_Columns::
+reset(const cow_vector<cow_string>& names)
+  {
+    this->m_columns.clear();
+    this->m_row_count = 0;
+    this->m_arena.clear();
+
+    this->m_columns.resize(names.size());
+    for(size_t col = 0;  col != names.size();  ++col) {
+      this->m_columns[col].name = names[col];
+      this->m_columns[col].type = mysql_value_null;
+    }
+  }
+
+void
+MySQL_Result_Columns::
+append_row(const cow_vector<MySQL_Value>& row)
+  {
+    if(row.size() != this->m_columns.size())
+      POSEIDON_THROW((
+          "Number of values mismatches number of columns (`$1` != `$2`)"),
+          row.size(), this->m_columns.size());
+
+    // Check types before making any changes.
+    for(size_t col = 0;  col != row.size();  ++col) {
+      const auto& column = this->m_columns[col];
+      if(row[col].is_null() || (column.type == mysql_value_null))
+        continue;
+
+      if(column.type != row[col].type())
+        POSEIDON_THROW((
+            "MySQL column `$1` has type `$2`, but value has type `$3`"),
+            column.name, column.type, row[col].type());
+    }
+
+    size_t row_index = this->m_row_count;
+    for(size_t col = 0;  col != row.size();  ++col) {
+      auto& column = this->m_columns[col];
+      const auto& value = row[col];
+
+      if(column.nulls.size() <= row_index / 8)
+        column.nulls.push_back(0);
+
+      uint8_t mask = static_cast<uint8_t>(1U << row_index % 8);
+      if(value.is_null())
+        column.nulls[row_index / 8] |= mask;
+      else
+        column.nulls[row_index / 8] &= static_cast<uint8_t>(~mask);
+
+      if(!value.is_null() && (column.type == mysql_value_null)) {
+        // This is the first non-null value, which determines the type of this
+        // column. Previous values are all nulls.
+        column.type = value.type();
+        switch(column.type)
+          {
+          case mysql_value_integer:
+            column.integers.resize(row_index);
+            break;
+
+          case mysql_value_double:
+            column.doubles.resize(row_index);
+            break;
+
+          case mysql_value_blob:
+            column.blobs.resize(row_index);
+            break;
+
+          case mysql_value_datetime:
+            column.datetimes.resize(row_index);
+            break;
+
+          default:
+            ASTERIA_TERMINATE(("Corrupted MySQL value type `$1`"), column.type);
+          }
+      }
+
+      switch(column.type)
+        {
+        case mysql_value_null:
+          break;
+
+        case mysql_value_integer:
+          column.integers.push_back(value.is_null() ? 0 : value.as_integer());
+          break;
+
+        case mysql_value_double:
+          column.doubles.push_back(value.is_null() ? 0 : value.as_double());
+          break;
+
+        case mysql_value_blob:
+          if(value.is_null())
+            column.blobs.emplace_back(this->m_arena.size(), 0U);
+          else {
+            column.blobs.emplace_back(this->m_arena.size(), value.as_blob_size());
+            this->m_arena.append(value.as_blob_data(), value.as_blob_size());
+          }
+          break;
+
+        case mysql_value_datetime:
+          column.datetimes.push_back(value.is_null() ? system_time() : value.as_system_time());
+          break;
+
+        default:
+          ASTERIA_TERMINATE(("Corrupted MySQL value type `$1`"), column.type);
+        }
+    }
+
+    this->m_row_count ++;
+  }
+
+bool
+MySQL_Result_Columns::
+is_null(size_t col, size_t row)
+  const
+  {
+    const auto& column = this->m_columns.at(col);
+    if(row >= this->m_row_count)
+      POSEIDON_THROW((
+          "MySQL row index out of range (`$1` >= `$2`)"),
+          row, this->m_row_count);
+
+    return column.nulls[row / 8] >> row % 8 & 1;
+  }
+
+MySQL_Value
+MySQL_Result_Columns::
+value(size_t col, size_t row)
+  const
+  {
+    if(this->is_null(col, row))
+      return nullptr;
+
+    const auto& column = this->m_columns[col];
+    switch(column.type)
+      {
+      case mysql_value_integer:
+        return column.integers[row];
+
+      case mysql_value_double:
+        return column.doubles[row];
+
+      case mysql_value_blob:
+        return cow_string(this->m_arena.data() + column.blobs[row].first,
+                          column.blobs[row].second);
+
+      case mysql_value_datetime:
+        return column.datetimes[row];
+
+      default:
+        ASTERIA_TERMINATE(("Corrupted MySQL value type `$1`"), column.type);
+      }
+  }
+
+}  // namespace poseidon
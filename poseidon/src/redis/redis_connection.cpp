@@ -26,8 +26,8 @@ Redis_Connection::
 reset()
   noexcept
   {
-    // Discard the current reply.
-    this->m_reply.reset();
+    // Discard all pending replies.
+    this->m_replies.clear();
 
     // Check whether an error has occurred.
     bool error = this->m_connected && (this->m_redis->err != 0);
@@ -37,93 +37,96 @@ reset()
 
 void
 Redis_Connection::
-execute(const cow_vector<cow_string>& cmd)
+do_connect_if_needed()
   {
-    if(cmd.empty())
-      POSEIDON_THROW(("Empty Redis command"));
+    if(this->m_connected)
+      return;
+
+    // Parse the service URI in a hacky way.
+    cow_string user = &"default";
+    cow_string host = &"localhost";
+    uint16_t port = 6379;
+    cow_string database = &"0";
+
+    cow_string uri = this->m_service_uri;
+    size_t t = uri.find_of("@/");
+    if((t != cow_string::npos) && (uri[t] == '@')) {
+      user.assign(uri, 0, t);
+      uri.erase(0, t + 1);
+    }
 
-    if(!this->m_connected) {
-      // Parse the service URI in a hacky way.
-      cow_string user = &"default";
-      cow_string host = &"localhost";
-      uint16_t port = 6379;
-      cow_string database = &"0";
-
-      cow_string uri = this->m_service_uri;
-      size_t t = uri.find_of("@/");
-      if((t != cow_string::npos) && (uri[t] == '@')) {
-        user.assign(uri, 0, t);
-        uri.erase(0, t + 1);
-      }
+    Network_Reference ref;
+    if(parse_network_reference(ref, uri) != uri.size())
+      POSEIDON_THROW((
+          "Invalid Redis service URI `$1`",
+          "[`parse_network_reference()` failed]"),
+          this->m_service_uri);
 
-      Network_Reference ref;
-      if(parse_network_reference(ref, uri) != uri.size())
-        POSEIDON_THROW((
-            "Invalid Redis service URI `$1`",
-            "[`parse_network_reference()` failed]"),
-            this->m_service_uri);
+    if(ref.host.n != 0)
+      host.assign(ref.host.p, ref.host.n);
 
-      if(ref.host.n != 0)
-        host.assign(ref.host.p, ref.host.n);
+    if(ref.port.n != 0)
+      port = ref.port_num;
 
-      if(ref.port.n != 0)
-        port = ref.port_num;
+    if(ref.path.n != 0)
+      database.assign(ref.path.p + 1, ref.path.n - 1);
 
-      if(ref.path.n != 0)
-        database.assign(ref.path.p + 1, ref.path.n - 1);
+    // Try connecting to the server.
+    if(!this->m_redis.reset(::redisConnect(host.c_str(), port)))
+      POSEIDON_THROW((
+          "Could not connect to Redis server `$1`: ${errno:full}",
+          "[`redisConnect()` failed]"),
+          this->m_service_uri);
 
-      // Try connecting to the server.
-      if(!this->m_redis.reset(::redisConnect(host.c_str(), port)))
+    if(this->m_redis->err != 0)
+      POSEIDON_THROW((
+          "Could not connect to Redis server `$1`: ERROR $2: $3",
+          "[`redisConnect()` failed]"),
+          this->m_service_uri, this->m_redis->err, this->m_redis->errstr);
+
+    uniptr_redisReply reply;
+    if(this->m_password.size() != 0) {
+      // `AUTH user password`
+      if(!reply.reset(static_cast<::redisReply*>(::redisCommand(
+                             this->m_redis, "AUTH %s %s", user.c_str(),
+                             this->m_password.c_str()))))
         POSEIDON_THROW((
-            "Could not connect to Redis server `$1`: ${errno:full}",
-            "[`redisConnect()` failed]"),
-            this->m_service_uri);
+            "Could not execute Redis command: ERROR $1: $2",
+            "[`redisCommand()` failed]"),
+            this->m_redis->err, this->m_redis->errstr);
 
-      if(this->m_redis->err != 0)
+      if(reply->type == REDIS_REPLY_ERROR)
         POSEIDON_THROW((
-            "Could not connect to Redis server `$1`: ERROR $2: $3",
-            "[`redisConnect()` failed]"),
-            this->m_service_uri, this->m_redis->err, this->m_redis->errstr);
-
-      if(this->m_password.size() != 0) {
-        // `AUTH user password`
-        if(!this->m_reply.reset(static_cast<::redisReply*>(::redisCommand(
-                                    this->m_redis, "AUTH %s %s", user.c_str(),
-                                    this->m_password.c_str()))))
-          POSEIDON_THROW((
-              "Could not execute Redis command: ERROR $1: $2",
-              "[`redisCommand()` failed]"),
-              this->m_redis->err, this->m_redis->errstr);
-
-        if(this->m_reply->type == REDIS_REPLY_ERROR)
-          POSEIDON_THROW((
-              "Failed to authenticate with Redis server: $1"),
-              this->m_reply->str);
-      }
+            "Failed to authenticate with Redis server: $1"),
+            reply->str);
+    }
 
-      if(database.size() != 0) {
-        // `SELECT index`
-        if(!this->m_reply.reset(static_cast<::redisReply*>(::redisCommand(
-                                    this->m_redis, "SELECT %s", database.c_str()))))
-          POSEIDON_THROW((
-              "Could not execute Redis command: ERROR $1: $2",
-              "[`redisCommand()` failed]"),
-              this->m_redis->err, this->m_redis->errstr);
-
-        if(this->m_reply->type == REDIS_REPLY_ERROR)
-          POSEIDON_THROW((
-              "Could not set logical database: $1"),
-              this->m_reply->str);
-      }
+    if(database.size() != 0) {
+      // `SELECT index`
+      if(!reply.reset(static_cast<::redisReply*>(::redisCommand(
+                             this->m_redis, "SELECT %s", database.c_str()))))
+        POSEIDON_THROW((
+            "Could not execute Redis command: ERROR $1: $2",
+            "[`redisCommand()` failed]"),
+            this->m_redis->err, this->m_redis->errstr);
 
-      cow_string().swap(this->m_password);
-      this->m_connected = true;
-      POSEIDON_LOG_INFO(("Connected to Redis server `$1`"), this->m_service_uri);
+      if(reply->type == REDIS_REPLY_ERROR)
+        POSEIDON_THROW((
+            "Could not set logical database: $1"),
+            reply->str);
     }
 
-    // Discard the current reply.
-    this->m_reply.reset();
-    this->m_reset_clear = false;
+    cow_string().swap(this->m_password);
+    this->m_connected = true;
+    POSEIDON_LOG_INFO(("Connected to Redis server `$1`"), this->m_service_uri);
+  }
+
+void
+Redis_Connection::
+do_append_command(const cow_vector<cow_string>& cmd)
+  {
+    if(cmd.empty())
+      POSEIDON_THROW(("Empty Redis command"));
 
     // Compose the argument and length vector.
     ::std::vector<uintptr_t> argv;
@@ -133,19 +136,79 @@ execute(const cow_vector<cow_string>& cmd)
       argv.at(cmd.size() + t) = cmd.at(t).size();
     }
 
-    if(!this->m_reply.reset(static_cast<::redisReply*>(::redisCommandArgv(
-                                this->m_redis, static_cast<int>(cmd.size()),
+    if(::redisAppendCommandArgv(this->m_redis, static_cast<int>(cmd.size()),
                                 reinterpret_cast<const char**>(argv.data()),
-                                reinterpret_cast<size_t*>(argv.data() + cmd.size())))))
+                                reinterpret_cast<size_t*>(argv.data() + cmd.size()))
+       != REDIS_OK)
       POSEIDON_THROW((
           "Could not execute Redis command: ERROR $1: $2",
-          "[`redisCommandArgv()` failed]"),
+          "[`redisAppendCommandArgv()` failed]"),
           this->m_redis->err, this->m_redis->errstr);
+  }
 
-    if(this->m_reply->type == REDIS_REPLY_ERROR)
+void
+Redis_Connection::
+do_get_reply()
+  {
+    void* reply = nullptr;
+    if(::redisGetReply(this->m_redis, &reply) != REDIS_OK)
       POSEIDON_THROW((
-          "Redis server replied with an error: $1"),
-          this->m_reply->str);
+          "Could not execute Redis command: ERROR $1: $2",
+          "[`redisGetReply()` failed]"),
+          this->m_redis->err, this->m_redis->errstr);
+
+    uniptr_redisReply unique_reply(static_cast<::redisReply*>(reply));
+    this->m_replies.push_back(move(unique_reply));
+  }
+
+void
+Redis_Connection::
+execute(const cow_vector<cow_string>& cmd)
+  {
+    if(cmd.empty())
+      POSEIDON_THROW(("Empty Redis command"));
+
+    this->do_connect_if_needed();
+
+    // Discard all pending replies.
+    this->m_replies.clear();
+    this->m_reset_clear = false;
+
+    this->do_append_command(cmd);
+    this->do_get_reply();
+
+    const ::redisReply* reply = this->m_replies.front();
+    if(reply->type == REDIS_REPLY_ERROR) {
+      cow_string msg(reply->str, reply->len);
+      this->m_replies.clear();
+      POSEIDON_THROW(("Redis server replied with an error: $1"), msg);
+    }
+  }
+
+void
+Redis_Connection::
+execute_pipeline(const cow_vector<cow_vector<cow_string>>& cmds)
+  {
+    if(cmds.empty())
+      POSEIDON_THROW(("Empty Redis pipeline"));
+
+    for(const auto& cmd : cmds)
+      if(cmd.empty())
+        POSEIDON_THROW(("Empty Redis command"));
+
+    this->do_connect_if_needed();
+
+    // Discard all pending replies.
+    this->m_replies.clear();
+    this->m_reset_clear = false;
+
+    // Write all commands into the output buffer, which is flushed by the
+    // first call to `redisGetReply()`, then read all replies in order.
+    for(const auto& cmd : cmds)
+      this->do_append_command(cmd);
+
+    for(size_t k = 0;  k != cmds.size();  ++k)
+      this->do_get_reply();
   }
 
 bool
@@ -155,10 +218,12 @@ fetch_reply(cow_string& status, Redis_Value& value)
     status.clear();
     value.clear();
 
-    const auto unique_reply = move(this->m_reply);
-    if(!unique_reply)
+    if(this->m_replies.empty())
       return false;
 
+    const auto unique_reply = move(this->m_replies.front());
+    this->m_replies.pop_front();
+
     // Parse the reply and store the result into `value`.
     struct xFrame
       {
@@ -177,6 +242,11 @@ fetch_reply(cow_string& status, Redis_Value& value)
       return true;
     }
 
+    if(reply->type == REDIS_REPLY_ERROR)
+      POSEIDON_THROW((
+          "Redis server replied with an error: $1"),
+          cow_string(reply->str, reply->len));
+
   do_pack_loop_:
     switch(reply->type)
       {
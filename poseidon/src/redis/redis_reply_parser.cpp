@@ -0,0 +1,284 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../redis/redis_reply_parser.hpp"
+#include "../../utils.hpp"
+namespace poseidon {
+namespace {
+
+// This is the maximum length of a bulk string, as imposed by Redis.
+constexpr int64_t max_bulk_length = 512 * 1048576;
+
+bool
+do_get_line(chars_view& line, const char*& rptr, const char* eptr)
+  noexcept
+  {
+    // A line is terminated by CR LF, which is not part of it.
+    const char* lptr = rptr;
+    while((eptr - lptr >= 2) && ((lptr[0] != '\r') || (lptr[1] != '\n')))
+      lptr ++;
+
+    if(eptr - lptr < 2)
+      return false;
+
+    line = chars_view(rptr, static_cast<size_t>(lptr - rptr));
+    rptr = lptr + 2;
+    return true;
+  }
+
+bool
+do_parse_integer(int64_t& num, chars_view str)
+  noexcept
+  {
+    if(str.n == 0)
+      return false;
+
+    bool neg = (str.p[0] == '-');
+    size_t k = (neg || (str.p[0] == '+')) ? 1U : 0U;
+    if(k == str.n)
+      return false;
+
+    uint64_t val = 0;
+    while(k != str.n) {
+      uint32_t dval = static_cast<uint8_t>(str.p[k]) - static_cast<uint32_t>('0');
+      if(dval > 9)
+        return false;
+
+      if(val > (static_cast<uint64_t>(INT64_MAX) + neg - dval) / 10)
+        return false;
+
+      val = val * 10 + dval;
+      k ++;
+    }
+
+    num = neg ? static_cast<int64_t>(0 - val) : static_cast<int64_t>(val);
+    return true;
+  }
+
+}  // namespace
+
+Redis_Reply_Parser::
+Redis_Reply_Parser()
+  noexcept
+  {
+  }
+
+Redis_Reply_Parser::
+~Redis_Reply_Parser()
+  {
+  }
+
+bool
+Redis_Reply_Parser::
+parse_reply_from_stream(linear_buffer& data)
+  {
+    if(this->m_error)
+      return false;
+
+    if(!this->m_pval) {
+      // Start a new reply.
+      this->m_type = redis_reply_value;
+      this->m_status.clear();
+      this->m_value.clear();
+      this->m_stack.clear();
+      this->m_attrs.clear();
+      this->m_pval = &(this->m_value);
+    }
+
+    // Elements that have been parsed are removed from `data`, so they will not
+    // be parsed again when more data arrive. `bptr` points to the beginning of
+    // the current element, which may be incomplete.
+    const char* rptr = data.data();
+    const char* const eptr = data.data() + data.size();
+    const char* bptr;
+    chars_view line;
+    int64_t num;
+
+  do_parse_loop_:
+    bptr = rptr;
+    if(!do_get_line(line, rptr, eptr))
+      goto do_incomplete_;
+
+    if(line.n == 0)
+      goto do_error_;
+
+    switch(line.p[0])
+      {
+      case '+':
+        // simple string
+        if(this->m_stack.empty()) {
+          this->m_type = redis_reply_status;
+          this->m_status.append(line.p + 1, line.n - 1);
+        }
+        else
+          this->m_pval->open_string().append(line.p + 1, line.n - 1);
+        break;
+
+      case '-':
+        // simple error
+        if(this->m_stack.empty()) {
+          this->m_type = redis_reply_error;
+          this->m_status.append(line.p + 1, line.n - 1);
+        }
+        else
+          this->m_pval->open_string().append(line.p + 1, line.n - 1);
+        break;
+
+      case ':':
+        // integer
+        if(!do_parse_integer(num, chars_view(line.p + 1, line.n - 1)))
+          goto do_error_;
+
+        this->m_pval->open_integer() = num;
+        break;
+
+      case ',':
+      case '(':
+        // double or big number
+        this->m_pval->open_string().append(line.p + 1, line.n - 1);
+        break;
+
+      case '#':
+        // boolean
+        if((line.n != 2) || ((line.p[1] != 't') && (line.p[1] != 'f')))
+          goto do_error_;
+
+        this->m_pval->open_integer() = line.p[1] == 't';
+        break;
+
+      case '_':
+        // null
+        if(line.n != 1)
+          goto do_error_;
+
+        this->m_pval->clear();
+        break;
+
+      case '$':
+      case '=':
+      case '!':
+        {
+          // bulk string, verbatim string, or blob error
+          if(!do_parse_integer(num, chars_view(line.p + 1, line.n - 1)))
+            goto do_error_;
+
+          if((num == -1) && (line.p[0] == '$')) {
+            // RESP2 null
+            this->m_pval->clear();
+            break;
+          }
+
+          if((num < 0) || (num > max_bulk_length))
+            goto do_error_;
+
+          size_t len = static_cast<size_t>(num);
+          if(static_cast<size_t>(eptr - rptr) < len + 2)
+            goto do_incomplete_;
+
+          if((rptr[len] != '\r') || (rptr[len + 1] != '\n'))
+            goto do_error_;
+
+          chars_view str(rptr, len);
+          rptr += len + 2;
+
+          if(line.p[0] == '=') {
+            // Strip the format, such as `txt:`.
+            if((str.n < 4) || (str.p[3] != ':'))
+              goto do_error_;
+
+            str = chars_view(str.p + 4, str.n - 4);
+          }
+
+          if((line.p[0] == '!') && this->m_stack.empty()) {
+            this->m_type = redis_reply_error;
+            this->m_status.append(str.p, str.n);
+          }
+          else
+            this->m_pval->open_string().append(str.p, str.n);
+        }
+        break;
+
+      case '*':
+      case '~':
+      case '>':
+      case '%':
+      case '|':
+        {
+          // array, set, push, map, or attribute
+          if(!do_parse_integer(num, chars_view(line.p + 1, line.n - 1)))
+            goto do_error_;
+
+          if((num == -1) && (line.p[0] == '*')) {
+            // RESP2 null
+            this->m_pval->clear();
+            break;
+          }
+
+          if((num < 0) || (num > INT32_MAX))
+            goto do_error_;
+
+          size_t count = static_cast<size_t>(num);
+          if((line.p[0] == '%') || (line.p[0] == '|'))
+            count *= 2;
+
+          if((line.p[0] == '>') && this->m_stack.empty())
+            this->m_type = redis_reply_push;
+
+          auto& frm = this->m_stack.emplace_back();
+          frm.count = count;
+          frm.resume = nullptr;
+
+          if(line.p[0] == '|') {
+            frm.psa = &(this->m_attrs.emplace_back());
+            frm.resume = this->m_pval;
+          }
+          else
+            frm.psa = &(this->m_pval->open_array());
+
+          // Don't trust `count`, which may come from a compromised server.
+          frm.psa->reserve(static_cast<uint32_t>(::std::min<size_t>(count, 256)));
+        }
+        break;
+
+      default:
+        goto do_error_;
+      }
+
+    while(!this->m_stack.empty()) {
+      auto& frm = this->m_stack.back();
+      if(frm.psa->size() != frm.count) {
+        // next
+        this->m_pval = &(frm.psa->emplace_back());
+        goto do_parse_loop_;
+      }
+
+      // close
+      auto resume = frm.resume;
+      this->m_stack.pop_back();
+
+      if(resume) {
+        // The attribute is done, so parse the value which follows it.
+        this->m_pval = resume;
+        goto do_parse_loop_;
+      }
+    }
+
+    // The reply is complete.
+    data.discard(static_cast<size_t>(rptr - data.data()));
+    this->m_attrs.clear();
+    this->m_pval = nullptr;
+    return true;
+
+  do_incomplete_:
+    // Keep the partial reply in this parser, and wait for more data.
+    data.discard(static_cast<size_t>(bptr - data.data()));
+    return false;
+
+  do_error_:
+    POSEIDON_LOG_ERROR(("Invalid Redis reply: `$1`"), cow_string(line.p, ::std::min<size_t>(line.n, 64)));
+    this->m_error = true;
+    return false;
+  }
+
+}  // namespace poseidon
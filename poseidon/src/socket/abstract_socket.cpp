@@ -7,7 +7,18 @@
 #include <sys/socket.h>
 #include <netinet/tcp.h>
 #include <fcntl.h>
+#include <vector>
 namespace poseidon {
+namespace {
+
+// Each network thread keeps a few read buffers, which are lent to sockets
+// for the duration of an I/O event.
+constexpr size_t s_read_pool_size = 16;
+constexpr uint32_t s_min_read_size = 0x1000;
+constexpr uint32_t s_max_read_size = 0x100000;
+thread_local ::std::vector<linear_buffer> s_read_pool;
+
+}  // namespace
 
 Abstract_Socket::
 Abstract_Socket(unique_posix_fd&& fd)
@@ -81,6 +92,62 @@ do_abstract_socket_lock_write_queue(recursive_mutex::unique_lock& lock)
     return this->m_sched_write_queue;
   }
 
+chunk_queue&
+Abstract_Socket::
+do_abstract_socket_lock_write_chunks(recursive_mutex::unique_lock& lock)
+  noexcept
+  {
+    lock.lock(this->m_sched_mutex);
+    return this->m_sched_write_chunks;
+  }
+
+size_t
+Abstract_Socket::
+do_abstract_socket_reserve_read_queue(size_t last_nread)
+  {
+    // If the previous read has exhausted the size, more data are likely to
+    // follow, so read more at a time. If it was much smaller, read less.
+    uint32_t read_size = this->m_sched_read_size;
+    if(last_nread >= read_size)
+      read_size = min(read_size * 2, s_max_read_size);
+    else if((last_nread != 0) && (last_nread <= read_size / 4))
+      read_size = max(read_size / 2, s_min_read_size);
+    this->m_sched_read_size = read_size;
+
+    auto& queue = this->m_sched_read_queue;
+    if((queue.capacity_after_end() < read_size) && !s_read_pool.empty()) {
+      // Borrow a buffer from the pool, and move unconsumed data into it.
+      auto& buf = s_read_pool.back();
+      buf.putn(queue.data(), queue.size());
+      queue.swap(buf);
+      s_read_pool.pop_back();
+    }
+
+    queue.reserve_after_end(read_size);
+    return queue.capacity_after_end();
+  }
+
+void
+Abstract_Socket::
+do_abstract_socket_release_read_queue()
+  {
+    // If a large amount of data have not been consumed, copying them would be
+    // too expensive, so keep the buffer.
+    auto& queue = this->m_sched_read_queue;
+    if(queue.size() > s_min_read_size)
+      return;
+
+    // Keep unconsumed data in a buffer of their own size.
+    linear_buffer buf;
+    buf.putn(queue.data(), queue.size());
+    queue.swap(buf);
+
+    // Put the old buffer into the pool if it's worth it.
+    buf.clear();
+    if((buf.capacity_after_end() >= s_min_read_size) && (s_read_pool.size() < s_read_pool_size))
+      s_read_pool.emplace_back(move(buf));
+  }
+
 const IPv6_Address&
 Abstract_Socket::
 local_address()
@@ -143,6 +210,16 @@ remote_address()
     return this->m_peername;
   }
 
+pair<size_t, size_t>
+Abstract_Socket::
+pending_write_size()
+  const
+  {
+    recursive_mutex::unique_lock lock(this->m_sched_mutex);
+    return { this->m_sched_write_queue.size() + this->m_sched_write_chunks.size(),
+             this->m_sched_write_queue.capacity() + this->m_sched_write_chunks.memory_size() };
+  }
+
 bool
 Abstract_Socket::
 quick_shut_down()
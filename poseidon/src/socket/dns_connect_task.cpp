@@ -4,11 +4,344 @@
 #include "../xprecompiled.hpp"
 #include "../../socket/dns_connect_task.hpp"
 #include "../../socket/abstract_socket.hpp"
+#include "../../base/abstract_timer.hpp"
 #include "../../static/network_scheduler.hpp"
+#include "../../static/timer_scheduler.hpp"
+#include "../../static/dns_resolver.hpp"
 #include "../../utils.hpp"
+#include <vector>
 #include <sys/socket.h>
-#include <netdb.h>
+#include <sys/epoll.h>
+#include <netinet/tcp.h>
 namespace poseidon {
+namespace {
+
+void
+do_make_sockaddr(::sockaddr_in6& sa, const IPv6_Address& addr, uint16_t port)
+  {
+    sa = { };
+    sa.sin6_family = AF_INET6;
+    sa.sin6_addr = addr.addr();
+    sa.sin6_port = ::htons(port);
+  }
+
+void
+do_insert_or_close(Network_Scheduler& scheduler, const shptr<Abstract_Socket>& socket,
+                   bool success)
+  {
+    // If no connection can be initiated, the socket is shut down. It's still
+    // inserted, so a closure notification shall be delivered.
+    if(!success)
+      socket->quick_shut_down();
+
+    try {
+      scheduler.insert_weak(socket);
+    }
+    catch(exception& stdex) {
+      POSEIDON_LOG_ERROR(("Could not insert socket: $1"), stdex);
+      socket->quick_shut_down();
+    }
+  }
+
+unique_posix_fd
+do_create_epoll()
+  {
+    unique_posix_fd fd(::epoll_create1(EPOLL_CLOEXEC));
+    if(!fd)
+      POSEIDON_THROW((
+          "Could not allocate epoll object",
+          "[`epoll_create1()` failed: ${errno:full}]"));
+    return fd;
+  }
+
+cow_vector<IPv6_Address>
+do_interleave_addresses(const cow_vector<IPv6_Address>& addrs)
+  {
+    // Alternate between IPv6 and IPv4, starting with the family of the first
+    // address, which is IPv6 if available (RFC 8305, section 4).
+    cow_vector<IPv6_Address> first, second, res;
+    for(const auto& addr : addrs)
+      if(addr.is_v4mapped() == addrs.front().is_v4mapped())
+        first.push_back(addr);
+      else
+        second.push_back(addr);
+
+    for(size_t k = 0;  (k < first.size()) || (k < second.size());  ++k) {
+      if(k < first.size())
+        res.push_back(first[k]);
+      if(k < second.size())
+        res.push_back(second[k]);
+    }
+    return res;
+  }
+
+struct Attempt
+  {
+    unique_posix_fd fd;  // null for the socket of the caller
+    int raw_fd = -1;
+    IPv6_Address addr;
+    bool pending = false;
+  };
+
+// This races connections to addresses of a host. Attempts are started one
+// after another with a delay, and the first connection that is established
+// wins. Each attempt except the first one has its own socket, and the winner
+// replaces the socket of the caller with `dup2()`, which preserves its file
+// descriptor. Attempts are polled with an epoll object of their own, which is
+// itself polled by the network scheduler.
+struct Connect_Race final : Abstract_Socket, Abstract_Timer
+  {
+    Network_Scheduler* m_scheduler;
+    wkptr<Abstract_Socket> m_wsock;
+    cow_string m_host;
+    uint16_t m_port;
+    cow_vector<IPv6_Address> m_addrs;
+    milliseconds m_delay;
+
+    plain_mutex m_mutex;
+    shptr<Connect_Race> m_self;  // kept alive until finished
+    ::std::vector<Attempt> m_attempts;
+    size_t m_next_addr = 0;
+    uint32_t m_pending = 0;
+    steady_time m_last_start;
+    bool m_finished = false;
+
+    Connect_Race(Network_Scheduler& scheduler, const shptr<Abstract_Socket>& socket,
+                 const cow_string& host, uint16_t port, const cow_vector<IPv6_Address>& addrs,
+                 milliseconds delay)
+      :
+        Abstract_Socket(do_create_epoll()),
+        m_scheduler(&scheduler), m_wsock(socket), m_host(host), m_port(port),
+        m_addrs(do_interleave_addresses(addrs)), m_delay(delay)
+      { }
+
+    bool
+    do_start_next_attempt_nolock(Abstract_Socket& socket, steady_time now)
+      {
+        while(this->m_next_addr < this->m_addrs.size()) {
+          auto& at = this->m_attempts.emplace_back();
+          at.addr = this->m_addrs[this->m_next_addr];
+          this->m_next_addr ++;
+
+          if(this->m_attempts.size() == 1)
+            at.raw_fd = socket.fd();
+          else {
+            // Create a socket like `TCP_Socket`. Errors are ignored.
+            static constexpr int one = 1;
+            at.fd.reset(::socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK, IPPROTO_TCP));
+            if(!at.fd) {
+              POSEIDON_LOG_WARN(("Could not create IPv6 socket: ${errno:full}"));
+              continue;
+            }
+
+            ::setsockopt(at.fd, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one));
+            at.raw_fd = at.fd;
+          }
+
+          ::sockaddr_in6 sa;
+          do_make_sockaddr(sa, at.addr, this->m_port);
+          if((::connect(at.raw_fd, reinterpret_cast<const ::sockaddr*>(&sa), sizeof(sa)) != 0)
+             && (errno != EINPROGRESS)) {
+            POSEIDON_LOG_DEBUG(("Could not connect to `$1`: ${errno:full}"), IPv6_Address(at.addr, this->m_port));
+            continue;
+          }
+
+          ::epoll_event pev = { };
+          pev.events = EPOLLOUT;
+          pev.data.u64 = this->m_attempts.size() - 1;
+          if(::epoll_ctl(this->do_socket_fd(), EPOLL_CTL_ADD, at.raw_fd, &pev) != 0) {
+            POSEIDON_LOG_WARN(("Could not poll socket: ${errno:full}"));
+            continue;
+          }
+
+          POSEIDON_LOG_DEBUG(("Connecting to `$1` for `$2`"), IPv6_Address(at.addr, this->m_port), this->m_host);
+          at.pending = true;
+          this->m_pending ++;
+          this->m_last_start = now;
+          return true;
+        }
+        return false;
+      }
+
+    bool
+    do_finish_nolock(Abstract_Socket* socket, size_t winner, shptr<Connect_Race>& self)
+      {
+        this->m_finished = true;
+        this->abandon();
+        self.swap(this->m_self);
+
+        for(auto& at : this->m_attempts)
+          if(at.pending)
+            ::epoll_ctl(this->do_socket_fd(), EPOLL_CTL_DEL, at.raw_fd, nullptr);
+
+        bool success = socket && (winner < this->m_attempts.size());
+        if(success && this->m_attempts[winner].fd) {
+          // Replace the socket of the caller with the connected one. The old
+          // one is closed by the system.
+          if(::dup2(this->m_attempts[winner].raw_fd, socket->fd()) < 0) {
+            POSEIDON_LOG_ERROR(("Could not replace socket: ${errno:full}"));
+            success = false;
+          }
+        }
+
+        this->m_attempts.clear();
+        return success;
+      }
+
+    void
+    do_check_attempts(bool timed)
+      {
+        shptr<Connect_Race> self;
+        plain_mutex::unique_lock lock(this->m_mutex);
+        if(this->m_finished)
+          return;
+
+        auto socket = this->m_wsock.lock();
+        if(!socket) {
+          // The caller has abandoned the socket.
+          this->do_finish_nolock(nullptr, SIZE_MAX, self);
+          return;
+        }
+
+        const steady_time now = steady_clock::now();
+        size_t winner = SIZE_MAX;
+
+        ::epoll_event events[16];
+        int nevents;
+        while((winner == SIZE_MAX) && !timed
+              && ((nevents = ::epoll_wait(this->do_socket_fd(), events, 16, 0)) > 0))
+          for(int k = 0;  k != nevents;  ++k) {
+            size_t index = static_cast<size_t>(events[k].data.u64);
+            auto& at = this->m_attempts.at(index);
+            if(!at.pending)
+              continue;
+
+            // Check whether the connection has been established.
+            int err = 0;
+            ::socklen_t optlen = sizeof(err);
+            ::getsockopt(at.raw_fd, SOL_SOCKET, SO_ERROR, &err, &optlen);
+            if((err == 0) && !(events[k].events & (EPOLLERR | EPOLLHUP))) {
+              winner = index;
+              break;
+            }
+
+            errno = err;
+            POSEIDON_LOG_DEBUG((
+                "Could not connect to `$1`: ${errno:full}"),
+                IPv6_Address(at.addr, this->m_port));
+
+            ::epoll_ctl(this->do_socket_fd(), EPOLL_CTL_DEL, at.raw_fd, nullptr);
+            at.pending = false;
+            at.fd.reset();
+            this->m_pending --;
+
+            // Try the next address immediately.
+            this->do_start_next_attempt_nolock(*socket, now);
+          }
+
+        // Start another attempt if the last one is taking too long.
+        if((winner == SIZE_MAX) && timed && (now - this->m_last_start >= this->m_delay))
+          this->do_start_next_attempt_nolock(*socket, now);
+
+        if((winner == SIZE_MAX) && (this->m_pending != 0))
+          return;
+
+        if(winner == SIZE_MAX)
+          POSEIDON_LOG_WARN(("Could not connect to any address of `$1`"), this->m_host);
+
+        bool success = this->do_finish_nolock(socket.get(), winner, self);
+        lock.unlock();
+
+        do_insert_or_close(*(this->m_scheduler), socket, success);
+      }
+
+    virtual
+    void
+    do_abstract_socket_on_readable()
+      override
+      { this->do_check_attempts(false);  }
+
+    virtual
+    void
+    do_abstract_socket_on_writeable()
+      override
+      { }
+
+    virtual
+    void
+    do_abstract_socket_on_closed()
+      override
+      { }
+
+    virtual
+    void
+    do_abstract_timer_on_tick(steady_time /*now*/)
+      override
+      { this->do_check_attempts(true);  }
+  };
+
+void
+do_connect(Network_Scheduler& scheduler, const wkptr<Abstract_Socket>& wsock,
+           const cow_string& host, uint16_t port, const cow_vector<IPv6_Address>& addrs,
+           const char* error)
+  {
+    auto socket = wsock.lock();
+    if(!socket)
+      return;
+
+    bool success = false;
+
+    try {
+      if(error)
+        POSEIDON_THROW(("Could not resolve host `$1`: $2"), host, error);
+
+      if(addrs.empty())
+        POSEIDON_THROW(("No address found for host `$1`"), host);
+
+      // Only stream sockets can be raced.
+      int type = 0;
+      ::socklen_t optlen = sizeof(type);
+      ::getsockopt(socket->fd(), SOL_SOCKET, SO_TYPE, &type, &optlen);
+
+      if((addrs.size() == 1) || (type != SOCK_STREAM)) {
+        ::sockaddr_in6 sa;
+        do_make_sockaddr(sa, addrs.front(), port);
+        success = (::connect(socket->fd(), reinterpret_cast<const ::sockaddr*>(&sa), sizeof(sa)) == 0)
+                  || (errno == EINPROGRESS);
+        if(!success)
+          POSEIDON_LOG_WARN(("Could not connect to `$1`: ${errno:full}"), IPv6_Address(addrs.front(), port));
+
+        do_insert_or_close(scheduler, socket, success);
+        return;
+      }
+
+      // Start the first attempt now. The socket of the caller will be inserted
+      // after the race.
+      milliseconds delay = dns_resolver.connection_attempt_delay();
+      auto race = new_sh<Connect_Race>(scheduler, socket, host, port, addrs, delay);
+      plain_mutex::unique_lock lock(race->m_mutex);
+      success = race->do_start_next_attempt_nolock(*socket, steady_clock::now());
+      if(!success)
+        POSEIDON_LOG_WARN(("Could not connect to any address of `$1`"), host);
+      else
+        race->m_self = race;
+      lock.unlock();
+
+      if(success) {
+        scheduler.insert_weak(race);
+        timer_scheduler.insert_weak(race, delay / 5 + 1ms, delay / 5 + 1ms);
+        return;
+      }
+    }
+    catch(exception& stdex) {
+      POSEIDON_LOG_ERROR(("DNS lookup error: $1"), stdex);
+      success = false;
+    }
+
+    do_insert_or_close(scheduler, socket, success);
+  }
+
+}  // namespace
 
 DNS_Connect_Task::
 DNS_Connect_Task(Network_Scheduler& scheduler, const shptr<Abstract_Socket>& socket,
@@ -32,73 +365,21 @@ void
 DNS_Connect_Task::
 do_on_abstract_task_execute()
   {
-    shptr<Abstract_Socket> socket;
-    bool success = false;
+    // The callback may outlive this task, so copy everything it needs.
+    auto scheduler = this->m_scheduler;
+    auto wsock = this->m_wsock;
+    auto host = this->m_host;
+    auto port = this->m_port;
 
     try {
-      // Perform DNS query. This will block the worker thread.
-      ::addrinfo* res = nullptr;
-      ::asteria::unique_ptr<::addrinfo, vfn<::addrinfo*>> guard(res, ::freeaddrinfo);
-
-      ::addrinfo hints = { };
-      hints.ai_flags = AI_V4MAPPED | AI_ADDRCONFIG | AI_NUMERICSERV;
-      int err = ::getaddrinfo(this->m_host.safe_c_str(), nullptr, &hints, &res);
-      if(err == 0)
-        guard.reset(res);
-      else
-        POSEIDON_THROW((
-            "Could not resolve host `$1`",
-            "[`getaddrinfo()` failed: $2]"),
-            this->m_host, ::gai_strerror(err));
-
-      socket = this->m_wsock.lock();
-      if(!socket)
-        return;
-
-      for(res = guard;  !success && res;  res = res->ai_next)
-        if(res->ai_family == AF_INET) {
-          // IPv4
-          auto sa = reinterpret_cast<::sockaddr_in*>(res->ai_addr);
-          ::sockaddr_in6 v6addr = { };
-          v6addr.sin6_family = AF_INET6;
-          ::memcpy(v6addr.sin6_addr.s6_addr, ipv4_unspecified.data(), 12);
-          ::memcpy(v6addr.sin6_addr.s6_addr + 12, &(sa->sin_addr), 4);
-          v6addr.sin6_port = ::htons(this->m_port);
-          success = (::connect(socket->fd(),
-                               reinterpret_cast<const ::sockaddr*>(&v6addr),
-                               sizeof(::sockaddr_in6)) == 0)
-                    || (errno == EINPROGRESS);
-        }
-        else if(res->ai_family == AF_INET6) {
-          // IPv6
-          auto sa = reinterpret_cast<::sockaddr_in6*>(res->ai_addr);
-          sa->sin6_port = ::htons(this->m_port);
-          success = (::connect(socket->fd(),
-                               reinterpret_cast<const ::sockaddr*>(sa),
-                               sizeof(::sockaddr_in6)) == 0)
-                    || (errno == EINPROGRESS);
-        }
-
-      // Insert the socket, only after `connect()` has been called. Even in
-      // the case of a failure, a closure notification shall be delivered.
-      if(success)
-        this->m_scheduler->insert_weak(socket);
-      else
-        POSEIDON_LOG_WARN(("DNS lookup failed for `$1`"), this->m_host);
+      dns_resolver.resolve(this->m_host,
+          [=](const cow_vector<IPv6_Address>& addrs, const char* error)
+            { do_connect(*scheduler, wsock, host, port, addrs, error);  });
     }
     catch(exception& stdex) {
       POSEIDON_LOG_ERROR(("DNS lookup error: $1"), stdex);
-      success = false;
+      do_connect(*scheduler, wsock, host, port, { }, "resolver error");
     }
-
-    if(!socket) {
-      socket = this->m_wsock.lock();
-      if(!socket)
-        return;
-    }
-
-    if(!success)
-      socket->quick_shut_down();
   }
 
 }  // namespace poseidon
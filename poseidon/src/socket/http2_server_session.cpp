@@ -0,0 +1,1027 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../socket/http2_server_session.hpp"
+#include "../../static/main_config.hpp"
+#include "../../base/config_file.hpp"
+#include "../../utils.hpp"
+#include <unordered_map>
+namespace poseidon {
+namespace {
+
+// These are from RFC 9113, 6. Frame Definitions.
+enum : uint8_t
+  {
+    frame_DATA           = 0x00,
+    frame_HEADERS        = 0x01,
+    frame_PRIORITY       = 0x02,
+    frame_RST_STREAM     = 0x03,
+    frame_SETTINGS       = 0x04,
+    frame_PUSH_PROMISE   = 0x05,
+    frame_PING           = 0x06,
+    frame_GOAWAY         = 0x07,
+    frame_WINDOW_UPDATE  = 0x08,
+    frame_CONTINUATION   = 0x09,
+  };
+
+enum : uint8_t
+  {
+    flag_END_STREAM   = 0x01,
+    flag_ACK          = 0x01,
+    flag_END_HEADERS  = 0x04,
+    flag_PADDED       = 0x08,
+    flag_PRIORITY     = 0x20,
+  };
+
+enum : uint16_t
+  {
+    setting_HEADER_TABLE_SIZE       = 0x01,
+    setting_ENABLE_PUSH             = 0x02,
+    setting_MAX_CONCURRENT_STREAMS  = 0x03,
+    setting_INITIAL_WINDOW_SIZE     = 0x04,
+    setting_MAX_FRAME_SIZE          = 0x05,
+    setting_MAX_HEADER_LIST_SIZE    = 0x06,
+  };
+
+constexpr char s_client_preface[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+constexpr size_t s_client_preface_size = sizeof(s_client_preface) - 1;
+constexpr uint32_t s_default_max_frame_size = 16384;
+constexpr uint32_t s_window_update_threshold = 32768;
+constexpr int64_t s_max_window_size = 0x7FFFFFFF;
+
+struct Stream
+  {
+    HTTP_C_Headers req;
+    linear_buffer payload;
+    linear_buffer pending;
+    int64_t send_window = 0;
+    uint32_t recv_unacked = 0;
+    bool remote_closed = false;
+    bool bad_request = false;
+    bool headers_sent = false;
+    bool end_requested = false;
+    bool local_closed = false;
+  };
+
+struct Stream_Table
+  {
+    ::std::unordered_map<uint32_t, Stream> map;
+  };
+
+bool
+do_is_connection_specific_header(const cow_string& name)
+  {
+    return (name == "connection") || (name == "keep-alive") || (name == "proxy-connection")
+           || (name == "transfer-encoding") || (name == "upgrade");
+  }
+
+}  // namespace
+
+POSEIDON_HIDDEN_X_STRUCT(HTTP2_Server_Session,
+  Stream_Table);
+
+HTTP2_Server_Session::
+HTTP2_Server_Session()
+  {
+    auto conf_file = main_config.copy();
+    this->m_max_header_length = static_cast<uint32_t>(conf_file.get_integer_opt(
+                           &"network.http.max_header_length", 256, 16777216).value_or(262144));
+    this->m_max_content_length = static_cast<uint32_t>(conf_file.get_integer_opt(
+                 &"network.http.max_request_content_length", 256, 16777216).value_or(1048576));
+    this->m_max_concurrent_streams = static_cast<uint32_t>(conf_file.get_integer_opt(
+                     &"network.http.http2_max_concurrent_streams", 1, 65535).value_or(100));
+
+    this->m_streams = new_uni<X_Stream_Table>();
+
+    cow_vector<cow_string> protos;
+    protos.emplace_back(::asteria::sref("h2"));
+    this->do_ssl_set_alpn_protocols(protos);
+  }
+
+HTTP2_Server_Session::
+~HTTP2_Server_Session()
+  {
+  }
+
+bool
+HTTP2_Server_Session::
+do_http2_send_frame(uint8_t type, uint8_t flags, uint32_t stream_id, chars_view payload)
+  {
+    ROCKET_ASSERT(payload.n <= 0xFFFFFF);
+
+    char header[9];
+    ::asteria::store_be<uint32_t>(header, static_cast<uint32_t>(payload.n << 8 | type));
+    header[4] = static_cast<char>(flags);
+    ::asteria::store_be<uint32_t>(header + 5, stream_id & 0x7FFFFFFFU);
+
+    // The caller holds the I/O lock, so these will not be interleaved with
+    // other frames.
+    return this->ssl_send(chars_view(header, 9)) && ((payload.n == 0) || this->ssl_send(payload));
+  }
+
+bool
+HTTP2_Server_Session::
+do_http2_send_headers(uint32_t stream_id, const HTTP_S_Headers& resp, bool end_stream)
+  {
+    tinyfmt_ln fmt;
+    this->m_hpack_enc.encode_response(fmt, resp);
+    chars_view block = fmt;
+
+    // The header block is split into a HEADERS frame, followed by zero or more
+    // CONTINUATION frames. Each of them shall not exceed the maximum frame size
+    // of the client.
+    uint8_t type = frame_HEADERS;
+    uint8_t flags = end_stream ? flag_END_STREAM : 0;
+    for(;;) {
+      size_t n = ::std::min<size_t>(block.n, this->m_peer_max_frame_size);
+      if(n == block.n)
+        flags |= flag_END_HEADERS;
+
+      if(!this->do_http2_send_frame(type, flags, stream_id, chars_view(block.p, n)))
+        return false;
+
+      if(n == block.n)
+        return true;
+
+      block.p += n;
+      block.n -= n;
+      type = frame_CONTINUATION;
+      flags = 0;
+    }
+  }
+
+bool
+HTTP2_Server_Session::
+do_http2_send_data(uint32_t stream_id, chars_view data, bool end_stream)
+  {
+    auto it = this->m_streams->map.find(stream_id);
+    if(it == this->m_streams->map.end())
+      return false;
+
+    if(!it->second.headers_sent)
+      POSEIDON_THROW((
+          "Response headers not sent yet: stream_id `$3`",
+          "[HTTP/2 server session `$1` (class `$2`)]"),
+          this, typeid(*this), stream_id);
+
+    if(it->second.end_requested)
+      POSEIDON_THROW((
+          "Response already finished: stream_id `$3`",
+          "[HTTP/2 server session `$1` (class `$2`)]"),
+          this, typeid(*this), stream_id);
+
+    it->second.pending.putn(data.p, data.n);
+    it->second.end_requested = end_stream;
+    return this->do_http2_flush_stream(stream_id);
+  }
+
+bool
+HTTP2_Server_Session::
+do_http2_flush_stream(uint32_t stream_id)
+  {
+    auto it = this->m_streams->map.find(stream_id);
+    if(it == this->m_streams->map.end())
+      return false;
+
+    auto& stream = it->second;
+    while(!stream.pending.empty()) {
+      // Send as many bytes as flow control permits. If either window is
+      // exhausted, remaining data will be sent upon the next WINDOW_UPDATE.
+      int64_t n = ::std::min({ this->m_send_window, stream.send_window,
+                               static_cast<int64_t>(this->m_peer_max_frame_size),
+                               static_cast<int64_t>(stream.pending.size()) });
+      if(n <= 0)
+        return true;
+
+      bool fin = stream.end_requested && (n == static_cast<int64_t>(stream.pending.size()));
+      if(!this->do_http2_send_frame(frame_DATA, fin ? flag_END_STREAM : 0, stream_id,
+                                    chars_view(stream.pending.begin(), static_cast<size_t>(n))))
+        return false;
+
+      stream.pending.discard(static_cast<size_t>(n));
+      stream.send_window -= n;
+      this->m_send_window -= n;
+      stream.local_closed = fin;
+    }
+
+    if(stream.end_requested && !stream.local_closed) {
+      // All data have been sent, so mark the end with an empty frame.
+      if(!this->do_http2_send_frame(frame_DATA, flag_END_STREAM, stream_id, ""))
+        return false;
+
+      stream.local_closed = true;
+    }
+
+    if(!stream.local_closed)
+      return true;
+
+    // If the client has not finished its request, tell it to stop sending.
+    // See RFC 9113, 8.1. HTTP Message Framing.
+    if(!stream.remote_closed)
+      this->do_http2_reset_stream(stream_id, http2_no_error);
+    else
+      this->m_streams->map.erase(it);
+    return true;
+  }
+
+void
+HTTP2_Server_Session::
+do_http2_flush_all_streams()
+  {
+    // `do_http2_flush_stream()` may erase the stream being flushed, but no
+    // others.
+    auto it = this->m_streams->map.begin();
+    while(it != this->m_streams->map.end()) {
+      uint32_t stream_id = it->first;
+      ++ it;
+      this->do_http2_flush_stream(stream_id);
+    }
+  }
+
+void
+HTTP2_Server_Session::
+do_http2_reset_stream(uint32_t stream_id, HTTP2_Error error)
+  {
+    char payload[4];
+    ::asteria::store_be<uint32_t>(payload, error);
+    this->do_http2_send_frame(frame_RST_STREAM, 0, stream_id, chars_view(payload, 4));
+    this->m_streams->map.erase(stream_id);
+  }
+
+void
+HTTP2_Server_Session::
+do_http2_connection_error(HTTP2_Error error, const char* desc)
+  {
+    POSEIDON_LOG_ERROR((
+        "HTTP/2 connection error: $3 ($4)",
+        "[HTTP/2 server session `$1` (class `$2`)]"),
+        this, typeid(*this), desc, static_cast<uint32_t>(error));
+
+    this->http2_shut_down(error);
+  }
+
+void
+HTTP2_Server_Session::
+do_http2_process_header_block(uint32_t stream_id, bool end_stream)
+  {
+    // The dynamic table is shared by all streams, so all header blocks must be
+    // decoded, even if they are about to be discarded.
+    cow_bivector<cow_string, cow_string> fields;
+    try {
+      this->m_hpack_dec.decode(fields, this->m_cont_block);
+    }
+    catch(exception& stdex) {
+      POSEIDON_LOG_DEBUG(("HPACK decoding error: $1"), stdex);
+      this->do_http2_connection_error(http2_compression_error, "invalid header block");
+      return;
+    }
+
+    this->m_cont_block.clear();
+    this->m_cont_stream_id = 0;
+
+    auto it = this->m_streams->map.find(stream_id);
+    if(it != this->m_streams->map.end()) {
+      // These are trailers, which must end the stream. Trailers are not
+      // passed to user code.
+      if(it->second.remote_closed)
+        this->do_http2_reset_stream(stream_id, http2_stream_closed);
+      else if(!end_stream)
+        this->do_http2_reset_stream(stream_id, http2_protocol_error);
+      else
+        this->do_http2_end_of_request(stream_id);
+      return;
+    }
+
+    if(stream_id <= this->m_last_stream_id) {
+      // Streams that have been closed can't be reopened.
+      this->do_http2_connection_error(http2_stream_closed, "HEADERS on closed stream");
+      return;
+    }
+
+    this->m_last_stream_id = stream_id;
+
+    // Don't accept new streams if the connection is going away.
+    if(this->m_goaway_sent)
+      return;
+
+    if(this->m_streams->map.size() >= this->m_max_concurrent_streams) {
+      this->do_http2_reset_stream(stream_id, http2_refused_stream);
+      return;
+    }
+
+    auto& stream = this->m_streams->map[stream_id];
+    stream.send_window = this->m_peer_initial_window_size;
+    stream.remote_closed = end_stream;
+
+    // Translate pseudo-header fields. See RFC 9113, 8.3.1. Request
+    // Pseudo-Header Fields.
+    HTTP_C_Headers req;
+    req.is_ssl = true;
+    bool bad_request = false;
+    bool method_seen = false, scheme_seen = false, regular_seen = false;
+    cow_string path;
+
+    for(const auto& field : fields) {
+      const auto& name = field.first;
+      const auto& value = field.second;
+
+      if(name.empty() || ::std::any_of(name.begin(), name.end(),
+                                        [](char c) { return (c >= 'A') && (c <= 'Z');  }))
+        bad_request = true;
+      else if(name[0] != ':') {
+        regular_seen = true;
+        if(do_is_connection_specific_header(name) || ((name == "te") && (value != "trailers")))
+          bad_request = true;
+        else
+          req.headers.emplace_back(name, value);
+      }
+      else if(regular_seen)
+        bad_request = true;
+      else if(name == ":method") {
+        if(method_seen || value.empty()
+           || !::memccpy(req.method_str, value.c_str(), 0, sizeof(req.method_str)))
+          bad_request = true;
+        method_seen = true;
+      }
+      else if(name == ":scheme") {
+        if(scheme_seen)
+          bad_request = true;
+        scheme_seen = true;
+      }
+      else if(name == ":authority")
+        req.raw_host = value;
+      else if(name == ":path") {
+        if(!path.empty() || value.empty())
+          bad_request = true;
+        path = value;
+      }
+      else
+        bad_request = true;
+    }
+
+    // If `:authority` is absent, `Host:` is used instead.
+    if(req.raw_host.empty())
+      for(const auto& hr : req.headers)
+        if(hr.first == "Host") {
+          req.raw_host = hr.second.as_string();
+          break;
+        }
+
+    // `CONNECT` requests don't have paths, and are not supported.
+    if(!method_seen || !scheme_seen || req.raw_host.empty() || path.empty())
+      bad_request = true;
+
+    if(!bad_request) {
+      // Split the path and query string. Only the origin form is allowed.
+      Network_Reference ref;
+      if(parse_request_target(ref, path) != path.size())
+        bad_request = true;
+      else {
+        if(ref.path.n != 0)
+          req.raw_path.assign(ref.path.p, ref.path.n);
+        else
+          req.raw_path = &"/";
+
+        if(ref.query.n != 0)
+          req.raw_query.assign(ref.query.p, ref.query.n);
+      }
+    }
+
+    if(bad_request) {
+      stream.bad_request = true;
+      this->do_on_http2_request_error(stream_id, http_status_bad_request);
+      return;
+    }
+
+    // `stream` may be invalidated if the callback sends a response, so the
+    // request is stored afterwards.
+    this->do_on_http2_request_headers(stream_id, req, end_stream);
+
+    it = this->m_streams->map.find(stream_id);
+    if(it == this->m_streams->map.end())
+      return;
+
+    it->second.req = move(req);
+    if(end_stream)
+      this->do_http2_end_of_request(stream_id);
+  }
+
+void
+HTTP2_Server_Session::
+do_http2_end_of_request(uint32_t stream_id)
+  {
+    auto it = this->m_streams->map.find(stream_id);
+    if(it == this->m_streams->map.end())
+      return;
+
+    it->second.remote_closed = true;
+
+    if(it->second.bad_request || it->second.local_closed) {
+      // A response has been sent, so there is nothing to do.
+      if(it->second.local_closed)
+        this->m_streams->map.erase(it);
+      return;
+    }
+
+    HTTP_C_Headers req = move(it->second.req);
+    linear_buffer payload = move(it->second.payload);
+    this->do_on_http2_request_finish(stream_id, move(req), move(payload));
+  }
+
+void
+HTTP2_Server_Session::
+do_http2_process_frame(uint8_t type, uint8_t flags, uint32_t stream_id, chars_view payload)
+  {
+    if(this->m_cont_stream_id != 0) {
+      // A header block must not be interleaved with other frames.
+      if((type != frame_CONTINUATION) || (stream_id != this->m_cont_stream_id)) {
+        this->do_http2_connection_error(http2_protocol_error, "incomplete header block");
+        return;
+      }
+    }
+
+    switch(type)
+      {
+      case frame_DATA:
+        {
+          if(stream_id == 0) {
+            this->do_http2_connection_error(http2_protocol_error, "DATA on stream 0");
+            return;
+          }
+
+          // Flow control applies to the entire payload, including padding.
+          uint32_t frame_length = static_cast<uint32_t>(payload.n);
+          if(flags & flag_PADDED) {
+            if((payload.n == 0) || (static_cast<uint8_t>(payload.p[0]) >= payload.n)) {
+              this->do_http2_connection_error(http2_protocol_error, "invalid padding");
+              return;
+            }
+
+            payload.n -= 1U + static_cast<uint8_t>(payload.p[0]);
+            payload.p ++;
+          }
+
+          this->m_recv_unacked += frame_length;
+          if(this->m_recv_unacked >= s_window_update_threshold) {
+            char incr[4];
+            ::asteria::store_be<uint32_t>(incr, this->m_recv_unacked);
+            this->do_http2_send_frame(frame_WINDOW_UPDATE, 0, 0, chars_view(incr, 4));
+            this->m_recv_unacked = 0;
+          }
+
+          auto it = this->m_streams->map.find(stream_id);
+          if(it == this->m_streams->map.end()) {
+            // The stream may have been reset by us, in which case this frame
+            // is ignored.
+            if(stream_id > this->m_last_stream_id)
+              this->do_http2_connection_error(http2_protocol_error, "DATA on idle stream");
+            return;
+          }
+
+          if(it->second.remote_closed) {
+            this->do_http2_reset_stream(stream_id, http2_stream_closed);
+            return;
+          }
+
+          bool end_stream = flags & flag_END_STREAM;
+          it->second.recv_unacked += frame_length;
+          if(!end_stream && (it->second.recv_unacked >= s_window_update_threshold)) {
+            char incr[4];
+            ::asteria::store_be<uint32_t>(incr, it->second.recv_unacked);
+            this->do_http2_send_frame(frame_WINDOW_UPDATE, 0, stream_id, chars_view(incr, 4));
+            it->second.recv_unacked = 0;
+          }
+
+          if(!it->second.bad_request && (payload.n != 0)) {
+            // `it` may be invalidated if the callback sends a response, so the
+            // payload is moved out and stored afterwards.
+            linear_buffer data = move(it->second.payload);
+            data.putn(payload.p, payload.n);
+            HTTP_Status status = http_status_bad_request;
+            try {
+              this->do_on_http2_request_payload_stream(stream_id, data);
+              status = http_status_ok;
+            }
+            catch(exception& stdex) {
+              POSEIDON_LOG_DEBUG((
+                  "Rejecting HTTP/2 request payload: $3",
+                  "[HTTP/2 server session `$1` (class `$2`)]"),
+                  this, typeid(*this), stdex);
+
+              if(data.size() > this->m_max_content_length)
+                status = http_status_payload_too_large;
+            }
+
+            it = this->m_streams->map.find(stream_id);
+            if(it == this->m_streams->map.end())
+              return;
+
+            if(status != http_status_ok) {
+              it->second.bad_request = true;
+              this->do_on_http2_request_error(stream_id, status);
+            }
+            else
+              it->second.payload = move(data);
+          }
+
+          if(end_stream)
+            this->do_http2_end_of_request(stream_id);
+        }
+        return;
+
+      case frame_HEADERS:
+        {
+          if((stream_id == 0) || (stream_id % 2 == 0)) {
+            this->do_http2_connection_error(http2_protocol_error, "HEADERS on invalid stream");
+            return;
+          }
+
+          if(flags & flag_PADDED) {
+            if((payload.n == 0) || (static_cast<uint8_t>(payload.p[0]) >= payload.n)) {
+              this->do_http2_connection_error(http2_protocol_error, "invalid padding");
+              return;
+            }
+
+            payload.n -= 1U + static_cast<uint8_t>(payload.p[0]);
+            payload.p ++;
+          }
+
+          // Priority information is deprecated and ignored.
+          if(flags & flag_PRIORITY) {
+            if(payload.n < 5) {
+              this->do_http2_connection_error(http2_frame_size_error, "HEADERS too short");
+              return;
+            }
+
+            payload.n -= 5;
+            payload.p += 5;
+          }
+
+          if(payload.n > this->m_max_header_length) {
+            this->do_http2_connection_error(http2_enhance_your_calm, "header block too large");
+            return;
+          }
+
+          this->m_cont_block.clear();
+          this->m_cont_block.putn(payload.p, payload.n);
+          this->m_cont_stream_id = stream_id;
+          this->m_cont_flags = flags;
+
+          if(flags & flag_END_HEADERS)
+            this->do_http2_process_header_block(stream_id, flags & flag_END_STREAM);
+        }
+        return;
+
+      case frame_CONTINUATION:
+        {
+          if(this->m_cont_stream_id == 0) {
+            this->do_http2_connection_error(http2_protocol_error, "unexpected CONTINUATION");
+            return;
+          }
+
+          if(this->m_cont_block.size() + payload.n > this->m_max_header_length) {
+            this->do_http2_connection_error(http2_enhance_your_calm, "header block too large");
+            return;
+          }
+
+          this->m_cont_block.putn(payload.p, payload.n);
+
+          if(flags & flag_END_HEADERS)
+            this->do_http2_process_header_block(stream_id, this->m_cont_flags & flag_END_STREAM);
+        }
+        return;
+
+      case frame_PRIORITY:
+        {
+          if(stream_id == 0) {
+            this->do_http2_connection_error(http2_protocol_error, "PRIORITY on stream 0");
+            return;
+          }
+
+          // Priority information is deprecated and ignored.
+        }
+        return;
+
+      case frame_RST_STREAM:
+        {
+          if(stream_id == 0) {
+            this->do_http2_connection_error(http2_protocol_error, "RST_STREAM on stream 0");
+            return;
+          }
+
+          if(payload.n != 4) {
+            this->do_http2_connection_error(http2_frame_size_error, "invalid RST_STREAM");
+            return;
+          }
+
+          if(stream_id > this->m_last_stream_id) {
+            this->do_http2_connection_error(http2_protocol_error, "RST_STREAM on idle stream");
+            return;
+          }
+
+          POSEIDON_LOG_DEBUG((
+              "HTTP/2 stream `$3` reset by client: error `$4`",
+              "[HTTP/2 server session `$1` (class `$2`)]"),
+              this, typeid(*this), stream_id, ::asteria::load_be<uint32_t>(payload.p));
+
+          this->m_streams->map.erase(stream_id);
+        }
+        return;
+
+      case frame_SETTINGS:
+        {
+          if(stream_id != 0) {
+            this->do_http2_connection_error(http2_protocol_error, "SETTINGS on non-zero stream");
+            return;
+          }
+
+          if(flags & flag_ACK) {
+            if(payload.n != 0)
+              this->do_http2_connection_error(http2_frame_size_error, "invalid SETTINGS ACK");
+            return;
+          }
+
+          if(payload.n % 6 != 0) {
+            this->do_http2_connection_error(http2_frame_size_error, "invalid SETTINGS");
+            return;
+          }
+
+          for(size_t k = 0;  k != payload.n;  k += 6) {
+            uint16_t id = ::asteria::load_be<uint16_t>(payload.p + k);
+            uint32_t value = ::asteria::load_be<uint32_t>(payload.p + k + 2);
+
+            switch(id)
+              {
+              case setting_ENABLE_PUSH:
+                if(value > 1) {
+                  this->do_http2_connection_error(http2_protocol_error, "invalid ENABLE_PUSH");
+                  return;
+                }
+                break;
+
+              case setting_INITIAL_WINDOW_SIZE:
+                {
+                  if(value > s_max_window_size) {
+                    this->do_http2_connection_error(http2_flow_control_error,
+                                                    "invalid INITIAL_WINDOW_SIZE");
+                    return;
+                  }
+
+                  // Adjust windows of all open streams. They may become
+                  // negative. See RFC 9113, 6.9.2. Initial Flow-Control Window
+                  // Size.
+                  int64_t delta = static_cast<int64_t>(value) - this->m_peer_initial_window_size;
+                  for(auto& r : this->m_streams->map)
+                    r.second.send_window += delta;
+                  this->m_peer_initial_window_size = value;
+                }
+                break;
+
+              case setting_MAX_FRAME_SIZE:
+                if((value < s_default_max_frame_size) || (value > 0xFFFFFF)) {
+                  this->do_http2_connection_error(http2_protocol_error, "invalid MAX_FRAME_SIZE");
+                  return;
+                }
+                this->m_peer_max_frame_size = value;
+                break;
+
+              case setting_HEADER_TABLE_SIZE:
+              case setting_MAX_CONCURRENT_STREAMS:
+              case setting_MAX_HEADER_LIST_SIZE:
+              default:
+                // Our encoder doesn't use the dynamic table, and we don't push
+                // streams to the client, so these are ignored.
+                break;
+              }
+          }
+
+          this->do_http2_send_frame(frame_SETTINGS, flag_ACK, 0, "");
+          this->do_http2_flush_all_streams();
+        }
+        return;
+
+      case frame_PUSH_PROMISE:
+        this->do_http2_connection_error(http2_protocol_error, "PUSH_PROMISE from client");
+        return;
+
+      case frame_PING:
+        {
+          if(stream_id != 0) {
+            this->do_http2_connection_error(http2_protocol_error, "PING on non-zero stream");
+            return;
+          }
+
+          if(payload.n != 8) {
+            this->do_http2_connection_error(http2_frame_size_error, "invalid PING");
+            return;
+          }
+
+          if(!(flags & flag_ACK))
+            this->do_http2_send_frame(frame_PING, flag_ACK, 0, payload);
+        }
+        return;
+
+      case frame_GOAWAY:
+        {
+          if(stream_id != 0) {
+            this->do_http2_connection_error(http2_protocol_error, "GOAWAY on non-zero stream");
+            return;
+          }
+
+          if(payload.n < 8) {
+            this->do_http2_connection_error(http2_frame_size_error, "invalid GOAWAY");
+            return;
+          }
+
+          // Streams that have been opened can still be responded to.
+          POSEIDON_LOG_DEBUG((
+              "HTTP/2 client going away: last_stream_id `$3`, error `$4`",
+              "[HTTP/2 server session `$1` (class `$2`)]"),
+              this, typeid(*this), ::asteria::load_be<uint32_t>(payload.p) & 0x7FFFFFFFU,
+              ::asteria::load_be<uint32_t>(payload.p + 4));
+        }
+        return;
+
+      case frame_WINDOW_UPDATE:
+        {
+          if(payload.n != 4) {
+            this->do_http2_connection_error(http2_frame_size_error, "invalid WINDOW_UPDATE");
+            return;
+          }
+
+          uint32_t incr = ::asteria::load_be<uint32_t>(payload.p) & 0x7FFFFFFFU;
+          if(stream_id == 0) {
+            this->m_send_window += incr;
+            if((incr == 0) || (this->m_send_window > s_max_window_size)) {
+              this->do_http2_connection_error(http2_flow_control_error, "invalid WINDOW_UPDATE");
+              return;
+            }
+
+            this->do_http2_flush_all_streams();
+            return;
+          }
+
+          auto it = this->m_streams->map.find(stream_id);
+          if(it == this->m_streams->map.end())
+            return;
+
+          it->second.send_window += incr;
+          if((incr == 0) || (it->second.send_window > s_max_window_size)) {
+            this->do_http2_reset_stream(stream_id, http2_flow_control_error);
+            return;
+          }
+
+          this->do_http2_flush_stream(stream_id);
+        }
+        return;
+
+      default:
+        // Unknown frames are ignored. See RFC 9113, 4.1. Frame Format.
+        return;
+      }
+  }
+
+void
+HTTP2_Server_Session::
+do_on_ssl_stream(linear_buffer& data, bool eof)
+  {
+    // All states are protected by the I/O lock, which is also acquired by
+    // functions that send responses.
+    recursive_mutex::unique_lock io_lock;
+    this->do_abstract_socket_lock_write_queue(io_lock);
+
+    if(!this->m_preface_done) {
+      // Check the client connection preface. See RFC 9113, 3.4. HTTP/2
+      // Connection Preface.
+      size_t n = ::std::min(data.size(), s_client_preface_size);
+      if(::memcmp(data.begin(), s_client_preface, n) != 0) {
+        data.clear();
+        POSEIDON_LOG_DEBUG((
+            "Invalid HTTP/2 connection preface",
+            "[HTTP/2 server session `$1` (class `$2`)]"),
+            this, typeid(*this));
+
+        this->ssl_shut_down();
+        return;
+      }
+
+      if(n != s_client_preface_size)
+        return;
+
+      data.discard(n);
+      this->m_preface_done = true;
+
+      // Send our SETTINGS frame, which must be the first frame.
+      char settings[12];
+      ::asteria::store_be<uint16_t>(settings, setting_MAX_CONCURRENT_STREAMS);
+      ::asteria::store_be<uint32_t>(settings + 2, this->m_max_concurrent_streams);
+      ::asteria::store_be<uint16_t>(settings + 6, setting_MAX_HEADER_LIST_SIZE);
+      ::asteria::store_be<uint32_t>(settings + 8, this->m_max_header_length);
+      this->do_http2_send_frame(frame_SETTINGS, 0, 0, chars_view(settings, 12));
+    }
+
+    for(;;) {
+      // If something has gone wrong, ignore further incoming data.
+      if(this->socket_state() >= socket_closing) {
+        data.clear();
+        return;
+      }
+
+      if(data.size() < 9)
+        break;
+
+      auto bptr = reinterpret_cast<const unsigned char*>(data.begin());
+      uint32_t length = ::asteria::load_be<uint32_t>(bptr) >> 8;
+      uint8_t type = bptr[3];
+      uint8_t flags = bptr[4];
+      uint32_t stream_id = ::asteria::load_be<uint32_t>(bptr + 5) & 0x7FFFFFFFU;
+
+      if(length > s_default_max_frame_size) {
+        this->do_http2_connection_error(http2_frame_size_error, "frame too large");
+        continue;
+      }
+
+      if(data.size() < 9 + length)
+        break;
+
+      // `data` is not modified by frame handlers, so the payload can be
+      // passed by reference.
+      this->do_http2_process_frame(type, flags, stream_id, chars_view(data.begin() + 9, length));
+      data.discard(9 + length);
+    }
+
+    if(eof && (data.size() != 0))
+      POSEIDON_LOG_DEBUG((
+          "HTTP/2 connection closed with incomplete frame",
+          "[HTTP/2 server session `$1` (class `$2`)]"),
+          this, typeid(*this));
+  }
+
+void
+HTTP2_Server_Session::
+do_on_http2_request_headers(uint32_t stream_id, HTTP_C_Headers& req, bool /*end_stream*/)
+  {
+    POSEIDON_LOG_DEBUG((
+        "HTTP/2 server received request: $4 $5",
+        "[HTTP/2 server session `$1` (class `$2`), stream `$3`]"),
+        this, typeid(*this), stream_id, req.method_str, req.raw_path);
+  }
+
+void
+HTTP2_Server_Session::
+do_on_http2_request_payload_stream(uint32_t stream_id, linear_buffer& data)
+  {
+    // Leave `data` alone for consumption by `do_on_http2_request_finish()`,
+    // but perform some security checks, so we won't be affected by compromised
+    // 3rd-party servers.
+    if(data.size() > this->m_max_content_length)
+      POSEIDON_THROW((
+          "HTTP request payload too large: `$4` > `$5`",
+          "[HTTP/2 server session `$1` (class `$2`), stream `$3`]"),
+          this, typeid(*this), stream_id, data.size(), this->m_max_content_length);
+  }
+
+bool
+HTTP2_Server_Session::
+http2_response_headers_only(uint32_t stream_id, HTTP_S_Headers&& resp)
+  {
+    recursive_mutex::unique_lock io_lock;
+    this->do_abstract_socket_lock_write_queue(io_lock);
+
+    auto it = this->m_streams->map.find(stream_id);
+    if(it == this->m_streams->map.end())
+      return false;
+
+    if(it->second.headers_sent)
+      POSEIDON_THROW((
+          "Response headers already sent: stream_id `$3`",
+          "[HTTP/2 server session `$1` (class `$2`)]"),
+          this, typeid(*this), stream_id);
+
+    if(!this->do_http2_send_headers(stream_id, resp, true))
+      return false;
+
+    it->second.headers_sent = true;
+    it->second.end_requested = true;
+    it->second.local_closed = true;
+    return this->do_http2_flush_stream(stream_id);
+  }
+
+bool
+HTTP2_Server_Session::
+http2_response(uint32_t stream_id, bool method_was_head, HTTP_S_Headers&& resp, chars_view data)
+  {
+    // Some responses are required to have no payload and require no
+    // `Content-Length` header.
+    if((resp.status <= 199) || (resp.status == 204) || (resp.status == 304))
+      return this->http2_response_headers_only(stream_id, move(resp));
+
+    // Unlike HTTP/1.1, the end of the payload is marked by END_STREAM, so
+    // `Content-Length` is advisory.
+    resp.headers.emplace_back(&"Content-Length", static_cast<int64_t>(data.n));
+
+    if(method_was_head || (data.n == 0))
+      return this->http2_response_headers_only(stream_id, move(resp));
+
+    recursive_mutex::unique_lock io_lock;
+    this->do_abstract_socket_lock_write_queue(io_lock);
+
+    if(!this->http2_chunked_response_start(stream_id, move(resp)))
+      return false;
+
+    return this->do_http2_send_data(stream_id, data, true);
+  }
+
+bool
+HTTP2_Server_Session::
+http2_chunked_response_start(uint32_t stream_id, HTTP_S_Headers&& resp)
+  {
+    recursive_mutex::unique_lock io_lock;
+    this->do_abstract_socket_lock_write_queue(io_lock);
+
+    auto it = this->m_streams->map.find(stream_id);
+    if(it == this->m_streams->map.end())
+      return false;
+
+    if(it->second.headers_sent)
+      POSEIDON_THROW((
+          "Response headers already sent: stream_id `$3`",
+          "[HTTP/2 server session `$1` (class `$2`)]"),
+          this, typeid(*this), stream_id);
+
+    if(!this->do_http2_send_headers(stream_id, resp, false))
+      return false;
+
+    it->second.headers_sent = true;
+    return true;
+  }
+
+bool
+HTTP2_Server_Session::
+http2_chunked_response_send(uint32_t stream_id, chars_view data)
+  {
+    recursive_mutex::unique_lock io_lock;
+    this->do_abstract_socket_lock_write_queue(io_lock);
+
+    // Ignore empty chunks, which would mark the end of the payload.
+    if(data.n == 0)
+      return this->m_streams->map.count(stream_id) != 0;
+
+    return this->do_http2_send_data(stream_id, data, false);
+  }
+
+bool
+HTTP2_Server_Session::
+http2_chunked_response_finish(uint32_t stream_id)
+  {
+    recursive_mutex::unique_lock io_lock;
+    this->do_abstract_socket_lock_write_queue(io_lock);
+
+    return this->do_http2_send_data(stream_id, "", true);
+  }
+
+bool
+HTTP2_Server_Session::
+http2_reset_stream(uint32_t stream_id, HTTP2_Error error)
+  {
+    recursive_mutex::unique_lock io_lock;
+    this->do_abstract_socket_lock_write_queue(io_lock);
+
+    if(this->m_streams->map.count(stream_id) == 0)
+      return false;
+
+    this->do_http2_reset_stream(stream_id, error);
+    return true;
+  }
+
+bool
+HTTP2_Server_Session::
+http2_shut_down(HTTP2_Error error)
+  noexcept
+  {
+    recursive_mutex::unique_lock io_lock;
+    this->do_abstract_socket_lock_write_queue(io_lock);
+
+    bool succ = false;
+    try {
+      if(!this->m_goaway_sent) {
+        // Streams that have been opened will not be processed any further.
+        char payload[8];
+        ::asteria::store_be<uint32_t>(payload, this->m_last_stream_id);
+        ::asteria::store_be<uint32_t>(payload + 4, error);
+        succ = this->do_http2_send_frame(frame_GOAWAY, 0, 0, chars_view(payload, 8));
+        this->m_goaway_sent = true;
+      }
+    }
+    catch(exception& stdex) {
+      POSEIDON_LOG_ERROR((
+          "Failed to send GOAWAY: $3",
+          "[HTTP/2 server session `$1` (class `$2`)]"),
+          this, typeid(*this), stdex);
+    }
+    succ |= this->ssl_shut_down();
+    return succ;
+  }
+
+}  // namespace poseidon
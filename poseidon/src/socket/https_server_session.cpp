@@ -4,8 +4,25 @@
 #include "../xprecompiled.hpp"
 #include "../../socket/https_server_session.hpp"
 #include "../../http/http_header_parser.hpp"
+#include "../../http/http_compressor.hpp"
 #include "../../utils.hpp"
 namespace poseidon {
+namespace {
+
+void
+do_encode_chunk(tinyfmt& fmt, chars_view data)
+  {
+    // The length of this chunk is written as a hexadecimal integer without the
+    // `0x` prefix.
+    ::asteria::ascii_numput nump;
+    nump.put_XU(data.n);
+    fmt.putn(nump.data() + 2, nump.size() - 2);
+    fmt << "\r\n";
+    fmt.putn(data.p, data.n);
+    fmt << "\r\n";
+  }
+
+}  // namespace
 
 HTTPS_Server_Session::
 HTTPS_Server_Session()
@@ -45,6 +62,7 @@ do_on_ssl_stream(linear_buffer& data, bool eof)
 
         if(this->m_req_parser.error()) {
           data.clear();
+          this->m_resp_codings.putc(static_cast<char>(http_coding_identity));
           this->do_on_https_request_error(this->m_req_parser.headers().method == http_HEAD,
                                           this->m_req_parser.http_status_from_error());
           return;
@@ -56,6 +74,13 @@ do_on_ssl_stream(linear_buffer& data, bool eof)
         // Check headers.
         auto& headers = this->m_req_parser.mut_headers();
 
+        // Select a content coding for the response, which will be consumed by
+        // the response functions in the same order.
+        auto coding = http_coding_identity;
+        if(this->m_req_parser.default_compression_level() != 0)
+          coding = HTTP_Compressor::select_content_coding(headers);
+        this->m_resp_codings.putc(static_cast<char>(coding));
+
         if(headers.is_proxy == false)
           headers.is_ssl = true;
 
@@ -158,6 +183,19 @@ do_on_https_upgraded_stream(linear_buffer& data, bool eof)
         this, typeid(*this), data.size(), eof);
   }
 
+HTTP_Content_Coding
+HTTPS_Server_Session::
+do_https_front_content_coding()
+  {
+    // The coding is removed after the response has been sent.
+    recursive_mutex::unique_lock io_lock;
+    this->do_abstract_socket_lock_write_queue(io_lock);
+    if(this->m_resp_codings.empty())
+      return http_coding_identity;
+
+    return static_cast<HTTP_Content_Coding>(this->m_resp_codings.data()[0]);
+  }
+
 bool
 HTTPS_Server_Session::
 do_https_raw_response(const HTTP_S_Headers& resp, chars_view data)
@@ -168,6 +206,16 @@ do_https_raw_response(const HTTP_S_Headers& resp, chars_view data)
     fmt.putn(data.p, data.n);
     bool sent = this->ssl_send(fmt);
 
+    // Informational responses don't complete requests, so the coding for this
+    // one is kept, unless the server switches to another protocol.
+    recursive_mutex::unique_lock io_lock;
+    this->do_abstract_socket_lock_write_queue(io_lock);
+    if(resp.status == 101)
+      this->m_resp_codings.clear();
+    else if((resp.status >= 200) && !this->m_resp_codings.empty())
+      this->m_resp_codings.discard(1);
+    io_lock.unlock();
+
     // For server sessions, a status of 101 indicates that the server will switch
     // to another protocol after this message. The client might have sent more
     // data before this, which would violate RFC 6455 anyway, so we don't care.
@@ -217,6 +265,15 @@ https_response(bool method_was_head, HTTP_S_Headers&& resp, chars_view data)
     if((resp.status <= 199) || (resp.status == 204) || (resp.status == 304))
       return this->do_https_raw_response(resp, "");
 
+    // Compress the payload if the client accepts it. This is also done for HEAD
+    // requests, so `Content-Length` and other headers match GET requests.
+    auto coding = this->do_https_front_content_coding();
+    cow_string compressed;
+    if(HTTP_Compressor::compress_response(compressed, resp, data, coding,
+                                          this->m_req_parser.default_compression_level(),
+                                          this->m_req_parser.compression_cache_size()))
+      data = compressed;
+
     // Otherwise, a `Content-Length` is required; otherwise the response would
     // be interpreted as terminating by closure ofthe connection.
     resp.headers.emplace_back(&"Content-Length", static_cast<int64_t>(data.n));
@@ -237,7 +294,17 @@ https_chunked_response_start(HTTP_S_Headers&& resp)
     // Write a chunked header.
     resp.headers.emplace_back(&"Transfer-Encoding", &"chunked");
 
-    return this->do_https_raw_response(resp, "");
+    auto coding = this->do_https_front_content_coding();
+    int level = this->m_req_parser.default_compression_level();
+    uniptr<HTTP_Compressor> compr;
+    if(HTTP_Compressor::prepare_chunked_response(resp, coding, level))
+      compr = new_uni<HTTP_Compressor>(coding, level);
+
+    recursive_mutex::unique_lock io_lock;
+    this->do_abstract_socket_lock_write_queue(io_lock);
+    bool sent = this->do_https_raw_response(resp, "");
+    this->m_chunk_compr = move(compr);
+    return sent;
   }
 
 bool
@@ -254,15 +321,28 @@ https_chunked_response_send(chars_view data)
     if(data.n == 0)
       return this->ssl_send("");
 
-    // Compose a chunk and send it as a whole. The length of this chunk is
-    // written as a hexadecimal integer without the `0x` prefix.
+    recursive_mutex::unique_lock io_lock;
+    this->do_abstract_socket_lock_write_queue(io_lock);
     tinyfmt_ln fmt;
-    ::asteria::ascii_numput nump;
-    nump.put_XU(data.n);
-    fmt.putn(nump.data() + 2, nump.size() - 2);
-    fmt << "\r\n";
-    fmt.putn(data.p, data.n);
-    fmt << "\r\n";
+
+    if(this->m_chunk_compr) {
+      // Compress this chunk and flush it, so the client may process it as soon
+      // as possible.
+      auto& obuf = this->m_chunk_compr->mut_output_buffer();
+      const char* ptr = data.p;
+      const char* end = ptr + data.n;
+      while(ptr != end)
+        ptr += this->m_chunk_compr->deflate(chars_view(ptr, static_cast<size_t>(end - ptr)));
+      this->m_chunk_compr->sync_flush();
+
+      if(obuf.size() != 0)
+        do_encode_chunk(fmt, obuf);
+      obuf.clear();
+    }
+    else
+      do_encode_chunk(fmt, data);
+
+    // Send the chunk as a whole.
     return this->ssl_send(fmt);
   }
 
@@ -276,7 +356,22 @@ https_chunked_response_finish()
           "[HTTPS server session `$1` (class `$2`)]"),
           this, typeid(*this));
 
-    return this->ssl_send("0\r\n\r\n");
+    recursive_mutex::unique_lock io_lock;
+    this->do_abstract_socket_lock_write_queue(io_lock);
+    tinyfmt_ln fmt;
+
+    if(this->m_chunk_compr) {
+      // Complete the compressed stream.
+      auto& obuf = this->m_chunk_compr->mut_output_buffer();
+      this->m_chunk_compr->finish();
+
+      if(obuf.size() != 0)
+        do_encode_chunk(fmt, obuf);
+      this->m_chunk_compr.reset();
+    }
+
+    fmt << "0\r\n\r\n";
+    return this->ssl_send(fmt);
   }
 
 bool
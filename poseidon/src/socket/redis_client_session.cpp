@@ -0,0 +1,365 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../socket/redis_client_session.hpp"
+#include "../../utils.hpp"
+namespace poseidon {
+namespace {
+
+// Push messages that have not been taken by `redis_wait_push()` are queued,
+// but not without a limit.
+constexpr size_t max_queued_push_messages = 1024;
+
+// These are kinds of subscriptions. `m_subscriptions` is indexed by these
+// values minus one.
+enum : uint8_t
+  {
+    sub_none     = 0,
+    sub_channel  = 1,
+    sub_pattern  = 2,
+    sub_shard    = 3,
+  };
+
+struct Subscription_Command
+  {
+    char name[16];
+    uint8_t kind;
+    bool unsub;
+  };
+
+constexpr Subscription_Command s_subscription_commands[] =
+  {
+    { "subscribe",     sub_channel,  false },
+    { "unsubscribe",   sub_channel,  true  },
+    { "psubscribe",    sub_pattern,  false },
+    { "punsubscribe",  sub_pattern,  true  },
+    { "ssubscribe",    sub_shard,    false },
+    { "sunsubscribe",  sub_shard,    true  },
+  };
+
+const Subscription_Command*
+do_find_subscription_command(const cow_string& name)
+  noexcept
+  {
+    for(const auto& r : s_subscription_commands)
+      if(::asteria::ascii_ci_equal(name.data(), name.size(), r.name, ::strlen(r.name)))
+        return &r;
+
+    return nullptr;
+  }
+
+void
+do_encode_command(cow_string& data, const cow_vector<cow_string>& cmd)
+  {
+    // `*<count> CR LF` followed by `$<length> CR LF <bytes> CR LF` for each
+    // argument
+    ::asteria::ascii_numput nump;
+    nump.put_DU(cmd.size());
+    data.push_back('*');
+    data.append(nump.data(), nump.size());
+    data.append("\r\n");
+
+    for(const auto& arg : cmd) {
+      nump.put_DU(arg.size());
+      data.push_back('$');
+      data.append(nump.data(), nump.size());
+      data.append("\r\n");
+      data.append(arg);
+      data.append("\r\n");
+    }
+  }
+
+}  // namespace
+
+Redis_Client_Session::
+Redis_Client_Session(const cow_string& user, const cow_string& password, uint32_t database)
+  :
+    m_user(user), m_password(password), m_database(database)
+  {
+  }
+
+Redis_Client_Session::
+~Redis_Client_Session()
+  {
+  }
+
+void
+Redis_Client_Session::
+do_redis_deliver_push(Redis_Value&& message)
+  {
+    while(!this->m_push_waiters.empty()) {
+      auto callback = move(this->m_push_waiters.front());
+      this->m_push_waiters.pop_front();
+
+      try {
+        // If the waiter has gone away, try the next one.
+        if(callback(move(message), nullptr))
+          return;
+      }
+      catch(exception& stdex) {
+        POSEIDON_LOG_ERROR(("Unhandled exception from Redis push callback: $1"), stdex);
+        return;
+      }
+    }
+
+    if(this->m_push_queue.size() >= max_queued_push_messages) {
+      POSEIDON_LOG_WARN(("Too many Redis push messages queued; discarding the oldest one"));
+      this->m_push_queue.pop_front();
+    }
+
+    this->m_push_queue.push_back(move(message));
+  }
+
+bool
+Redis_Client_Session::
+do_redis_confirm_subscription(Redis_Value& message)
+  {
+    if(this->m_pending.empty() || (this->m_pending.front().sub_kind == sub_none))
+      return false;
+
+    // A confirmation is `[kind, channel, count]`, where `channel` is nil if
+    // there was no subscription to cancel.
+    if(!message.is_array() || (message.as_array().size() != 3)
+       || !message.as_array().at(0).is_string())
+      return false;
+
+    auto sub = do_find_subscription_command(message.as_array().at(0).as_string());
+    auto& front = this->m_pending.front();
+    if(!sub || (sub->kind != front.sub_kind) || (sub->unsub != front.unsub))
+      return false;
+
+    auto& subscriptions = this->m_subscriptions[sub->kind - 1];
+    if(front.sub_replies == 0) {
+      // This cancels all subscriptions of this kind. There is a confirmation
+      // for each of them, or a single one if there is none.
+      front.sub_replies = static_cast<uint32_t>(::std::max<size_t>(subscriptions.size(), 1));
+    }
+
+    const auto& channel = message.as_array().at(1);
+    if(channel.is_string() && sub->unsub)
+      subscriptions.erase(channel.as_string());
+    else if(channel.is_string())
+      subscriptions.emplace(channel.as_string());
+
+    front.sub_replies --;
+    if(front.sub_replies != 0)
+      return true;
+
+    auto callback = move(front.callback);
+    this->m_pending.pop_front();
+
+    try {
+      callback(cow_string(), move(message), nullptr);
+    }
+    catch(exception& stdex) {
+      POSEIDON_LOG_ERROR(("Unhandled exception from Redis callback: $1"), stdex);
+    }
+    return true;
+  }
+
+void
+Redis_Client_Session::
+do_redis_handshake()
+  {
+    // Switch to RESP3, which is required for push messages on a connection
+    // which also executes commands.
+    cow_vector<cow_string> cmd = { &"HELLO", &"3" };
+    if(this->m_password.size() != 0) {
+      cmd.push_back(&"AUTH");
+      cmd.push_back(this->m_user.empty() ? cow_string(&"default") : this->m_user);
+      cmd.push_back(this->m_password);
+    }
+
+    cow_string data;
+    do_encode_command(data, cmd);
+    uint32_t count = 1;
+
+    if(this->m_database != 0) {
+      ::asteria::ascii_numput nump;
+      nump.put_DU(this->m_database);
+      cmd = { &"SELECT", cow_string(nump.data(), nump.size()) };
+      do_encode_command(data, cmd);
+      count ++;
+    }
+
+    recursive_mutex::unique_lock io_lock;
+    this->do_redis_lock_socket(io_lock);
+
+    if(!this->do_redis_send(data))
+      return;
+
+    this->m_handshake_replies += count;
+    cow_string().swap(this->m_password);
+  }
+
+void
+Redis_Client_Session::
+do_redis_on_stream(linear_buffer& data)
+  {
+    for(;;) {
+      if(!this->m_parser.parse_reply_from_stream(data)) {
+        if(this->m_parser.error()) {
+          data.clear();
+          this->do_redis_shut_down();
+        }
+        return;
+      }
+
+      if(this->m_parser.reply_type() == redis_reply_push) {
+        // This is out of band, and does not belong to any command, unless it
+        // confirms a subscription.
+        if(!this->do_redis_confirm_subscription(this->m_parser.mut_value()))
+          this->do_on_redis_push(move(this->m_parser.mut_value()));
+        continue;
+      }
+
+      if(this->m_handshake_replies != 0) {
+        this->m_handshake_replies --;
+
+        if(this->m_parser.reply_type() == redis_reply_error) {
+          POSEIDON_LOG_ERROR(("Redis handshake failed: $1"), this->m_parser.status());
+          data.clear();
+          this->do_redis_shut_down();
+          return;
+        }
+        continue;
+      }
+
+      if(this->m_pending.empty()) {
+        POSEIDON_LOG_ERROR(("Unexpected Redis reply without a command"));
+        data.clear();
+        this->do_redis_shut_down();
+        return;
+      }
+
+      auto callback = move(this->m_pending.front().callback);
+      this->m_pending.pop_front();
+
+      try {
+        if(this->m_parser.reply_type() == redis_reply_error)
+          callback(cow_string(), Redis_Value(), this->m_parser.status().c_str());
+        else
+          callback(move(this->m_parser.mut_status()), move(this->m_parser.mut_value()), nullptr);
+      }
+      catch(exception& stdex) {
+        POSEIDON_LOG_ERROR(("Unhandled exception from Redis callback: $1"), stdex);
+      }
+    }
+  }
+
+void
+Redis_Client_Session::
+do_redis_on_closed(int err)
+  noexcept
+  {
+    this->m_closed = true;
+
+    char sbuf[1024];
+    const char* err_str = "connection closed without a reply";
+    if(err != 0)
+      err_str = ::strerror_r(err, sbuf, sizeof(sbuf));
+
+    while(!this->m_pending.empty()) {
+      auto callback = move(this->m_pending.front().callback);
+      this->m_pending.pop_front();
+
+      try {
+        callback(cow_string(), Redis_Value(), err_str);
+      }
+      catch(exception& stdex) {
+        POSEIDON_LOG_ERROR(("Unhandled exception from Redis callback: $1"), stdex);
+      }
+    }
+
+    while(!this->m_push_waiters.empty()) {
+      auto callback = move(this->m_push_waiters.front());
+      this->m_push_waiters.pop_front();
+
+      try {
+        callback(Redis_Value(), err_str);
+      }
+      catch(exception& stdex) {
+        POSEIDON_LOG_ERROR(("Unhandled exception from Redis push callback: $1"), stdex);
+      }
+    }
+  }
+
+void
+Redis_Client_Session::
+do_on_redis_push(Redis_Value&& message)
+  {
+    POSEIDON_LOG_TRACE(("Redis push message: $1"), message);
+    this->do_redis_deliver_push(move(message));
+  }
+
+bool
+Redis_Client_Session::
+redis_execute(const cow_vector<cow_string>& cmd, const callback_type& callback)
+  {
+    if(cmd.empty())
+      POSEIDON_THROW(("Empty Redis command"));
+
+    cow_string data;
+    do_encode_command(data, cmd);
+
+    X_Pending_Command elem;
+    elem.callback = callback;
+    elem.sub_kind = sub_none;
+    elem.unsub = false;
+    elem.sub_replies = 0;
+
+    if(auto sub = do_find_subscription_command(cmd[0])) {
+      // There is a confirmation for each channel.
+      elem.sub_kind = sub->kind;
+      elem.unsub = sub->unsub;
+      elem.sub_replies = static_cast<uint32_t>(cmd.size() - 1);
+
+      if(!sub->unsub && (elem.sub_replies == 0))
+        POSEIDON_THROW(("No channel to subscribe to"));
+    }
+
+    // Lock the socket first, so a reply can't be processed before the callback
+    // is queued, and concurrent commands are queued in the order they are sent.
+    recursive_mutex::unique_lock io_lock;
+    this->do_redis_lock_socket(io_lock);
+
+    this->m_pending.push_back(move(elem));
+    try {
+      if(this->do_redis_send(data))
+        return true;
+    }
+    catch(...) {
+      this->m_pending.pop_back();
+      throw;
+    }
+
+    this->m_pending.pop_back();
+    return false;
+  }
+
+void
+Redis_Client_Session::
+redis_wait_push(const push_callback_type& callback)
+  {
+    recursive_mutex::unique_lock io_lock;
+    this->do_redis_lock_socket(io_lock);
+
+    if(!this->m_push_queue.empty()) {
+      // The message is still owned by the queue until `callback` has taken it.
+      if(callback(move(this->m_push_queue.front()), nullptr))
+        this->m_push_queue.pop_front();
+      return;
+    }
+
+    if(this->m_closed) {
+      io_lock.unlock();
+
+      callback(Redis_Value(), "connection closed");
+      return;
+    }
+
+    this->m_push_waiters.push_back(callback);
+  }
+
+}  // namespace poseidon
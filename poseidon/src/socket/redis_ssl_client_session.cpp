@@ -0,0 +1,64 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../socket/redis_ssl_client_session.hpp"
+#include "../../static/network_scheduler.hpp"
+#include "../../utils.hpp"
+namespace poseidon {
+
+Redis_SSL_Client_Session::
+Redis_SSL_Client_Session(const cow_string& user, const cow_string& password,
+                         uint32_t database)
+  :
+    SSL_Socket(network_scheduler), Redis_Client_Session(user, password, database)
+  {
+    this->do_redis_handshake();
+  }
+
+Redis_SSL_Client_Session::
+~Redis_SSL_Client_Session()
+  {
+  }
+
+void
+Redis_SSL_Client_Session::
+do_abstract_socket_on_closed()
+  {
+    int err = errno;
+    this->SSL_Socket::do_abstract_socket_on_closed();
+    this->do_redis_on_closed(err);
+  }
+
+void
+Redis_SSL_Client_Session::
+do_on_ssl_stream(linear_buffer& data, bool /*eof*/)
+  {
+    // If the connection is closed, pending commands are failed by
+    // `do_abstract_socket_on_closed()`.
+    this->do_redis_on_stream(data);
+  }
+
+void
+Redis_SSL_Client_Session::
+do_redis_lock_socket(recursive_mutex::unique_lock& lock)
+  {
+    this->do_abstract_socket_lock_write_queue(lock);
+  }
+
+bool
+Redis_SSL_Client_Session::
+do_redis_send(const cow_string& data)
+  {
+    return this->ssl_send(data);
+  }
+
+void
+Redis_SSL_Client_Session::
+do_redis_shut_down()
+  noexcept
+  {
+    this->quick_shut_down();
+  }
+
+}  // namespace poseidon
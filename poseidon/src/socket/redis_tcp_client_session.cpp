@@ -0,0 +1,63 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../socket/redis_tcp_client_session.hpp"
+#include "../../utils.hpp"
+namespace poseidon {
+
+Redis_TCP_Client_Session::
+Redis_TCP_Client_Session(const cow_string& user, const cow_string& password,
+                         uint32_t database)
+  :
+    TCP_Socket(), Redis_Client_Session(user, password, database)
+  {
+    this->do_redis_handshake();
+  }
+
+Redis_TCP_Client_Session::
+~Redis_TCP_Client_Session()
+  {
+  }
+
+void
+Redis_TCP_Client_Session::
+do_abstract_socket_on_closed()
+  {
+    int err = errno;
+    this->TCP_Socket::do_abstract_socket_on_closed();
+    this->do_redis_on_closed(err);
+  }
+
+void
+Redis_TCP_Client_Session::
+do_on_tcp_stream(linear_buffer& data, bool /*eof*/)
+  {
+    // If the connection is closed, pending commands are failed by
+    // `do_abstract_socket_on_closed()`.
+    this->do_redis_on_stream(data);
+  }
+
+void
+Redis_TCP_Client_Session::
+do_redis_lock_socket(recursive_mutex::unique_lock& lock)
+  {
+    this->do_abstract_socket_lock_write_queue(lock);
+  }
+
+bool
+Redis_TCP_Client_Session::
+do_redis_send(const cow_string& data)
+  {
+    return this->tcp_send_shared(data);
+  }
+
+void
+Redis_TCP_Client_Session::
+do_redis_shut_down()
+  noexcept
+  {
+    this->quick_shut_down();
+  }
+
+}  // namespace poseidon
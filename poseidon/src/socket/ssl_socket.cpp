@@ -29,6 +29,7 @@ SSL_Socket(unique_posix_fd&& fd, const Network_Scheduler& scheduler)
           ::ERR_reason_error_string(::ERR_get_error()));
 
     ::SSL_set_accept_state(this->m_ssl);
+    ::SSL_set_app_data(this->m_ssl, this);
   }
 
 SSL_Socket::
@@ -49,6 +50,7 @@ SSL_Socket(const Network_Scheduler& scheduler)
           ::ERR_reason_error_string(::ERR_get_error()));
 
     ::SSL_set_connect_state(this->m_ssl);
+    ::SSL_set_app_data(this->m_ssl, this);
   }
 
 SSL_Socket::
@@ -56,6 +58,97 @@ SSL_Socket::
   {
   }
 
+int
+SSL_Socket::
+do_ssl_alpn_select(::SSL* ssl, const unsigned char** out, unsigned char* outlen,
+                   const unsigned char* in, unsigned int inlen, void* /*arg*/)
+  {
+    auto socket = static_cast<const SSL_Socket*>(::SSL_get_app_data(ssl));
+    if(!socket || socket->m_alpn_proto_list.empty())
+      return SSL_TLSEXT_ERR_NOACK;
+
+    // Select a protocol from our list. `SSL_select_next_proto()` does not
+    // modify the input buffers, despite its prototype.
+    unsigned char* sel = nullptr;
+    unsigned char sel_len = 0;
+    const auto& list = socket->m_alpn_proto_list;
+    if(::SSL_select_next_proto(&sel, &sel_len,
+                               reinterpret_cast<const unsigned char*>(list.data()),
+                               static_cast<unsigned int>(list.size()),
+                               in, inlen) != OPENSSL_NPN_NEGOTIATED)
+      return SSL_TLSEXT_ERR_NOACK;
+
+    *out = sel;
+    *outlen = sel_len;
+    return SSL_TLSEXT_ERR_OK;
+  }
+
+int
+SSL_Socket::
+do_ssl_new_session(::SSL* ssl, ::SSL_SESSION* session)
+  {
+    auto socket = static_cast<SSL_Socket*>(::SSL_get_app_data(ssl));
+    if(!socket)
+      return 0;
+
+    try {
+      // Call the user-defined session callback.
+      socket->do_on_ssl_new_session(session);
+    }
+    catch(exception& stdex) {
+      POSEIDON_LOG_ERROR((
+          "Unhandled exception: $3",
+          "[SSL socket `$1` (class `$2`)]"),
+          socket, typeid(*socket), stdex);
+    }
+
+    // The session is not retained by us, so OpenSSL shall free it.
+    return 0;
+  }
+
+void
+SSL_Socket::
+do_ssl_set_alpn_protocols(const cow_vector<cow_string>& protos)
+  {
+    // Compose the list in wire format, which is a sequence of length-prefixed
+    // strings.
+    cow_string list;
+    for(const auto& proto : protos) {
+      if((proto.size() == 0) || (proto.size() > 255))
+        POSEIDON_THROW((
+            "Invalid ALPN protocol name `$3`",
+            "[SSL socket `$1` (class `$2`)]"),
+            this, typeid(*this), proto);
+
+      list.push_back(static_cast<char>(proto.size()));
+      list.append(proto);
+    }
+
+    if(!::SSL_is_server(this->m_ssl)
+       && (::SSL_set_alpn_protos(this->m_ssl,
+                                 reinterpret_cast<const unsigned char*>(list.data()),
+                                 static_cast<unsigned int>(list.size())) != 0))
+      POSEIDON_THROW((
+          "Could not set ALPN protocols",
+          "[`SSL_set_alpn_protos()` failed: $3]",
+          "[SSL socket `$1` (class `$2`)]"),
+          this, typeid(*this), ::ERR_reason_error_string(::ERR_get_error()));
+
+    this->m_alpn_proto_list.swap(list);
+  }
+
+void
+SSL_Socket::
+do_ssl_set_session(::SSL_SESSION* session)
+  {
+    if(!::SSL_set_session(this->m_ssl, session))
+      POSEIDON_THROW((
+          "Could not set SSL session",
+          "[`SSL_set_session()` failed: $3]",
+          "[SSL socket `$1` (class `$2`)]"),
+          this, typeid(*this), ::ERR_reason_error_string(::ERR_get_error()));
+  }
+
 void
 SSL_Socket::
 do_abstract_socket_on_closed()
@@ -73,11 +166,13 @@ do_abstract_socket_on_readable()
     recursive_mutex::unique_lock io_lock;
     auto& queue = this->do_abstract_socket_lock_read_queue(io_lock);
 
+    // Unconsumed data are kept in the read queue, and will be passed to the
+    // callback again with new data.
+    size_t nread = 0;
     for(;;) {
-      queue.clear();
-      queue.reserve_after_end(0xFFFF);
-      size_t nread = queue.capacity_after_end();
-      int ret = ::SSL_read_ex(this->m_ssl, queue.mut_end(), nread, &nread);
+      size_t navail = this->do_abstract_socket_reserve_read_queue(nread);
+      nread = 0;
+      int ret = ::SSL_read_ex(this->m_ssl, queue.mut_end(), navail, &nread);
       if(ret <= 0)
         switch(::SSL_get_error(this->m_ssl, ret))
           {
@@ -133,6 +228,11 @@ do_abstract_socket_on_readable()
         return;
       }
 
+      // If reading has been paused by the callback, stop here. Remaining data
+      // will be read after reading is resumed.
+      if(this->do_abstract_socket_read_paused())
+        return;
+
       POSEIDON_LOG_TRACE(("SSL socket `$1` (class `$2`) IN"), this, typeid(*this));
     }
   }
@@ -211,6 +311,27 @@ do_on_ssl_connected()
         this, typeid(*this), this->remote_address());
   }
 
+void
+SSL_Socket::
+do_on_ssl_new_session(::SSL_SESSION* session)
+  {
+    POSEIDON_LOG_DEBUG((
+        "SSL session `$3` received from `$4`",
+        "[SSL socket `$1` (class `$2`)]"),
+        this, typeid(*this), session, this->remote_address());
+  }
+
+cow_string
+SSL_Socket::
+alpn_protocol()
+  const
+  {
+    const unsigned char* str = nullptr;
+    unsigned int len = 0;
+    ::SSL_get0_alpn_selected(this->m_ssl, &str, &len);
+    return cow_string(reinterpret_cast<const char*>(str), len);
+  }
+
 uint32_t
 SSL_Socket::
 max_segment_size()
@@ -6,7 +6,14 @@
 #include "../../utils.hpp"
 #include <sys/socket.h>
 #include <netinet/tcp.h>
+#include <sys/uio.h>
 namespace poseidon {
+namespace {
+
+// This is the maximum number of chunks to send with a single `writev()`.
+constexpr size_t s_max_iov = 64;
+
+}  // namespace
 
 TCP_Socket::
 TCP_Socket(unique_posix_fd&& fd)
@@ -44,11 +51,12 @@ do_abstract_socket_on_readable()
     recursive_mutex::unique_lock io_lock;
     auto& queue = this->do_abstract_socket_lock_read_queue(io_lock);
 
+    // Unconsumed data are kept in the read queue, and will be passed to the
+    // callback again with new data.
+    size_t nread = 0;
     for(;;) {
-      queue.clear();
-      queue.reserve_after_end(0xFFFF);
-      ::ssize_t ior = ::recv(this->do_socket_fd(), queue.mut_end(),
-                             queue.capacity_after_end(), 0);
+      size_t navail = this->do_abstract_socket_reserve_read_queue(nread);
+      ::ssize_t ior = ::recv(this->do_socket_fd(), queue.mut_end(), navail, 0);
       if(ior < 0) {
         if((errno == EAGAIN) || (errno == EWOULDBLOCK))
           return;
@@ -63,7 +71,8 @@ do_abstract_socket_on_readable()
         return;
       }
 
-      queue.accept(static_cast<size_t>(ior));
+      nread = static_cast<size_t>(ior);
+      queue.accept(nread);
       bool eof = ior == 0;
 
       try {
@@ -87,6 +96,11 @@ do_abstract_socket_on_readable()
         return;
       }
 
+      // If reading has been paused by the callback, stop here. Remaining data
+      // will be read after reading is resumed.
+      if(this->do_abstract_socket_read_paused())
+        return;
+
       POSEIDON_LOG_TRACE(("TCP socket `$1` (class `$2`) IN"), this, typeid(*this));
     }
   }
@@ -96,7 +110,7 @@ TCP_Socket::
 do_abstract_socket_on_writeable()
   {
     recursive_mutex::unique_lock io_lock;
-    auto& queue = this->do_abstract_socket_lock_write_queue(io_lock);
+    auto& queue = this->do_abstract_socket_lock_write_chunks(io_lock);
 
     if(this->do_socket_test_change(socket_pending, socket_established))
       try {
@@ -126,7 +140,9 @@ do_abstract_socket_on_writeable()
         return;
       }
 
-      ::ssize_t ior = ::send(this->do_socket_fd(), queue.begin(), queue.size(), 0);
+      ::iovec iov[s_max_iov];
+      size_t niov = queue.gather(iov, s_max_iov);
+      ::ssize_t ior = ::writev(this->do_socket_fd(), iov, static_cast<int>(niov));
       if(ior < 0) {
         if((errno == EAGAIN) || (errno == EWOULDBLOCK))
           return;
@@ -178,58 +194,83 @@ max_segment_size()
 
 bool
 TCP_Socket::
-tcp_send(chars_view data)
+do_tcp_send(chars_view data, const cow_string* str)
   {
     if(this->socket_state() >= socket_closing)
       return false;
 
     recursive_mutex::unique_lock io_lock;
-    auto& queue = this->do_abstract_socket_lock_write_queue(io_lock);
-
-    // Reserve storage for the sake of exception safety.
-    queue.reserve_after_end(data.n);
-
-    if(queue.empty() && (this->socket_state() == socket_established)) {
-      // Send until the operation would block.
-      chars_view window = data;
-      for(;;) {
-        if(window.n == 0)
-          return true;
-
-        ::ssize_t ior = ::send(this->do_socket_fd(), window.p, window.n, 0);
-        if(ior < 0) {
-          if((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
-            // Stash remaining data, and wait for the next writability
-            // notification. Storage has been reserved so this will not throw
-            // any exceptions.
-            ::memcpy(queue.mut_end(), window.p, window.n);
-            queue.accept(window.n);
-            return true;
-          }
-
-          POSEIDON_LOG_DEBUG((
-              "TCP socket write error: ${errno:full}",
-              "[TCP socket `$1` (class `$2`)]"),
-              this, typeid(*this));
-
-          // The connection is now broken.
-          this->quick_shut_down();
-          return false;
-        }
-
-        // Discard sent data;
-        window >>= static_cast<size_t>(ior);
-
-        POSEIDON_LOG_TRACE(("TCP socket `$1` (class `$2`) W"), this, typeid(*this));
-      }
-    }
-    else {
+    auto& queue = this->do_abstract_socket_lock_write_chunks(io_lock);
+
+    if(!queue.empty() || (this->socket_state() != socket_established)) {
       // If a previous write operation would have blocked, append `data` to
       // `queue`, and wait for the next writability notification.
-      ::memcpy(queue.mut_end(), data.p, data.n);
-      queue.accept(data.n);
+      if(str)
+        queue.append(*str);
+      else
+        queue.append(data.p, data.n);
       return true;
     }
+
+    // Send until the operation would block.
+    chars_view window = data;
+    for(;;) {
+      if(window.n == 0)
+        return true;
+
+      ::ssize_t ior = ::send(this->do_socket_fd(), window.p, window.n, 0);
+      if(ior < 0) {
+        if((errno == EAGAIN) || (errno == EWOULDBLOCK))
+          break;
+
+        POSEIDON_LOG_DEBUG((
+            "TCP socket write error: ${errno:full}",
+            "[TCP socket `$1` (class `$2`)]"),
+            this, typeid(*this));
+
+        // The connection is now broken.
+        this->quick_shut_down();
+        return false;
+      }
+
+      // Discard sent data;
+      window >>= static_cast<size_t>(ior);
+
+      POSEIDON_LOG_TRACE(("TCP socket `$1` (class `$2`) W"), this, typeid(*this));
+    }
+
+    try {
+      // Stash remaining data, and wait for the next writability notification.
+      if(str)
+        queue.append(*str, static_cast<size_t>(window.p - data.p));
+      else
+        queue.append(window.p, window.n);
+      return true;
+    }
+    catch(exception& stdex) {
+      POSEIDON_LOG_ERROR((
+          "Could not enqueue data: $3",
+          "[TCP socket `$1` (class `$2`)]"),
+          this, typeid(*this), stdex);
+
+      // Some data have been sent, so the connection is now broken.
+      this->quick_shut_down();
+      return false;
+    }
+  }
+
+bool
+TCP_Socket::
+tcp_send(chars_view data)
+  {
+    return this->do_tcp_send(data, nullptr);
+  }
+
+bool
+TCP_Socket::
+tcp_send_shared(const cow_string& data)
+  {
+    return this->do_tcp_send(chars_view(data.data(), data.size()), &data);
   }
 
 bool
@@ -241,7 +282,7 @@ tcp_shut_down()
       return false;
 
     recursive_mutex::unique_lock io_lock;
-    auto& queue = this->do_abstract_socket_lock_write_queue(io_lock);
+    auto& queue = this->do_abstract_socket_lock_write_chunks(io_lock);
 
     if(queue.empty()) {
       // Close the connection immediately.
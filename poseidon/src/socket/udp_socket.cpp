@@ -3,19 +3,144 @@
 
 #include "../xprecompiled.hpp"
 #include "../../socket/udp_socket.hpp"
+#include "../../static/network_scheduler.hpp"
 #include "../../utils.hpp"
+#include <vector>
 #include <sys/socket.h>
 #include <netinet/udp.h>
 #include <net/if.h>
 namespace poseidon {
+namespace {
+
+// Each packet is received into a 64 KiB buffer, which is large enough for any
+// UDP packet, including one that has been coalesced by GRO.
+constexpr size_t s_max_packet_size = 0x10000;
+
+// These are limits of `UDP_SEGMENT`. The total size excludes the IPv6 and
+// UDP headers.
+constexpr size_t s_max_gso_segments = 64;
+constexpr size_t s_max_gso_size = 0xFFFF - 48;
+
+// Packets in the send queue are prefixed with this header. As the queue is
+// not aligned, it's always copied with `memcpy()`.
+struct Queued_Packet_Header
+  {
+    ::in6_addr addr;
+    uint16_t port;
+    uint16_t reserved;
+    uint32_t size;
+  };
+
+struct alignas(::cmsghdr) Control_Buffer
+  {
+    char bytes[CMSG_SPACE(sizeof(int))];
+  };
+
+struct Receive_Slab
+  {
+    uint32_t size = 0;
+    ::std::vector<char> data;
+    ::std::vector<::mmsghdr> msgs;
+    ::std::vector<::iovec> iovs;
+    ::std::vector<::sockaddr_in6> addrs;
+    ::std::vector<Control_Buffer> controls;
+  };
+
+// Packets are received by the network thread, so this is allocated only once.
+thread_local Receive_Slab s_slab;
+
+void
+do_prepare_slab(Receive_Slab& slab, uint32_t size)
+  {
+    if(slab.size != size) {
+      slab.data.resize(size * s_max_packet_size);
+      slab.msgs.resize(size);
+      slab.iovs.resize(size);
+      slab.addrs.resize(size);
+      slab.controls.resize(size);
+      slab.size = size;
+    }
+
+    // These are overwritten by `recvmmsg()`, so they have to be reset for each
+    // call.
+    for(uint32_t k = 0;  k != size;  ++k) {
+      slab.iovs[k].iov_base = slab.data.data() + k * s_max_packet_size;
+      slab.iovs[k].iov_len = s_max_packet_size;
+
+      auto& hdr = slab.msgs[k].msg_hdr;
+      hdr.msg_name = &(slab.addrs[k]);
+      hdr.msg_namelen = sizeof(slab.addrs[k]);
+      hdr.msg_iov = &(slab.iovs[k]);
+      hdr.msg_iovlen = 1;
+      hdr.msg_control = slab.controls[k].bytes;
+      hdr.msg_controllen = sizeof(slab.controls[k].bytes);
+      hdr.msg_flags = 0;
+      slab.msgs[k].msg_len = 0;
+    }
+  }
+
+size_t
+do_get_gro_segment_size(::msghdr& hdr, size_t size)
+  {
+    for(auto cmsg = CMSG_FIRSTHDR(&hdr);  cmsg;  cmsg = CMSG_NXTHDR(&hdr, cmsg))
+      if((cmsg->cmsg_level == SOL_UDP) && (cmsg->cmsg_type == UDP_GRO)) {
+        int gso_size;
+        ::memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+        if(gso_size > 0)
+          return static_cast<size_t>(gso_size);
+      }
+
+    // The packet has not been coalesced.
+    return size;
+  }
+
+size_t
+do_get_gso_run_length(const chars_view* data, size_t count)
+  {
+    // All segments but the last one must have the same size. The last one may
+    // be shorter.
+    size_t seg_size = data[0].n;
+    if(seg_size == 0)
+      return 1;
+
+    size_t total = seg_size;
+    size_t n = 1;
+    while((n != count) && (n != s_max_gso_segments) && (data[n].n != 0)
+          && (data[n].n <= seg_size) && (total + data[n].n <= s_max_gso_size)) {
+      total += data[n].n;
+      n ++;
+      if(data[n - 1].n != seg_size)
+        break;
+    }
+    return n;
+  }
+
+void
+do_set_udp_gro(int fd)
+  {
+    if(!network_scheduler.udp_gro_enabled())
+      return;
+
+    static constexpr int one = 1;
+    if(::setsockopt(fd, SOL_UDP, UDP_GRO, &one, sizeof(one)) != 0)
+      POSEIDON_LOG_DEBUG((
+          "Could not enable UDP GRO: ${errno:full}",
+          "[`setsockopt()` failed]"));
+  }
+
+}  // namespace
 
 UDP_Socket::
 UDP_Socket(const IPv6_Address& addr)
   :
     Abstract_Socket(SOCK_DGRAM, IPPROTO_UDP)
   {
+    this->m_send_queue_size = network_scheduler.udp_send_queue_size();
+    this->m_drop_policy = network_scheduler.udp_drop_policy();
+
     static constexpr int one = 1;
     ::setsockopt(this->do_socket_fd(), SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    do_set_udp_gro(this->do_socket_fd());
 
     ::sockaddr_in6 sa = { };
     sa.sin6_family = AF_INET6;
@@ -38,6 +163,9 @@ UDP_Socket()
   :
     Abstract_Socket(SOCK_DGRAM, IPPROTO_UDP)
   {
+    this->m_send_queue_size = network_scheduler.udp_send_queue_size();
+    this->m_drop_policy = network_scheduler.udp_drop_policy();
+    do_set_udp_gro(this->do_socket_fd());
   }
 
 UDP_Socket::
@@ -45,6 +173,51 @@ UDP_Socket::
   {
   }
 
+bool
+UDP_Socket::
+do_enqueue_packet_nolock(linear_buffer& queue, const IPv6_Address& addr, chars_view data)
+  {
+    Queued_Packet_Header header;
+    size_t total = sizeof(header) + data.n;
+
+    if(total > this->m_send_queue_size) {
+      // The packet can't be enqueued anyway.
+      this->m_dropped_packets.xadd(1);
+      this->m_dropped_bytes.xadd(data.n);
+      return false;
+    }
+
+    if(queue.size() + total > this->m_send_queue_size) {
+      if(this->m_drop_policy == udp_drop_newest) {
+        this->m_dropped_packets.xadd(1);
+        this->m_dropped_bytes.xadd(data.n);
+        return false;
+      }
+
+      // Drop packets from the head of the queue until there is enough room.
+      // The queue always starts with a complete packet.
+      while(queue.size() + total > this->m_send_queue_size) {
+        ::memcpy(&header, queue.begin(), sizeof(header));
+        queue.discard(sizeof(header) + header.size);
+        this->m_dropped_packets.xadd(1);
+        this->m_dropped_bytes.xadd(header.size);
+      }
+    }
+
+    // Reserve storage for the sake of exception safety.
+    queue.reserve_after_end(total);
+
+    header.addr = addr.addr();
+    header.port = addr.port();
+    header.reserved = 0;
+    header.size = static_cast<uint32_t>(data.n);
+    ::memcpy(queue.mut_end(), &header, sizeof(header));
+    queue.accept(sizeof(header));
+    ::memcpy(queue.mut_end(), data.p, data.n);
+    queue.accept(data.n);
+    return true;
+  }
+
 void
 UDP_Socket::
 do_abstract_socket_on_closed()
@@ -63,15 +236,13 @@ do_abstract_socket_on_readable()
     auto& queue = this->do_abstract_socket_lock_read_queue(io_lock);
     auto& from_addr = this->m_from_addr;
 
+    auto& slab = s_slab;
+    uint32_t batch_size = network_scheduler.udp_receive_batch_size();
+
     for(;;) {
-      queue.clear();
-      queue.reserve_after_end(0xFFFF);
-      ::sockaddr_in6 sa;
-      ::socklen_t salen = sizeof(sa);
-      ::ssize_t ior = ::recvfrom(this->do_socket_fd(), queue.mut_end(),
-                                 queue.capacity_after_end(), 0,
-                                 reinterpret_cast<::sockaddr*>(&sa), &salen);
-      if(ior < 0) {
+      do_prepare_slab(slab, batch_size);
+      int nmsgs = ::recvmmsg(this->do_socket_fd(), slab.msgs.data(), batch_size, 0, nullptr);
+      if(nmsgs < 0) {
         if((errno == EAGAIN) || (errno == EWOULDBLOCK))
           return;
 
@@ -84,25 +255,40 @@ do_abstract_socket_on_readable()
         continue;
       }
 
-      queue.accept(static_cast<size_t>(ior));
-      from_addr.set_addr(sa.sin6_addr);
-      from_addr.set_port(::ntohs(sa.sin6_port));
+      for(uint32_t k = 0;  k != static_cast<uint32_t>(nmsgs);  ++k) {
+        const char* data = slab.data.data() + k * s_max_packet_size;
+        size_t size = slab.msgs[k].msg_len;
+        size_t seg_size = do_get_gro_segment_size(slab.msgs[k].msg_hdr, size);
+        size_t offset = 0;
 
-      try {
-        // Call the user-defined data callback.
-        this->do_on_udp_packet(move(from_addr), move(queue));
-      }
-      catch(exception& stdex) {
-        POSEIDON_LOG_ERROR((
-            "Unhandled exception: $3",
-            "[UDP socket `$1` (class `$2`)]"),
-            this, typeid(*this), stdex);
+        do {
+          // Copy the packet into a buffer of its own size, so the slab can be
+          // reused, and small packets don't pin large buffers.
+          size_t seg_len = min(seg_size, size - offset);
+          queue.clear();
+          queue.putn(data + offset, seg_len);
+          offset += seg_len;
 
-        // For UDP sockets, errors are ignored.
-        continue;
+          from_addr.set_addr(slab.addrs[k].sin6_addr);
+          from_addr.set_port(::ntohs(slab.addrs[k].sin6_port));
+
+          try {
+            // Call the user-defined data callback.
+            this->do_on_udp_packet(move(from_addr), move(queue));
+          }
+          catch(exception& stdex) {
+            POSEIDON_LOG_ERROR((
+                "Unhandled exception: $3",
+                "[UDP socket `$1` (class `$2`)]"),
+                this, typeid(*this), stdex);
+
+            // For UDP sockets, errors are ignored.
+          }
+        }
+        while(offset < size);
       }
 
-      POSEIDON_LOG_TRACE(("UDP socket `$1` (class `$2`) IN"), this, typeid(*this));
+      POSEIDON_LOG_TRACE(("UDP socket `$1` (class `$2`) IN: $3 packets"), this, typeid(*this), nmsgs);
     }
   }
 
@@ -110,7 +296,63 @@ void
 UDP_Socket::
 do_abstract_socket_on_writeable()
   {
+    recursive_mutex::unique_lock io_lock;
+    auto& queue = this->do_abstract_socket_lock_write_queue(io_lock);
+
     this->do_socket_test_change(socket_pending, socket_established);
+
+    ::mmsghdr msgs[s_max_gso_segments];
+    ::iovec iovs[s_max_gso_segments];
+    ::sockaddr_in6 addrs[s_max_gso_segments];
+
+    while(!queue.empty()) {
+      // Send queued packets in batches.
+      uint32_t nmsgs = 0;
+      size_t offset = 0;
+
+      while((offset != queue.size()) && (nmsgs != s_max_gso_segments)) {
+        Queued_Packet_Header header;
+        ::memcpy(&header, queue.begin() + offset, sizeof(header));
+        offset += sizeof(header);
+
+        addrs[nmsgs] = { };
+        addrs[nmsgs].sin6_family = AF_INET6;
+        addrs[nmsgs].sin6_port = ::htons(header.port);
+        addrs[nmsgs].sin6_addr = header.addr;
+        iovs[nmsgs].iov_base = const_cast<char*>(queue.begin() + offset);
+        iovs[nmsgs].iov_len = header.size;
+        offset += header.size;
+
+        auto& hdr = msgs[nmsgs].msg_hdr;
+        hdr = { };
+        hdr.msg_name = &(addrs[nmsgs]);
+        hdr.msg_namelen = sizeof(addrs[nmsgs]);
+        hdr.msg_iov = &(iovs[nmsgs]);
+        hdr.msg_iovlen = 1;
+        msgs[nmsgs].msg_len = 0;
+        nmsgs ++;
+      }
+
+      int ior = ::sendmmsg(this->do_socket_fd(), msgs, nmsgs, 0);
+      if(ior < 0) {
+        if((errno == EAGAIN) || (errno == EWOULDBLOCK))
+          return;
+
+        POSEIDON_LOG_DEBUG((
+            "UDP socket write error: ${errno:full}",
+            "[UDP socket `$1` (class `$2`)]"),
+            this, typeid(*this));
+
+        // Errors are ignored. Drop this packet and continue.
+        ior = 1;
+      }
+
+      // Discard sent packets.
+      for(int k = 0;  k != ior;  ++k)
+        queue.discard(sizeof(Queued_Packet_Header) + iovs[k].iov_len);
+
+      POSEIDON_LOG_TRACE(("UDP socket `$1` (class `$2`) OUT: $3 packets"), this, typeid(*this), ior);
+    }
   }
 
 void
@@ -234,6 +476,16 @@ leave_multicast_group(const IPv6_Address& maddr, const cow_string& ifname)
         this, typeid(*this), maddr, ifname);
   }
 
+void
+UDP_Socket::
+udp_set_send_queue(uint32_t size, UDP_Drop_Policy policy)
+  {
+    recursive_mutex::unique_lock io_lock;
+    this->do_abstract_socket_lock_write_queue(io_lock);
+    this->m_send_queue_size = size;
+    this->m_drop_policy = policy;
+  }
+
 bool
 UDP_Socket::
 udp_send(const IPv6_Address& addr, chars_view data)
@@ -241,6 +493,15 @@ udp_send(const IPv6_Address& addr, chars_view data)
     if(this->socket_state() >= socket_closing)
       return false;
 
+    recursive_mutex::unique_lock io_lock;
+    auto& queue = this->do_abstract_socket_lock_write_queue(io_lock);
+
+    if(!queue.empty()) {
+      // If a previous write operation would have blocked, append `data` to
+      // `queue`, so packets are sent in order.
+      return this->do_enqueue_packet_nolock(queue, addr, data);
+    }
+
     ::sockaddr_in6 sa = { };
     sa.sin6_family = AF_INET6;
     sa.sin6_port = ::htons(addr.port());
@@ -248,6 +509,11 @@ udp_send(const IPv6_Address& addr, chars_view data)
     ::ssize_t ior = ::sendto(this->do_socket_fd(), data.p, data.n, 0,
                              reinterpret_cast<::sockaddr*>(&sa), sizeof(sa));
     if(ior < 0) {
+      if((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+        // Stash the packet, and wait for the next writability notification.
+        return this->do_enqueue_packet_nolock(queue, addr, data);
+      }
+
       POSEIDON_LOG_DEBUG((
           "UDP socket write error: ${errno:full}",
           "[UDP socket `$1` (class `$2`)]"),
@@ -260,4 +526,133 @@ udp_send(const IPv6_Address& addr, chars_view data)
     return true;
   }
 
+size_t
+UDP_Socket::
+udp_send_batch(const IPv6_Address& addr, const chars_view* data, size_t count)
+  {
+    if(this->socket_state() >= socket_closing)
+      return 0;
+
+    recursive_mutex::unique_lock io_lock;
+    auto& queue = this->do_abstract_socket_lock_write_queue(io_lock);
+    size_t sent = 0;
+    size_t pos = 0;
+
+    if(!queue.empty()) {
+      // If a previous write operation would have blocked, append all packets
+      // to `queue`, so packets are sent in order.
+      while(pos != count)
+        sent += this->do_enqueue_packet_nolock(queue, addr, data[pos++]);
+
+      return sent;
+    }
+
+    ::sockaddr_in6 sa = { };
+    sa.sin6_family = AF_INET6;
+    sa.sin6_port = ::htons(addr.port());
+    sa.sin6_addr = addr.addr();
+
+    bool gso = network_scheduler.udp_gso_enabled() && !this->m_gso_failed.load();
+    ::mmsghdr msgs[s_max_gso_segments];
+    ::iovec iovs[s_max_gso_segments];
+
+    while(pos != count) {
+      size_t run = gso ? do_get_gso_run_length(data + pos, count - pos) : 1;
+      size_t n = 0;
+
+      if(run > 1) {
+        // Send these packets as a super-packet, which will be segmented by
+        // the kernel or the network interface.
+        for(size_t k = 0;  k != run;  ++k) {
+          iovs[k].iov_base = const_cast<char*>(data[pos + k].p);
+          iovs[k].iov_len = data[pos + k].n;
+        }
+
+        Control_Buffer control;
+        ::msghdr hdr = { };
+        hdr.msg_name = &sa;
+        hdr.msg_namelen = sizeof(sa);
+        hdr.msg_iov = iovs;
+        hdr.msg_iovlen = run;
+        hdr.msg_control = control.bytes;
+        hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+
+        auto cmsg = CMSG_FIRSTHDR(&hdr);
+        cmsg->cmsg_level = SOL_UDP;
+        cmsg->cmsg_type = UDP_SEGMENT;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        uint16_t gso_size = static_cast<uint16_t>(data[pos].n);
+        ::memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+
+        if(::sendmsg(this->do_socket_fd(), &hdr, 0) >= 0) {
+          sent += run;
+          pos += run;
+          continue;
+        }
+
+        if((errno == EAGAIN) || (errno == EWOULDBLOCK))
+          break;
+
+        if(errno == EIO) {
+          // The network interface doesn't support checksum offload, which is
+          // required by GSO, so don't try again.
+          POSEIDON_LOG_DEBUG((
+              "UDP GSO not supported: ${errno:full}",
+              "[UDP socket `$1` (class `$2`)]"),
+              this, typeid(*this));
+
+          this->m_gso_failed.store(true);
+          gso = false;
+        }
+
+        // Send these packets individually.
+        n = run;
+      }
+      else {
+        // Send packets up to the next super-packet.
+        n = 1;
+        while((pos + n != count) && (n != s_max_gso_segments)
+              && !(gso && (do_get_gso_run_length(data + pos + n, count - pos - n) > 1)))
+          n ++;
+      }
+
+      for(size_t k = 0;  k != n;  ++k) {
+        iovs[k].iov_base = const_cast<char*>(data[pos + k].p);
+        iovs[k].iov_len = data[pos + k].n;
+
+        auto& hdr = msgs[k].msg_hdr;
+        hdr = { };
+        hdr.msg_name = &sa;
+        hdr.msg_namelen = sizeof(sa);
+        hdr.msg_iov = &(iovs[k]);
+        hdr.msg_iovlen = 1;
+        msgs[k].msg_len = 0;
+      }
+
+      int nmsgs = ::sendmmsg(this->do_socket_fd(), msgs, static_cast<unsigned>(n), 0);
+      if(nmsgs < 0) {
+        if((errno == EAGAIN) || (errno == EWOULDBLOCK))
+          break;
+
+        POSEIDON_LOG_DEBUG((
+            "UDP socket write error: ${errno:full}",
+            "[UDP socket `$1` (class `$2`)]"),
+            this, typeid(*this));
+
+        // Errors are ignored. Drop this packet and continue.
+        pos ++;
+        continue;
+      }
+
+      sent += static_cast<size_t>(nmsgs);
+      pos += static_cast<size_t>(nmsgs);
+    }
+
+    // Stash remaining packets, and wait for the next writability notification.
+    while(pos != count)
+      sent += this->do_enqueue_packet_nolock(queue, addr, data[pos++]);
+
+    return sent;
+  }
+
 }  // namespace poseidon
@@ -4,6 +4,7 @@
 #include "../xprecompiled.hpp"
 #include "../../socket/wss_server_session.hpp"
 #include "../../http/websocket_deflator.hpp"
+#include "../../http/websocket_broadcast_frame.hpp"
 #include "../../utils.hpp"
 namespace poseidon {
 
@@ -347,6 +348,35 @@ wss_send(WS_Opcode opcode, chars_view data)
       }
   }
 
+bool
+WSS_Server_Session::
+wss_send(const WebSocket_Broadcast_Frame& frame)
+  {
+    if(!this->do_has_upgraded())
+      return false;
+
+    if(this->m_pmce_opt) {
+      // The compressed frame doesn't depend on previous messages, but if context
+      // takeover is active, the client will append it to its sliding window,
+      // which our deflator doesn't know about. The deflator must be reset before
+      // the next message, and the mutex must not be unlocked before this frame
+      // is sent completely.
+      cow_string pmce_frame = frame.compressed_frame(this->m_parser.pmce_send_window_bits(),
+                                                     this->m_parser.pmce_compression_level());
+      if(!pmce_frame.empty()) {
+        plain_mutex::unique_lock lock;
+        this->m_pmce_opt->deflate_output_buffer(lock);
+        bool succ = this->ssl_send(pmce_frame);
+        if(!this->m_parser.pmce_send_no_context_takeover())
+          this->m_pmce_opt->deflate_reset(lock);
+        return succ;
+      }
+    }
+
+    // Send the message uncompressed.
+    return this->ssl_send(frame.plain_frame());
+  }
+
 bool
 WSS_Server_Session::
 wss_shut_down(WS_Status status, chars_view reason)
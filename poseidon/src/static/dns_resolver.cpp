@@ -0,0 +1,1235 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../static/dns_resolver.hpp"
+#include "../../static/network_scheduler.hpp"
+#include "../../static/timer_scheduler.hpp"
+#include "../../socket/udp_socket.hpp"
+#include "../../socket/tcp_socket.hpp"
+#include "../../base/abstract_timer.hpp"
+#include "../../base/config_file.hpp"
+#include "../../utils.hpp"
+#include <unordered_map>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/random.h>
+#include <arpa/inet.h>
+namespace poseidon {
+namespace {
+
+// These are from RFC 1035 and RFC 3596.
+constexpr uint16_t s_type_A = 1;
+constexpr uint16_t s_type_CNAME = 5;
+constexpr uint16_t s_type_SOA = 6;
+constexpr uint16_t s_type_AAAA = 28;
+constexpr uint16_t s_type_OPT = 41;
+constexpr uint16_t s_class_IN = 1;
+
+// This is the EDNS0 payload size that has been recommended since the DNS
+// flag day 2020, which avoids IP fragmentation.
+constexpr uint16_t s_edns_payload_size = 1232;
+
+constexpr uint32_t s_max_cname_hops = 8;
+constexpr milliseconds s_timer_period = 200ms;
+
+struct Question
+  {
+    uint16_t type = 0;
+    uint16_t id = 0;
+    bool done = false;
+    bool use_tcp = false;
+    shptr<UDP_Socket> udp;
+    shptr<TCP_Socket> tcp;
+  };
+
+struct Query
+  {
+    phcow_string name;
+    cow_vector<DNS_Resolver::callback_type> callbacks;
+
+    // names to look up in order, according to the search list
+    cow_vector<phcow_string> candidates;
+    size_t candidate = 0;
+
+    // addresses from the hosts file, which are used if no name is found
+    cow_vector<IPv6_Address> fallback;
+
+    // AAAA, A
+    Question questions[2];
+    cow_vector<IPv6_Address> addrs[2];
+    uint32_t ttl = UINT32_MAX;
+    uint32_t negative_ttl = UINT32_MAX;
+
+    uint32_t attempt = 0;
+    steady_time deadline;
+  };
+
+struct Cache_Entry
+  {
+    cow_vector<IPv6_Address> addrs;  // empty if negative
+    steady_time expiry;
+  };
+
+struct Query_Table
+  {
+    mutable plain_mutex mutex;
+
+    // configuration
+    cow_vector<IPv6_Address> servers;
+    seconds timeout = 5s;
+    uint32_t attempts = 2;
+    uint32_t cache_size = 1024;
+    seconds negative_ttl = 30s;
+
+    // queries and results
+    ::std::unordered_map<phcow_string, Cache_Entry, phcow_string::hash> cache;
+    ::std::unordered_map<phcow_string, shptr<Query>, phcow_string::hash> queries;
+    ::std::unordered_map<uint16_t, shptr<Query>> queries_by_id;
+    shptr<Abstract_Timer> timer;
+  };
+
+// Sockets must not be used, and callbacks must not be invoked, with the table
+// locked; otherwise the order of locks would be inverted in the network
+// thread. They are deferred until the table has been unlocked.
+struct Pending_Actions
+  {
+    struct Packet
+      {
+        shptr<UDP_Socket> udp;
+        IPv6_Address addr;
+        cow_string data;
+      };
+
+    struct Completion
+      {
+        cow_vector<DNS_Resolver::callback_type> callbacks;
+        cow_vector<IPv6_Address> addrs;
+        const char* error;
+      };
+
+    shptr<Abstract_Timer> new_timer;
+    ::std::vector<Packet> udp_packets;
+    ::std::vector<pair<shptr<TCP_Socket>, Packet>> tcp_packets;
+    ::std::vector<shptr<Abstract_Socket>> closed_sockets;
+    ::std::vector<Completion> completions;
+  };
+
+void
+do_process_response(const shptr<Query_Table>& table, const Abstract_Socket* socket,
+                    const IPv6_Address* from, chars_view data);
+
+void
+do_check_timeouts(const shptr<Query_Table>& table, steady_time now);
+
+struct DNS_UDP_Socket final : UDP_Socket
+  {
+    wkptr<Query_Table> m_wtable;
+
+    explicit
+    DNS_UDP_Socket(const shptr<Query_Table>& table)
+      :
+        m_wtable(table)
+      { }
+
+    virtual
+    void
+    do_on_udp_packet(IPv6_Address&& addr, linear_buffer&& data)
+      override
+      {
+        auto table = this->m_wtable.lock();
+        if(!table)
+          return;
+
+        do_process_response(table, this, &addr, data);
+      }
+  };
+
+struct DNS_TCP_Socket final : TCP_Socket
+  {
+    wkptr<Query_Table> m_wtable;
+
+    explicit
+    DNS_TCP_Socket(const shptr<Query_Table>& table)
+      :
+        m_wtable(table)
+      { }
+
+    virtual
+    void
+    do_on_tcp_connected()
+      override
+      {
+        // The query has been enqueued before connection, so there is nothing
+        // to do here.
+      }
+
+    virtual
+    void
+    do_on_tcp_stream(linear_buffer& data, bool /*eof*/)
+      override
+      {
+        // Each message is prefixed with its length.
+        if(data.size() < 2)
+          return;
+
+        size_t len = ::asteria::load_be<uint16_t>(data.data());
+        if(data.size() < 2 + len)
+          return;
+
+        auto table = this->m_wtable.lock();
+        if(table)
+          do_process_response(table, this, nullptr, chars_view(data.data() + 2, len));
+
+        data.discard(2 + len);
+        this->tcp_shut_down();
+      }
+  };
+
+struct DNS_Timer final : Abstract_Timer
+  {
+    wkptr<Query_Table> m_wtable;
+
+    explicit
+    DNS_Timer(const shptr<Query_Table>& table)
+      :
+        m_wtable(table)
+      { }
+
+    virtual
+    void
+    do_abstract_timer_on_tick(steady_time now)
+      override
+      {
+        auto table = this->m_wtable.lock();
+        if(!table)
+          return;
+
+        do_check_timeouts(table, now);
+      }
+  };
+
+bool
+do_normalize_host_name(phcow_string& name, chars_view host)
+  {
+    // Remove the trailing dot of a fully qualified name.
+    if((host.n != 0) && (host.p[host.n - 1] == '.'))
+      host.n --;
+
+    if((host.n == 0) || (host.n > 253))
+      return false;
+
+    cow_string str;
+    str.reserve(host.n);
+    size_t label_len = 0;
+
+    for(size_t k = 0;  k != host.n;  ++k) {
+      char ch = host.p[k];
+      if(ch == '.') {
+        // Empty labels are not allowed.
+        if(label_len == 0)
+          return false;
+
+        label_len = 0;
+        str.push_back(ch);
+        continue;
+      }
+
+      // Names are case-insensitive.
+      if((ch >= 'A') && (ch <= 'Z'))
+        ch = static_cast<char>(ch - 'A' + 'a');
+      else if(!(((ch >= 'a') && (ch <= 'z')) || ((ch >= '0') && (ch <= '9'))
+                || (ch == '-') || (ch == '_')))
+        return false;
+
+      label_len ++;
+      if(label_len > 63)
+        return false;
+
+      str.push_back(ch);
+    }
+
+    if(label_len == 0)
+      return false;
+
+    name = str;
+    return true;
+  }
+
+bool
+do_parse_ip_literal(IPv6_Address& addr, chars_view host)
+  {
+    // IPv6 addresses may be enclosed in brackets, like in URLs.
+    char str[64];
+    if((host.n >= 2) && (host.p[0] == '[') && (host.p[host.n - 1] == ']')) {
+      host.p ++;
+      host.n -= 2;
+    }
+
+    if(host.n >= sizeof(str))
+      return false;
+
+    ::memcpy(str, host.p, host.n);
+    str[host.n] = 0;
+
+    ::in_addr v4addr;
+    if(::inet_pton(AF_INET, str, &v4addr) == 1) {
+      addr = ipv4_unspecified;
+      ::memcpy(addr.mut_data() + 12, &v4addr, 4);
+      return true;
+    }
+
+    ::in6_addr v6addr;
+    if(::inet_pton(AF_INET6, str, &v6addr) == 1) {
+      addr = IPv6_Address(v6addr, 0);
+      return true;
+    }
+
+    return false;
+  }
+
+void
+do_sort_addresses(cow_vector<IPv6_Address>& addrs)
+  {
+    // Put IPv6 addresses before IPv4 ones, like `getaddrinfo()` does.
+    cow_vector<IPv6_Address> sorted;
+    for(const auto& addr : addrs)
+      if(!addr.is_v4mapped())
+        sorted.push_back(addr);
+
+    for(const auto& addr : addrs)
+      if(addr.is_v4mapped())
+        sorted.push_back(addr);
+
+    addrs.swap(sorted);
+  }
+
+cow_string
+do_read_text_file_opt(const cow_string& path)
+  {
+    cow_string text;
+    unique_posix_fd fd(::open(path.safe_c_str(), O_RDONLY | O_NOCTTY | O_CLOEXEC, 0));
+    if(!fd) {
+      // A missing file is not an error.
+      if(errno == ENOENT)
+        return text;
+
+      POSEIDON_THROW((
+          "Could not open file `$1` for reading",
+          "[`open()` failed: ${errno:full}]"),
+          path);
+    }
+
+    for(;;) {
+      char buf[4096];
+      ::ssize_t ior = POSEIDON_SYSCALL_LOOP(::read(fd, buf, sizeof(buf)));
+      if(ior < 0)
+        POSEIDON_THROW((
+            "Could not read file `$1`",
+            "[`read()` failed: ${errno:full}]"),
+            path);
+
+      if(ior == 0)
+        break;
+
+      text.append(buf, static_cast<size_t>(ior));
+    }
+    return text;
+  }
+
+template<typename xCallback>
+void
+do_for_each_line(const cow_string& text, xCallback&& callback)
+  {
+    // Split lines into words, and remove comments.
+    cow_vector<cow_string> words;
+    const char* bp = text.data();
+    const char* const ep = bp + text.size();
+
+    while(bp != ep) {
+      words.clear();
+      bool comment = false;
+
+      while((bp != ep) && (*bp != '\n')) {
+        char ch = *bp++;
+        if((ch == '#') || (ch == ';'))
+          comment = true;
+        else if(comment)
+          continue;
+        else if((ch == ' ') || (ch == '\t') || (ch == '\r'))
+          words.emplace_back();
+        else if(words.empty())
+          words.emplace_back(1, ch);
+        else
+          words.mut_back().push_back(ch);
+      }
+
+      if(bp != ep)
+        bp ++;
+
+      // Remove empty words which are caused by consecutive spaces.
+      cow_vector<cow_string> temp;
+      for(const auto& word : words)
+        if(word != "")
+          temp.push_back(word);
+
+      if(!temp.empty())
+        callback(temp);
+    }
+  }
+
+void
+do_put_be16(cow_string& data, uint16_t value)
+  {
+    char bytes[2];
+    ::asteria::store_be<uint16_t>(bytes, value);
+    data.append(bytes, 2);
+  }
+
+cow_string
+do_encode_query(uint16_t id, const phcow_string& name, uint16_t type)
+  {
+    cow_string data;
+    data.reserve(64);
+
+    // ID; RD; QDCOUNT = 1; ANCOUNT = 0; NSCOUNT = 0; ARCOUNT = 1
+    do_put_be16(data, id);
+    do_put_be16(data, 0x0100);
+    do_put_be16(data, 1);
+    do_put_be16(data, 0);
+    do_put_be16(data, 0);
+    do_put_be16(data, 1);
+
+    // QNAME, as a sequence of labels; QTYPE; QCLASS
+    const char* bp = name.data();
+    const char* const ep = bp + name.size();
+    while(bp != ep) {
+      const char* dp = ::std::find(bp, ep, '.');
+      data.push_back(static_cast<char>(dp - bp));
+      data.append(bp, static_cast<size_t>(dp - bp));
+      bp = dp + (dp != ep);
+    }
+    data.push_back('\0');
+    do_put_be16(data, type);
+    do_put_be16(data, s_class_IN);
+
+    // OPT pseudo-record for EDNS0 (RFC 6891), where CLASS is the UDP payload
+    // size; TTL = 0; RDLENGTH = 0
+    data.push_back('\0');
+    do_put_be16(data, s_type_OPT);
+    do_put_be16(data, s_edns_payload_size);
+    do_put_be16(data, 0);
+    do_put_be16(data, 0);
+    do_put_be16(data, 0);
+    return data;
+  }
+
+bool
+do_read_name(cow_string& name, chars_view msg, size_t& offset)
+  {
+    // Names may be compressed with pointers to previous names (RFC 1035
+    // 4.1.4). Pointers may point to further pointers, but they can't form a
+    // loop, so we limit the number of them.
+    name.clear();
+    size_t pos = offset;
+    uint32_t jumps = 0;
+
+    for(;;) {
+      if(pos >= msg.n)
+        return false;
+
+      size_t len = static_cast<uint8_t>(msg.p[pos]);
+      if(len == 0) {
+        if(jumps == 0)
+          offset = pos + 1;
+        return true;
+      }
+
+      if((len & 0xC0) == 0xC0) {
+        // pointer
+        if(pos + 2 > msg.n)
+          return false;
+
+        if(jumps == 0)
+          offset = pos + 2;
+
+        jumps ++;
+        if(jumps > 32)
+          return false;
+
+        pos = ::asteria::load_be<uint16_t>(msg.p + pos) & 0x3FFFU;
+        continue;
+      }
+
+      if(len > 63)
+        return false;
+
+      // label
+      if(pos + 1 + len > msg.n)
+        return false;
+
+      if(name.size() != 0)
+        name.push_back('.');
+
+      for(size_t k = 0;  k != len;  ++k) {
+        char ch = msg.p[pos + 1 + k];
+        if((ch >= 'A') && (ch <= 'Z'))
+          ch = static_cast<char>(ch - 'A' + 'a');
+        name.push_back(ch);
+      }
+
+      if(name.size() > 255)
+        return false;
+
+      pos += 1 + len;
+    }
+  }
+
+struct Resource_Record
+  {
+    phcow_string name;
+    uint16_t type;
+    uint32_t ttl;
+    IPv6_Address addr;  // A or AAAA
+    phcow_string cname;  // CNAME
+  };
+
+struct Response
+  {
+    uint16_t id;
+    uint16_t flags;
+    phcow_string qname;
+    uint16_t qtype;
+    ::std::vector<Resource_Record> answers;
+    uint32_t soa_ttl = UINT32_MAX;
+  };
+
+bool
+do_parse_response(Response& resp, chars_view msg)
+  {
+    if(msg.n < 12)
+      return false;
+
+    resp.id = ::asteria::load_be<uint16_t>(msg.p);
+    resp.flags = ::asteria::load_be<uint16_t>(msg.p + 2);
+    uint32_t qdcount = ::asteria::load_be<uint16_t>(msg.p + 4);
+    uint32_t ancount = ::asteria::load_be<uint16_t>(msg.p + 6);
+    uint32_t nscount = ::asteria::load_be<uint16_t>(msg.p + 8);
+
+    // This must be a response to a standard query.
+    if(((resp.flags & 0x8000) == 0) || ((resp.flags & 0x7800) != 0) || (qdcount != 1))
+      return false;
+
+    size_t offset = 12;
+    cow_string name;
+    if(!do_read_name(name, msg, offset) || (offset + 4 > msg.n))
+      return false;
+
+    resp.qname = name;
+    resp.qtype = ::asteria::load_be<uint16_t>(msg.p + offset);
+    offset += 4;
+
+    // If the response has been truncated, records may be incomplete.
+    if(resp.flags & 0x0200)
+      return true;
+
+    for(uint32_t k = 0;  k != ancount + nscount;  ++k) {
+      Resource_Record rr;
+      if(!do_read_name(name, msg, offset) || (offset + 10 > msg.n))
+        return false;
+
+      rr.name = name;
+      rr.type = ::asteria::load_be<uint16_t>(msg.p + offset);
+      rr.ttl = ::asteria::load_be<uint32_t>(msg.p + offset + 4) & 0x7FFFFFFFU;
+      size_t rdlen = ::asteria::load_be<uint16_t>(msg.p + offset + 8);
+      offset += 10;
+
+      if(offset + rdlen > msg.n)
+        return false;
+
+      size_t rdoff = offset;
+      offset += rdlen;
+
+      if(::asteria::load_be<uint16_t>(msg.p + rdoff - 8) != s_class_IN)
+        continue;
+
+      if(k >= ancount) {
+        // Get the negative TTL from an SOA record in the authority section,
+        // which is the minimum of its own TTL and its MINIMUM field (RFC 2308).
+        if(rr.type != s_type_SOA)
+          continue;
+
+        if(!do_read_name(name, msg, rdoff) || !do_read_name(name, msg, rdoff))
+          return false;
+
+        if(rdoff + 20 > offset)
+          return false;
+
+        uint32_t minimum = ::asteria::load_be<uint32_t>(msg.p + rdoff + 16);
+        resp.soa_ttl = ::std::min({ resp.soa_ttl, rr.ttl, minimum });
+        continue;
+      }
+
+      if((rr.type == s_type_A) && (rdlen == 4)) {
+        rr.addr = ipv4_unspecified;
+        ::memcpy(rr.addr.mut_data() + 12, msg.p + rdoff, 4);
+      }
+      else if((rr.type == s_type_AAAA) && (rdlen == 16))
+        ::memcpy(rr.addr.mut_data(), msg.p + rdoff, 16);
+      else if(rr.type == s_type_CNAME) {
+        if(!do_read_name(name, msg, rdoff))
+          return false;
+
+        rr.cname = name;
+      }
+      else
+        continue;
+
+      resp.answers.push_back(move(rr));
+    }
+    return true;
+  }
+
+uint16_t
+do_allocate_id_nolock(const Query_Table& table)
+  {
+    // IDs must be unpredictable, which makes spoofing harder (RFC 5452).
+    uint16_t id;
+    do
+      if(::getrandom(&id, sizeof(id), 0) != sizeof(id))
+        POSEIDON_THROW((
+            "Could not generate DNS query ID",
+            "[`getrandom()` failed: ${errno:full}]"));
+    while(table.queries_by_id.count(id) != 0);
+    return id;
+  }
+
+void
+do_send_question_nolock(const shptr<Query_Table>& table, const Query& query, Question& qn,
+                        const IPv6_Address& server, Pending_Actions& act)
+  {
+    cow_string data = do_encode_query(qn.id, query.candidates.at(query.candidate), qn.type);
+
+    // Each message is sent from a new socket, so its source port is chosen
+    // randomly by the system, and a response is only accepted from the socket
+    // of its question (RFC 5452).
+    if(qn.udp)
+      act.closed_sockets.push_back(move(qn.udp));
+
+    if(qn.tcp)
+      act.closed_sockets.push_back(move(qn.tcp));
+
+    if(!qn.use_tcp) {
+      qn.udp = new_sh<DNS_UDP_Socket>(table);
+      auto& packet = act.udp_packets.emplace_back();
+      packet.udp = qn.udp;
+      packet.addr = server;
+      packet.data = move(data);
+      return;
+    }
+
+    // Open a new connection. Messages over TCP are prefixed with their
+    // lengths.
+    qn.tcp = new_sh<DNS_TCP_Socket>(table);
+    auto& r = act.tcp_packets.emplace_back();
+    r.first = qn.tcp;
+    r.second.addr = server;
+    do_put_be16(r.second.data, static_cast<uint16_t>(data.size()));
+    r.second.data.append(data);
+  }
+
+void
+do_send_query_nolock(const shptr<Query_Table>& table, Query& query, Pending_Actions& act,
+                     steady_time now)
+  {
+    // Try name servers in a round-robin way.
+    const auto& server = table->servers.at(query.attempt % table->servers.size());
+    query.deadline = now + table->timeout;
+
+    for(auto& qn : query.questions)
+      if(!qn.done)
+        do_send_question_nolock(table, query, qn, server, act);
+  }
+
+void
+do_start_query_nolock(const shptr<Query_Table>& table, const shptr<Query>& query,
+                      Pending_Actions& act, steady_time now)
+  {
+    // Send A and AAAA queries in parallel for the current candidate name.
+    query->questions[0].type = s_type_AAAA;
+    query->questions[1].type = s_type_A;
+    query->attempt = 0;
+
+    for(auto& qn : query->questions) {
+      qn.id = do_allocate_id_nolock(*table);
+      qn.done = false;
+      qn.use_tcp = false;
+      table->queries_by_id.emplace(qn.id, query);
+    }
+
+    POSEIDON_LOG_DEBUG(("Looking up `$1` from DNS"), query->candidates.at(query->candidate));
+    do_send_query_nolock(table, *query, act, now);
+  }
+
+void
+do_insert_cache_nolock(Query_Table& table, const phcow_string& name,
+                       const cow_vector<IPv6_Address>& addrs, uint32_t ttl, steady_time now)
+  {
+    if((table.cache_size == 0) || (ttl == 0))
+      return;
+
+    if((table.cache.size() >= table.cache_size) && (table.cache.count(name) == 0)) {
+      // Remove expired entries first. If the cache is still full, remove the
+      // entry that is going to expire first.
+      for(auto it = table.cache.begin();  it != table.cache.end();  )
+        if(it->second.expiry <= now)
+          it = table.cache.erase(it);
+        else
+          ++ it;
+
+      if(table.cache.size() >= table.cache_size) {
+        auto victim = table.cache.begin();
+        for(auto it = table.cache.begin();  it != table.cache.end();  ++it)
+          if(it->second.expiry < victim->second.expiry)
+            victim = it;
+
+        table.cache.erase(victim);
+      }
+    }
+
+    auto& entry = table.cache[name];
+    entry.addrs = addrs;
+    entry.expiry = now + seconds(ttl);
+  }
+
+void
+do_finish_query_nolock(Query_Table& table, const shptr<Query>& query, Pending_Actions& act,
+                       steady_time now, const char* error)
+  {
+    table.queries.erase(query->name);
+
+    for(auto& qn : query->questions) {
+      if(!qn.done)
+        table.queries_by_id.erase(qn.id);
+
+      if(qn.udp)
+        act.closed_sockets.push_back(move(qn.udp));
+
+      if(qn.tcp)
+        act.closed_sockets.push_back(move(qn.tcp));
+    }
+
+    auto& r = act.completions.emplace_back();
+    r.callbacks.swap(query->callbacks);
+    r.error = error;
+
+    r.addrs = query->addrs[0];
+    for(const auto& addr : query->addrs[1])
+      r.addrs.push_back(addr);
+
+    if(r.addrs.empty() && !query->fallback.empty()) {
+      // Use addresses from the hosts file, which come after DNS.
+      r.addrs = query->fallback;
+      r.error = nullptr;
+      return;
+    }
+
+    // Timeouts and server failures are not cached.
+    if(error)
+      return;
+
+    uint32_t ttl = query->ttl;
+    if(r.addrs.empty()) {
+      // Negative responses are cached only if they contain SOA records.
+      r.error = "host not found";
+      ttl = ::std::min(query->negative_ttl, static_cast<uint32_t>(table.negative_ttl.count()));
+      if(query->negative_ttl == UINT32_MAX)
+        ttl = 0;
+    }
+
+    do_insert_cache_nolock(table, query->name, r.addrs, ttl, now);
+  }
+
+void
+do_retry_query_nolock(const shptr<Query_Table>& table, const shptr<Query>& query,
+                      Pending_Actions& act, steady_time now, const char* error)
+  {
+    query->attempt ++;
+    if(query->attempt >= table->attempts * table->servers.size())
+      return do_finish_query_nolock(*table, query, act, now, error);
+
+    POSEIDON_LOG_DEBUG(("Retrying DNS query for `$1`: $2"), query->name, error);
+    do_send_query_nolock(table, *query, act, now);
+  }
+
+void
+do_perform_actions(Pending_Actions& act)
+  {
+    if(act.new_timer)
+      timer_scheduler.insert_weak(act.new_timer, s_timer_period, s_timer_period);
+
+    for(const auto& packet : act.udp_packets) {
+      network_scheduler.insert_weak(packet.udp);
+      packet.udp->udp_send(packet.addr, packet.data);
+    }
+
+    for(const auto& r : act.tcp_packets) {
+      ::sockaddr_in6 sa = { };
+      sa.sin6_family = AF_INET6;
+      sa.sin6_addr = r.second.addr.addr();
+      sa.sin6_port = ::htons(r.second.addr.port());
+      if((::connect(r.first->fd(), reinterpret_cast<const ::sockaddr*>(&sa), sizeof(sa)) != 0)
+         && (errno != EINPROGRESS)) {
+        // This query will time out.
+        POSEIDON_LOG_WARN((
+            "Could not connect to DNS server `$1`",
+            "[`connect()` failed: ${errno:full}]"),
+            r.second.addr);
+        continue;
+      }
+
+      // Data are sent after the connection has been established.
+      r.first->tcp_send(r.second.data);
+      network_scheduler.insert_weak(r.first);
+    }
+
+    for(const auto& socket : act.closed_sockets)
+      socket->quick_shut_down();
+
+    for(const auto& r : act.completions)
+      for(const auto& callback : r.callbacks)
+        try {
+          callback(r.addrs, r.error);
+        }
+        catch(exception& stdex) {
+          POSEIDON_LOG_ERROR(("Unhandled exception in DNS callback: $1"), stdex);
+        }
+  }
+
+void
+do_process_response(const shptr<Query_Table>& table, const Abstract_Socket* socket,
+                    const IPv6_Address* from, chars_view data)
+  {
+    Response resp;
+    if(!do_parse_response(resp, data)) {
+      POSEIDON_LOG_DEBUG(("Ignoring invalid DNS message from `$1`"), from ? *from : ipv6_unspecified);
+      return;
+    }
+
+    Pending_Actions act;
+    plain_mutex::unique_lock lock(table->mutex);
+    const steady_time now = steady_clock::now();
+
+    auto qit = table->queries_by_id.find(resp.id);
+    if(qit == table->queries_by_id.end())
+      return;
+
+    // Check whether this is a response to an outstanding question. Responses
+    // from unknown sources, or via other sockets, are ignored, which makes
+    // spoofing harder.
+    auto query = qit->second;
+    Question* qn = nullptr;
+    for(auto& r : query->questions)
+      if((r.id == resp.id) && !r.done)
+        qn = &r;
+
+    if(!qn || (qn->type != resp.qtype) || (resp.qname != query->candidates.at(query->candidate)))
+      return;
+
+    if((socket != qn->udp.get()) && (socket != qn->tcp.get()))
+      return;
+
+    if(from && is_none_of(*from, table->servers))
+      return;
+
+    if(resp.flags & 0x0200) {
+      // The response has been truncated, so ask the same server over TCP.
+      if(from) {
+        qn->use_tcp = true;
+        do_send_question_nolock(table, *query, *qn, *from, act);
+      }
+    }
+    else if(is_any_of(resp.flags & 0x000F, { 0, 3 })) {
+      // NOERROR or NXDOMAIN; Follow the CNAME chain from the question.
+      size_t index = static_cast<size_t>(qn - query->questions);
+      qn->done = true;
+      table->queries_by_id.erase(qn->id);
+      if(qn->udp)
+        act.closed_sockets.push_back(move(qn->udp));
+
+      if(qn->tcp)
+        act.closed_sockets.push_back(move(qn->tcp));
+
+      phcow_string target = resp.qname;
+      uint32_t ttl = UINT32_MAX;
+      for(uint32_t hops = 0;  hops != s_max_cname_hops;  ++hops) {
+        auto rr = ::std::find_if(resp.answers.begin(), resp.answers.end(),
+                      [&](const Resource_Record& x) {
+                        return (x.type == s_type_CNAME) && (x.name == target);  });
+        if(rr == resp.answers.end())
+          break;
+
+        target = rr->cname;
+        ttl = ::std::min(ttl, rr->ttl);
+      }
+
+      for(const auto& rr : resp.answers)
+        if((rr.type == qn->type) && (rr.name == target) && is_none_of(rr.addr, query->addrs[index])) {
+          POSEIDON_LOG_DEBUG(("Received DNS record: `$1` => `$2`"), query->name, rr.addr);
+          query->addrs[index].push_back(rr.addr);
+          query->ttl = ::std::min({ query->ttl, ttl, rr.ttl });
+        }
+
+      if(query->addrs[index].empty())
+        query->negative_ttl = ::std::min(query->negative_ttl, resp.soa_ttl);
+
+      if(query->questions[0].done && query->questions[1].done) {
+        if(query->addrs[0].empty() && query->addrs[1].empty()
+           && (query->candidate + 1 < query->candidates.size())) {
+          // The name has not been found, so try the next one in the search
+          // list, like the resolver of glibc.
+          query->candidate ++;
+          do_start_query_nolock(table, query, act, now);
+        }
+        else
+          do_finish_query_nolock(*table, query, act, now, nullptr);
+      }
+    }
+    else {
+      // SERVFAIL, REFUSED, etc. Try the next server.
+      do_retry_query_nolock(table, query, act, now, "server failure");
+    }
+
+    lock.unlock();
+    do_perform_actions(act);
+  }
+
+void
+do_check_timeouts(const shptr<Query_Table>& table, steady_time now)
+  {
+    Pending_Actions act;
+    plain_mutex::unique_lock lock(table->mutex);
+
+    ::std::vector<shptr<Query>> expired;
+    for(const auto& r : table->queries)
+      if(r.second->deadline <= now)
+        expired.push_back(r.second);
+
+    for(const auto& query : expired)
+      do_retry_query_nolock(table, query, act, now, "timed out");
+
+    lock.unlock();
+    do_perform_actions(act);
+  }
+
+}  // namespace
+
+POSEIDON_HIDDEN_X_STRUCT(DNS_Resolver,
+  Query_Table);
+
+DNS_Resolver::
+DNS_Resolver()
+  noexcept
+  {
+  }
+
+DNS_Resolver::
+~DNS_Resolver()
+  {
+  }
+
+void
+DNS_Resolver::
+reload(const Config_File& conf_file)
+  {
+    // Read paths from configuration.
+    cow_string resolv_conf_path = conf_file.get_string_opt(
+                      &"network.dns.resolv_conf_path").value_or(&"/etc/resolv.conf");
+    cow_string hosts_path = conf_file.get_string_opt(
+                      &"network.dns.hosts_path").value_or(&"/etc/hosts");
+    cow_string nsswitch_conf_path = conf_file.get_string_opt(
+                      &"network.dns.nsswitch_conf_path").value_or(&"/etc/nsswitch.conf");
+
+    // Read cache settings from configuration.
+    uint32_t cache_size = static_cast<uint32_t>(conf_file.get_integer_opt(
+                      &"network.dns.cache_size", 0, INT_MAX).value_or(1024));
+    seconds negative_ttl = seconds(static_cast<int>(conf_file.get_integer_opt(
+                      &"network.dns.negative_ttl", 0, 86400).value_or(30)));
+
+    // Read the delay for Happy Eyeballs. RFC 8305 recommends 250 ms, and
+    // requires no less than 10 ms.
+    milliseconds connection_attempt_delay = milliseconds(static_cast<int>(conf_file.get_integer_opt(
+                      &"network.dns.connection_attempt_delay", 10, 10000).value_or(250)));
+
+    // Read name servers and options from 'resolv.conf', like the resolver
+    // of glibc.
+    cow_vector<IPv6_Address> servers;
+    cow_vector<phcow_string> search;
+    uint32_t ndots = 1;
+    seconds timeout = 5s;
+    uint32_t attempts = 2;
+
+    cow_string text = do_read_text_file_opt(resolv_conf_path);
+    do_for_each_line(text,
+      [&](const cow_vector<cow_string>& words)
+        {
+          if((words[0] == "nameserver") && (words.size() >= 2)) {
+            // Scope IDs are not supported.
+            IPv6_Address addr;
+            size_t pos = words[1].find('%');
+            if(do_parse_ip_literal(addr, chars_view(words[1].data(), ::std::min(pos, words[1].size()))))
+              servers.emplace_back(addr, 53);
+          }
+          else if((words[0] == "search") || (words[0] == "domain")) {
+            // The last one of them takes precedence. `domain` has only one
+            // name.
+            size_t end = (words[0] == "domain") ? 2 : words.size();
+            search.clear();
+            for(size_t k = 1;  k < ::std::min(end, words.size());  ++k) {
+              phcow_string name;
+              if(do_normalize_host_name(name, words[k]) && is_none_of(name, search))
+                search.push_back(name);
+            }
+          }
+          else if(words[0] == "options")
+            for(size_t k = 1;  k < words.size();  ++k)
+              if(::strncmp(words[k].c_str(), "ndots:", 6) == 0)
+                ndots = static_cast<uint32_t>(::asteria::clamp(::atoi(words[k].c_str() + 6), 0, 15));
+              else if(::strncmp(words[k].c_str(), "timeout:", 8) == 0)
+                timeout = seconds(::asteria::clamp(::atoi(words[k].c_str() + 8), 1, 30));
+              else if(::strncmp(words[k].c_str(), "attempts:", 9) == 0)
+                attempts = static_cast<uint32_t>(::asteria::clamp(::atoi(words[k].c_str() + 9), 1, 5));
+        });
+
+    // Name servers from 'main.conf' take precedence.
+    size_t count = conf_file.get_array_size_opt(&"network.dns.name_servers").value_or(0);
+    if(count != 0) {
+      servers.clear();
+      for(size_t k = 0;  k != count;  ++k)
+        servers.emplace_back(conf_file.get_string(sformat("network.dns.name_servers[$1]", k)));
+    }
+
+    if(servers.empty())
+      servers.emplace_back(ipv4_loopback, 53);
+
+    // Read static hosts.
+    cow_dictionary<cow_vector<IPv6_Address>> hosts;
+    text = do_read_text_file_opt(hosts_path);
+    do_for_each_line(text,
+      [&](const cow_vector<cow_string>& words)
+        {
+          IPv6_Address addr;
+          if(!do_parse_ip_literal(addr, words[0]))
+            return;
+
+          for(size_t k = 1;  k < words.size();  ++k) {
+            phcow_string name;
+            if(do_normalize_host_name(name, words[k]) && is_none_of(addr, hosts[name]))
+              hosts[name].push_back(addr);
+          }
+        });
+
+    // Read the order of the hosts file and DNS from 'nsswitch.conf'. If the
+    // file doesn't exist, the hosts file is looked up first. Other sources and
+    // actions are ignored.
+    bool use_hosts = true;
+    bool hosts_first = true;
+    text = do_read_text_file_opt(nsswitch_conf_path);
+    do_for_each_line(text,
+      [&](const cow_vector<cow_string>& words)
+        {
+          if(::strncmp(words[0].c_str(), "hosts:", 6) != 0)
+            return;
+
+          size_t files_pos = SIZE_MAX;
+          size_t dns_pos = SIZE_MAX;
+          for(size_t k = 0;  k < words.size();  ++k) {
+            const char* str = words[k].c_str() + ((k == 0) ? 6 : 0);
+            if((::strcmp(str, "files") == 0) && (files_pos == SIZE_MAX))
+              files_pos = k;
+            else if((::strcmp(str, "dns") == 0) && (dns_pos == SIZE_MAX))
+              dns_pos = k;
+          }
+
+          use_hosts = files_pos != SIZE_MAX;
+          hosts_first = files_pos < dns_pos;
+        });
+
+    // Set up new data.
+    plain_mutex::unique_lock lock(this->m_conf_mutex);
+    this->m_conf_hosts.swap(hosts);
+    this->m_conf_use_hosts = use_hosts;
+    this->m_conf_hosts_first = hosts_first;
+    this->m_conf_search.swap(search);
+    this->m_conf_ndots = ndots;
+    this->m_conf_connection_attempt_delay = connection_attempt_delay;
+
+    if(!this->m_table)
+      this->m_table = new_sh<X_Query_Table>();
+
+    auto table = this->m_table;
+    lock.unlock();
+
+    // Queries in progress are not affected, except that they will be retried
+    // with the new servers.
+    lock.lock(table->mutex);
+    table->servers.swap(servers);
+    table->timeout = timeout;
+    table->attempts = attempts;
+    table->cache_size = cache_size;
+    table->negative_ttl = negative_ttl;
+    table->cache.clear();
+  }
+
+milliseconds
+DNS_Resolver::
+connection_attempt_delay()
+  const noexcept
+  {
+    plain_mutex::unique_lock lock(this->m_conf_mutex);
+    return this->m_conf_connection_attempt_delay;
+  }
+
+void
+DNS_Resolver::
+resolve(const cow_string& host, const callback_type& callback)
+  {
+    if(!callback)
+      POSEIDON_THROW(("Null DNS callback not valid"));
+
+    // Numeric addresses need no lookup.
+    cow_vector<IPv6_Address> addrs;
+    IPv6_Address addr;
+    if(do_parse_ip_literal(addr, host)) {
+      addrs.push_back(addr);
+      callback(addrs, nullptr);
+      return;
+    }
+
+    phcow_string name;
+    if(!do_normalize_host_name(name, host)) {
+      callback(addrs, "invalid host name");
+      return;
+    }
+
+    // Names with a trailing dot are absolute, and are not subject to the
+    // search list.
+    bool absolute = host.back() == '.';
+    cow_vector<IPv6_Address> fallback;
+    cow_vector<phcow_string> candidates;
+
+    plain_mutex::unique_lock lock(this->m_conf_mutex);
+    auto hit = this->m_conf_hosts.find(name);
+    if(this->m_conf_use_hosts && (hit != this->m_conf_hosts.end())) {
+      if(this->m_conf_hosts_first)
+        addrs = hit->second;
+      else
+        fallback = hit->second;
+    }
+
+    if(absolute || this->m_conf_search.empty())
+      candidates.push_back(name);
+    else {
+      // Like the resolver of glibc, if the name has at least `ndots` dots, it
+      // is looked up as is first; otherwise, it is looked up as is after all
+      // names in the search list.
+      size_t dots = static_cast<size_t>(::std::count(name.data(), name.data() + name.size(), '.'));
+      if(dots >= this->m_conf_ndots)
+        candidates.push_back(name);
+
+      for(const auto& domain : this->m_conf_search)
+        if(name.size() + 1 + domain.size() <= 253) {
+          cow_string str(name.data(), name.size());
+          str.push_back('.');
+          str.append(domain.data(), domain.size());
+          candidates.emplace_back(str);
+        }
+
+      if(dots < this->m_conf_ndots)
+        candidates.push_back(name);
+
+      // The result of a relative name may differ from that of the absolute
+      // one, so it's cached with a suffix that can't appear in host names.
+      cow_string str(name.data(), name.size());
+      str.push_back('~');
+      name = str;
+    }
+
+    auto table = this->m_table;
+    lock.unlock();
+
+    if(!addrs.empty()) {
+      do_sort_addresses(addrs);
+      callback(addrs, nullptr);
+      return;
+    }
+
+    if(!table)
+      POSEIDON_THROW(("DNS resolver not initialized"));
+
+    // Check for a cached result. If the name has not been found, addresses
+    // from the hosts file are used instead.
+    do_sort_addresses(fallback);
+    Pending_Actions act;
+    lock.lock(table->mutex);
+    const steady_time now = steady_clock::now();
+
+    auto cit = table->cache.find(name);
+    if(cit != table->cache.end()) {
+      if(now < cit->second.expiry) {
+        addrs = cit->second.addrs;
+        lock.unlock();
+
+        if(addrs.empty())
+          addrs = fallback;
+
+        callback(addrs, addrs.empty() ? "host not found" : nullptr);
+        return;
+      }
+
+      table->cache.erase(cit);
+    }
+
+    // If a query for the same host is in progress, wait for it.
+    auto qit = table->queries.find(name);
+    if(qit != table->queries.end()) {
+      qit->second->callbacks.push_back(callback);
+      return;
+    }
+
+    if(!table->timer) {
+      // Create the timer upon the first query.
+      table->timer = new_sh<DNS_Timer>(table);
+      act.new_timer = table->timer;
+    }
+
+    auto query = new_sh<Query>();
+    query->name = name;
+    query->callbacks.push_back(callback);
+    query->candidates.swap(candidates);
+    query->fallback.swap(fallback);
+
+    table->queries.emplace(name, query);
+    do_start_query_nolock(table, query, act, now);
+    lock.unlock();
+
+    do_perform_actions(act);
+  }
+
+void
+DNS_Resolver::
+clear_cache()
+  noexcept
+  {
+    plain_mutex::unique_lock lock(this->m_conf_mutex);
+    auto table = this->m_table;
+    lock.unlock();
+
+    if(!table)
+      return;
+
+    lock.lock(table->mutex);
+    table->cache.clear();
+  }
+
+}  // namespace poseidon
@@ -242,6 +242,46 @@ do_fiber_yield_function(const shptr<Abstract_Future>& futr_opt)
       POSEIDON_THROW(("Abandoning `$1` (class `$2`)"), s_ep->fiber, typeid(*(s_ep->fiber)));
   }
 
+POSEIDON_VISIBILITY_HIDDEN
+void
+Fiber_Scheduler::
+do_fiber_park_function(milliseconds timeout)
+  {
+    ASTERIA_ASSERT(s_ep);
+    s_ep->wfutr.reset();
+    s_ep->yield_time = steady_clock::now();
+
+    // Set the wakeup time, and publish it so `unpark()` can bring it forward.
+    // If `unpark()` has been called in the meantime, don't block at all.
+    plain_mutex::unique_lock park_lock(s_ep->fiber->m_park_mutex);
+    if(s_ep->fiber->m_park_permit)
+      return;
+
+    s_ep->async_time.store(s_ep->yield_time + timeout);
+    shptr<atomic_relaxed<steady_time>> async_time_ptr(s_ep, &(s_ep->async_time));
+    s_ep->fiber->m_park_waker = async_time_ptr;
+    park_lock.unlock();
+
+    POSEIDON_LOG_TRACE(("Parking `$1` (class `$2`)"), s_ep->fiber, typeid(*(s_ep->fiber)));
+    ASTERIA_ASSERT(s_ep->state == st_running);
+    s_ep->state = st_suspended;
+
+    do_sanitizer_start_switch_fiber();
+    ::swapcontext(s_ep->sched_inner, s_sched_outer);
+    do_sanitizer_finish_switch_fiber();
+
+    POSEIDON_LOG_TRACE(("Unparking `$1` (class `$2`)"), s_ep->fiber, typeid(*(s_ep->fiber)));
+    ASTERIA_ASSERT(s_ep->state == st_suspended);
+    s_ep->state = st_running;
+
+    park_lock.lock(s_ep->fiber->m_park_mutex);
+    s_ep->fiber->m_park_waker.reset();
+    park_lock.unlock();
+
+    if(s_ep->fiber->m_abandoned.load())
+      POSEIDON_THROW(("Abandoning `$1` (class `$2`)"), s_ep->fiber, typeid(*(s_ep->fiber)));
+  }
+
 void
 Fiber_Scheduler::
 reload(const Config_File& conf_file)
@@ -267,11 +307,16 @@ reload(const Config_File& conf_file)
     seconds fail_timeout = seconds(static_cast<int>(conf_file.get_integer_opt(
                                     &"fiber.fail_timeout", 0, 86400).value_or(300)));
 
+    // Read the number of seconds for which an idle fiber may stay parked.
+    seconds park_timeout = seconds(static_cast<int>(conf_file.get_integer_opt(
+                                    &"fiber.park_timeout", 0, 86400).value_or(10)));
+
     // Set up new data.
     plain_mutex::unique_lock lock(this->m_conf_mutex);
     this->m_conf_stack_vm_size = stack_vm_size;
     this->m_conf_warn_timeout = warn_timeout;
     this->m_conf_fail_timeout = fail_timeout;
+    this->m_conf_park_timeout = park_timeout;
   }
 
 void
@@ -343,6 +388,7 @@ thread_loop()
     recursive_mutex::unique_lock sched_lock(ep->fiber->m_sched_mutex);
     ep->fiber->m_scheduler = this;
     ep->fiber->m_sched_yield_fn = do_fiber_yield_function;
+    ep->fiber->m_sched_park_fn = do_fiber_park_function;
     auto futr = ep->wfutr.lock();
     lock.unlock();
 
@@ -389,9 +435,19 @@ thread_loop()
     ASTERIA_ASSERT(s_ep == ep);
     ep->fiber->m_scheduler = reinterpret_cast<Fiber_Scheduler*>(-5);
     ep->fiber->m_sched_yield_fn = nullptr;
+    ep->fiber->m_sched_park_fn = nullptr;
     s_ep.reset();
   }
 
+seconds
+Fiber_Scheduler::
+park_timeout()
+  const noexcept
+  {
+    plain_mutex::unique_lock lock(this->m_conf_mutex);
+    return this->m_conf_park_timeout;
+  }
+
 size_t
 Fiber_Scheduler::
 size()
@@ -0,0 +1,640 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "../xprecompiled.hpp"
+#include "../../static/http_connector.hpp"
+#include "../../static/network_scheduler.hpp"
+#include "../../static/task_scheduler.hpp"
+#include "../../socket/http_client_session.hpp"
+#include "../../socket/https_client_session.hpp"
+#include "../../socket/dns_connect_task.hpp"
+#include "../../base/config_file.hpp"
+#include "../../utils.hpp"
+#include <openssl/ssl.h>
+#include <deque>
+#include <unordered_map>
+namespace poseidon {
+namespace {
+
+struct Connection_Pool;
+
+struct Exchange
+  {
+    phcow_string origin;
+    cow_string host;
+    uint16_t port = 0;
+    bool ssl = false;
+    cow_string default_host;
+
+    HTTP_C_Headers req;
+    cow_string payload;
+    HTTP_Connector::callback_type callback;
+    bool reused = false;
+    bool retried = false;
+  };
+
+struct Pooled_Session
+  {
+    wkptr<Connection_Pool> m_wpool;
+    phcow_string m_origin;
+
+    plain_mutex m_exch_mutex;
+    uniptr<Exchange> m_exch;
+    shptr<Pooled_Session> m_self;
+    bool m_resp_begun = false;
+    bool m_used = false;
+
+    Pooled_Session(const shptr<Connection_Pool>& pool, const phcow_string& origin)
+      :
+        m_wpool(pool), m_origin(origin)
+      { }
+
+    virtual
+    ~Pooled_Session() = default;
+
+    // Checks whether this connection can still be used for new requests.
+    virtual
+    bool
+    do_pooled_alive()
+      const noexcept
+      = 0;
+
+    // Sends the request of `exch`, and attaches `exch` to this connection. If
+    // the request cannot be sent, `false` is returned and `exch` is intact.
+    virtual
+    bool
+    do_pooled_start(uniptr<Exchange>& exch, const shptr<Pooled_Session>& self)
+      = 0;
+
+    virtual
+    void
+    do_pooled_shut_down()
+      noexcept
+      = 0;
+  };
+
+struct Idle_Connection
+  {
+    steady_time time;
+    shptr<Pooled_Session> session;
+  };
+
+struct Origin
+  {
+    ::std::deque<Idle_Connection> idle;  // oldest first
+    uniptr_SSL_SESSION ssl_session;
+  };
+
+struct Connection_Pool
+  {
+    mutable plain_mutex mutex;
+    uint32_t max_idle_connections = 8;
+    seconds idle_timeout = 30s;
+    ::std::unordered_map<phcow_string, Origin, phcow_string::hash> origins;
+  };
+
+bool
+do_is_idempotent(HTTP_Method method)
+  noexcept
+  {
+    return (method == http_NULL) || (method == http_GET) || (method == http_HEAD)
+           || (method == http_PUT) || (method == http_DELETE) || (method == http_OPTIONS)
+           || (method == http_TRACE);
+  }
+
+shptr<Pooled_Session>
+do_pop_idle_connection(Connection_Pool& pool, const phcow_string& origin)
+  {
+    ::std::vector<shptr<Pooled_Session>> expired;
+    shptr<Pooled_Session> session;
+
+    plain_mutex::unique_lock lock(pool.mutex);
+    auto oit = pool.origins.find(origin);
+    if(oit == pool.origins.end())
+      return session;
+
+    // Close idle connections.
+    auto& idle = oit->second.idle;
+    const steady_time now = steady_clock::now();
+    while(!idle.empty() && (now - idle.front().time > pool.idle_timeout)) {
+      expired.push_back(move(idle.front().session));
+      idle.pop_front();
+    }
+
+    // Take the most recent one, which is the least likely to have been closed
+    // by the server.
+    while(!idle.empty() && !session) {
+      session = move(idle.back().session);
+      idle.pop_back();
+
+      if(!session->do_pooled_alive())
+        expired.push_back(move(session));
+    }
+
+    // Sockets must not be shut down with `pool.mutex` locked, as that would
+    // lock the socket and might cause deadlocks.
+    lock.unlock();
+    for(const auto& elem : expired)
+      elem->do_pooled_shut_down();
+
+    return session;
+  }
+
+void
+do_pool_connection(Connection_Pool& pool, const shptr<Pooled_Session>& session)
+  {
+    ::std::vector<shptr<Pooled_Session>> expired;
+
+    plain_mutex::unique_lock lock(pool.mutex);
+    if(pool.max_idle_connections == 0) {
+      // The connection pool is disabled.
+      lock.unlock();
+      session->do_pooled_shut_down();
+      return;
+    }
+
+    // Close idle connections. The oldest one is closed if the pool is full.
+    auto& idle = pool.origins[session->m_origin].idle;
+    const steady_time now = steady_clock::now();
+    while(!idle.empty() && ((now - idle.front().time > pool.idle_timeout)
+                            || (idle.size() >= pool.max_idle_connections))) {
+      expired.push_back(move(idle.front().session));
+      idle.pop_front();
+    }
+
+    auto& elem = idle.emplace_back();
+    elem.time = now;
+    elem.session = session;
+
+    lock.unlock();
+    for(const auto& s : expired)
+      s->do_pooled_shut_down();
+  }
+
+void
+do_remove_idle_connection(Connection_Pool& pool, const Pooled_Session& session)
+  {
+    shptr<Pooled_Session> removed;
+
+    plain_mutex::unique_lock lock(pool.mutex);
+    auto oit = pool.origins.find(session.m_origin);
+    if(oit == pool.origins.end())
+      return;
+
+    auto& idle = oit->second.idle;
+    for(auto it = idle.begin();  it != idle.end();  ++it)
+      if(it->session.get() == &session) {
+        // The session may be destroyed when `removed` goes out of scope.
+        removed = move(it->session);
+        idle.erase(it);
+        break;
+      }
+  }
+
+void
+do_invoke_callback(Exchange& exch, HTTP_S_Headers&& resp, linear_buffer&& data, const char* error)
+  {
+    try {
+      exch.callback(move(resp), move(data), error);
+    }
+    catch(exception& stdex) {
+      POSEIDON_LOG_ERROR(("Unhandled exception: $1"), stdex);
+    }
+  }
+
+void
+do_dispatch(const shptr<Connection_Pool>& pool, uniptr<Exchange>& exch, bool reuse);
+
+HTTP_Payload_Type
+do_pooled_on_response_headers(Pooled_Session& session, const HTTP_S_Headers& resp)
+  {
+    plain_mutex::unique_lock lock(session.m_exch_mutex);
+    if(!session.m_exch)
+      POSEIDON_THROW((
+          "Unexpected HTTP response `$2 $3` from `$1`"),
+          session.m_origin, resp.status, resp.reason);
+
+    session.m_resp_begun = true;
+
+    // The response to a HEAD request has no payload, although it may have a
+    // `Content-Length` header.
+    if(session.m_exch->req.method == http_HEAD)
+      return http_payload_empty;
+
+    return http_payload_normal;
+  }
+
+void
+do_pooled_on_response_finish(Pooled_Session& session, HTTP_S_Headers&& resp, linear_buffer&& data,
+                             bool close_after_response)
+  {
+    // Interim responses, such as `100 Continue`, are followed by the final
+    // one, so ignore them.
+    if((resp.status >= 100) && (resp.status <= 199) && (resp.status != 101))
+      return;
+
+    plain_mutex::unique_lock lock(session.m_exch_mutex);
+    auto exch = move(session.m_exch);
+    auto self = move(session.m_self);
+    session.m_used = true;
+    lock.unlock();
+
+    if(!exch)
+      return;
+
+    // Put the connection back into the pool before the callback is invoked, so
+    // it can be reused by the next request immediately.
+    auto pool = session.m_wpool.lock();
+    if(pool && !close_after_response && (resp.status != 101))
+      do_pool_connection(*pool, self);
+    else
+      session.do_pooled_shut_down();
+
+    do_invoke_callback(*exch, move(resp), move(data), nullptr);
+  }
+
+void
+do_pooled_on_closed(Pooled_Session& session, int err)
+  {
+    plain_mutex::unique_lock lock(session.m_exch_mutex);
+    auto exch = move(session.m_exch);
+    auto self = move(session.m_self);
+    bool resp_begun = session.m_resp_begun;
+    lock.unlock();
+
+    auto pool = session.m_wpool.lock();
+    if(pool)
+      do_remove_idle_connection(*pool, session);
+
+    if(!exch)
+      return;
+
+    if(pool && exch->reused && !resp_begun && !exch->retried && do_is_idempotent(exch->req.method))
+      try {
+        // The server may have closed the connection just before the request
+        // arrived, which is not an error. Retry it on a new connection.
+        POSEIDON_LOG_DEBUG(("Retrying HTTP request to `$1`"), exch->origin);
+        exch->retried = true;
+        do_dispatch(pool, exch, false);
+        return;
+      }
+      catch(exception& stdex) {
+        POSEIDON_LOG_ERROR(("Could not retry HTTP request: $1"), stdex);
+      }
+
+    char sbuf[1024];
+    const char* err_str = "connection closed without a response";
+    if(err != 0)
+      err_str = ::strerror_r(err, sbuf, sizeof(sbuf));
+
+    do_invoke_callback(*exch, HTTP_S_Headers(), linear_buffer(), err_str);
+  }
+
+struct Final_HTTP_Session final : HTTP_Client_Session, Pooled_Session
+  {
+    Final_HTTP_Session(const shptr<Connection_Pool>& pool, const phcow_string& origin,
+                       const cow_string& default_host)
+      :
+        TCP_Socket(), HTTP_Client_Session(default_host),
+        Pooled_Session(pool, origin)
+      { }
+
+    virtual
+    bool
+    do_pooled_alive()
+      const noexcept
+      override
+      { return this->socket_state() == socket_established;  }
+
+    virtual
+    bool
+    do_pooled_start(uniptr<Exchange>& exch, const shptr<Pooled_Session>& self)
+      override
+      {
+        // Lock the socket first, so a response can't be processed before the
+        // exchange is attached.
+        recursive_mutex::unique_lock io_lock;
+        this->do_abstract_socket_lock_write_queue(io_lock);
+        plain_mutex::unique_lock lock(this->m_exch_mutex);
+        ASTERIA_ASSERT(!this->m_exch);
+
+        HTTP_C_Headers req = exch->req;
+        if(!this->http_request(move(req), exch->payload))
+          return false;
+
+        exch->reused = this->m_used;
+        this->m_exch = move(exch);
+        this->m_self = self;
+        this->m_resp_begun = false;
+        return true;
+      }
+
+    virtual
+    void
+    do_pooled_shut_down()
+      noexcept
+      override
+      { this->tcp_shut_down();  }
+
+    virtual
+    void
+    do_on_tcp_connected()
+      override
+      {
+        // The request has been enqueued before connection, so there is nothing
+        // to do here.
+      }
+
+    virtual
+    HTTP_Payload_Type
+    do_on_http_response_headers(HTTP_S_Headers& resp)
+      override
+      { return do_pooled_on_response_headers(*this, resp);  }
+
+    virtual
+    void
+    do_on_http_response_finish(HTTP_S_Headers&& resp, linear_buffer&& data)
+      override
+      {
+        do_pooled_on_response_finish(*this, move(resp), move(data),
+                                     this->do_should_close_after_response());
+      }
+
+    virtual
+    void
+    do_abstract_socket_on_closed()
+      override
+      {
+        int err = errno;
+        this->HTTP_Client_Session::do_abstract_socket_on_closed();
+        do_pooled_on_closed(*this, err);
+      }
+  };
+
+struct Final_HTTPS_Session final : HTTPS_Client_Session, Pooled_Session
+  {
+    Final_HTTPS_Session(const shptr<Connection_Pool>& pool, const phcow_string& origin,
+                        const cow_string& default_host, ::SSL_SESSION* resume_opt)
+      :
+        SSL_Socket(network_scheduler), HTTPS_Client_Session(default_host),
+        Pooled_Session(pool, origin)
+      {
+        if(resume_opt)
+          this->do_ssl_set_session(resume_opt);
+      }
+
+    virtual
+    bool
+    do_pooled_alive()
+      const noexcept
+      override
+      { return this->socket_state() == socket_established;  }
+
+    virtual
+    bool
+    do_pooled_start(uniptr<Exchange>& exch, const shptr<Pooled_Session>& self)
+      override
+      {
+        // Lock the socket first, so a response can't be processed before the
+        // exchange is attached.
+        recursive_mutex::unique_lock io_lock;
+        this->do_abstract_socket_lock_write_queue(io_lock);
+        plain_mutex::unique_lock lock(this->m_exch_mutex);
+        ASTERIA_ASSERT(!this->m_exch);
+
+        HTTP_C_Headers req = exch->req;
+        if(!this->https_request(move(req), exch->payload))
+          return false;
+
+        exch->reused = this->m_used;
+        this->m_exch = move(exch);
+        this->m_self = self;
+        this->m_resp_begun = false;
+        return true;
+      }
+
+    virtual
+    void
+    do_pooled_shut_down()
+      noexcept
+      override
+      { this->ssl_shut_down();  }
+
+    virtual
+    void
+    do_on_ssl_connected()
+      override
+      {
+        // The request has been enqueued before connection, so there is nothing
+        // to do here.
+      }
+
+    virtual
+    void
+    do_on_ssl_new_session(::SSL_SESSION* session)
+      override
+      {
+        auto pool = this->m_wpool.lock();
+        if(!pool)
+          return;
+
+        // Keep the latest session for new connections to the same origin.
+        ::SSL_SESSION_up_ref(session);
+        uniptr_SSL_SESSION ssl_session(session);
+
+        plain_mutex::unique_lock lock(pool->mutex);
+        pool->origins[this->m_origin].ssl_session.swap(ssl_session);
+      }
+
+    virtual
+    HTTP_Payload_Type
+    do_on_https_response_headers(HTTP_S_Headers& resp)
+      override
+      { return do_pooled_on_response_headers(*this, resp);  }
+
+    virtual
+    void
+    do_on_https_response_finish(HTTP_S_Headers&& resp, linear_buffer&& data)
+      override
+      {
+        do_pooled_on_response_finish(*this, move(resp), move(data),
+                                     this->do_should_close_after_response());
+      }
+
+    virtual
+    void
+    do_abstract_socket_on_closed()
+      override
+      {
+        int err = errno;
+        this->HTTPS_Client_Session::do_abstract_socket_on_closed();
+        do_pooled_on_closed(*this, err);
+      }
+  };
+
+void
+do_dispatch(const shptr<Connection_Pool>& pool, uniptr<Exchange>& exch, bool reuse)
+  {
+    while(reuse) {
+      auto session = do_pop_idle_connection(*pool, exch->origin);
+      if(!session)
+        break;
+
+      if(session->do_pooled_start(exch, session)) {
+        POSEIDON_LOG_TRACE(("Reusing HTTP connection to `$1`"), exch->origin);
+        return;
+      }
+
+      session->do_pooled_shut_down();
+    }
+
+    // Create a new connection. If a TLS session has been received from the
+    // same origin, try resuming it.
+    shptr<Pooled_Session> session;
+    shptr<Abstract_Socket> socket;
+
+    if(exch->ssl) {
+      uniptr_SSL_SESSION resume;
+      plain_mutex::unique_lock lock(pool->mutex);
+      auto oit = pool->origins.find(exch->origin);
+      if((oit != pool->origins.end()) && oit->second.ssl_session) {
+        ::SSL_SESSION_up_ref(oit->second.ssl_session);
+        resume.reset(oit->second.ssl_session.get());
+      }
+      lock.unlock();
+
+      auto ssl_session = new_sh<Final_HTTPS_Session>(pool, exch->origin, exch->default_host, resume);
+      socket = ssl_session;
+      session = ssl_session;
+    }
+    else {
+      auto tcp_session = new_sh<Final_HTTP_Session>(pool, exch->origin, exch->default_host);
+      socket = tcp_session;
+      session = tcp_session;
+    }
+
+    task_scheduler.launch(new_sh<DNS_Connect_Task>(network_scheduler, socket, exch->host, exch->port));
+
+    // The request will be sent after the connection is established.
+    POSEIDON_LOG_TRACE(("Creating HTTP connection to `$1`"), exch->origin);
+    if(!session->do_pooled_start(exch, session))
+      POSEIDON_THROW(("Could not send HTTP request to `$1`"), exch->origin);
+  }
+
+}  // namespace
+
+POSEIDON_HIDDEN_X_STRUCT(HTTP_Connector,
+  Connection_Pool);
+
+HTTP_Connector::
+HTTP_Connector()
+  noexcept
+  {
+  }
+
+HTTP_Connector::
+~HTTP_Connector()
+  {
+  }
+
+void
+HTTP_Connector::
+reload(const Config_File& conf_file)
+  {
+    // Read connection pool settings from configuration.
+    uint32_t max_idle_connections = static_cast<uint32_t>(conf_file.get_integer_opt(
+                          &"network.http.client_max_idle_connections", 0, 1000).value_or(8));
+    seconds idle_timeout = seconds(static_cast<int>(conf_file.get_integer_opt(
+                          &"network.http.client_idle_timeout", 0, 86400).value_or(30)));
+
+    // Set up new data.
+    plain_mutex::unique_lock lock(this->m_conf_mutex);
+    if(!this->m_pool)
+      this->m_pool = new_sh<X_Connection_Pool>();
+
+    auto pool = this->m_pool;
+    lock.unlock();
+
+    lock.lock(pool->mutex);
+    pool->max_idle_connections = max_idle_connections;
+    pool->idle_timeout = idle_timeout;
+  }
+
+void
+HTTP_Connector::
+request(const HTTP_C_Headers& req, const cow_string& payload, const callback_type& callback)
+  {
+    if(req.is_proxy)
+      POSEIDON_THROW(("Proxy requests not supported"));
+
+    if(req.method == http_CONNECT)
+      POSEIDON_THROW(("CONNECT requests not supported"));
+
+    if(req.raw_host.empty())
+      POSEIDON_THROW(("No host specified in HTTP request"));
+
+    plain_mutex::unique_lock lock(this->m_conf_mutex);
+    auto pool = this->m_pool;
+    lock.unlock();
+
+    if(!pool)
+      POSEIDON_THROW(("HTTP connector not initialized"));
+
+    auto exch = new_uni<Exchange>();
+    exch->ssl = req.is_ssl;
+    exch->port = req.port;
+    if(exch->port == 0)
+      exch->port = exch->ssl ? 443 : 80;
+
+    // Host names are case-insensitive. IPv6 addresses shall be enclosed in
+    // brackets in the `Host:` header.
+    exch->host = req.raw_host;
+    char* hp = exch->host.mut_data();
+    for(size_t k = 0;  k != exch->host.size();  ++k)
+      if((hp[k] >= 'A') && (hp[k] <= 'Z'))
+        hp[k] = static_cast<char>(hp[k] - 'A' + 'a');
+
+    cow_string bracketed = exch->host;
+    if((bracketed[0] != '[') && (bracketed.find(':') != cow_string::npos))
+      bracketed = sformat("[$1]", exch->host);
+
+    exch->origin = sformat("$1://$2:$3", exch->ssl ? "https" : "http", bracketed, exch->port);
+    exch->default_host = bracketed;
+    if(exch->port != (exch->ssl ? 443 : 80))
+      exch->default_host = sformat("$1:$2", bracketed, exch->port);
+
+    // The host is passed to the session as its default, so the `Host:` header
+    // will contain the port number if it's not the default one.
+    exch->req = req;
+    exch->req.raw_host.clear();
+    exch->req.port = 0;
+    exch->req.is_ssl = false;
+    exch->payload = payload;
+    exch->callback = callback;
+
+    do_dispatch(pool, exch, true);
+  }
+
+void
+HTTP_Connector::
+close_idle_connections()
+  noexcept
+  {
+    plain_mutex::unique_lock lock(this->m_conf_mutex);
+    auto pool = this->m_pool;
+    lock.unlock();
+
+    if(!pool)
+      return;
+
+    ::std::unordered_map<phcow_string, Origin, phcow_string::hash> origins;
+    lock.lock(pool->mutex);
+    origins.swap(pool->origins);
+    lock.unlock();
+
+    for(const auto& r : origins)
+      for(const auto& elem : r.second.idle)
+        elem.session->do_pooled_shut_down();
+  }
+
+}  // namespace poseidon
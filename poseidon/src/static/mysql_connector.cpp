@@ -3,10 +3,13 @@
 
 #include "../xprecompiled.hpp"
 #include "../../static/mysql_connector.hpp"
+#include "../../static/network_scheduler.hpp"
 #include "../../mysql/mysql_connection.hpp"
+#include "../../socket/abstract_socket.hpp"
 #include "../../base/config_file.hpp"
 #include "../../utils.hpp"
 #include <asteria/rocket/once_flag.hpp>
+#include <fcntl.h>
 namespace poseidon {
 namespace {
 
@@ -16,6 +19,86 @@ struct Pooled_Connection
     uniptr<MySQL_Connection> conn;
   };
 
+// This socket polls a duplicate of the descriptor of an asynchronous MySQL
+// connection, and drives the operation in progress. It's owned by the
+// connection. While an operation is in progress, the connection is owned by
+// this socket in turn.
+struct Async_Socket final : Abstract_Socket
+  {
+    uniptr<MySQL_Connection> conn;
+    MySQL_Connector::callback_type callback;
+
+    explicit
+    Async_Socket(unique_posix_fd&& fd)
+      :
+        Abstract_Socket(move(fd))
+      { }
+
+    void
+    lock(recursive_mutex::unique_lock& io_lock)
+      {
+        this->do_abstract_socket_lock_read_queue(io_lock);
+      }
+
+    void
+    do_complete(const char* error)
+      {
+        auto conn2 = move(this->conn);
+        auto callback2 = move(this->callback);
+
+        try {
+          callback2(move(conn2), error);
+        }
+        catch(exception& stdex) {
+          POSEIDON_LOG_ERROR(("Unhandled exception in MySQL callback: $1"), stdex);
+        }
+      }
+
+    void
+    do_continue()
+      {
+        if(!this->conn)
+          return;
+
+        try {
+          if(!this->conn->execute_nonblocking_continue())
+            return;
+        }
+        catch(exception& stdex) {
+          this->do_complete(stdex.what());
+          return;
+        }
+
+        this->do_complete(nullptr);
+      }
+
+    virtual
+    void
+    do_abstract_socket_on_readable()
+      override
+      { this->do_continue();  }
+
+    virtual
+    void
+    do_abstract_socket_on_writeable()
+      override
+      { this->do_continue();  }
+
+    virtual
+    void
+    do_abstract_socket_on_closed()
+      override
+      {
+        char sbuf[1024];
+        const char* err_str = "connection closed by server";
+        if(errno != 0)
+          err_str = ::strerror_r(errno, sbuf, sizeof(sbuf));
+
+        if(this->conn)
+          this->do_complete(err_str);
+      }
+  };
+
 }  // namespace
 
 POSEIDON_HIDDEN_X_STRUCT(MySQL_Connector,
@@ -63,6 +146,12 @@ reload(const Config_File& conf_file)
                                         &"mysql.connection_pool_size", 0, 100).value_or(0));
     seconds connection_idle_timeout = seconds(static_cast<int>(conf_file.get_integer_opt(
                                         &"mysql.connection_idle_timeout", 0, 86400).value_or(60)));
+    uint32_t statement_cache_size = static_cast<uint32_t>(conf_file.get_integer_opt(
+                                        &"mysql.statement_cache_size", 0, 1000).value_or(16));
+    bool keep_statements_on_reset = conf_file.get_boolean_opt(
+                                        &"mysql.keep_statements_on_reset").value_or(false);
+    bool asynchronous_queries = conf_file.get_boolean_opt(
+                                        &"mysql.asynchronous_queries").value_or(false);
 
     // Initialize the MySQL client library in a thread-safe manner.
     static ::asteria::once_flag s_init_once;
@@ -78,12 +167,16 @@ reload(const Config_File& conf_file)
     this->m_conf_tertiary_password.swap(tertiary_password);
     this->m_conf_connection_pool_size = static_cast<uint32_t>(connection_pool_size);
     this->m_conf_connection_idle_timeout = static_cast<seconds>(connection_idle_timeout);
+    this->m_conf_statement_cache_size = statement_cache_size;
+    this->m_conf_keep_statements_on_reset = keep_statements_on_reset;
+    this->m_conf_asynchronous_queries = asynchronous_queries;
   }
 
 POSEIDON_VISIBILITY_HIDDEN
 uniptr<MySQL_Connection>
 MySQL_Connector::
-do_get_pooled_connection_opt(seconds idle_timeout, const cow_string& service_uri)
+do_get_pooled_connection_opt(seconds idle_timeout, const cow_string& service_uri,
+                             bool async)
   {
     plain_mutex::unique_lock lock(this->m_pool_mutex);
     const steady_time now = steady_clock::now();
@@ -91,7 +184,8 @@ do_get_pooled_connection_opt(seconds idle_timeout, const cow_string& service_uri
     // Look for a matching connection.
     uniptr<MySQL_Connection> conn;
     for(auto pos = this->m_pool.mut_begin();  pos != this->m_pool.end();  ++pos)
-      if(pos->conn->m_service_uri == service_uri) {
+      if((pos->conn->m_service_uri == service_uri)
+         && (!pos->conn->m_connected || (pos->conn->m_async == async))) {
         conn.swap(pos->conn);
         this->m_pool.erase(pos);
         break;
@@ -104,17 +198,46 @@ do_get_pooled_connection_opt(seconds idle_timeout, const cow_string& service_uri
     return conn;
   }
 
+POSEIDON_VISIBILITY_HIDDEN
+void
+MySQL_Connector::
+do_await_async(uniptr<MySQL_Connection>&& conn, recursive_mutex::unique_lock& io_lock,
+               const callback_type& callback)
+  {
+    auto socket = static_pointer_cast<Async_Socket>(conn->m_async_socket);
+    if(!socket) {
+      // The connection has been initiated, so poll its socket.
+      unique_posix_fd fd(::fcntl(conn->nonblocking_fd(), F_DUPFD_CLOEXEC, 0));
+      if(!fd)
+        POSEIDON_THROW((
+            "Could not duplicate MySQL socket",
+            "[`fcntl()` failed: ${errno:full}]"));
+
+      socket = new_sh<Async_Socket>(move(fd));
+      socket->lock(io_lock);
+      network_scheduler.insert_weak(socket);
+      conn->m_async_socket = socket;
+    }
+
+    socket->callback = callback;
+    socket->conn = move(conn);
+  }
+
 uniptr<MySQL_Connection>
 MySQL_Connector::
 allocate_connection(const cow_string& service_uri, const cow_string& password)
   {
     plain_mutex::unique_lock lock(this->m_conf_mutex);
     const seconds idle_timeout = this->m_conf_connection_idle_timeout;
+    const uint32_t statement_cache_size = this->m_conf_statement_cache_size;
+    const bool keep_statements_on_reset = this->m_conf_keep_statements_on_reset;
     lock.unlock();
 
-    auto conn = this->do_get_pooled_connection_opt(idle_timeout, service_uri);
+    auto conn = this->do_get_pooled_connection_opt(idle_timeout, service_uri, false);
     if(!conn)
       conn = new_uni<MySQL_Connection>(service_uri, password);
+    conn->set_statement_cache_size(statement_cache_size);
+    conn->set_keep_statements_on_reset(keep_statements_on_reset);
     return conn;
   }
 
@@ -126,11 +249,15 @@ allocate_default_connection()
     const cow_string service_uri = this->m_conf_default_service_uri;
     const cow_string password = this->m_conf_default_password;
     const seconds idle_timeout = this->m_conf_connection_idle_timeout;
+    const uint32_t statement_cache_size = this->m_conf_statement_cache_size;
+    const bool keep_statements_on_reset = this->m_conf_keep_statements_on_reset;
     lock.unlock();
 
-    auto conn = this->do_get_pooled_connection_opt(idle_timeout, service_uri);
+    auto conn = this->do_get_pooled_connection_opt(idle_timeout, service_uri, false);
     if(!conn)
       conn = new_uni<MySQL_Connection>(service_uri, password);
+    conn->set_statement_cache_size(statement_cache_size);
+    conn->set_keep_statements_on_reset(keep_statements_on_reset);
     return conn;
   }
 
@@ -142,11 +269,15 @@ allocate_secondary_connection()
     const cow_string service_uri = this->m_conf_secondary_service_uri;
     const cow_string password = this->m_conf_secondary_password;
     const seconds idle_timeout = this->m_conf_connection_idle_timeout;
+    const uint32_t statement_cache_size = this->m_conf_statement_cache_size;
+    const bool keep_statements_on_reset = this->m_conf_keep_statements_on_reset;
     lock.unlock();
 
-    auto conn = this->do_get_pooled_connection_opt(idle_timeout, service_uri);
+    auto conn = this->do_get_pooled_connection_opt(idle_timeout, service_uri, false);
     if(!conn)
       conn = new_uni<MySQL_Connection>(service_uri, password);
+    conn->set_statement_cache_size(statement_cache_size);
+    conn->set_keep_statements_on_reset(keep_statements_on_reset);
     return conn;
   }
 
@@ -158,14 +289,66 @@ allocate_tertiary_connection()
     const cow_string service_uri = this->m_conf_tertiary_service_uri;
     const cow_string password = this->m_conf_tertiary_password;
     const seconds idle_timeout = this->m_conf_connection_idle_timeout;
+    const uint32_t statement_cache_size = this->m_conf_statement_cache_size;
+    const bool keep_statements_on_reset = this->m_conf_keep_statements_on_reset;
     lock.unlock();
 
-    auto conn = this->do_get_pooled_connection_opt(idle_timeout, service_uri);
+    auto conn = this->do_get_pooled_connection_opt(idle_timeout, service_uri, false);
     if(!conn)
       conn = new_uni<MySQL_Connection>(service_uri, password);
+    conn->set_statement_cache_size(statement_cache_size);
+    conn->set_keep_statements_on_reset(keep_statements_on_reset);
     return conn;
   }
 
+bool
+MySQL_Connector::
+asynchronous_queries()
+  const
+  {
+    plain_mutex::unique_lock lock(this->m_conf_mutex);
+    return this->m_conf_asynchronous_queries;
+  }
+
+void
+MySQL_Connector::
+execute_async(uniptr<MySQL_Connection>&& conn_opt, const cow_string& stmt,
+              const cow_vector<MySQL_Value>& args, const callback_type& callback)
+  {
+    auto conn = move(conn_opt);
+    if(!conn) {
+      plain_mutex::unique_lock lock(this->m_conf_mutex);
+      const cow_string service_uri = this->m_conf_default_service_uri;
+      const cow_string password = this->m_conf_default_password;
+      const seconds idle_timeout = this->m_conf_connection_idle_timeout;
+      lock.unlock();
+
+      conn = this->do_get_pooled_connection_opt(idle_timeout, service_uri, true);
+      if(!conn)
+        conn = new_uni<MySQL_Connection>(service_uri, password);
+    }
+
+    // Lock the socket first, so the operation can't complete before it's
+    // attached.
+    recursive_mutex::unique_lock io_lock;
+    auto socket = static_pointer_cast<Async_Socket>(conn->m_async_socket);
+    if(socket) {
+      socket->lock(io_lock);
+      if(socket->socket_state() == socket_closed)
+        POSEIDON_THROW((
+            "MySQL connection to `$1` has been closed"),
+            conn->m_service_uri);
+    }
+
+    if(conn->execute_nonblocking_start(stmt, args)) {
+      io_lock.unlock();
+      callback(move(conn), nullptr);
+      return;
+    }
+
+    this->do_await_async(move(conn), io_lock, callback);
+  }
+
 bool
 MySQL_Connector::
 pool_connection(uniptr<MySQL_Connection>&& conn)
@@ -210,4 +393,39 @@ pool_connection(uniptr<MySQL_Connection>&& conn)
     return true;
   }
 
+void
+MySQL_Connector::
+pool_connection_async(uniptr<MySQL_Connection>&& conn)
+  {
+    if(!conn)
+      return;
+
+    // Lock the socket first, so the operation can't complete before it's
+    // attached. If the socket has been closed, the connection is discarded.
+    recursive_mutex::unique_lock io_lock;
+    auto socket = static_pointer_cast<Async_Socket>(conn->m_async_socket);
+    if(socket) {
+      socket->lock(io_lock);
+      if(socket->socket_state() == socket_closed)
+        return;
+    }
+
+    if(conn->reset_nonblocking_start()) {
+      io_lock.unlock();
+      this->pool_connection(move(conn));
+      return;
+    }
+
+    this->do_await_async(move(conn), io_lock,
+      [this](uniptr<MySQL_Connection>&& conn2, const char* error)
+        {
+          if(error) {
+            POSEIDON_LOG_WARN(("Could not reset MySQL connection: $1"), error);
+            return;
+          }
+
+          this->pool_connection(move(conn2));
+        });
+  }
+
 }  // namespace poseidon
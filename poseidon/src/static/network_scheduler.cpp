@@ -4,6 +4,7 @@
 #include "../xprecompiled.hpp"
 #include "../../static/network_scheduler.hpp"
 #include "../../socket/abstract_socket.hpp"
+#include "../../socket/ssl_socket.hpp"
 #include "../../base/config_file.hpp"
 #include "../../utils.hpp"
 #include <sys/epoll.h>
@@ -92,6 +93,60 @@ client_ssl_ctx()
     return uniptr_SSL_CTX(ptr);
   }
 
+uint32_t
+Network_Scheduler::
+throttle_size()
+  const noexcept
+  {
+    plain_mutex::unique_lock lock(this->m_conf_mutex);
+    return this->m_throttle_size;
+  }
+
+uint32_t
+Network_Scheduler::
+udp_receive_batch_size()
+  const noexcept
+  {
+    plain_mutex::unique_lock lock(this->m_conf_mutex);
+    return this->m_udp_receive_batch_size;
+  }
+
+bool
+Network_Scheduler::
+udp_gro_enabled()
+  const noexcept
+  {
+    plain_mutex::unique_lock lock(this->m_conf_mutex);
+    return this->m_udp_gro;
+  }
+
+bool
+Network_Scheduler::
+udp_gso_enabled()
+  const noexcept
+  {
+    plain_mutex::unique_lock lock(this->m_conf_mutex);
+    return this->m_udp_gso;
+  }
+
+uint32_t
+Network_Scheduler::
+udp_send_queue_size()
+  const noexcept
+  {
+    plain_mutex::unique_lock lock(this->m_conf_mutex);
+    return this->m_udp_send_queue_size;
+  }
+
+UDP_Drop_Policy
+Network_Scheduler::
+udp_drop_policy()
+  const noexcept
+  {
+    plain_mutex::unique_lock lock(this->m_conf_mutex);
+    return this->m_udp_drop_policy;
+  }
+
 void
 Network_Scheduler::
 reload(const Config_File& conf_file)
@@ -106,6 +161,24 @@ reload(const Config_File& conf_file)
     uint32_t throttle_size = static_cast<uint32_t>(conf_file.get_integer_opt(
                           &"network.poll.throttle_size", 0, INT_MAX).value_or(1048576));
 
+    // Read UDP settings.
+    uint32_t udp_receive_batch_size = static_cast<uint32_t>(conf_file.get_integer_opt(
+                          &"network.udp.receive_batch_size", 1, 256).value_or(32));
+    bool udp_gro = conf_file.get_boolean_opt(&"network.udp.enable_gro").value_or(false);
+    bool udp_gso = conf_file.get_boolean_opt(&"network.udp.enable_gso").value_or(false);
+    uint32_t udp_send_queue_size = static_cast<uint32_t>(conf_file.get_integer_opt(
+                          &"network.udp.send_queue_size", 0, INT_MAX).value_or(0));
+
+    UDP_Drop_Policy udp_drop_policy = udp_drop_newest;
+    cow_string str = conf_file.get_string_opt(&"network.udp.drop_policy").value_or(&"newest");
+    if(str == "oldest")
+      udp_drop_policy = udp_drop_oldest;
+    else if(str != "newest")
+      POSEIDON_THROW((
+          "Invalid `network.udp.drop_policy` value `$1`",
+          "[in configuration file '$2']"),
+          str, conf_file.path());
+
     // Read SSL settings.
     cow_string default_certificate = conf_file.get_string_opt(&"network.ssl.default_certificate").value_or(&"");
     cow_string default_private_key = conf_file.get_string_opt(&"network.ssl.default_private_key").value_or(&"");
@@ -173,6 +246,10 @@ reload(const Config_File& conf_file)
             ::ERR_reason_error_string(::ERR_get_error()), conf_file.path());
 
       ::SSL_CTX_set_verify(server_ssl_ctx, SSL_VERIFY_PEER | SSL_VERIFY_CLIENT_ONCE, nullptr);
+
+      // Application-layer protocols are selected by individual sockets. By
+      // default no protocol is selected, which implies HTTP/1.1.
+      ::SSL_CTX_set_alpn_select_cb(server_ssl_ctx, SSL_Socket::do_ssl_alpn_select, nullptr);
     }
 
     // The client SSL context is always created for outgoing connections.
@@ -186,6 +263,11 @@ reload(const Config_File& conf_file)
     ::SSL_CTX_set_mode(client_ssl_ctx, SSL_MODE_ENABLE_PARTIAL_WRITE);
     ::SSL_CTX_set_mode(client_ssl_ctx, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
 
+    // OpenSSL never resumes client sessions by itself, so sessions are passed
+    // to sockets, which may keep them for later connections to the same server.
+    ::SSL_CTX_set_session_cache_mode(client_ssl_ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    ::SSL_CTX_sess_set_new_cb(client_ssl_ctx, SSL_Socket::do_ssl_new_session);
+
     cow_string trusted_ca_path = conf_file.get_string_opt(&"network.ssl.trusted_ca_path").value_or(&"");
     if(trusted_ca_path != "") {
       if(!::SSL_CTX_load_verify_locations(client_ssl_ctx, nullptr, trusted_ca_path.safe_c_str()))
@@ -209,10 +291,36 @@ reload(const Config_File& conf_file)
     plain_mutex::unique_lock lock(this->m_conf_mutex);
     this->m_event_buffer_size = event_buffer_size;
     this->m_throttle_size = throttle_size;
+    this->m_udp_receive_batch_size = udp_receive_batch_size;
+    this->m_udp_gro = udp_gro;
+    this->m_udp_gso = udp_gso;
+    this->m_udp_send_queue_size = udp_send_queue_size;
+    this->m_udp_drop_policy = udp_drop_policy;
     this->m_server_ssl_ctx.swap(server_ssl_ctx);
     this->m_client_ssl_ctx.swap(client_ssl_ctx);
   }
 
+void
+Network_Scheduler::
+do_modify_epoll_events_nolock(Abstract_Socket& socket)
+  {
+    ::epoll_event pev;
+    pev.data.ptr = &socket;
+
+    if(socket.m_sched_throttled)
+      pev.events = EPOLLOUT;  // output-only, level-triggered
+    else if(socket.m_sched_read_paused)
+      pev.events = EPOLLOUT | EPOLLET;  // output-only
+    else
+      pev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+
+    if(::epoll_ctl(this->m_epoll_fd, EPOLL_CTL_MOD, socket.m_fd, &pev) != 0)
+      POSEIDON_LOG_FATAL((
+          "Could not modify socket `$1` (class `$2`)",
+          "[`epoll_ctl()` failed: ${errno:full}]"),
+          &socket, typeid(socket));
+  }
+
 void
 Network_Scheduler::
 thread_loop()
@@ -289,6 +397,9 @@ thread_loop()
           socket->do_abstract_socket_on_closed();
         }
       }
+
+      // Return the read buffer, so idle sockets don't pin memory.
+      socket->do_abstract_socket_release_read_queue();
     }
     catch(exception& stdex) {
       POSEIDON_LOG_ERROR(("Socket error: $1"), stdex);
@@ -304,20 +415,11 @@ thread_loop()
 
     // When there are too many pending bytes, as a safety measure, EPOLLIN
     // notifications are disabled until some bytes can be transferred.
-    bool should_throttle = socket->m_sched_write_queue.size() > throttle_size;
+    bool should_throttle = socket->m_sched_write_queue.size()
+                           + socket->m_sched_write_chunks.size() > throttle_size;
     if(socket->m_sched_throttled != should_throttle) {
       socket->m_sched_throttled = should_throttle;
-
-      if(should_throttle)
-        pev.events = EPOLLOUT;  // output-only, level-triggered
-      else
-        pev.events = EPOLLIN | EPOLLOUT | EPOLLET;
-
-      if(::epoll_ctl(this->m_epoll_fd, EPOLL_CTL_MOD, socket->m_fd, &pev) != 0)
-        POSEIDON_LOG_FATAL((
-            "Could not modify socket `$1` (class `$2`)",
-            "[`epoll_ctl()` failed: ${errno:full}]"),
-            socket, typeid(*socket));
+      this->do_modify_epoll_events_nolock(*socket);
     }
 
     POSEIDON_LOG_TRACE(("Socket `$1` (class `$2`) I/O complete"), socket, typeid(*socket));
@@ -375,4 +477,25 @@ insert_weak(const shptr<Abstract_Socket>& socket)
     this->m_epoll_map_used ++;
   }
 
+void
+Network_Scheduler::
+pause_reading(Abstract_Socket& socket, bool paused)
+  {
+    recursive_mutex::unique_lock io_lock(socket.m_sched_mutex);
+    if(socket.m_sched_read_paused == paused)
+      return;
+
+    socket.m_sched_read_paused = paused;
+
+    // If the socket has been closed, it will have been removed from the epoll
+    // set. If it is being throttled, the new state will take effect when
+    // throttling ends.
+    if((socket.socket_state() == socket_closed) || socket.m_sched_throttled)
+      return;
+
+    // When reading is resumed, modifying the socket will cause an `EPOLLIN`
+    // notification if some data have arrived in the meantime.
+    this->do_modify_epoll_events_nolock(socket);
+  }
+
 }  // namespace poseidon
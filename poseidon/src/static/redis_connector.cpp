@@ -4,8 +4,15 @@
 #include "../xprecompiled.hpp"
 #include "../../static/redis_connector.hpp"
 #include "../../redis/redis_connection.hpp"
+#include "../../redis/redis_value.hpp"
+#include "../../socket/redis_tcp_client_session.hpp"
+#include "../../socket/dns_connect_task.hpp"
+#include "../../static/network_scheduler.hpp"
+#include "../../static/task_scheduler.hpp"
 #include "../../base/config_file.hpp"
 #include "../../utils.hpp"
+#include <list>
+#include <unordered_map>
 namespace poseidon {
 namespace {
 
@@ -15,11 +22,151 @@ struct Pooled_Connection
     uniptr<Redis_Connection> conn;
   };
 
+struct Pipelined_Command
+  {
+    uint64_t serial = 0;
+    cow_vector<cow_string> cmd;
+    Redis_Connector::callback_type callback;
+  };
+
+struct Cached_Value
+  {
+    Redis_Value value;
+    steady_time expiry;
+    uint64_t serial = 0;  // non-zero while the value is being read
+    size_t size = 0;
+    ::std::list<cow_string>::iterator lru_pos;
+  };
+
+struct Near_Cache
+  {
+    ::std::unordered_map<cow_string, Cached_Value, cow_string::hash> values;
+    ::std::list<cow_string> lru;  // most recently used first
+    size_t total_size = 0;
+    uint64_t next_serial = 0;
+    steady_time tracking_retry_time;
+  };
+
+size_t
+do_estimate_size(const cow_string& key, const Redis_Value& value)
+  {
+    // This is an approximation of memory that is used by a cached value,
+    // including overheads of containers.
+    size_t size = 64 + key.size();
+    ::std::vector<const Redis_Value*> stack;
+    stack.push_back(&value);
+    while(!stack.empty()) {
+      auto pval = stack.back();
+      stack.pop_back();
+      size += sizeof(Redis_Value);
+
+      if(pval->is_string())
+        size += pval->as_string_length();
+      else if(pval->is_array())
+        for(const auto& elem : pval->as_array())
+          stack.push_back(&elem);
+    }
+    return size;
+  }
+
+void
+do_erase_cached_value(Near_Cache& cache, ::std::unordered_map<cow_string, Cached_Value,
+                                                              cow_string::hash>::iterator it)
+  {
+    cache.total_size -= it->second.size;
+    cache.lru.erase(it->second.lru_pos);
+    cache.values.erase(it);
+  }
+
+bool
+do_match_prefixes(const cow_vector<cow_string>& prefixes, const cow_string& key)
+  {
+    // If no prefix has been specified, all keys match.
+    if(prefixes.empty())
+      return true;
+
+    for(const auto& prefix : prefixes)
+      if((key.size() >= prefix.size()) && (::memcmp(key.data(), prefix.data(), prefix.size()) == 0))
+        return true;
+
+    return false;
+  }
+
+struct Tracking_Session final : Redis_TCP_Client_Session
+  {
+    Redis_Connector* m_ctr;
+    cow_vector<cow_string> m_prefixes;
+    atomic_relaxed<bool> m_ready;
+
+    Tracking_Session(Redis_Connector& ctr, const cow_string& user, const cow_string& password,
+                     const cow_vector<cow_string>& prefixes)
+      :
+        TCP_Socket(), Redis_TCP_Client_Session(user, password, 0),
+        m_ctr(&ctr), m_prefixes(prefixes)
+      { }
+
+    virtual
+    void
+    do_on_redis_push(Redis_Value&& message)
+      override
+      {
+        // `invalidate` messages carry an array of keys that have been
+        // modified, or nil if the database has been flushed.
+        if(!message.is_array() || (message.as_array().size() != 2))
+          return;
+
+        const auto& kind = message.as_array().at(0);
+        if(!kind.is_string() || (kind.as_string() != "invalidate"))
+          return;
+
+        const auto& keys = message.as_array().at(1);
+        if(keys.is_array()) {
+          for(const auto& key : keys.as_array())
+            if(key.is_string())
+              this->m_ctr->cache_invalidate(key.as_string());
+        }
+        else
+          this->m_ctr->cache_clear();
+      }
+
+    virtual
+    void
+    do_abstract_socket_on_closed()
+      override
+      {
+        this->Redis_TCP_Client_Session::do_abstract_socket_on_closed();
+
+        // Invalidations may have been lost, so nothing in the cache can be
+        // trusted any longer.
+        this->m_ready.store(false);
+        this->m_ctr->cache_clear();
+      }
+  };
+
+void
+do_invoke_callback(const Redis_Connector::callback_type& callback, cow_string& status,
+                   Redis_Value& value, const char* error)
+  noexcept
+  {
+    try {
+      callback(move(status), move(value), error);
+    }
+    catch(exception& stdex) {
+      POSEIDON_LOG_ERROR(("Unhandled exception from Redis callback: $1"), stdex);
+    }
+  }
+
 }  // namespace
 
 POSEIDON_HIDDEN_X_STRUCT(Redis_Connector,
   Pooled_Connection);
 
+POSEIDON_HIDDEN_X_STRUCT(Redis_Connector,
+  Pipelined_Command);
+
+POSEIDON_HIDDEN_X_STRUCT(Redis_Connector,
+  Near_Cache);
+
 Redis_Connector::
 Redis_Connector()
   noexcept
@@ -49,12 +196,38 @@ reload(const Config_File& conf_file)
     seconds connection_idle_timeout = seconds(static_cast<int>(conf_file.get_integer_opt(
                                         &"redis.connection_idle_timeout", 0, 86400).value_or(60)));
 
+    // Read pipelining settings from configuration.
+    uint32_t auto_pipeline_size = static_cast<uint32_t>(conf_file.get_integer_opt(
+                                        &"redis.auto_pipeline_size", 0, 10000).value_or(0));
+
+    // Read near cache settings from configuration.
+    uint64_t near_cache_max_size = static_cast<uint64_t>(conf_file.get_integer_opt(
+                                        &"redis.near_cache_max_size", 0, INT64_MAX).value_or(0));
+    seconds near_cache_ttl = seconds(static_cast<int>(conf_file.get_integer_opt(
+                                        &"redis.near_cache_ttl", 1, 86400).value_or(60)));
+    seconds near_cache_negative_ttl = seconds(static_cast<int>(conf_file.get_integer_opt(
+                                        &"redis.near_cache_negative_ttl", 0, 86400).value_or(10)));
+    bool near_cache_tracking = conf_file.get_boolean_opt(
+                                        &"redis.near_cache_tracking").value_or(false);
+
+    cow_vector<cow_string> near_cache_prefixes;
+    size_t count = conf_file.get_array_size_opt(&"redis.near_cache_prefixes").value_or(0);
+    for(size_t k = 0;  k != count;  ++k)
+      near_cache_prefixes.emplace_back(conf_file.get_string(
+                                        sformat("redis.near_cache_prefixes[$1]", k)));
+
     // Set up new data.
     plain_mutex::unique_lock lock(this->m_conf_mutex);
     this->m_conf_default_service_uri.swap(default_service_uri);
     this->m_conf_default_password.swap(default_password);
     this->m_conf_connection_pool_size = connection_pool_size;
     this->m_conf_connection_idle_timeout = connection_idle_timeout;
+    this->m_conf_auto_pipeline_size = auto_pipeline_size;
+    this->m_conf_near_cache_max_size = near_cache_max_size;
+    this->m_conf_near_cache_ttl = near_cache_ttl;
+    this->m_conf_near_cache_negative_ttl = near_cache_negative_ttl;
+    this->m_conf_near_cache_tracking = near_cache_tracking;
+    this->m_conf_near_cache_prefixes.swap(near_cache_prefixes);
   }
 
 POSEIDON_VISIBILITY_HIDDEN
@@ -111,6 +284,376 @@ allocate_default_connection()
     return conn;
   }
 
+POSEIDON_VISIBILITY_HIDDEN
+void
+Redis_Connector::
+do_execute_pipeline(const cow_vector<X_Pipelined_Command>& batch)
+  noexcept
+  {
+    size_t nreplies = 0;
+    cow_string status;
+    Redis_Value value;
+
+    try {
+      cow_vector<cow_vector<cow_string>> cmds;
+      cmds.reserve(batch.size());
+      for(const auto& elem : batch)
+        cmds.push_back(elem.cmd);
+
+      auto conn = this->allocate_default_connection();
+      conn->execute_pipeline(cmds);
+
+      // Replies arrive in the same order as commands. An error reply fails
+      // only its own command.
+      while(nreplies != batch.size()) {
+        cow_string error;
+        try {
+          conn->fetch_reply(status, value);
+        }
+        catch(exception& stdex) {
+          error = stdex.what();
+        }
+
+        const auto& elem = batch.at(nreplies);
+        nreplies ++;
+        do_invoke_callback(elem.callback, status, value, error.empty() ? nullptr : error.c_str());
+      }
+
+      if(conn->reset())
+        this->pool_connection(move(conn));
+    }
+    catch(exception& stdex) {
+      // Fail all commands that have not been replied.
+      POSEIDON_LOG_ERROR(("Redis pipeline error: $1"), stdex);
+
+      while(nreplies != batch.size()) {
+        const auto& elem = batch.at(nreplies);
+        nreplies ++;
+        status.clear();
+        value.clear();
+        do_invoke_callback(elem.callback, status, value, stdex.what());
+      }
+    }
+  }
+
+void
+Redis_Connector::
+execute_pipelined(const cow_vector<cow_string>& cmd, const callback_type& callback)
+  {
+    if(cmd.empty())
+      POSEIDON_THROW(("Empty Redis command"));
+
+    plain_mutex::unique_lock lock(this->m_conf_mutex);
+    const uint32_t pipeline_size = this->m_conf_auto_pipeline_size;
+    lock.unlock();
+
+    cow_vector<X_Pipelined_Command> batch;
+    auto& elem = batch.emplace_back();
+    elem.cmd = cmd;
+    elem.callback = callback;
+
+    if(pipeline_size == 0) {
+      // Automatic pipelining is disabled.
+      this->do_execute_pipeline(batch);
+      return;
+    }
+
+    lock.lock(this->m_pipeline_mutex);
+    const uint64_t serial = ++ this->m_pipeline_serial;
+    elem.serial = serial;
+    this->m_pipeline_queue.push_back(move(elem));
+    batch.clear();
+
+    // Commands are sent in batches, in the order in which they have been
+    // queued. If another thread is sending a batch, wait for it. If our
+    // command has been taken by another thread, its callback will be invoked
+    // by that thread, so return. A thread only sends batches until its own
+    // command has been sent, so it never drains the queue for others.
+    for(;;) {
+      if(this->m_pipeline_queue.empty() || (this->m_pipeline_queue.front().serial > serial))
+        return;
+
+      if(this->m_pipeline_busy) {
+        this->m_pipeline_avail.wait(lock);
+        continue;
+      }
+
+      try {
+        // Take at most `pipeline_size` commands from the queue.
+        if(this->m_pipeline_queue.size() <= pipeline_size)
+          batch.swap(this->m_pipeline_queue);
+        else {
+          auto mid = this->m_pipeline_queue.begin() + static_cast<ptrdiff_t>(pipeline_size);
+          batch.append(this->m_pipeline_queue.begin(), mid);
+          this->m_pipeline_queue.erase(this->m_pipeline_queue.begin(), mid);
+        }
+      }
+      catch(...) {
+        // The caller will get an exception, so our command must not be sent
+        // by another thread later.
+        batch.clear();
+        for(size_t k = 0;  k != this->m_pipeline_queue.size();  ++k)
+          if(this->m_pipeline_queue[k].serial == serial) {
+            this->m_pipeline_queue.erase(this->m_pipeline_queue.begin() + static_cast<ptrdiff_t>(k));
+            break;
+          }
+        throw;
+      }
+
+      this->m_pipeline_busy = true;
+      lock.unlock();
+      this->do_execute_pipeline(batch);
+      batch.clear();
+
+      lock.lock(this->m_pipeline_mutex);
+      this->m_pipeline_busy = false;
+      this->m_pipeline_avail.notify_all();
+    }
+  }
+
+POSEIDON_VISIBILITY_HIDDEN
+bool
+Redis_Connector::
+do_check_tracking_session()
+  {
+    plain_mutex::unique_lock lock(this->m_conf_mutex);
+    const cow_string service_uri = this->m_conf_default_service_uri;
+    const cow_string password = this->m_conf_default_password;
+    const cow_vector<cow_string> prefixes = this->m_conf_near_cache_prefixes;
+    lock.unlock();
+
+    lock.lock(this->m_cache_mutex);
+    auto session = this->m_tracking_session;
+    bool replace = false;
+    if(session && (session->socket_state() < socket_closing)) {
+      // If prefixes have been changed by `reload()`, the server has to be
+      // told about them, which requires a new session.
+      const auto& tracking = static_cast<const Tracking_Session&>(*session);
+      if(::std::equal(tracking.m_prefixes.begin(), tracking.m_prefixes.end(),
+                      prefixes.begin(), prefixes.end()))
+        return tracking.m_ready.load();
+
+      replace = true;
+    }
+
+    // Don't reconnect too often if the server is down.
+    const steady_time now = steady_clock::now();
+    if(!this->m_cache)
+      this->m_cache = new_sh<X_Near_Cache>();
+    else if(!replace && (now < this->m_cache->tracking_retry_time))
+      return false;
+
+    this->m_cache->tracking_retry_time = now + 5s;
+    lock.unlock();
+
+    // Parse the service URI in a hacky way. Invalidations are broadcast for
+    // all databases, so the database is ignored.
+    cow_string user = &"default";
+    cow_string host = &"localhost";
+    uint16_t port = 6379;
+
+    cow_string uri = service_uri;
+    size_t t = uri.find_of("@/");
+    if((t != cow_string::npos) && (uri[t] == '@')) {
+      user.assign(uri, 0, t);
+      uri.erase(0, t + 1);
+    }
+
+    Network_Reference ref;
+    if(parse_network_reference(ref, uri) != uri.size())
+      POSEIDON_THROW((
+          "Invalid Redis service URI `$1`",
+          "[`parse_network_reference()` failed]"),
+          service_uri);
+
+    if(ref.host.n != 0)
+      host.assign(ref.host.p, ref.host.n);
+
+    if(ref.port.n != 0)
+      port = ref.port_num;
+
+    // Ask the server to send invalidations for keys that are modified by
+    // anyone. In broadcasting mode, the server sends invalidations for all
+    // keys unless prefixes are specified, so only keys that may be cached are
+    // subscribed to. The session is not ready until the server has agreed.
+    auto new_session = new_sh<Tracking_Session>(*this, user, password, prefixes);
+    auto raw_session = new_session.get();
+    cow_vector<cow_string> cmd = { &"CLIENT", &"TRACKING", &"on", &"BCAST" };
+    for(const auto& prefix : prefixes) {
+      cmd.emplace_back(&"PREFIX");
+      cmd.emplace_back(prefix);
+    }
+    new_session->redis_execute(cmd,
+      [raw_session](cow_string&& /*status*/, Redis_Value&& /*value*/, const char* error)
+        {
+          if(error) {
+            POSEIDON_LOG_ERROR(("Could not enable Redis client tracking: $1"), error);
+            raw_session->quick_shut_down();
+            return;
+          }
+
+          raw_session->m_ready.store(true);
+          POSEIDON_LOG_INFO(("Redis near cache tracking enabled"));
+        });
+
+    lock.lock(this->m_cache_mutex);
+    if(this->m_tracking_session != session)
+      return false;
+
+    this->m_tracking_session = new_session;
+    lock.unlock();
+
+    // Values that were cached before this session may be stale. The old
+    // session, if any, is not needed any longer.
+    if(replace)
+      session->quick_shut_down();
+
+    this->cache_clear();
+    task_scheduler.launch(new_sh<DNS_Connect_Task>(network_scheduler, new_session, host, port));
+    return false;
+  }
+
+bool
+Redis_Connector::
+cache_lookup(Redis_Value& value, uint64_t& serial, const cow_string& key)
+  {
+    serial = 0;
+
+    plain_mutex::unique_lock lock(this->m_conf_mutex);
+    const uint64_t max_size = this->m_conf_near_cache_max_size;
+    const bool tracking = this->m_conf_near_cache_tracking;
+    const cow_vector<cow_string> prefixes = this->m_conf_near_cache_prefixes;
+    lock.unlock();
+
+    if(max_size == 0)
+      return false;
+
+    // Keys that match no prefix are never cached, as no invalidation would be
+    // received for them.
+    if(!do_match_prefixes(prefixes, key)) {
+      this->m_cache_misses.xadd(1);
+      return false;
+    }
+
+    if(tracking && !this->do_check_tracking_session()) {
+      this->m_cache_misses.xadd(1);
+      return false;
+    }
+
+    lock.lock(this->m_cache_mutex);
+    if(!this->m_cache)
+      this->m_cache = new_sh<X_Near_Cache>();
+
+    auto& cache = *(this->m_cache);
+    const steady_time now = steady_clock::now();
+    auto it = cache.values.find(key);
+    if((it != cache.values.end()) && (it->second.serial == 0) && (now < it->second.expiry)) {
+      // Move this value to the front.
+      cache.lru.splice(cache.lru.begin(), cache.lru, it->second.lru_pos);
+      value = it->second.value;
+      this->m_cache_hits.xadd(1);
+      return true;
+    }
+
+    this->m_cache_misses.xadd(1);
+
+    // Insert a placeholder, which will be removed if the key is invalidated
+    // before the value arrives.
+    if(it == cache.values.end()) {
+      cache.lru.push_front(key);
+      try {
+        it = cache.values.emplace(key, Cached_Value()).first;
+      }
+      catch(...) {
+        cache.lru.pop_front();
+        throw;
+      }
+      it->second.lru_pos = cache.lru.begin();
+    }
+
+    cache.total_size -= it->second.size;
+    it->second.value.clear();
+    it->second.size = do_estimate_size(key, nullptr);
+    it->second.serial = ++ cache.next_serial;
+    cache.total_size += it->second.size;
+    serial = it->second.serial;
+
+    // Evict least recently used values. The placeholder itself may be evicted,
+    // in which case the value will not be stored.
+    while(!cache.lru.empty() && (cache.total_size > max_size))
+      do_erase_cached_value(cache, cache.values.find(cache.lru.back()));
+
+    return false;
+  }
+
+void
+Redis_Connector::
+cache_store(const cow_string& key, uint64_t serial, const Redis_Value& value)
+  {
+    if(serial == 0)
+      return;
+
+    plain_mutex::unique_lock lock(this->m_conf_mutex);
+    const uint64_t max_size = this->m_conf_near_cache_max_size;
+    const seconds ttl = value.is_nil() ? this->m_conf_near_cache_negative_ttl
+                                       : this->m_conf_near_cache_ttl;
+    lock.unlock();
+
+    lock.lock(this->m_cache_mutex);
+    if(!this->m_cache)
+      return;
+
+    auto& cache = *(this->m_cache);
+    auto it = cache.values.find(key);
+    if((it == cache.values.end()) || (it->second.serial != serial))
+      return;
+
+    if(ttl == 0s) {
+      do_erase_cached_value(cache, it);
+      return;
+    }
+
+    cache.total_size -= it->second.size;
+    it->second.value = value;
+    it->second.expiry = steady_clock::now() + ttl;
+    it->second.serial = 0;
+    it->second.size = do_estimate_size(key, value);
+    cache.total_size += it->second.size;
+    cache.lru.splice(cache.lru.begin(), cache.lru, it->second.lru_pos);
+
+    // Evict least recently used values.
+    while(!cache.lru.empty() && (cache.total_size > max_size))
+      do_erase_cached_value(cache, cache.values.find(cache.lru.back()));
+  }
+
+void
+Redis_Connector::
+cache_invalidate(const cow_string& key)
+  {
+    plain_mutex::unique_lock lock(this->m_cache_mutex);
+    if(!this->m_cache)
+      return;
+
+    auto& cache = *(this->m_cache);
+    auto it = cache.values.find(key);
+    if(it != cache.values.end())
+      do_erase_cached_value(cache, it);
+  }
+
+void
+Redis_Connector::
+cache_clear()
+  {
+    plain_mutex::unique_lock lock(this->m_cache_mutex);
+    if(!this->m_cache)
+      return;
+
+    auto& cache = *(this->m_cache);
+    cache.values.clear();
+    cache.lru.clear();
+    cache.total_size = 0;
+  }
+
 bool
 Redis_Connector::
 pool_connection(uniptr<Redis_Connection>&& conn)
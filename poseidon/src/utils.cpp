@@ -280,6 +280,87 @@ random_bytes(void* ptr, size_t size)
           ::ERR_reason_error_string(::ERR_get_error()));
   }
 
+namespace {
+
+size_t
+do_parse_path_query_fragment(Network_Reference& caddr, chars_view str, const char* mptr)
+  noexcept
+  {
+    // `mptr` points to the first character after the host and port.
+    const char* bptr;
+
+    if(*mptr == '/') {
+      // Get a path. The leading slash is part of the path.
+      bptr = mptr;
+      mptr = ::std::find_if_not(bptr, str.p + str.n,
+        [](char c) {
+          return ((c >= '0') && (c <= '9'))
+                 || ((c >= 'A') && (c <= 'Z')) || ((c >= 'a') && (c <= 'z'))
+                 || (c == '-') || (c == '.') || (c == '_') || (c == '~')  // ^^ unreserved
+                 || (c == '!') || (c == '$') || (c == '&') || (c == '\'')
+                 || (c == '(') || (c == ')') || (c == '*') || (c == '+')
+                 || (c == ',') || (c == ';') || (c == '=')  // ^^ sub-delims
+                 || (c == '%') || (c == ':') || (c == '@')  // ^^ pchar
+                 || (c == '/');
+        });
+
+      caddr.path.p = bptr;
+      caddr.path.n = (size_t) (mptr - bptr);
+
+      if(mptr == str.p + str.n)
+        return str.n;
+    }
+
+    if(*mptr == '?') {
+      // Get a query string.
+      bptr = mptr + 1;
+      mptr = ::std::find_if_not(bptr, str.p + str.n,
+        [](char c) {
+          return ((c >= '0') && (c <= '9'))
+                 || ((c >= 'A') && (c <= 'Z')) || ((c >= 'a') && (c <= 'z'))
+                 || (c == '-') || (c == '.') || (c == '_') || (c == '~')  // ^^ unreserved
+                 || (c == '!') || (c == '$') || (c == '&') || (c == '\'')
+                 || (c == '(') || (c == ')') || (c == '*') || (c == '+')
+                 || (c == ',') || (c == ';') || (c == '=')  // ^^ sub-delims
+                 || (c == '%') || (c == ':') || (c == '@')  // ^^ pchar
+                 || (c == '/') || (c == '?');
+        });
+
+      caddr.query.p = bptr;
+      caddr.query.n = (size_t) (mptr - bptr);
+
+      if(mptr == str.p + str.n)
+        return str.n;
+    }
+
+    if(*mptr == '#') {
+      // Get a fragment string.
+      bptr = mptr + 1;
+      mptr = ::std::find_if_not(bptr, str.p + str.n,
+        [](char c) {
+          return ((c >= '0') && (c <= '9'))
+                 || ((c >= 'A') && (c <= 'Z')) || ((c >= 'a') && (c <= 'z'))
+                 || (c == '-') || (c == '.') || (c == '_') || (c == '~')  // ^^ unreserved
+                 || (c == '!') || (c == '$') || (c == '&') || (c == '\'')
+                 || (c == '(') || (c == ')') || (c == '*') || (c == '+')
+                 || (c == ',') || (c == ';') || (c == '=')  // ^^ sub-delims
+                 || (c == '%') || (c == ':') || (c == '@')  // ^^ pchar
+                 || (c == '/') || (c == '?') || (c == '#');
+        });
+
+      caddr.fragment.p = bptr;
+      caddr.fragment.n = (size_t) (mptr - bptr);
+
+      if(mptr == str.p + str.n)
+        return str.n;
+    }
+
+    // Return the number of characters that have been consumed.
+    return (size_t) (mptr - str.p);
+  }
+
+}  // namespace
+
 size_t
 parse_network_reference(Network_Reference& caddr, chars_view str)
   noexcept
@@ -364,74 +445,18 @@ parse_network_reference(Network_Reference& caddr, chars_view str)
         return str.n;
     }
 
-    if(*mptr == '/') {
-      // Get a path. The leading slash is part of the path.
-      bptr = mptr;
-      mptr = ::std::find_if_not(bptr, str.p + str.n,
-        [](char c) {
-          return ((c >= '0') && (c <= '9'))
-                 || ((c >= 'A') && (c <= 'Z')) || ((c >= 'a') && (c <= 'z'))
-                 || (c == '-') || (c == '.') || (c == '_') || (c == '~')  // ^^ unreserved
-                 || (c == '!') || (c == '$') || (c == '&') || (c == '\'')
-                 || (c == '(') || (c == ')') || (c == '*') || (c == '+')
-                 || (c == ',') || (c == ';') || (c == '=')  // ^^ sub-delims
-                 || (c == '%') || (c == ':') || (c == '@')  // ^^ pchar
-                 || (c == '/');
-        });
-
-      caddr.path.p = bptr;
-      caddr.path.n = (size_t) (mptr - bptr);
-
-      if(mptr == str.p + str.n)
-        return str.n;
-    }
-
-    if(*mptr == '?') {
-      // Get a query string.
-      bptr = mptr + 1;
-      mptr = ::std::find_if_not(bptr, str.p + str.n,
-        [](char c) {
-          return ((c >= '0') && (c <= '9'))
-                 || ((c >= 'A') && (c <= 'Z')) || ((c >= 'a') && (c <= 'z'))
-                 || (c == '-') || (c == '.') || (c == '_') || (c == '~')  // ^^ unreserved
-                 || (c == '!') || (c == '$') || (c == '&') || (c == '\'')
-                 || (c == '(') || (c == ')') || (c == '*') || (c == '+')
-                 || (c == ',') || (c == ';') || (c == '=')  // ^^ sub-delims
-                 || (c == '%') || (c == ':') || (c == '@')  // ^^ pchar
-                 || (c == '/') || (c == '?');
-        });
-
-      caddr.query.p = bptr;
-      caddr.query.n = (size_t) (mptr - bptr);
-
-      if(mptr == str.p + str.n)
-        return str.n;
-    }
-
-    if(*mptr == '#') {
-      // Get a fragment string.
-      bptr = mptr + 1;
-      mptr = ::std::find_if_not(bptr, str.p + str.n,
-        [](char c) {
-          return ((c >= '0') && (c <= '9'))
-                 || ((c >= 'A') && (c <= 'Z')) || ((c >= 'a') && (c <= 'z'))
-                 || (c == '-') || (c == '.') || (c == '_') || (c == '~')  // ^^ unreserved
-                 || (c == '!') || (c == '$') || (c == '&') || (c == '\'')
-                 || (c == '(') || (c == ')') || (c == '*') || (c == '+')
-                 || (c == ',') || (c == ';') || (c == '=')  // ^^ sub-delims
-                 || (c == '%') || (c == ':') || (c == '@')  // ^^ pchar
-                 || (c == '/') || (c == '?') || (c == '#');
-        });
-
-      caddr.fragment.p = bptr;
-      caddr.fragment.n = (size_t) (mptr - bptr);
+    return do_parse_path_query_fragment(caddr, str, mptr);
+  }
 
-      if(mptr == str.p + str.n)
-        return str.n;
-    }
+size_t
+parse_request_target(Network_Reference& caddr, chars_view str)
+  noexcept
+  {
+    // Only the origin form is accepted, which starts with a slash.
+    if((str.n == 0) || (*(str.p) != '/'))
+      return 0;
 
-    // Return the number of characters that have been consumed.
-    return (size_t) (mptr - str.p);
+    return do_parse_path_query_fragment(caddr, str, str.p);
   }
 
 cow_string
@@ -0,0 +1,86 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_STATIC_DNS_RESOLVER_
+#define POSEIDON_STATIC_DNS_RESOLVER_
+
+#include "../fwd.hpp"
+#include "../socket/ipv6_address.hpp"
+namespace poseidon {
+
+class DNS_Resolver
+  {
+  public:
+    // This is the user-defined callback, where `addrs` is the list of
+    // addresses that have been found, and `error` is a description of the
+    // error if the lookup has failed. IPv6 addresses precede IPv4 ones, and
+    // all ports are zero. The callback may be invoked by the calling thread,
+    // the network thread, or the timer thread, and shall not block.
+    using callback_type = shared_function<
+            void
+             (const cow_vector<IPv6_Address>& addrs,
+              const char* error)>;
+
+  private:
+    mutable plain_mutex m_conf_mutex;
+    cow_dictionary<cow_vector<IPv6_Address>> m_conf_hosts;
+    bool m_conf_use_hosts = true;
+    bool m_conf_hosts_first = true;
+    cow_vector<phcow_string> m_conf_search;
+    uint32_t m_conf_ndots = 1;
+    milliseconds m_conf_connection_attempt_delay = 250ms;
+
+    struct X_Query_Table;
+    shptr<X_Query_Table> m_table;
+
+  public:
+    // Constructs an empty resolver.
+    DNS_Resolver()
+      noexcept;
+
+  public:
+    DNS_Resolver(const DNS_Resolver&) = delete;
+    DNS_Resolver& operator=(const DNS_Resolver&) & = delete;
+    ~DNS_Resolver();
+
+    // Reloads configuration from 'main.conf', as well as name servers, the
+    // search list and options from '/etc/resolv.conf', static hosts from
+    // '/etc/hosts', and whether they precede DNS from '/etc/nsswitch.conf'.
+    // All cached results are discarded.
+    // If this function fails, an exception is thrown, and there is no effect.
+    // This function is thread-safe.
+    void
+    reload(const Config_File& conf_file);
+
+    // Gets the delay between two connection attempts to addresses of the same
+    // host, as in Happy Eyeballs (RFC 8305). This is used by `DNS_Connect_Task`.
+    // This function is thread-safe.
+    milliseconds
+    connection_attempt_delay()
+      const noexcept;
+
+    // Looks up addresses of a host asynchronously. If `host` is an IP address
+    // or a name in the hosts file, or if a cached result is available, the
+    // callback is invoked before this function returns; otherwise, A and AAAA
+    // queries are sent to name servers over UDP (and over TCP if a response is
+    // truncated), and the callback will be invoked by the network thread, or
+    // by the timer thread in case of a timeout. Each query is sent from a new
+    // socket with a random ID. Unless `host` ends with a dot, names in the
+    // search list are tried according to `ndots`, like the resolver of glibc.
+    // Concurrent lookups of the same host share the same queries. Results are
+    // cached according to their TTL values; failures are also cached according
+    // to SOA records.
+    // If this function throws an exception, there is no effect.
+    // This function is thread-safe.
+    void
+    resolve(const cow_string& host, const callback_type& callback);
+
+    // Discards all cached results.
+    // This function is thread-safe.
+    void
+    clear_cache()
+      noexcept;
+  };
+
+}  // namespace poseidon
+#endif
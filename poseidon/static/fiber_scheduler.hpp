@@ -16,6 +16,7 @@ class Fiber_Scheduler
     uint32_t m_conf_stack_vm_size = 0;
     seconds m_conf_warn_timeout = 0s;
     seconds m_conf_fail_timeout = 0s;
+    seconds m_conf_park_timeout = 0s;
 
     mutable plain_mutex m_pq_mutex;
     cow_vector<shptr<X_Queued_Fiber>> m_pq;
@@ -36,6 +37,10 @@ class Fiber_Scheduler
     void
     do_fiber_yield_function(const shptr<Abstract_Future>& futr_opt);
 
+    static
+    void
+    do_fiber_park_function(milliseconds timeout);
+
   public:
     Fiber_Scheduler(const Fiber_Scheduler&) = delete;
     Fiber_Scheduler& operator=(const Fiber_Scheduler&) & = delete;
@@ -52,6 +57,14 @@ class Fiber_Scheduler
     void
     thread_loop();
 
+    // Gets the number of seconds for which an idle fiber of an Easy server
+    // stays parked, before it exits and its stack is reclaimed. If this is
+    // zero, such fibers exit as soon as they become idle.
+    // This function is thread-safe.
+    seconds
+    park_timeout()
+      const noexcept;
+
     // Returns the number of fibers that are being scheduled.
     // This function is thread-safe.
     ASTERIA_PURE
@@ -0,0 +1,70 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#ifndef POSEIDON_STATIC_HTTP_CONNECTOR_
+#define POSEIDON_STATIC_HTTP_CONNECTOR_
+
+#include "../fwd.hpp"
+#include "../http/http_c_headers.hpp"
+#include "../http/http_s_headers.hpp"
+namespace poseidon {
+
+class HTTP_Connector
+  {
+  public:
+    // This is the user-defined callback, where `resp` and `data` are the
+    // headers and body of the response, respectively, and `error` is a
+    // description of the error if the request has failed. The callback is
+    // invoked by the network thread, and shall not block.
+    using callback_type = shared_function<
+            void
+             (HTTP_S_Headers&& resp,
+              linear_buffer&& data,
+              const char* error)>;
+
+  private:
+    mutable plain_mutex m_conf_mutex;
+    struct X_Connection_Pool;
+    shptr<X_Connection_Pool> m_pool;
+
+  public:
+    // Constructs an empty connector.
+    HTTP_Connector()
+      noexcept;
+
+  public:
+    HTTP_Connector(const HTTP_Connector&) = delete;
+    HTTP_Connector& operator=(const HTTP_Connector&) & = delete;
+    ~HTTP_Connector();
+
+    // Reloads configuration from 'main.conf'. Idle connections are not
+    // affected until they are reused.
+    // If this function fails, an exception is thrown, and there is no effect.
+    // This function is thread-safe.
+    void
+    reload(const Config_File& conf_file);
+
+    // Sends a request to the server denoted by `req.raw_host` and `req.port`,
+    // over TLS if `req.is_ssl` is set. If `req.port` is zero, 80 or 443 is
+    // implied. If an idle connection to the same origin exists in the pool, it
+    // is reused; otherwise a new connection is created, resuming a previous TLS
+    // session if possible. After a response has been received, the connection
+    // is put back into the pool, unless it will be closed by the server. If a
+    // reused connection is closed before a response to an idempotent request
+    // arrives, the request is retried once on a new connection. Proxy requests
+    // and CONNECT requests are not supported.
+    // If this function throws an exception, there is no effect.
+    // This function is thread-safe.
+    void
+    request(const HTTP_C_Headers& req, const cow_string& payload, const callback_type& callback);
+
+    // Shuts down all idle connections, and discards all TLS sessions. Requests
+    // in progress are not affected.
+    // This function is thread-safe.
+    void
+    close_idle_connections()
+      noexcept;
+  };
+
+}  // namespace poseidon
+#endif
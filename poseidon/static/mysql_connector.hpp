@@ -9,6 +9,16 @@ namespace poseidon {
 
 class MySQL_Connector
   {
+  public:
+    // This is the callback for asynchronous operations, where `conn` is the
+    // connection on which the statement has been executed, and `error` is a
+    // description of the error if the operation has failed. The callback is
+    // invoked by the network thread, and shall not block.
+    using callback_type = shared_function<
+            void
+             (uniptr<MySQL_Connection>&& conn,
+              const char* error)>;
+
   private:
     mutable plain_mutex m_conf_mutex;
     cow_string m_conf_default_service_uri;
@@ -19,6 +29,9 @@ class MySQL_Connector
     cow_string m_conf_tertiary_password;
     uint32_t m_conf_connection_pool_size = 0;
     seconds m_conf_connection_idle_timeout = 0s;
+    uint32_t m_conf_statement_cache_size = 0;
+    bool m_conf_keep_statements_on_reset = false;
+    bool m_conf_asynchronous_queries = false;
 
     mutable plain_mutex m_pool_mutex;
     struct X_Pooled_Connection;
@@ -31,7 +44,12 @@ class MySQL_Connector
 
   private:
     uniptr<MySQL_Connection>
-    do_get_pooled_connection_opt(seconds idle_timeout, const cow_string& service_uri);
+    do_get_pooled_connection_opt(seconds idle_timeout, const cow_string& service_uri,
+                                 bool async);
+
+    void
+    do_await_async(uniptr<MySQL_Connection>&& conn, recursive_mutex::unique_lock& io_lock,
+                   const callback_type& callback);
 
   public:
     MySQL_Connector(const MySQL_Connector&) = delete;
@@ -46,7 +64,8 @@ class MySQL_Connector
 
     // Allocates a connection to `user@server:port/database`. If a matching
     // idle connection exists in the pool, it is returned; otherwise a new
-    // connection is created.
+    // connection is created. The size of its statement cache, and whether
+    // cached statements are kept by `.reset()`, are set from 'main.conf'.
     uniptr<MySQL_Connection>
     allocate_connection(const cow_string& service_uri, const cow_string& password);
 
@@ -67,6 +86,27 @@ class MySQL_Connector
     uniptr<MySQL_Connection>
     allocate_tertiary_connection();
 
+    // Checks whether `MySQL_Query_Future` shall execute statements with
+    // `execute_async()` by default. This is set from 'main.conf'.
+    // This function is thread-safe.
+    bool
+    asynchronous_queries()
+      const;
+
+    // Executes a statement without blocking the calling thread. If `conn_opt` is
+    // null, a connection is allocated using arguments from 'main.conf'. The
+    // connection is polled by the network scheduler, so many statements can be
+    // in flight without a thread for each of them. Synchronous and asynchronous
+    // connections are pooled separately. See `MySQL_Connection::
+    // execute_nonblocking_start()` for details about `stmt` and `args`. After
+    // the operation has completed, `callback` is invoked with the connection,
+    // from which results can be fetched without blocking.
+    // If this function throws an exception, the connection is closed.
+    // This function is thread-safe.
+    void
+    execute_async(uniptr<MySQL_Connection>&& conn_opt, const cow_string& stmt,
+                  const cow_vector<MySQL_Value>& args, const callback_type& callback);
+
     // Puts a connection back into the pool. It is required to `.reset()` a
     // connection before putting it back. Resetting a connection is a blocking
     // operation that we can't afford. Hence, if the connection has not been
@@ -74,6 +114,15 @@ class MySQL_Connector
     // returned.
     bool
     pool_connection(uniptr<MySQL_Connection>&& conn);
+
+    // Resets an asynchronous connection without blocking the calling thread,
+    // and puts it back into the pool after the server has responded. This is
+    // the non-blocking counterpart of `.reset()` followed by `pool_connection()`,
+    // and shall be used by the network thread. If the connection can't be
+    // reset, it is closed.
+    // This function is thread-safe.
+    void
+    pool_connection_async(uniptr<MySQL_Connection>&& conn);
   };
 
 }  // namespace poseidon
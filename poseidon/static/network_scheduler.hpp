@@ -5,6 +5,7 @@
 #define POSEIDON_STATIC_NETWORK_SCHEDULER_
 
 #include "../fwd.hpp"
+#include "../socket/enums.hpp"
 #include "../details/openssl_fwd.hpp"
 #include <valarray>
 namespace poseidon {
@@ -15,6 +16,11 @@ class Network_Scheduler
     mutable plain_mutex m_conf_mutex;
     uint32_t m_event_buffer_size = 0;
     uint32_t m_throttle_size = 0;
+    uint32_t m_udp_receive_batch_size = 32;
+    bool m_udp_gro = false;
+    bool m_udp_gso = false;
+    UDP_Drop_Policy m_udp_drop_policy = udp_drop_newest;
+    uint32_t m_udp_send_queue_size = 0;
     uniptr_SSL_CTX m_server_ssl_ctx;
     uniptr_SSL_CTX m_client_ssl_ctx;
 
@@ -36,6 +42,9 @@ class Network_Scheduler
     do_find_socket_nolock(volatile Abstract_Socket* socket)
       noexcept;
 
+    void
+    do_modify_epoll_events_nolock(Abstract_Socket& socket);
+
   public:
     Network_Scheduler(const Network_Scheduler&) = delete;
     Network_Scheduler& operator=(const Network_Scheduler&) & = delete;
@@ -59,6 +68,43 @@ class Network_Scheduler
     client_ssl_ctx()
       const;
 
+    // Gets the maximum number of bytes that may be pending in the write queue
+    // of a socket, before reading is suspended.
+    // This function is thread-safe.
+    uint32_t
+    throttle_size()
+      const noexcept;
+
+    // Gets the maximum number of UDP packets that may be received with a single
+    // system call.
+    // This function is thread-safe.
+    uint32_t
+    udp_receive_batch_size()
+      const noexcept;
+
+    // Checks whether UDP generic receive offload (GRO) and generic segmentation
+    // offload (GSO) have been enabled in 'main.conf'.
+    // These functions are thread-safe.
+    bool
+    udp_gro_enabled()
+      const noexcept;
+
+    bool
+    udp_gso_enabled()
+      const noexcept;
+
+    // Gets the default limit of the send queue of a UDP socket, in bytes, and
+    // how to drop packets if the queue is full. These values are copied by new
+    // sockets, and can be overridden by `UDP_Socket::udp_set_send_queue()`.
+    // These functions are thread-safe.
+    uint32_t
+    udp_send_queue_size()
+      const noexcept;
+
+    UDP_Drop_Policy
+    udp_drop_policy()
+      const noexcept;
+
     // Reloads configuration from 'main.conf'.
     // If this function fails, an exception is thrown, and there is no effect.
     // This function is thread-safe.
@@ -75,6 +121,15 @@ class Network_Scheduler
     // This function is thread-safe.
     void
     insert_weak(const shptr<Abstract_Socket>& socket);
+
+    // Suspends or resumes reading from a socket. While reading is suspended,
+    // incoming data are left in the system receive buffer, so the peer will
+    // eventually be blocked by TCP flow control. This can be used to apply
+    // backpressure when incoming data arrive faster than they are consumed.
+    // Writing is not affected.
+    // This function is thread-safe.
+    void
+    pause_reading(Abstract_Socket& socket, bool paused);
   };
 
 }  // namespace poseidon
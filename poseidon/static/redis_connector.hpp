@@ -9,17 +9,48 @@ namespace poseidon {
 
 class Redis_Connector
   {
+  public:
+    // This is the callback for pipelined commands, where `status` and `value`
+    // are the reply of the command, and `error` is a description of the error
+    // if the command has failed. The callback may be invoked by a thread that
+    // has submitted another command, and shall not block.
+    using callback_type = shared_function<
+            void
+             (cow_string&& status,
+              Redis_Value&& value,
+              const char* error)>;
+
   private:
     mutable plain_mutex m_conf_mutex;
     cow_string m_conf_default_service_uri;
     cow_string m_conf_default_password;
     uint32_t m_conf_connection_pool_size = 0;
     seconds m_conf_connection_idle_timeout = 0s;
+    uint32_t m_conf_auto_pipeline_size = 0;
+    uint64_t m_conf_near_cache_max_size = 0;
+    seconds m_conf_near_cache_ttl = 0s;
+    seconds m_conf_near_cache_negative_ttl = 0s;
+    bool m_conf_near_cache_tracking = false;
+    cow_vector<cow_string> m_conf_near_cache_prefixes;
 
     mutable plain_mutex m_pool_mutex;
     struct X_Pooled_Connection;
     cow_vector<X_Pooled_Connection> m_pool;
 
+    mutable plain_mutex m_pipeline_mutex;
+    struct X_Pipelined_Command;
+    condition_variable m_pipeline_avail;
+    cow_vector<X_Pipelined_Command> m_pipeline_queue;
+    uint64_t m_pipeline_serial = 0;
+    bool m_pipeline_busy = false;
+
+    mutable plain_mutex m_cache_mutex;
+    struct X_Near_Cache;
+    shptr<X_Near_Cache> m_cache;
+    shptr<Redis_TCP_Client_Session> m_tracking_session;
+    atomic_relaxed<uint64_t> m_cache_hits;
+    atomic_relaxed<uint64_t> m_cache_misses;
+
   public:
     // Constructs an empty connector.
     Redis_Connector()
@@ -29,6 +60,13 @@ class Redis_Connector
     uniptr<Redis_Connection>
     do_get_pooled_connection_opt(seconds idle_timeout, const cow_string& service_uri);
 
+    void
+    do_execute_pipeline(const cow_vector<X_Pipelined_Command>& batch)
+      noexcept;
+
+    bool
+    do_check_tracking_session();
+
   public:
     Redis_Connector(const Redis_Connector&) = delete;
     Redis_Connector& operator=(const Redis_Connector&) & = delete;
@@ -51,6 +89,60 @@ class Redis_Connector
     uniptr<Redis_Connection>
     allocate_default_connection();
 
+    // Executes a command on a connection using arguments from 'main.conf', and
+    // invokes `callback` with its reply. If automatic pipelining is enabled,
+    // commands that are submitted concurrently are queued, and sent in batches
+    // of at most `redis.auto_pipeline_size` commands on a single connection,
+    // one batch at a time. A caller waits for the batch in progress, and then
+    // either returns if its command has been taken by another caller, whose
+    // thread will invoke its callback, or sends the next batch itself. If
+    // automatic pipelining is disabled, the command is executed on its own
+    // connection. This function may block.
+    // This function is thread-safe.
+    void
+    execute_pipelined(const cow_vector<cow_string>& cmd, const callback_type& callback);
+
+    // Looks up a value in the near cache, which is enabled by `redis.near_cache_
+    // max_size` in 'main.conf'. If an unexpired value is found, it is copied
+    // into `value`, and `true` is returned. Otherwise, `false` is returned, and
+    // `serial` is set to a non-zero value if the value may be cached; after the
+    // value has been read from the server, `cache_store()` shall be called with
+    // this `serial`, so the value will not be stored if the key has been
+    // invalidated in the meantime. If `redis.near_cache_prefixes` is not empty,
+    // only keys that begin with one of them are cached. If `redis.near_cache_
+    // tracking` is enabled, no value is cached until the invalidation channel
+    // has been established.
+    // This function is thread-safe.
+    bool
+    cache_lookup(Redis_Value& value, uint64_t& serial, const cow_string& key);
+
+    // Stores a value that has been read from the server into the near cache. A
+    // nil value denotes a key that doesn't exist, and is cached for a shorter
+    // time. If `serial` doesn't match the result of `cache_lookup()`, there is
+    // no effect.
+    // This function is thread-safe.
+    void
+    cache_store(const cow_string& key, uint64_t serial, const Redis_Value& value);
+
+    // Removes a key or all keys from the near cache.
+    // These functions are thread-safe.
+    void
+    cache_invalidate(const cow_string& key);
+
+    void
+    cache_clear();
+
+    // Gets statistics of the near cache.
+    uint64_t
+    cache_hit_count()
+      const noexcept
+      { return this->m_cache_hits.load();  }
+
+    uint64_t
+    cache_miss_count()
+      const noexcept
+      { return this->m_cache_misses.load();  }
+
     // Puts a connection back into the pool. It is required to `.reset()` a
     // connection before putting it back. Resetting a connection is a blocking
     // operation that we can't afford. Hence, if the connection has not been
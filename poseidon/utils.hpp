@@ -178,6 +178,14 @@ size_t
 parse_network_reference(Network_Reference& caddr, chars_view str)
   noexcept;
 
+// Parses the target of an HTTP request in origin form, which is an absolute
+// path, followed by an optional query string, and an optional fragment. The
+// `host` and `port` fields in `caddr` are left unmodified. Other fields and
+// the return value are the same as `parse_network_reference()`.
+size_t
+parse_request_target(Network_Reference& caddr, chars_view str)
+  noexcept;
+
 // URL-decodes and then canonicalizes the path (of a network reference). The
 // result path will always start with a slash. If the source path appears to
 // denote a directory, the the result path will also end with a slash.
@@ -0,0 +1,79 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/details/chunk_queue.hpp"
+using namespace ::poseidon;
+
+static
+cow_string
+do_gather_all(const chunk_queue& queue)
+  {
+    ::iovec iov[100];
+    size_t niov = queue.gather(iov, 100);
+    cow_string str;
+    for(size_t k = 0;  k != niov;  ++k)
+      str.append(static_cast<const char*>(iov[k].iov_base), iov[k].iov_len);
+    return str;
+  }
+
+int
+main()
+  {
+    chunk_queue queue;
+    POSEIDON_TEST_CHECK(queue.empty());
+    POSEIDON_TEST_CHECK(queue.memory_size() == 0);
+
+    // Small writes share a segment.
+    queue.append("hello", 5);
+    queue.append(",", 1);
+    queue.append(cow_string(" world"));
+    POSEIDON_TEST_CHECK(queue.size() == 12);
+    POSEIDON_TEST_CHECK(queue.memory_size() == chunk_queue::segment_size);
+    POSEIDON_TEST_CHECK(do_gather_all(queue) == "hello, world");
+
+    // Large strings are shared.
+    cow_string large(5000, 'a');
+    queue.append(large, 1000);
+    POSEIDON_TEST_CHECK(queue.size() == 4012);
+    POSEIDON_TEST_CHECK(queue.memory_size() == chunk_queue::segment_size);
+
+    ::iovec iov[10];
+    POSEIDON_TEST_CHECK(queue.gather(iov, 10) == 2);
+    POSEIDON_TEST_CHECK(iov[1].iov_base == large.data() + 1000);
+    POSEIDON_TEST_CHECK(iov[1].iov_len == 4000);
+
+    // Data after a shared string go into a new segment.
+    queue.append("!", 1);
+    POSEIDON_TEST_CHECK(queue.gather(iov, 10) == 3);
+    POSEIDON_TEST_CHECK(queue.memory_size() == chunk_queue::segment_size * 2);
+
+    queue.discard(7);
+    POSEIDON_TEST_CHECK(queue.size() == 4006);
+    POSEIDON_TEST_CHECK(do_gather_all(queue) == cow_string("world") + cow_string(4000, 'a') + "!");
+
+    // One segment is kept for reuse.
+    queue.discard(4006);
+    POSEIDON_TEST_CHECK(queue.empty());
+    POSEIDON_TEST_CHECK(queue.gather(iov, 10) == 0);
+    POSEIDON_TEST_CHECK(queue.memory_size() == chunk_queue::segment_size);
+
+    // Large copies are split into segments.
+    cow_string data;
+    for(size_t k = 0;  k != 100000;  ++k)
+      data.push_back(static_cast<char>('0' + k % 10));
+
+    queue.append(data.data(), data.size());
+    POSEIDON_TEST_CHECK(queue.size() == 100000);
+    POSEIDON_TEST_CHECK(queue.gather(iov, 10) == 7);
+    POSEIDON_TEST_CHECK(queue.memory_size() == chunk_queue::segment_size * 7);
+    POSEIDON_TEST_CHECK(do_gather_all(queue) == data);
+
+    queue.discard(50000);
+    POSEIDON_TEST_CHECK(queue.memory_size() == chunk_queue::segment_size * 5);
+    POSEIDON_TEST_CHECK(do_gather_all(queue) == data.substr(50000));
+
+    queue.discard(50000);
+    POSEIDON_TEST_CHECK(queue.empty());
+    POSEIDON_TEST_CHECK(queue.memory_size() == chunk_queue::segment_size);
+  }
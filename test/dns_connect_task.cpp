@@ -0,0 +1,171 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/socket/dns_connect_task.hpp"
+#include "../poseidon/socket/tcp_socket.hpp"
+#include "../poseidon/static/dns_resolver.hpp"
+#include "../poseidon/static/network_scheduler.hpp"
+#include "../poseidon/static/timer_scheduler.hpp"
+#include "../poseidon/static/task_scheduler.hpp"
+#include "../poseidon/base/config_file.hpp"
+#include "../poseidon/base/abstract_task.hpp"
+#include "../poseidon/base/abstract_timer.hpp"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+using namespace ::poseidon;
+
+static ::std::atomic<bool> stopping;
+
+struct Test_Socket : TCP_Socket
+  {
+    ::std::atomic<bool> connected { false };
+
+    virtual
+    void
+    do_on_tcp_connected()
+      override
+      { this->connected = true;  }
+
+    virtual
+    void
+    do_on_tcp_stream(linear_buffer& data, bool /*eof*/)
+      override
+      { data.clear();  }
+  };
+
+struct Wake_Task : Abstract_Task
+  {
+    virtual
+    void
+    do_on_abstract_task_execute()
+      override
+      { }
+  };
+
+struct Wake_Timer : Abstract_Timer
+  {
+    virtual
+    void
+    do_abstract_timer_on_tick(steady_time /*now*/)
+      override
+      { }
+  };
+
+static
+int
+do_listen(int family, const char* addr, uint16_t port, int backlog)
+  {
+    int fd = ::socket(family, SOCK_STREAM, 0);
+    ::sockaddr_in6 sa6 = { };
+    ::sockaddr_in sa4 = { };
+    int r;
+    if(family == AF_INET6) {
+      sa6.sin6_family = AF_INET6;
+      ::inet_pton(AF_INET6, addr, &(sa6.sin6_addr));
+      sa6.sin6_port = ::htons(port);
+      r = ::bind(fd, reinterpret_cast<::sockaddr*>(&sa6), sizeof(sa6));
+    }
+    else {
+      sa4.sin_family = AF_INET;
+      ::inet_pton(AF_INET, addr, &(sa4.sin_addr));
+      sa4.sin_port = ::htons(port);
+      r = ::bind(fd, reinterpret_cast<::sockaddr*>(&sa4), sizeof(sa4));
+    }
+    POSEIDON_TEST_CHECK(r == 0);
+    POSEIDON_TEST_CHECK(::listen(fd, backlog) == 0);
+    return fd;
+  }
+
+int
+main()
+  {
+    ::alarm(30);
+
+    // Create a listener on IPv6 whose backlog is full, so new connections
+    // hang, and another one on IPv4 with the same port.
+    int fd6 = do_listen(AF_INET6, "::1", 0, 0);
+    ::sockaddr_in6 sa = { };
+    ::socklen_t salen = sizeof(sa);
+    POSEIDON_TEST_CHECK(::getsockname(fd6, reinterpret_cast<::sockaddr*>(&sa), &salen) == 0);
+    uint16_t port = ::ntohs(sa.sin6_port);
+
+    ::std::vector<int> fillers;
+    for(uint32_t k = 0;  k != 3;  ++k) {
+      int fd = ::socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK, 0);
+      ::connect(fd, reinterpret_cast<::sockaddr*>(&sa), salen);
+      fillers.push_back(fd);
+    }
+    ::usleep(100000);
+
+    int fd4 = do_listen(AF_INET, "127.0.0.1", port, 16);
+
+    // Map a name to both addresses. The IPv6 one comes first.
+    char hosts_path[] = "/tmp/poseidon_hosts_XXXXXX";
+    int fd = ::mkstemp(hosts_path);
+    POSEIDON_TEST_CHECK(fd >= 0);
+    static constexpr char hosts[] = "127.0.0.1  dual\n::1  dual\n";
+    POSEIDON_TEST_CHECK(::write(fd, hosts, sizeof(hosts) - 1) > 0);
+    ::close(fd);
+
+    char conf_path[] = "/tmp/poseidon_conf_XXXXXX";
+    fd = ::mkstemp(conf_path);
+    POSEIDON_TEST_CHECK(fd >= 0);
+    cow_string conf = sformat(
+        "network {\n  dns {\n"
+        "    resolv_conf_path = \"/nonexistent\"\n"
+        "    hosts_path = \"$1\"\n"
+        "    connection_attempt_delay = 100\n"
+        "  }\n}\n",
+        hosts_path);
+    POSEIDON_TEST_CHECK(::write(fd, conf.data(), conf.size()) > 0);
+    ::close(fd);
+
+    Config_File conf_file(cow_string(conf_path));
+    ::unlink(hosts_path);
+    ::unlink(conf_path);
+
+    network_scheduler.reload(conf_file);
+    dns_resolver.reload(conf_file);
+    POSEIDON_TEST_CHECK(dns_resolver.connection_attempt_delay() == 100ms);
+
+    ::std::thread network_thread([] { while(!stopping) network_scheduler.thread_loop();  });
+    ::std::thread timer_thread([] { while(!stopping) timer_scheduler.thread_loop();  });
+    ::std::thread task_thread([] { while(!stopping) task_scheduler.thread_loop();  });
+
+    // The IPv6 attempt hangs, so the IPv4 one shall win after the delay.
+    steady_time since = steady_clock::now();
+    auto socket = new_sh<Test_Socket>();
+    task_scheduler.launch(new_sh<DNS_Connect_Task>(network_scheduler, socket, &"dual", port));
+
+    for(uint32_t k = 0;  !socket->connected && (k != 5000);  ++k)
+      ::usleep(1000);
+
+    double elapsed_ms = duration<double, ::std::milli>(steady_clock::now() - since).count();
+    ::fprintf(stderr, "Happy Eyeballs: connected in %.3f ms\n", elapsed_ms);
+    POSEIDON_TEST_CHECK(socket->connected);
+    POSEIDON_TEST_CHECK(socket->remote_address() == IPv6_Address(ipv4_loopback, port));
+    POSEIDON_TEST_CHECK(elapsed_ms < 1000);
+
+    int client = ::accept(fd4, nullptr, nullptr);
+    POSEIDON_TEST_CHECK(client >= 0);
+    ::close(client);
+
+    // Stop all threads.
+    stopping = true;
+    auto wake_timer = new_sh<Wake_Timer>();
+    timer_scheduler.insert_weak(wake_timer, 0ms, 0ms);
+    task_scheduler.launch(new_sh<Wake_Task>());
+    network_thread.join();
+    timer_thread.join();
+    task_thread.join();
+
+    for(int filler : fillers)
+      ::close(filler);
+    ::close(fd4);
+    ::close(fd6);
+  }
@@ -0,0 +1,353 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/static/dns_resolver.hpp"
+#include "../poseidon/static/network_scheduler.hpp"
+#include "../poseidon/static/timer_scheduler.hpp"
+#include "../poseidon/base/config_file.hpp"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <atomic>
+#include <thread>
+using namespace ::poseidon;
+
+// This is a stand-in name server, which answers queries from the resolver.
+static ::std::atomic<int> server_fd;
+static ::std::atomic<int> query_count;
+static ::std::atomic<bool> stopping;
+
+static
+void
+do_put_be16(cow_string& msg, uint32_t value)
+  {
+    msg.push_back(static_cast<char>(value >> 8));
+    msg.push_back(static_cast<char>(value));
+  }
+
+static
+void
+do_put_be32(cow_string& msg, uint32_t value)
+  {
+    do_put_be16(msg, value >> 16);
+    do_put_be16(msg, value & 0xFFFF);
+  }
+
+static
+void
+do_put_name(cow_string& msg, const char* name)
+  {
+    while(*name) {
+      size_t len = ::strcspn(name, ".");
+      msg.push_back(static_cast<char>(len));
+      msg.append(name, len);
+      name += len;
+      name += (*name == '.');
+    }
+    msg.push_back('\0');
+  }
+
+static
+void
+do_put_address(cow_string& msg, const char* name, uint32_t qtype)
+  {
+    char addr[16];
+    size_t len = (qtype == 1) ? 4 : 16;
+    ::inet_pton((qtype == 1) ? AF_INET : AF_INET6,
+                (qtype == 1) ? "192.0.2.1" : "2001:db8::1", addr);
+
+    do_put_name(msg, name);
+    do_put_be16(msg, qtype);
+    do_put_be16(msg, 1);
+    do_put_be32(msg, 60);
+    do_put_be16(msg, static_cast<uint32_t>(len));
+    msg.append(addr, len);
+  }
+
+static
+void
+do_server_loop()
+  {
+    char buf[1500];
+    for(;;) {
+      ::sockaddr_in sa;
+      ::socklen_t salen = sizeof(sa);
+      ::ssize_t len = ::recvfrom(server_fd, buf, sizeof(buf), 0,
+                                 reinterpret_cast<::sockaddr*>(&sa), &salen);
+      if(stopping)
+        return;
+      if(len < 17)
+        continue;
+
+      query_count ++;
+
+      // Decode the question.
+      cow_string qname;
+      size_t offset = 12;
+      while((offset < static_cast<size_t>(len)) && (buf[offset] != 0)) {
+        size_t llen = static_cast<uint8_t>(buf[offset]);
+        if(!qname.empty())
+          qname.push_back('.');
+        qname.append(buf + offset + 1, llen);
+        offset += 1 + llen;
+      }
+      offset ++;
+      uint32_t qtype = static_cast<uint8_t>(buf[offset]) * 256U + static_cast<uint8_t>(buf[offset + 1]);
+      offset += 4;
+
+      if(qname == "slow.example.com")
+        continue;
+
+      // Compose a response.
+      cow_string answers;
+      uint32_t ancount = 0;
+      uint32_t nscount = 0;
+      uint32_t rcode = 0;
+
+      if(qname == "www.example.com") {
+        do_put_address(answers, "www.example.com", qtype);
+        ancount = 1;
+      }
+      else if(qname == "alias.example.com") {
+        do_put_name(answers, "alias.example.com");
+        do_put_be16(answers, 5);  // CNAME
+        do_put_be16(answers, 1);
+        do_put_be32(answers, 60);
+        do_put_be16(answers, 17);
+        do_put_name(answers, "www.example.com");
+        do_put_address(answers, "www.example.com", qtype);
+        ancount = 2;
+      }
+      else if((qname == "other.example.com") && (qtype == 1)) {
+        do_put_address(answers, "other.example.com", qtype);
+        ancount = 1;
+      }
+      else if(qname != "other.example.com") {
+        // NXDOMAIN, with an SOA record for negative caching
+        do_put_name(answers, "example.com");
+        do_put_be16(answers, 6);  // SOA
+        do_put_be16(answers, 1);
+        do_put_be32(answers, 60);
+        do_put_be16(answers, 22);
+        do_put_name(answers, "");
+        do_put_name(answers, "");
+        for(uint32_t k = 0;  k != 5;  ++k)
+          do_put_be32(answers, 60);
+        nscount = 1;
+        rcode = 3;
+      }
+
+      cow_string msg(buf, 2);
+      do_put_be16(msg, 0x8180 | rcode);
+      do_put_be16(msg, 1);
+      do_put_be16(msg, ancount);
+      do_put_be16(msg, nscount);
+      do_put_be16(msg, 0);
+      msg.append(buf + 12, offset - 12);
+      msg.append(answers);
+
+      ::sendto(server_fd, msg.data(), msg.size(), 0, reinterpret_cast<::sockaddr*>(&sa), salen);
+    }
+  }
+
+struct Result
+  {
+    ::std::atomic<bool> done { false };
+    cow_vector<IPv6_Address> addrs;
+    cow_string error;
+  };
+
+static
+shptr<Result>
+do_resolve(const cow_string& host)
+  {
+    auto result = new_sh<Result>();
+    dns_resolver.resolve(host,
+      [result](const cow_vector<IPv6_Address>& addrs, const char* error)
+        {
+          result->addrs = addrs;
+          result->error = error ? error : "";
+          result->done = true;
+        });
+    return result;
+  }
+
+static
+cow_string
+do_write_temp_file(const char* text)
+  {
+    char path[] = "/tmp/poseidon_dns_XXXXXX";
+    int fd = ::mkstemp(path);
+    POSEIDON_TEST_CHECK(fd >= 0);
+    POSEIDON_TEST_CHECK(::write(fd, text, ::strlen(text)) >= 0);
+    ::close(fd);
+    return cow_string(path);
+  }
+
+static
+void
+do_reload(const char* resolv_conf, const char* nsswitch_conf, uint16_t port)
+  {
+    cow_string resolv_path = do_write_temp_file(resolv_conf);
+    cow_string hosts_path = do_write_temp_file("10.1.2.3  myhost  myhost.localdomain\n::1  myhost\n");
+    cow_string nsswitch_path = do_write_temp_file(nsswitch_conf);
+    cow_string conf = sformat(
+        "network {\n  dns {\n"
+        "    resolv_conf_path = \"$1\"\n"
+        "    hosts_path = \"$2\"\n"
+        "    nsswitch_conf_path = \"$3\"\n"
+        "    name_servers = [ \"127.0.0.1:$4\" ]\n"
+        "  }\n}\n",
+        resolv_path, hosts_path, nsswitch_path, port);
+    cow_string conf_path = do_write_temp_file(conf.c_str());
+
+    Config_File conf_file(conf_path);
+    ::unlink(resolv_path.c_str());
+    ::unlink(hosts_path.c_str());
+    ::unlink(nsswitch_path.c_str());
+    ::unlink(conf_path.c_str());
+
+    network_scheduler.reload(conf_file);
+    dns_resolver.reload(conf_file);
+  }
+
+static
+void
+do_wait(const shptr<Result>& result)
+  {
+    for(uint32_t k = 0;  !result->done && (k != 5000);  ++k)
+      ::usleep(1000);
+  }
+
+int
+main()
+  {
+    ::alarm(30);
+
+    // Start the name server on an ephemeral port.
+    server_fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    ::sockaddr_in sa = { };
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+    POSEIDON_TEST_CHECK(::bind(server_fd, reinterpret_cast<::sockaddr*>(&sa), sizeof(sa)) == 0);
+    ::socklen_t salen = sizeof(sa);
+    POSEIDON_TEST_CHECK(::getsockname(server_fd, reinterpret_cast<::sockaddr*>(&sa), &salen) == 0);
+    ::std::thread server_thread(do_server_loop);
+
+    // Write configuration files.
+    do_reload("nameserver 192.0.2.53  # unused\noptions timeout:1 attempts:1\n",
+              "hosts: files dns\n", ::ntohs(sa.sin_port));
+
+    ::std::thread network_thread([] { while(!stopping) network_scheduler.thread_loop();  });
+    ::std::thread timer_thread([] { while(!stopping) timer_scheduler.thread_loop();  });
+
+    // Numeric addresses and static hosts need no queries.
+    auto r = do_resolve(&"127.0.0.1");
+    POSEIDON_TEST_CHECK(r->done);
+    POSEIDON_TEST_CHECK(r->addrs.size() == 1);
+    POSEIDON_TEST_CHECK(r->addrs.at(0) == ipv4_loopback);
+
+    r = do_resolve(&"[::1]");
+    POSEIDON_TEST_CHECK(r->done);
+    POSEIDON_TEST_CHECK(r->addrs.size() == 1);
+    POSEIDON_TEST_CHECK(r->addrs.at(0) == ipv6_loopback);
+
+    r = do_resolve(&"MyHost");
+    POSEIDON_TEST_CHECK(r->done);
+    POSEIDON_TEST_CHECK(r->addrs.size() == 2);
+    POSEIDON_TEST_CHECK(r->addrs.at(0) == ipv6_loopback);
+    POSEIDON_TEST_CHECK(r->addrs.at(1) == IPv6_Address(&"10.1.2.3:0"));
+    POSEIDON_TEST_CHECK(query_count == 0);
+
+    // Look up a name from the server. IPv6 addresses come first.
+    r = do_resolve(&"www.example.com");
+    do_wait(r);
+    POSEIDON_TEST_CHECK(r->done);
+    POSEIDON_TEST_CHECK(r->error == "");
+    POSEIDON_TEST_CHECK(r->addrs.size() == 2);
+    POSEIDON_TEST_CHECK(r->addrs.at(0) == IPv6_Address(&"[2001:db8::1]:0"));
+    POSEIDON_TEST_CHECK(r->addrs.at(1) == IPv6_Address(&"192.0.2.1:0"));
+    POSEIDON_TEST_CHECK(query_count == 2);
+
+    // The result shall have been cached.
+    r = do_resolve(&"WWW.Example.COM.");
+    POSEIDON_TEST_CHECK(r->done);
+    POSEIDON_TEST_CHECK(r->addrs.size() == 2);
+    POSEIDON_TEST_CHECK(query_count == 2);
+
+    // Follow a CNAME record.
+    r = do_resolve(&"alias.example.com");
+    do_wait(r);
+    POSEIDON_TEST_CHECK(r->error == "");
+    POSEIDON_TEST_CHECK(r->addrs.size() == 2);
+    POSEIDON_TEST_CHECK(r->addrs.at(1) == IPv6_Address(&"192.0.2.1:0"));
+    POSEIDON_TEST_CHECK(query_count == 4);
+
+    // Concurrent lookups share queries. The AAAA query yields no data.
+    auto r1 = do_resolve(&"other.example.com");
+    auto r2 = do_resolve(&"other.example.com");
+    do_wait(r1);
+    do_wait(r2);
+    POSEIDON_TEST_CHECK(r1->addrs.size() == 1);
+    POSEIDON_TEST_CHECK(r2->addrs.size() == 1);
+    POSEIDON_TEST_CHECK(query_count == 6);
+
+    // Nonexistent names are cached, too.
+    r = do_resolve(&"missing.example.com");
+    do_wait(r);
+    POSEIDON_TEST_CHECK(r->done);
+    POSEIDON_TEST_CHECK(r->error != "");
+    POSEIDON_TEST_CHECK(r->addrs.empty());
+    POSEIDON_TEST_CHECK(query_count == 8);
+
+    r = do_resolve(&"missing.example.com");
+    POSEIDON_TEST_CHECK(r->done);
+    POSEIDON_TEST_CHECK(r->error != "");
+    POSEIDON_TEST_CHECK(query_count == 8);
+
+    // Time out, according to options from 'resolv.conf'.
+    r = do_resolve(&"slow.example.com");
+    do_wait(r);
+    POSEIDON_TEST_CHECK(r->done);
+    POSEIDON_TEST_CHECK(r->error == "timed out");
+
+    // Invalid names fail immediately.
+    r = do_resolve(&"bad..name");
+    POSEIDON_TEST_CHECK(r->done);
+    POSEIDON_TEST_CHECK(r->error != "");
+
+    // Look up a short name with the search list, and then as is.
+    do_reload("search example.com\noptions ndots:1 timeout:1 attempts:1\n",
+              "hosts: dns files\n", ::ntohs(sa.sin_port));
+    query_count = 0;
+
+    r = do_resolve(&"www");
+    do_wait(r);
+    POSEIDON_TEST_CHECK(r->error == "");
+    POSEIDON_TEST_CHECK(r->addrs.size() == 2);
+    POSEIDON_TEST_CHECK(r->addrs.at(1) == IPv6_Address(&"192.0.2.1:0"));
+    POSEIDON_TEST_CHECK(query_count == 2);
+
+    // Absolute names are not subject to the search list.
+    r = do_resolve(&"www.");
+    do_wait(r);
+    POSEIDON_TEST_CHECK(r->error != "");
+    POSEIDON_TEST_CHECK(query_count == 4);
+
+    // The hosts file comes after DNS, so names that are not found by name
+    // servers are looked up there.
+    r = do_resolve(&"myhost");
+    do_wait(r);
+    POSEIDON_TEST_CHECK(r->error == "");
+    POSEIDON_TEST_CHECK(r->addrs.size() == 2);
+    POSEIDON_TEST_CHECK(r->addrs.at(0) == ipv6_loopback);
+    POSEIDON_TEST_CHECK(query_count == 8);
+
+    // Stop all threads.
+    stopping = true;
+    ::sendto(server_fd, "", 0, 0, reinterpret_cast<::sockaddr*>(&sa), salen);
+    server_thread.join();
+    network_thread.join();
+    timer_thread.join();
+  }
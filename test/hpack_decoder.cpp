@@ -0,0 +1,75 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/http/hpack_decoder.hpp"
+#include "../poseidon/http/hpack_encoder.hpp"
+using namespace ::poseidon;
+
+int
+main()
+  {
+    // RFC 7541, C.4. Request Examples with Huffman Coding
+    HPACK_Decoder dec;
+    cow_bivector<cow_string, cow_string> fields;
+
+    dec.decode(fields, chars_view("\x82\x86\x84\x41\x8c\xf1\xe3\xc2\xe5\xf2\x3a\x6b\xa0\xab\x90\xf4\xff", 17));
+    POSEIDON_TEST_CHECK(fields.size() == 4);
+    POSEIDON_TEST_CHECK(fields.at(0).first == ":method");
+    POSEIDON_TEST_CHECK(fields.at(0).second == "GET");
+    POSEIDON_TEST_CHECK(fields.at(1).first == ":scheme");
+    POSEIDON_TEST_CHECK(fields.at(1).second == "http");
+    POSEIDON_TEST_CHECK(fields.at(2).first == ":path");
+    POSEIDON_TEST_CHECK(fields.at(2).second == "/");
+    POSEIDON_TEST_CHECK(fields.at(3).first == ":authority");
+    POSEIDON_TEST_CHECK(fields.at(3).second == "www.example.com");
+    POSEIDON_TEST_CHECK(dec.table_size() == 57);
+    POSEIDON_TEST_CHECK(dec.table_entry_count() == 1);
+
+    fields.clear();
+    dec.decode(fields, chars_view("\x82\x86\x84\xbe\x58\x86\xa8\xeb\x10\x64\x9c\xbf", 12));
+    POSEIDON_TEST_CHECK(fields.size() == 5);
+    POSEIDON_TEST_CHECK(fields.at(3).first == ":authority");
+    POSEIDON_TEST_CHECK(fields.at(3).second == "www.example.com");
+    POSEIDON_TEST_CHECK(fields.at(4).first == "cache-control");
+    POSEIDON_TEST_CHECK(fields.at(4).second == "no-cache");
+    POSEIDON_TEST_CHECK(dec.table_size() == 110);
+
+    fields.clear();
+    dec.decode(fields, chars_view("\x82\x87\x85\xbf\x40\x88\x25\xa8\x49\xe9\x5b\xa9\x7d\x7f"
+                                  "\x89\x25\xa8\x49\xe9\x5b\xb8\xe8\xb4\xbf", 24));
+    POSEIDON_TEST_CHECK(fields.size() == 5);
+    POSEIDON_TEST_CHECK(fields.at(1).second == "https");
+    POSEIDON_TEST_CHECK(fields.at(2).second == "/index.html");
+    POSEIDON_TEST_CHECK(fields.at(3).first == ":authority");
+    POSEIDON_TEST_CHECK(fields.at(3).second == "www.example.com");
+    POSEIDON_TEST_CHECK(fields.at(4).first == "custom-key");
+    POSEIDON_TEST_CHECK(fields.at(4).second == "custom-value");
+    POSEIDON_TEST_CHECK(dec.table_size() == 164);
+    POSEIDON_TEST_CHECK(dec.table_entry_count() == 3);
+
+    // invalid index
+    fields.clear();
+    POSEIDON_TEST_CHECK_CATCH(dec.decode(fields, chars_view("\xff\x00", 2)));
+
+    // round trip
+    HPACK_Encoder enc;
+    tinyfmt_ln fmt;
+    enc.encode_field(fmt, ":status", "200");
+    enc.encode_field(fmt, "content-type", "text/plain");
+    enc.encode_field(fmt, "x-custom", "hello");
+    POSEIDON_TEST_CHECK(fmt.get_buffer().size() != 0);
+    POSEIDON_TEST_CHECK(static_cast<unsigned char>(fmt.get_buffer().begin()[0]) == 0x88);
+
+    dec.clear();
+    fields.clear();
+    dec.decode(fields, fmt);
+    POSEIDON_TEST_CHECK(fields.size() == 3);
+    POSEIDON_TEST_CHECK(fields.at(0).first == ":status");
+    POSEIDON_TEST_CHECK(fields.at(0).second == "200");
+    POSEIDON_TEST_CHECK(fields.at(1).first == "content-type");
+    POSEIDON_TEST_CHECK(fields.at(1).second == "text/plain");
+    POSEIDON_TEST_CHECK(fields.at(2).first == "x-custom");
+    POSEIDON_TEST_CHECK(fields.at(2).second == "hello");
+    POSEIDON_TEST_CHECK(dec.table_entry_count() == 0);
+  }
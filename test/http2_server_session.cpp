@@ -0,0 +1,381 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/socket/http2_server_session.hpp"
+#include "../poseidon/http/hpack_decoder.hpp"
+#include "../poseidon/http/hpack_encoder.hpp"
+#include "../poseidon/static/network_scheduler.hpp"
+#include "../poseidon/base/config_file.hpp"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+using namespace ::poseidon;
+
+struct Frame
+  {
+    uint8_t type;
+    uint8_t flags;
+    uint32_t stream_id;
+    cow_string payload;
+  };
+
+// The socket is never connected, so nothing is encrypted, and all frames
+// that are sent by the session stay in the write queue.
+struct Test_Session final : HTTP2_Server_Session
+  {
+    linear_buffer m_input;
+    cow_string m_path;
+    cow_string m_query;
+    cow_vector<uint32_t> m_finished;
+    cow_string m_payload;
+    cow_vector<uint32_t> m_errors;
+    HTTP_Status m_error_status = http_status_ok;
+
+    explicit
+    Test_Session(unique_posix_fd&& fd)
+      :
+        SSL_Socket(move(fd), network_scheduler), HTTP2_Server_Session()
+      { }
+
+    void
+    feed(const cow_string& data)
+      {
+        this->m_input.putn(data.data(), data.size());
+        this->do_on_ssl_stream(this->m_input, false);
+      }
+
+    cow_vector<Frame>
+    take_frames()
+      {
+        recursive_mutex::unique_lock io_lock;
+        auto& queue = this->do_abstract_socket_lock_write_queue(io_lock);
+
+        cow_vector<Frame> frames;
+        while(queue.size() >= 9) {
+          auto bptr = reinterpret_cast<const unsigned char*>(queue.begin());
+          uint32_t length = ::asteria::load_be<uint32_t>(bptr) >> 8;
+          POSEIDON_TEST_CHECK(queue.size() >= 9 + length);
+
+          auto& frm = frames.emplace_back();
+          frm.type = bptr[3];
+          frm.flags = bptr[4];
+          frm.stream_id = ::asteria::load_be<uint32_t>(bptr + 5);
+          frm.payload.assign(queue.begin() + 9, length);
+          queue.discard(9 + length);
+        }
+        POSEIDON_TEST_CHECK(queue.empty());
+        return frames;
+      }
+
+    virtual
+    void
+    do_on_http2_request_headers(uint32_t /*stream_id*/, HTTP_C_Headers& req, bool /*end_stream*/)
+      override
+      {
+        this->m_path = req.raw_path;
+        this->m_query = req.raw_query;
+      }
+
+    virtual
+    void
+    do_on_http2_request_finish(uint32_t stream_id, HTTP_C_Headers&& /*req*/, linear_buffer&& data)
+      override
+      {
+        this->m_finished.push_back(stream_id);
+        this->m_payload.assign(data.begin(), data.size());
+      }
+
+    virtual
+    void
+    do_on_http2_request_error(uint32_t stream_id, HTTP_Status status)
+      override
+      {
+        this->m_errors.push_back(stream_id);
+        this->m_error_status = status;
+      }
+  };
+
+static
+cow_string
+do_frame(uint8_t type, uint8_t flags, uint32_t stream_id, chars_view payload)
+  {
+    char header[9];
+    ::asteria::store_be<uint32_t>(header, static_cast<uint32_t>(payload.n << 8 | type));
+    header[4] = static_cast<char>(flags);
+    ::asteria::store_be<uint32_t>(header + 5, stream_id);
+
+    cow_string frame(header, 9);
+    frame.append(payload.p, payload.n);
+    return frame;
+  }
+
+static
+cow_string
+do_u32(uint32_t value)
+  {
+    char bytes[4];
+    ::asteria::store_be<uint32_t>(bytes, value);
+    return cow_string(bytes, 4);
+  }
+
+static
+cow_string
+do_request(HPACK_Encoder& enc, uint32_t stream_id, const char* method, const char* path,
+           bool end_stream)
+  {
+    tinyfmt_ln fmt;
+    enc.encode_field(fmt, ":method", method);
+    enc.encode_field(fmt, ":scheme", "https");
+    enc.encode_field(fmt, ":authority", "example.com");
+    enc.encode_field(fmt, ":path", path);
+    chars_view block = fmt;
+    return do_frame(0x01, 0x04 | (end_stream ? 0x01 : 0), stream_id, block);
+  }
+
+static
+void
+do_reload_with_certificate()
+  {
+    // Generate a self-signed certificate for the server SSL context, which is
+    // required to create server sockets, but not used otherwise.
+    ::EVP_PKEY* key = ::EVP_EC_gen("P-256");
+    POSEIDON_TEST_CHECK(key);
+    ::X509* cert = ::X509_new();
+    POSEIDON_TEST_CHECK(cert);
+    ::ASN1_INTEGER_set(::X509_get_serialNumber(cert), 1);
+    ::X509_gmtime_adj(::X509_getm_notBefore(cert), 0);
+    ::X509_gmtime_adj(::X509_getm_notAfter(cert), 86400);
+    ::X509_set_pubkey(cert, key);
+    ::X509_NAME* name = ::X509_get_subject_name(cert);
+    ::X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                 reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+    ::X509_set_issuer_name(cert, name);
+    POSEIDON_TEST_CHECK(::X509_sign(cert, key, ::EVP_sha256()) > 0);
+
+    char cert_path[] = "/tmp/poseidon_crt_XXXXXX";
+    int fd = ::mkstemp(cert_path);
+    POSEIDON_TEST_CHECK(fd >= 0);
+    ::FILE* fp = ::fdopen(fd, "w");
+    POSEIDON_TEST_CHECK(::PEM_write_X509(fp, cert) == 1);
+    ::fclose(fp);
+
+    char key_path[] = "/tmp/poseidon_key_XXXXXX";
+    fd = ::mkstemp(key_path);
+    POSEIDON_TEST_CHECK(fd >= 0);
+    fp = ::fdopen(fd, "w");
+    POSEIDON_TEST_CHECK(::PEM_write_PrivateKey(fp, key, nullptr, nullptr, 0, nullptr, nullptr) == 1);
+    ::fclose(fp);
+
+    ::X509_free(cert);
+    ::EVP_PKEY_free(key);
+
+    char conf_path[] = "/tmp/poseidon_conf_XXXXXX";
+    fd = ::mkstemp(conf_path);
+    POSEIDON_TEST_CHECK(fd >= 0);
+    cow_string conf = sformat(
+        "network {\n  ssl {\n"
+        "    default_certificate = \"$1\"\n"
+        "    default_private_key = \"$2\"\n"
+        "  }\n}\n",
+        cert_path, key_path);
+    POSEIDON_TEST_CHECK(::write(fd, conf.data(), conf.size()) > 0);
+    ::close(fd);
+
+    Config_File conf_file(cow_string(conf_path));
+    network_scheduler.reload(conf_file);
+    ::unlink(cert_path);
+    ::unlink(key_path);
+    ::unlink(conf_path);
+  }
+
+int
+main()
+  {
+    do_reload_with_certificate();
+
+    int fds[2];
+    POSEIDON_TEST_CHECK(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == 0);
+    unique_posix_fd peer(fds[1]);
+    auto session = new_sh<Test_Session>(unique_posix_fd(fds[0]));
+
+    HPACK_Encoder enc;
+    HPACK_Decoder dec;
+    cow_bivector<cow_string, cow_string> fields;
+    cow_vector<Frame> frames;
+
+    // The server sends its SETTINGS after the preface, and acknowledges ours.
+    session->feed(cow_string("PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n") + do_frame(0x04, 0, 0, ""));
+    frames = session->take_frames();
+    POSEIDON_TEST_CHECK(frames.size() == 2);
+    POSEIDON_TEST_CHECK(frames.at(0).type == 0x04);
+    POSEIDON_TEST_CHECK(frames.at(0).flags == 0);
+    POSEIDON_TEST_CHECK(frames.at(0).payload.size() % 6 == 0);
+    POSEIDON_TEST_CHECK(frames.at(1).type == 0x04);
+    POSEIDON_TEST_CHECK(frames.at(1).flags == 0x01);
+
+    session->feed(do_frame(0x06, 0, 0, "12345678"));
+    frames = session->take_frames();
+    POSEIDON_TEST_CHECK(frames.size() == 1);
+    POSEIDON_TEST_CHECK(frames.at(0).type == 0x06);
+    POSEIDON_TEST_CHECK(frames.at(0).flags == 0x01);
+    POSEIDON_TEST_CHECK(frames.at(0).payload == "12345678");
+
+    // A request without a payload, and a response with one
+    session->feed(do_request(enc, 1, "GET", "/index.html?a=1&b=2", true));
+    POSEIDON_TEST_CHECK(session->m_path == "/index.html");
+    POSEIDON_TEST_CHECK(session->m_query == "a=1&b=2");
+    POSEIDON_TEST_CHECK(session->m_finished.size() == 1);
+    POSEIDON_TEST_CHECK(session->m_finished.back() == 1);
+
+    HTTP_S_Headers resp;
+    resp.status = http_status_ok;
+    resp.headers.emplace_back(&"Content-Type", &"text/plain");
+    POSEIDON_TEST_CHECK(session->http2_response(1, false, move(resp), "hello") == true);
+    frames = session->take_frames();
+    POSEIDON_TEST_CHECK(frames.size() == 2);
+    POSEIDON_TEST_CHECK(frames.at(0).type == 0x01);
+    POSEIDON_TEST_CHECK(frames.at(0).stream_id == 1);
+    POSEIDON_TEST_CHECK(frames.at(0).flags == 0x04);
+    dec.decode(fields, frames.at(0).payload);
+    POSEIDON_TEST_CHECK(fields.at(0).first == ":status");
+    POSEIDON_TEST_CHECK(fields.at(0).second == "200");
+    POSEIDON_TEST_CHECK(frames.at(1).type == 0x00);
+    POSEIDON_TEST_CHECK(frames.at(1).stream_id == 1);
+    POSEIDON_TEST_CHECK(frames.at(1).flags == 0x01);
+    POSEIDON_TEST_CHECK(frames.at(1).payload == "hello");
+
+    // The stream has been closed.
+    resp.clear();
+    resp.status = http_status_ok;
+    POSEIDON_TEST_CHECK(session->http2_response_headers_only(1, move(resp)) == false);
+
+    // A malformed `:path` is rejected, but the stream is kept open for an
+    // error response.
+    session->feed(do_request(enc, 3, "GET", "/a b", true));
+    POSEIDON_TEST_CHECK(session->m_errors.size() == 1);
+    POSEIDON_TEST_CHECK(session->m_errors.back() == 3);
+    POSEIDON_TEST_CHECK(session->m_error_status == http_status_bad_request);
+    POSEIDON_TEST_CHECK(session->m_finished.size() == 1);
+
+    resp.clear();
+    resp.status = http_status_bad_request;
+    POSEIDON_TEST_CHECK(session->http2_response_headers_only(3, move(resp)) == true);
+    frames = session->take_frames();
+    POSEIDON_TEST_CHECK(frames.size() == 1);
+    POSEIDON_TEST_CHECK(frames.at(0).type == 0x01);
+    POSEIDON_TEST_CHECK(frames.at(0).flags == 0x05);
+
+    session->feed(do_request(enc, 5, "GET", "*", true));
+    POSEIDON_TEST_CHECK(session->m_errors.size() == 2);
+    POSEIDON_TEST_CHECK(session->m_errors.back() == 5);
+    POSEIDON_TEST_CHECK(session->http2_reset_stream(5) == true);
+    session->take_frames();
+
+    // A request payload in multiple DATA frames
+    session->feed(do_request(enc, 7, "POST", "/upload", false));
+    POSEIDON_TEST_CHECK(session->m_path == "/upload");
+    POSEIDON_TEST_CHECK(session->m_query == "");
+    session->feed(do_frame(0x00, 0, 7, "abc"));
+    POSEIDON_TEST_CHECK(session->m_finished.size() == 1);
+    session->feed(do_frame(0x00, 0x01, 7, "def"));
+    POSEIDON_TEST_CHECK(session->m_finished.size() == 2);
+    POSEIDON_TEST_CHECK(session->m_finished.back() == 7);
+    POSEIDON_TEST_CHECK(session->m_payload == "abcdef");
+    POSEIDON_TEST_CHECK(session->take_frames().size() == 0);
+
+    resp.clear();
+    resp.status = http_status_no_content;
+    POSEIDON_TEST_CHECK(session->http2_response(7, false, move(resp), "") == true);
+    session->take_frames();
+
+    // Receive windows are replenished after half of them have been consumed.
+    // The connection window includes all DATA frames that have been received.
+    session->feed(do_request(enc, 9, "POST", "/upload", false));
+    cow_string chunk;
+    chunk.append(16384, 'x');
+    session->feed(do_frame(0x00, 0, 9, chunk));
+    POSEIDON_TEST_CHECK(session->take_frames().size() == 0);
+    session->feed(do_frame(0x00, 0, 9, chunk));
+    frames = session->take_frames();
+    POSEIDON_TEST_CHECK(frames.size() == 2);
+    POSEIDON_TEST_CHECK(frames.at(0).type == 0x08);
+    POSEIDON_TEST_CHECK(frames.at(0).stream_id == 0);
+    POSEIDON_TEST_CHECK(::asteria::load_be<uint32_t>(frames.at(0).payload.data()) == 32774);
+    POSEIDON_TEST_CHECK(frames.at(1).type == 0x08);
+    POSEIDON_TEST_CHECK(frames.at(1).stream_id == 9);
+    POSEIDON_TEST_CHECK(::asteria::load_be<uint32_t>(frames.at(1).payload.data()) == 32768);
+    session->feed(do_frame(0x00, 0x01, 9, ""));
+    POSEIDON_TEST_CHECK(session->m_finished.back() == 9);
+    POSEIDON_TEST_CHECK(session->m_payload.size() == 32768);
+    POSEIDON_TEST_CHECK(session->http2_reset_stream(9) == true);
+    session->take_frames();
+
+    // Send windows. Data that exceed the window of the stream are sent after
+    // the client grants more credit.
+    cow_string settings;
+    settings.push_back('\x00');
+    settings.push_back('\x04');  // INITIAL_WINDOW_SIZE
+    settings += do_u32(4);
+    session->feed(do_frame(0x04, 0, 0, settings));
+    frames = session->take_frames();
+    POSEIDON_TEST_CHECK(frames.size() == 1);
+    POSEIDON_TEST_CHECK(frames.at(0).type == 0x04);
+    POSEIDON_TEST_CHECK(frames.at(0).flags == 0x01);
+
+    session->feed(do_request(enc, 11, "GET", "/", true));
+    resp.clear();
+    resp.status = http_status_ok;
+    POSEIDON_TEST_CHECK(session->http2_response(11, false, move(resp), "0123456789") == true);
+    frames = session->take_frames();
+    POSEIDON_TEST_CHECK(frames.size() == 2);
+    POSEIDON_TEST_CHECK(frames.at(0).type == 0x01);
+    POSEIDON_TEST_CHECK(frames.at(1).type == 0x00);
+    POSEIDON_TEST_CHECK(frames.at(1).flags == 0);
+    POSEIDON_TEST_CHECK(frames.at(1).payload == "0123");
+
+    session->feed(do_frame(0x08, 0, 11, do_u32(4)));
+    frames = session->take_frames();
+    POSEIDON_TEST_CHECK(frames.size() == 1);
+    POSEIDON_TEST_CHECK(frames.at(0).flags == 0);
+    POSEIDON_TEST_CHECK(frames.at(0).payload == "4567");
+
+    session->feed(do_frame(0x08, 0, 11, do_u32(100)));
+    frames = session->take_frames();
+    POSEIDON_TEST_CHECK(frames.size() == 1);
+    POSEIDON_TEST_CHECK(frames.at(0).flags == 0x01);
+    POSEIDON_TEST_CHECK(frames.at(0).payload == "89");
+    POSEIDON_TEST_CHECK(session->http2_reset_stream(11) == false);
+
+    // Streams that are reset by the client can't be responded to, and further
+    // DATA frames on them are ignored.
+    session->feed(do_request(enc, 13, "GET", "/", true));
+    POSEIDON_TEST_CHECK(session->m_finished.back() == 13);
+    session->feed(do_frame(0x03, 0, 13, do_u32(http2_cancel)));
+    resp.clear();
+    resp.status = http_status_ok;
+    POSEIDON_TEST_CHECK(session->http2_response(13, false, move(resp), "meow") == false);
+    session->feed(do_frame(0x00, 0x01, 13, "late"));
+    POSEIDON_TEST_CHECK(session->take_frames().size() == 0);
+
+    // Streams that are reset by the server
+    session->feed(do_request(enc, 15, "POST", "/", false));
+    POSEIDON_TEST_CHECK(session->http2_reset_stream(15, http2_refused_stream) == true);
+    POSEIDON_TEST_CHECK(session->http2_reset_stream(15) == false);
+    frames = session->take_frames();
+    POSEIDON_TEST_CHECK(frames.size() == 1);
+    POSEIDON_TEST_CHECK(frames.at(0).type == 0x03);
+    POSEIDON_TEST_CHECK(frames.at(0).stream_id == 15);
+    POSEIDON_TEST_CHECK(::asteria::load_be<uint32_t>(frames.at(0).payload.data()) == http2_refused_stream);
+
+    // Connection errors
+    session->feed(do_frame(0x00, 0, 0, "bad"));
+    frames = session->take_frames();
+    POSEIDON_TEST_CHECK(frames.size() == 1);
+    POSEIDON_TEST_CHECK(frames.at(0).type == 0x07);
+    POSEIDON_TEST_CHECK(::asteria::load_be<uint32_t>(frames.at(0).payload.data()) == 15);
+    POSEIDON_TEST_CHECK(::asteria::load_be<uint32_t>(frames.at(0).payload.data() + 4) == http2_protocol_error);
+    POSEIDON_TEST_CHECK(session->socket_state() >= socket_closing);
+  }
@@ -0,0 +1,120 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/http/http_c_headers.hpp"
+#include "../poseidon/http/http_s_headers.hpp"
+#include "../poseidon/http/http_compressor.hpp"
+using namespace ::poseidon;
+
+static
+HTTP_Content_Coding
+do_select(const char* accept_encoding)
+  {
+    HTTP_C_Headers req;
+    req.method = http_GET;
+    req.headers.emplace_back(&"Host", &"example.com");
+    if(accept_encoding)
+      req.headers.emplace_back(&"Accept-Encoding", cow_string(accept_encoding));
+    return HTTP_Compressor::select_content_coding(req);
+  }
+
+static
+size_t
+do_count(const HTTP_S_Headers& resp, const char* name, const char* value)
+  {
+    size_t count = 0;
+    for(const auto& hr : resp.headers)
+      if((hr.first == name) && (hr.second.as_string() == value))
+        count ++;
+    return count;
+  }
+
+int
+main()
+  {
+    // `Accept-Encoding` with quality values
+    POSEIDON_TEST_CHECK(do_select(nullptr) == http_coding_identity);
+    POSEIDON_TEST_CHECK(do_select("") == http_coding_identity);
+    POSEIDON_TEST_CHECK(do_select("gzip") == http_coding_gzip);
+    POSEIDON_TEST_CHECK(do_select("x-gzip") == http_coding_gzip);
+    POSEIDON_TEST_CHECK(do_select("deflate") == http_coding_deflate);
+    POSEIDON_TEST_CHECK(do_select("deflate, gzip") == http_coding_gzip);
+    POSEIDON_TEST_CHECK(do_select("gzip;q=0.5, deflate") == http_coding_deflate);
+    POSEIDON_TEST_CHECK(do_select("gzip;q=0.5, deflate;q=0.5") == http_coding_gzip);
+    POSEIDON_TEST_CHECK(do_select("br, zstd") == http_coding_identity);
+    POSEIDON_TEST_CHECK(do_select("*") == http_coding_gzip);
+    POSEIDON_TEST_CHECK(do_select("gzip;q=0, *") == http_coding_deflate);
+    POSEIDON_TEST_CHECK(do_select("gzip;q=0, deflate;q=0") == http_coding_identity);
+    POSEIDON_TEST_CHECK(do_select("*;q=0") == http_coding_identity);
+    POSEIDON_TEST_CHECK(do_select("gzip;q=0") == http_coding_identity);
+    POSEIDON_TEST_CHECK(do_select("identity;q=0") == http_coding_identity);
+    POSEIDON_TEST_CHECK(do_select("identity;q=0, gzip") == http_coding_gzip);
+    POSEIDON_TEST_CHECK(do_select("identity;q=0, deflate;q=0.1") == http_coding_deflate);
+    POSEIDON_TEST_CHECK(do_select("identity;q=0, *;q=0") == http_coding_identity);
+
+    // Compressible responses
+    HTTP_S_Headers resp;
+    resp.status = http_status_ok;
+    POSEIDON_TEST_CHECK(HTTP_Compressor::is_response_compressible(resp, 10000) == false);
+    resp.headers.emplace_back(&"Content-Type", &"text/html; charset=utf-8");
+    POSEIDON_TEST_CHECK(HTTP_Compressor::is_response_compressible(resp, 10000) == true);
+    POSEIDON_TEST_CHECK(HTTP_Compressor::is_response_compressible(resp, 100) == false);
+
+    resp.status = http_status_partial_content;
+    POSEIDON_TEST_CHECK(HTTP_Compressor::is_response_compressible(resp, 10000) == false);
+    resp.status = http_status_ok;
+    resp.headers.emplace_back(&"Content-Range", &"bytes 0-9999/20000");
+    POSEIDON_TEST_CHECK(HTTP_Compressor::is_response_compressible(resp, 10000) == false);
+    resp.headers.pop_back();
+
+    resp.headers.emplace_back(&"Content-Encoding", &"br");
+    POSEIDON_TEST_CHECK(HTTP_Compressor::is_response_compressible(resp, 10000) == false);
+    resp.headers.pop_back();
+
+    resp.headers.mut(0).second = &"image/png";
+    POSEIDON_TEST_CHECK(HTTP_Compressor::is_response_compressible(resp, 10000) == false);
+    resp.headers.mut(0).second = &"IMAGE/SVG+XML";
+    POSEIDON_TEST_CHECK(HTTP_Compressor::is_response_compressible(resp, 10000) == true);
+    resp.headers.mut(0).second = &"application/octet-stream";
+    POSEIDON_TEST_CHECK(HTTP_Compressor::is_response_compressible(resp, 10000) == false);
+    resp.headers.mut(0).second = &"application/json";
+    POSEIDON_TEST_CHECK(HTTP_Compressor::is_response_compressible(resp, 10000) == true);
+
+    // Compress a payload. `Vary` is sent even if it's not compressed.
+    cow_string payload;
+    for(int k = 0;  k != 100;  ++k)
+      payload += &"{\"meow\":42,\"bark\":\"hello\"}";
+
+    cow_string output;
+    HTTP_S_Headers plain = resp;
+    POSEIDON_TEST_CHECK(HTTP_Compressor::compress_response(output, plain, payload,
+                                                           http_coding_identity, 6, 0) == false);
+    POSEIDON_TEST_CHECK(do_count(plain, "Vary", "Accept-Encoding") == 1);
+    POSEIDON_TEST_CHECK(do_count(plain, "Content-Encoding", "gzip") == 0);
+
+    HTTP_S_Headers small = resp;
+    POSEIDON_TEST_CHECK(HTTP_Compressor::compress_response(output, small, "{}",
+                                                           http_coding_gzip, 6, 0) == false);
+    POSEIDON_TEST_CHECK(small.headers.size() == resp.headers.size());
+
+    HTTP_S_Headers gzipped = resp;
+    gzipped.headers.emplace_back(&"ETag", &"\"1234\"");
+    POSEIDON_TEST_CHECK(HTTP_Compressor::compress_response(output, gzipped, payload,
+                                                           http_coding_gzip, 6, 1048576) == true);
+    POSEIDON_TEST_CHECK(output.size() < payload.size());
+    POSEIDON_TEST_CHECK(do_count(gzipped, "Vary", "Accept-Encoding") == 1);
+    POSEIDON_TEST_CHECK(do_count(gzipped, "Content-Encoding", "gzip") == 1);
+    POSEIDON_TEST_CHECK(do_count(gzipped, "ETag", "W/\"1234\"") == 1);
+
+    // The same `ETag` with a different payload of the same length must not hit
+    // the cache.
+    cow_string other = payload;
+    other.mut(0) = '[';
+    cow_string output2;
+    gzipped = resp;
+    gzipped.headers.emplace_back(&"ETag", &"\"1234\"");
+    POSEIDON_TEST_CHECK(HTTP_Compressor::compress_response(output2, gzipped, other,
+                                                           http_coding_gzip, 6, 1048576) == true);
+    POSEIDON_TEST_CHECK(output2 != output);
+  }
@@ -0,0 +1,248 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/static/http_connector.hpp"
+#include "../poseidon/static/dns_resolver.hpp"
+#include "../poseidon/static/network_scheduler.hpp"
+#include "../poseidon/static/task_scheduler.hpp"
+#include "../poseidon/fiber/http_request_future.hpp"
+#include "../poseidon/base/config_file.hpp"
+#include "../poseidon/base/abstract_task.hpp"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+using namespace ::poseidon;
+
+// This is a stand-in HTTP server, which serves each connection in a thread.
+static ::std::atomic<int> accept_count;
+static ::std::atomic<bool> stopping;
+
+static
+void
+do_send_all(int fd, const cow_string& str)
+  {
+    size_t off = 0;
+    while(off != str.size()) {
+      ::ssize_t r = ::send(fd, str.data() + off, str.size() - off, MSG_NOSIGNAL);
+      if(r <= 0)
+        return;
+      off += static_cast<size_t>(r);
+    }
+  }
+
+static
+bool
+do_starts_with(const cow_string& str, const char* prefix)
+  {
+    return ::strncmp(str.c_str(), prefix, ::strlen(prefix)) == 0;
+  }
+
+static
+void
+do_serve_connection(int fd)
+  {
+    cow_string buf;
+    char temp[4096];
+    for(;;) {
+      size_t pos = buf.find("\r\n\r\n");
+      if(pos == cow_string::npos) {
+        ::ssize_t r = ::recv(fd, temp, sizeof(temp), 0);
+        if(r <= 0)
+          break;
+
+        buf.append(temp, static_cast<size_t>(r));
+        continue;
+      }
+
+      cow_string req(buf.data(), pos);
+      buf.erase(0, pos + 4);
+
+      if(do_starts_with(req, "HEAD /hello ")) {
+        do_send_all(fd, &"HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\n");
+      }
+      else if(do_starts_with(req, "GET /hello ")) {
+        do_send_all(fd, &"HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhello");
+      }
+      else if(do_starts_with(req, "GET /close ")) {
+        do_send_all(fd, &"HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 3\r\n\r\nbye");
+        break;
+      }
+      else if(do_starts_with(req, "GET /drop ")) {
+        // Close the connection silently, as if it had been idle for too long.
+        do_send_all(fd, &"HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\ndrop");
+        break;
+      }
+      else
+        do_send_all(fd, &"HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+    }
+    ::close(fd);
+  }
+
+struct Result
+  {
+    ::std::atomic<bool> done { false };
+    HTTP_S_Headers resp;
+    linear_buffer data;
+    cow_string error;
+  };
+
+static
+shptr<Result>
+do_request(HTTP_Method method, const char* path, uint16_t port)
+  {
+    HTTP_C_Headers req;
+    req.method = method;
+    req.raw_host = &"127.0.0.1";
+    req.port = port;
+    req.raw_path = cow_string(path);
+
+    auto result = new_sh<Result>();
+    http_connector.request(req, &"",
+      [result](HTTP_S_Headers&& resp, linear_buffer&& data, const char* error)
+        {
+          result->resp = move(resp);
+          result->data = move(data);
+          result->error = error ? error : "";
+          result->done = true;
+        });
+
+    for(uint32_t k = 0;  !result->done && (k != 5000);  ++k)
+      ::usleep(1000);
+
+    POSEIDON_TEST_CHECK(result->done);
+    return result;
+  }
+
+struct Wake_Task : Abstract_Task
+  {
+    virtual
+    void
+    do_on_abstract_task_execute()
+      override
+      { }
+  };
+
+int
+main()
+  {
+    ::alarm(30);
+
+    // Start the server on an ephemeral port.
+    int listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    ::sockaddr_in sa = { };
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+    POSEIDON_TEST_CHECK(::bind(listen_fd, reinterpret_cast<::sockaddr*>(&sa), sizeof(sa)) == 0);
+    ::socklen_t salen = sizeof(sa);
+    POSEIDON_TEST_CHECK(::getsockname(listen_fd, reinterpret_cast<::sockaddr*>(&sa), &salen) == 0);
+    POSEIDON_TEST_CHECK(::listen(listen_fd, 16) == 0);
+    uint16_t port = ::ntohs(sa.sin_port);
+
+    ::std::vector<::std::thread> conn_threads;
+    ::std::thread server_thread(
+      [&] {
+        for(;;) {
+          int fd = ::accept(listen_fd, nullptr, nullptr);
+          if(fd < 0)
+            return;
+
+          accept_count ++;
+          conn_threads.emplace_back(do_serve_connection, fd);
+        }
+      });
+
+    char conf_path[] = "/tmp/poseidon_conf_XXXXXX";
+    int fd = ::mkstemp(conf_path);
+    POSEIDON_TEST_CHECK(fd >= 0);
+    static constexpr char conf[] =
+        "network {\n"
+        "  dns {\n    resolv_conf_path = \"/nonexistent\"\n  }\n"
+        "  http {\n    client_max_idle_connections = 2\n    client_idle_timeout = 10\n  }\n"
+        "}\n";
+    POSEIDON_TEST_CHECK(::write(fd, conf, sizeof(conf) - 1) > 0);
+    ::close(fd);
+
+    Config_File conf_file(cow_string(conf_path));
+    ::unlink(conf_path);
+
+    network_scheduler.reload(conf_file);
+    dns_resolver.reload(conf_file);
+    http_connector.reload(conf_file);
+
+    ::std::thread network_thread([] { while(!stopping) network_scheduler.thread_loop();  });
+    ::std::thread task_thread([] { while(!stopping) task_scheduler.thread_loop();  });
+
+    // Consecutive requests share a connection.
+    auto r = do_request(http_GET, "/hello", port);
+    POSEIDON_TEST_CHECK(r->error == "");
+    POSEIDON_TEST_CHECK(r->resp.status == 200);
+    POSEIDON_TEST_CHECK(cow_string(r->data.data(), r->data.size()) == "hello");
+
+    r = do_request(http_HEAD, "/hello", port);
+    POSEIDON_TEST_CHECK(r->error == "");
+    POSEIDON_TEST_CHECK(r->resp.status == 200);
+    POSEIDON_TEST_CHECK(r->data.size() == 0);
+
+    r = do_request(http_GET, "/missing", port);
+    POSEIDON_TEST_CHECK(r->resp.status == 404);
+    POSEIDON_TEST_CHECK(accept_count == 1);
+
+    // The server closes the connection after this one.
+    r = do_request(http_GET, "/close", port);
+    POSEIDON_TEST_CHECK(r->error == "");
+    POSEIDON_TEST_CHECK(cow_string(r->data.data(), r->data.size()) == "bye");
+    POSEIDON_TEST_CHECK(accept_count == 1);
+
+    r = do_request(http_GET, "/hello", port);
+    POSEIDON_TEST_CHECK(r->error == "");
+    POSEIDON_TEST_CHECK(accept_count == 2);
+
+    // The server drops an idle connection silently. The next request shall
+    // succeed on a new connection.
+    r = do_request(http_GET, "/drop", port);
+    POSEIDON_TEST_CHECK(r->error == "");
+    POSEIDON_TEST_CHECK(accept_count == 2);
+
+    r = do_request(http_GET, "/hello", port);
+    POSEIDON_TEST_CHECK(r->error == "");
+    POSEIDON_TEST_CHECK(cow_string(r->data.data(), r->data.size()) == "hello");
+    POSEIDON_TEST_CHECK(accept_count == 3);
+
+    // Send a request with a future.
+    HTTP_C_Headers req;
+    req.raw_host = &"127.0.0.1";
+    req.port = port;
+    req.raw_path = &"/hello";
+    auto futr = new_sh<HTTP_Request_Future>(http_connector, req, &"");
+    task_scheduler.launch(futr);
+
+    for(uint32_t k = 0;  !futr->initialized() && (k != 5000);  ++k)
+      ::usleep(1000);
+
+    POSEIDON_TEST_CHECK(futr->successful());
+    POSEIDON_TEST_CHECK(futr->response().status == 200);
+    POSEIDON_TEST_CHECK(futr->response_payload().size() == 5);
+    POSEIDON_TEST_CHECK(accept_count == 3);
+
+    // Connection failures are reported. Shutting down the listening socket
+    // also stops the server.
+    http_connector.close_idle_connections();
+    ::shutdown(listen_fd, SHUT_RDWR);
+    server_thread.join();
+    for(auto& t : conn_threads)
+      t.join();
+
+    r = do_request(http_GET, "/hello", port);
+    POSEIDON_TEST_CHECK(r->error != "");
+    ::close(listen_fd);
+
+    // Stop all threads.
+    stopping = true;
+    task_scheduler.launch(new_sh<Wake_Task>());
+    network_thread.join();
+    task_thread.join();
+  }
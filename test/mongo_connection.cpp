@@ -4,6 +4,7 @@
 #include "utils.hpp"
 #include "../poseidon/mongo/mongo_connection.hpp"
 #include "../poseidon/mongo/mongo_value.hpp"
+#include "../poseidon/mongo/mongo_document_view.hpp"
 #include <asteria/rocket/tinyfmt_file.hpp>
 using namespace ::poseidon;
 
@@ -72,5 +73,59 @@ main()
       format(fmt, "  $1\n", doc);
     }
 
+    // Read a cursor in batches. `getMore` and `killCursors` must be sent to
+    // the server where the cursor was created.
+    uint32_t server_id = conn.select_server();
+    POSEIDON_TEST_CHECK(server_id != 0);
+
+    doc.clear();
+    doc.emplace_back(&"delete", &"poseidon_cursor_test");
+    auto& del = doc.emplace_back(&"deletes", nullptr).second.open_array().emplace_back().open_document();
+    del.emplace_back(&"q", nullptr).second.open_document();
+    del.emplace_back(&"limit", 0);
+    conn.execute(doc, server_id);
+
+    doc.clear();
+    doc.emplace_back(&"insert", &"poseidon_cursor_test");
+    auto& docs = doc.emplace_back(&"documents", nullptr).second.open_array();
+    for(int k = 0;  k != 5;  ++k)
+      docs.emplace_back().open_document().emplace_back(&"value", k);
+    conn.execute(doc, server_id);
+
+    doc.clear();
+    doc.emplace_back(&"find", &"poseidon_cursor_test");
+    doc.emplace_back(&"batchSize", 2);
+    conn.execute(doc, server_id);
+    auto bson_reply = conn.fetch_raw_reply_bson_opt();
+    POSEIDON_TEST_CHECK(bson_reply);
+    Mongo_Document_View cursor = Mongo_Document_View(bson_reply).get_document(&"cursor");
+    int64_t cursor_id = cursor.get_integer(&"id");
+    POSEIDON_TEST_CHECK(cursor_id != 0);
+    POSEIDON_TEST_CHECK(cursor.get_array(&"firstBatch").has_field(&"1"));
+    POSEIDON_TEST_CHECK(!cursor.get_array(&"firstBatch").has_field(&"2"));
+
+    // Cursor IDs must be 64-bit integers, so compose these commands directly.
+    scoped_bson bson_cmd;
+    ::bson_append_int64(bson_cmd, "getMore", -1, cursor_id);
+    ::bson_append_utf8(bson_cmd, "collection", -1, "poseidon_cursor_test", -1);
+    ::bson_append_int64(bson_cmd, "batchSize", -1, 2);
+    conn.execute_bson(bson_cmd, server_id);
+    bson_reply = conn.fetch_raw_reply_bson_opt();
+    POSEIDON_TEST_CHECK(bson_reply);
+    cursor = Mongo_Document_View(bson_reply).get_document(&"cursor");
+    POSEIDON_TEST_CHECK(cursor.get_integer(&"id") == cursor_id);
+    POSEIDON_TEST_CHECK(cursor.get_array(&"nextBatch").has_field(&"1"));
+
+    scoped_bson bson_kill;
+    ::bson_t cursors;
+    ::bson_append_utf8(bson_kill, "killCursors", -1, "poseidon_cursor_test", -1);
+    ::bson_append_array_unsafe_begin(bson_kill, "cursors", -1, &cursors);
+    ::bson_append_int64(&cursors, "0", -1, cursor_id);
+    ::bson_append_array_end(bson_kill, &cursors);
+    conn.execute_bson(bson_kill, server_id);
+    bson_reply = conn.fetch_raw_reply_bson_opt();
+    POSEIDON_TEST_CHECK(bson_reply);
+    POSEIDON_TEST_CHECK(Mongo_Document_View(bson_reply).get_array(&"cursorsKilled").has_field(&"0"));
+
     ::fprintf(stderr, "reset ==> %d\n", conn.reset());
   }
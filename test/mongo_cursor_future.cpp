@@ -0,0 +1,193 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/fiber/mongo_cursor_future.hpp"
+#include "../poseidon/static/mongo_connector.hpp"
+#include "../poseidon/static/task_scheduler.hpp"
+#include "../poseidon/mongo/mongo_connection.hpp"
+#include "../poseidon/mongo/mongo_document_view.hpp"
+#include "../poseidon/mongo/mongo_document_builder.hpp"
+#include "../poseidon/base/config_file.hpp"
+#include "../poseidon/base/abstract_task.hpp"
+#include <unistd.h>
+#include <atomic>
+#include <thread>
+using namespace ::poseidon;
+
+static ::std::atomic<bool> stopping;
+
+struct Wake_Task : Abstract_Task
+  {
+    virtual
+    void
+    do_on_abstract_task_execute()
+      override
+      { }
+  };
+
+static
+void
+do_wait(const shptr<Mongo_Cursor_Future>& futr)
+  {
+    task_scheduler.launch(futr);
+
+    for(uint32_t k = 0;  !futr->initialized() && (k != 5000);  ++k)
+      ::usleep(1000);
+
+    POSEIDON_TEST_CHECK(futr->successful());
+  }
+
+static
+uniptr<Mongo_Connection>
+do_take_pooled_connection(const Mongo_Connection* expected)
+  {
+    // The connection is put back into the pool after the future has become
+    // ready, so wait for it.
+    uniptr<Mongo_Connection> conn;
+    for(uint32_t k = 0;  k != 5000;  ++k) {
+      conn = mongo_connector.allocate_default_connection();
+      if(conn.get() == expected)
+        break;
+
+      ::usleep(1000);
+    }
+
+    POSEIDON_TEST_CHECK(conn.get() == expected);
+    return conn;
+  }
+
+int
+main()
+  {
+    Mongo_Document cmd;
+    Mongo_Document_Builder builder;
+    Mongo_Document_View view;
+    Mongo_Document doc;
+
+    // `find` takes `batchSize` at the top level.
+    cmd.emplace_back(&"find", &"poseidon_cursor_test");
+    Mongo_Cursor_Future::compose_command(builder, cmd, 7);
+    view = builder.view();
+    POSEIDON_TEST_CHECK(view.get_utf8(&"find") == "poseidon_cursor_test");
+    POSEIDON_TEST_CHECK(view.get_integer(&"batchSize") == 7);
+    POSEIDON_TEST_CHECK(!view.has_field(&"cursor"));
+
+    // A `batchSize` from the user is preserved.
+    cmd.emplace_back(&"batchSize", 3);
+    builder.clear();
+    Mongo_Cursor_Future::compose_command(builder, cmd, 7);
+    builder.view().to_document(doc);
+    POSEIDON_TEST_CHECK(doc.size() == 2);
+    POSEIDON_TEST_CHECK(doc.at(1).first == "batchSize");
+    POSEIDON_TEST_CHECK(doc.at(1).second.as_integer() == 3);
+
+    // `aggregate` takes `batchSize` in `cursor`.
+    cmd.clear();
+    cmd.emplace_back(&"aggregate", &"poseidon_cursor_test");
+    cmd.emplace_back(&"pipeline", nullptr).second.open_array();
+    cmd.emplace_back(&"cursor", nullptr).second.open_document();
+    builder.clear();
+    Mongo_Cursor_Future::compose_command(builder, cmd, 7);
+    view = builder.view();
+    POSEIDON_TEST_CHECK(view.get_document(&"cursor").get_integer(&"batchSize") == 7);
+    POSEIDON_TEST_CHECK(!view.has_field(&"batchSize"));
+
+    cmd.mut_back().second.open_document().emplace_back(&"batchSize", 5);
+    builder.clear();
+    Mongo_Cursor_Future::compose_command(builder, cmd, 7);
+    builder.view().to_document(doc);
+    POSEIDON_TEST_CHECK(doc.size() == 3);
+    POSEIDON_TEST_CHECK(doc.at(2).second.as_document().size() == 1);
+    POSEIDON_TEST_CHECK(doc.at(2).second.as_document().at(0).second.as_integer() == 5);
+
+    // Try connecting to localhost. If the server is offline, skip the test.
+    char conf_path[] = "/tmp/poseidon_conf_XXXXXX";
+    int fd = ::mkstemp(conf_path);
+    POSEIDON_TEST_CHECK(fd >= 0);
+    static constexpr char conf[] =
+        "mongo {\n"
+        "  default_service_uri = \"root@localhost:27017/admin\"\n"
+        "  default_password = \"123456\"\n"
+        "  connection_pool_size = 1\n"
+        "}\n";
+    POSEIDON_TEST_CHECK(::write(fd, conf, sizeof(conf) - 1) > 0);
+    ::close(fd);
+
+    Config_File conf_file(cow_string(conf_path));
+    ::unlink(conf_path);
+    mongo_connector.reload(conf_file);
+
+    auto conn = mongo_connector.allocate_default_connection();
+    try {
+      doc.clear();
+      doc.emplace_back(&"ping", 1);
+      conn->execute(doc);
+    }
+    catch(exception& e) {
+      ::fprintf(stderr, "could not connect to server: %s\n", e.what());
+      return ::strstr(e.what(), "ERROR 15.13053:")
+                  ? 77  // skip
+                  :  1; // fail
+    }
+
+    doc.clear();
+    doc.emplace_back(&"delete", &"poseidon_cursor_test");
+    auto& del = doc.emplace_back(&"deletes", nullptr).second.open_array().emplace_back().open_document();
+    del.emplace_back(&"q", nullptr).second.open_document();
+    del.emplace_back(&"limit", 0);
+    conn->execute(doc);
+
+    doc.clear();
+    doc.emplace_back(&"insert", &"poseidon_cursor_test");
+    auto& docs = doc.emplace_back(&"documents", nullptr).second.open_array();
+    for(int k = 0;  k != 5;  ++k)
+      docs.emplace_back().open_document().emplace_back(&"value", k);
+    conn->execute(doc);
+    POSEIDON_TEST_CHECK(conn->reset());
+
+    ::std::thread task_thread([] { while(!stopping) task_scheduler.thread_loop();  });
+
+    // Read all documents in batches, by chaining futures. The result of a
+    // future is not affected by the next one.
+    const Mongo_Connection* raw_conn = conn.get();
+    cmd.clear();
+    cmd.emplace_back(&"find", &"poseidon_cursor_test");
+    auto futr = new_sh<Mongo_Cursor_Future>(mongo_connector, move(conn), cmd, 2);
+    do_wait(futr);
+    POSEIDON_TEST_CHECK(futr->result().size() == 2);
+    POSEIDON_TEST_CHECK(futr->eof() == false);
+
+    auto next = new_sh<Mongo_Cursor_Future>(futr);
+    do_wait(next);
+    POSEIDON_TEST_CHECK(next->result().size() == 2);
+    POSEIDON_TEST_CHECK(next->eof() == false);
+    POSEIDON_TEST_CHECK(futr->result().size() == 2);
+
+    futr = new_sh<Mongo_Cursor_Future>(next);
+    do_wait(futr);
+    POSEIDON_TEST_CHECK(futr->result().size() == 1);
+    POSEIDON_TEST_CHECK(futr->eof() == true);
+    POSEIDON_TEST_CHECK_CATCH(new_sh<Mongo_Cursor_Future>(futr));
+
+    // After the end of the result, the connection is put back into the pool.
+    conn = do_take_pooled_connection(raw_conn);
+
+    // Close the cursor after the first batch. The connection is put back into
+    // the pool.
+    futr = new_sh<Mongo_Cursor_Future>(mongo_connector, move(conn), cmd, 2);
+    do_wait(futr);
+    POSEIDON_TEST_CHECK(futr->eof() == false);
+
+    next = new_sh<Mongo_Cursor_Future>(futr, true);
+    POSEIDON_TEST_CHECK(next->kill_cursor());
+    do_wait(next);
+    POSEIDON_TEST_CHECK(next->result().size() == 0);
+    POSEIDON_TEST_CHECK(next->eof() == true);
+    conn = do_take_pooled_connection(raw_conn);
+
+    // Stop all threads.
+    stopping = true;
+    task_scheduler.launch(new_sh<Wake_Task>());
+    task_thread.join();
+  }
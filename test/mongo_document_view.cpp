@@ -0,0 +1,103 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/mongo/mongo_document_view.hpp"
+#include "../poseidon/mongo/mongo_document_builder.hpp"
+using namespace ::poseidon;
+
+int
+main()
+  {
+    Mongo_Document_View empty;
+    POSEIDON_TEST_CHECK(empty.size() == 5);
+    POSEIDON_TEST_CHECK(!empty.has_field(&"name"));
+
+    // Compose a document directly.
+    Mongo_Document_Builder builder;
+    builder.append_utf8(&"name", &"meow");
+    builder.append_integer(&"level", 42);
+    builder.append_integer(&"exp", 12345678901234);
+    builder.append_double(&"ratio", 0.25);
+    builder.append_boolean(&"online", true);
+    builder.open_array(&"tags");
+    builder.append_utf8(&"ignored", &"one");
+    builder.append_integer(&"", 2);
+    builder.open_document(&"");
+    builder.append_null(&"three");
+    builder.close();
+    builder.close();
+    builder.open_document(&"pos");
+    POSEIDON_TEST_CHECK(builder.depth() == 1);
+    POSEIDON_TEST_CHECK_CATCH(builder.bson());
+    builder.append_double(&"x", 1.5);
+    builder.append_double(&"y", -2);
+    builder.close();
+    POSEIDON_TEST_CHECK(builder.depth() == 0);
+    POSEIDON_TEST_CHECK_CATCH(builder.close());
+
+    // Read fields without conversion.
+    Mongo_Document_View view = builder.view();
+    POSEIDON_TEST_CHECK(view.get_utf8(&"name") == "meow");
+    POSEIDON_TEST_CHECK(view.get_integer(&"level") == 42);
+    POSEIDON_TEST_CHECK(view.get_integer(&"exp") == 12345678901234);
+    POSEIDON_TEST_CHECK(view.get_double(&"ratio") == 0.25);
+    POSEIDON_TEST_CHECK(view.get_boolean(&"online") == true);
+    POSEIDON_TEST_CHECK(view.field_type(&"tags") == mongo_value_array);
+    POSEIDON_TEST_CHECK(view.field_type(&"none") == mongo_value_null);
+    POSEIDON_TEST_CHECK_CATCH(view.get_integer(&"name"));
+    POSEIDON_TEST_CHECK_CATCH(view.get_integer(&"none"));
+
+    Mongo_Document_View tags = view.get_array(&"tags");
+    POSEIDON_TEST_CHECK(tags.get_utf8(&"0") == "one");
+    POSEIDON_TEST_CHECK(tags.get_integer(&"1") == 2);
+    POSEIDON_TEST_CHECK(tags.get_document(&"2").has_field(&"three"));
+    POSEIDON_TEST_CHECK(view.get_document(&"pos").get_double(&"y") == -2);
+    POSEIDON_TEST_CHECK(view.get_value(&"tags").to_string() == R"(["one",2,{"three":null}])");
+    POSEIDON_TEST_CHECK(view.get_value(&"none").is_null());
+
+    // Convert to and from `Mongo_Document`.
+    Mongo_Document doc;
+    view.to_document(doc);
+    POSEIDON_TEST_CHECK(doc.size() == 7);
+    POSEIDON_TEST_CHECK(doc.at(1).first == "level");
+    POSEIDON_TEST_CHECK(doc.at(6).second.as_document().at(0).second.as_double() == 1.5);
+
+    Mongo_Document_Builder copy;
+    copy.append_fields(doc);
+    POSEIDON_TEST_CHECK(copy.view().size() == view.size());
+    POSEIDON_TEST_CHECK(::memcmp(copy.view().data(), view.data(), view.size()) == 0);
+
+    POSEIDON_TEST_CHECK_CATCH(Mongo_Document_View(view.data(), view.size() - 1));
+
+    builder.clear();
+    POSEIDON_TEST_CHECK(builder.view().size() == 5);
+
+    // Look up a field in many documents, by converting each of them into a
+    // `Mongo_Document`, and by reading the BSON data. The results shall match.
+    static constexpr size_t count = 100;
+    cow_bstring data;
+    for(size_t k = 0;  k != count;  ++k) {
+      copy.clear();
+      copy.append_fields(doc);
+      copy.append_integer(&"index", static_cast<int64_t>(k));
+      data.append(copy.view().data(), copy.view().size());
+    }
+
+    int64_t doc_sum = 0;
+    for(size_t offset = 0;  offset != data.size();  ) {
+      uint32_t size = ::asteria::load_le<uint32_t>(data.data() + offset);
+      Mongo_Document_View(data.data() + offset, size).to_document(doc);
+      doc_sum += doc.back().second.as_integer();
+      offset += size;
+    }
+
+    int64_t view_sum = 0;
+    for(size_t offset = 0;  offset != data.size();  ) {
+      uint32_t size = ::asteria::load_le<uint32_t>(data.data() + offset);
+      view_sum += Mongo_Document_View(data.data() + offset, size).get_integer(&"index");
+      offset += size;
+    }
+
+    POSEIDON_TEST_CHECK(doc_sum == view_sum);
+  }
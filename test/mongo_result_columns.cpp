@@ -0,0 +1,67 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/mongo/mongo_result_columns.hpp"
+using namespace ::poseidon;
+
+int
+main()
+  {
+    Mongo_Result_Columns cols;
+    POSEIDON_TEST_CHECK(cols.column_count() == 0);
+    POSEIDON_TEST_CHECK(cols.row_count() == 0);
+
+    Mongo_Document doc = { { &"name", &"meow" }, { &"flag", true } };
+    cols.append_document(doc);
+    POSEIDON_TEST_CHECK(cols.column_count() == 2);
+    POSEIDON_TEST_CHECK(cols.column_type(0) == mongo_value_utf8);
+    POSEIDON_TEST_CHECK(cols.column_type(1) == mongo_value_boolean);
+
+    // Fields may come in any order. New fields become new columns, and values
+    // in previous rows are missing.
+    doc = { { &"flag", 5 }, { &"tags", Mongo_Array{ 1, &"two" } }, { &"name", &"bark" } };
+    cols.append_document(doc);
+    POSEIDON_TEST_CHECK(cols.column_count() == 3);
+    POSEIDON_TEST_CHECK(cols.row_count() == 2);
+    POSEIDON_TEST_CHECK(cols.find_column(&"tags") == 2);
+    POSEIDON_TEST_CHECK(cols.find_column(&"none") == SIZE_MAX);
+    POSEIDON_TEST_CHECK(cols.string(0, 1) == "bark");
+    POSEIDON_TEST_CHECK(cols.column_type(1) == mongo_value_integer);
+    POSEIDON_TEST_CHECK(cols.integer_data(1)[0] == 1);
+    POSEIDON_TEST_CHECK(cols.integer_data(1)[1] == 5);
+    POSEIDON_TEST_CHECK(cols.is_null(2, 0));
+    POSEIDON_TEST_CHECK(cols.column_type(2) == mongo_value_array);
+    POSEIDON_TEST_CHECK(cols.string(2, 1) == R"([1,"two"])");
+
+    // Integers are promoted to doubles.
+    doc = { { &"flag", 2.5 } };
+    cols.append_document(doc);
+    POSEIDON_TEST_CHECK(cols.row_count() == 3);
+    POSEIDON_TEST_CHECK(cols.column_type(1) == mongo_value_double);
+    POSEIDON_TEST_CHECK(cols.double_data(1)[0] == 1);
+    POSEIDON_TEST_CHECK(cols.double_data(1)[1] == 5);
+    POSEIDON_TEST_CHECK(cols.double_data(1)[2] == 2.5);
+    POSEIDON_TEST_CHECK(cols.is_null(0, 2));
+    POSEIDON_TEST_CHECK(cols.is_null(2, 2));
+    POSEIDON_TEST_CHECK(cols.value(0, 2).is_null());
+    POSEIDON_TEST_CHECK(cols.value(0, 0).as_utf8() == "meow");
+
+    // Other values must have the same type as their columns.
+    doc = { { &"name", 42 }, { &"other", 1 } };
+    POSEIDON_TEST_CHECK_CATCH(cols.append_document(doc));
+    POSEIDON_TEST_CHECK(cols.column_count() == 3);
+    POSEIDON_TEST_CHECK(cols.row_count() == 3);
+    POSEIDON_TEST_CHECK_CATCH(cols.integer_data(0));
+
+    ::bson_oid_t oid_data = { 0x65,0xC9,0x8F,0x34,0x2D,0x18,0x60,0xB7,0xBA,0xEF,0x94,0xFB };
+    doc = { { &"_id", oid_data } };
+    cols.append_document(doc);
+    POSEIDON_TEST_CHECK(cols.column_type(3) == mongo_value_oid);
+    POSEIDON_TEST_CHECK(cols.string(3, 3).n == 12);
+    POSEIDON_TEST_CHECK(::bson_oid_equal(&(cols.value(3, 3).as_oid()), &oid_data));
+
+    cols.clear();
+    POSEIDON_TEST_CHECK(cols.column_count() == 0);
+    POSEIDON_TEST_CHECK(cols.row_count() == 0);
+  }
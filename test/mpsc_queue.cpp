@@ -0,0 +1,92 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/details/mpsc_queue.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+using namespace ::poseidon;
+
+static constexpr uint32_t producer_count = 4;
+static constexpr uint32_t value_count = 100000;
+
+struct Value
+  {
+    uint32_t producer;
+    uint32_t seq;
+  };
+
+static mpsc_queue<Value> queue;
+static ::std::atomic<uint32_t> pending_starts;
+static ::std::atomic<bool> stopping;
+
+int
+main()
+  {
+    ::alarm(60);
+
+    // Each consumer run ends when the queue becomes empty. A new run shall be
+    // requested by the producer which pushes the next value.
+    uint32_t consumed = 0;
+    uint32_t runs = 0;
+    uint32_t next_seq[producer_count] = { };
+
+    ::std::thread consumer(
+      [&] {
+        for(;;) {
+          if(pending_starts.load() == 0) {
+            if(stopping.load() && (pending_starts.load() == 0))
+              return;
+
+            ::std::this_thread::yield();
+            continue;
+          }
+
+          pending_starts --;
+          runs ++;
+
+          Value value;
+          while(queue.pop(value)) {
+            // Values from the same producer arrive in order.
+            POSEIDON_TEST_CHECK(value.producer < producer_count);
+            POSEIDON_TEST_CHECK(value.seq == next_seq[value.producer]);
+            next_seq[value.producer] ++;
+            consumed ++;
+          }
+        }
+      });
+
+    ::std::atomic<uint32_t> starts { 0 };
+    ::std::vector<::std::thread> producers;
+    for(uint32_t id = 0;  id != producer_count;  ++id)
+      producers.emplace_back(
+        [id, &starts] {
+          for(uint32_t seq = 0;  seq != value_count;  ++seq)
+            if(queue.push(Value{ id, seq })) {
+              starts ++;
+              pending_starts ++;
+            }
+        });
+
+    for(auto& t : producers)
+      t.join();
+
+    stopping = true;
+    consumer.join();
+
+    POSEIDON_TEST_CHECK(consumed == producer_count * value_count);
+    POSEIDON_TEST_CHECK(runs == starts.load());
+    POSEIDON_TEST_CHECK(runs >= 1);
+    for(uint32_t id = 0;  id != producer_count;  ++id)
+      POSEIDON_TEST_CHECK(next_seq[id] == value_count);
+
+    // An idle queue starts a new consumer.
+    POSEIDON_TEST_CHECK(queue.push(Value{ 0, 0 }) == true);
+    POSEIDON_TEST_CHECK(queue.push(Value{ 0, 1 }) == false);
+    Value value;
+    POSEIDON_TEST_CHECK(queue.pop(value) && (value.seq == 0));
+    POSEIDON_TEST_CHECK(queue.pop(value) && (value.seq == 1));
+    POSEIDON_TEST_CHECK(queue.pop(value) == false);
+    POSEIDON_TEST_CHECK(queue.push(Value{ 0, 2 }) == true);
+  }
@@ -0,0 +1,81 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/fiber/mysql_batch_insert_future.hpp"
+using namespace ::poseidon;
+
+int
+main()
+  {
+    const cow_vector<cow_string> columns = { &"id", &"name" };
+    const cow_vector<cow_string> no_columns;
+
+    // Plain names
+    POSEIDON_TEST_CHECK(MySQL_Batch_Insert_Future::compose_statement(
+          &"user", columns, no_columns, 1)
+        == "INSERT INTO `user` (`id`, `name`)\n  VALUES (?, ?)");
+
+    POSEIDON_TEST_CHECK(MySQL_Batch_Insert_Future::compose_statement(
+          &"user", columns, no_columns, 3)
+        == "INSERT INTO `user` (`id`, `name`)\n  VALUES (?, ?), (?, ?), (?, ?)");
+
+    // Qualified table names, and backticks in names
+    POSEIDON_TEST_CHECK(MySQL_Batch_Insert_Future::compose_statement(
+          &"game.user", columns, no_columns, 1)
+        == "INSERT INTO `game`.`user` (`id`, `name`)\n  VALUES (?, ?)");
+
+    POSEIDON_TEST_CHECK(MySQL_Batch_Insert_Future::compose_statement(
+          &"us`er", { &"a`b", &"``" }, no_columns, 1)
+        == "INSERT INTO `us``er` (`a``b`, ``````)\n  VALUES (?, ?)");
+
+    // Updates on key conflicts
+    POSEIDON_TEST_CHECK(MySQL_Batch_Insert_Future::compose_statement(
+          &"user", columns, { &"name" }, 2)
+        == "INSERT INTO `user` (`id`, `name`)\n  VALUES (?, ?), (?, ?) AS `new`\n"
+           "  ON DUPLICATE KEY UPDATE `name` = `new`.`name`");
+
+    POSEIDON_TEST_CHECK(MySQL_Batch_Insert_Future::compose_statement(
+          &"user", columns, { &"id", &"na`me" }, 1)
+        == "INSERT INTO `user` (`id`, `name`)\n  VALUES (?, ?) AS `new`\n"
+           "  ON DUPLICATE KEY UPDATE `id` = `new`.`id`, `na``me` = `new`.`na``me`");
+
+    // Invalid names
+    POSEIDON_TEST_CHECK_CATCH(MySQL_Batch_Insert_Future::compose_statement(
+          &"", columns, no_columns, 1));
+    POSEIDON_TEST_CHECK_CATCH(MySQL_Batch_Insert_Future::compose_statement(
+          &"game.", columns, no_columns, 1));
+    POSEIDON_TEST_CHECK_CATCH(MySQL_Batch_Insert_Future::compose_statement(
+          &".user", columns, no_columns, 1));
+    POSEIDON_TEST_CHECK_CATCH(MySQL_Batch_Insert_Future::compose_statement(
+          &"a.b.c", columns, no_columns, 1));
+    POSEIDON_TEST_CHECK_CATCH(MySQL_Batch_Insert_Future::compose_statement(
+          &"user", { &"id", &"" }, no_columns, 1));
+    POSEIDON_TEST_CHECK_CATCH(MySQL_Batch_Insert_Future::compose_statement(
+          &"user", { &"id", cow_string(1, '\0') }, no_columns, 1));
+    POSEIDON_TEST_CHECK_CATCH(MySQL_Batch_Insert_Future::compose_statement(
+          &"user", no_columns, no_columns, 1));
+    POSEIDON_TEST_CHECK_CATCH(MySQL_Batch_Insert_Future::compose_statement(
+          &"user", columns, no_columns, 0));
+
+    // Split rows by size. Each of these rows takes 122 bytes.
+    cow_vector<cow_vector<MySQL_Value>> rows;
+    cow_vector<MySQL_Value> row;
+    row.emplace_back(static_cast<int64_t>(1));
+    row.emplace_back(cow_string(2000, 'x'));
+    rows.push_back(row);
+    for(int k = 0;  k != 9;  ++k) {
+      row.mut(1) = cow_string(100, 'y');
+      rows.push_back(row);
+    }
+    rows.push_back(rows.front());
+
+    // An oversize row goes alone, without taking any rows after it.
+    POSEIDON_TEST_CHECK(MySQL_Batch_Insert_Future::count_statement_rows(rows, 0, 100, 1000) == 1);
+    POSEIDON_TEST_CHECK(MySQL_Batch_Insert_Future::count_statement_rows(rows, 1, 100, 1000) == 8);
+    POSEIDON_TEST_CHECK(MySQL_Batch_Insert_Future::count_statement_rows(rows, 9, 100, 1000) == 1);
+    POSEIDON_TEST_CHECK(MySQL_Batch_Insert_Future::count_statement_rows(rows, 10, 100, 1000) == 1);
+    POSEIDON_TEST_CHECK(MySQL_Batch_Insert_Future::count_statement_rows(rows, 11, 100, 1000) == 0);
+    POSEIDON_TEST_CHECK(MySQL_Batch_Insert_Future::count_statement_rows(rows, 1, 3, 1000) == 3);
+    POSEIDON_TEST_CHECK(MySQL_Batch_Insert_Future::count_statement_rows(rows, 1, 100, 100000) == 10);
+  }
@@ -5,6 +5,7 @@
 #include "../poseidon/mysql/mysql_connection.hpp"
 #include "../poseidon/mysql/mysql_value.hpp"
 #include <asteria/rocket/tinyfmt_file.hpp>
+#include <poll.h>
 using namespace ::poseidon;
 
 int
@@ -38,5 +39,80 @@ main()
         format(fmt, "  $1 = $2\n", fields.at(k), values.at(k));
     }
 
-    ::fprintf(stderr, "reset ==> %d\n", conn.reset());
+    // Prepared statements are reused.
+    POSEIDON_TEST_CHECK(conn.statement_cache_misses() == 1);
+    conn.set_statement_cache_size(4);
+    conn.execute(&"select 1", {});
+    POSEIDON_TEST_CHECK(conn.statement_cache_misses() == 2);
+    conn.execute(&"select 1", {});
+    POSEIDON_TEST_CHECK(conn.statement_cache_hits() == 1);
+    POSEIDON_TEST_CHECK(conn.fetch_row(values) && (values.at(0).as_integer() == 1));
+
+    // Session states are discarded by a reset, including cached statements.
+    conn.execute(&"set @meow = 42", {});
+    POSEIDON_TEST_CHECK(conn.reset());
+    conn.execute(&"select @meow", {});
+    POSEIDON_TEST_CHECK(conn.fetch_row(values) && values.at(0).is_null());
+    conn.execute(&"select 1", {});
+    POSEIDON_TEST_CHECK(conn.statement_cache_hits() == 1);
+
+    // Execute a statement asynchronously. Arguments are substituted.
+    MySQL_Connection aconn(&"root@localhost/mysql", &"123456");
+    bool done = aconn.execute_nonblocking_start(&"select ? + 1, '?', ? -- ?\n", { 41, &"str" });
+    while(!done) {
+      ::pollfd pfd = { aconn.nonblocking_fd(), POLLIN, 0 };
+      ::poll(&pfd, 1, 1000);
+      done = aconn.execute_nonblocking_continue();
+    }
+
+    POSEIDON_TEST_CHECK(aconn.connected() && aconn.asynchronous());
+    POSEIDON_TEST_CHECK(aconn.fetch_fields(fields) && (fields.size() == 3));
+    POSEIDON_TEST_CHECK(aconn.fetch_row(values) && (values.size() == 3));
+    POSEIDON_TEST_CHECK(values.at(0).as_integer() == 42);
+    POSEIDON_TEST_CHECK(values.at(1).as_blob() == "?");
+    POSEIDON_TEST_CHECK(values.at(2).as_blob() == "str");
+    POSEIDON_TEST_CHECK(aconn.fetch_row(values) == false);
+    POSEIDON_TEST_CHECK_CATCH(aconn.execute(&"select 1", {}));
+    POSEIDON_TEST_CHECK(aconn.reset());
+
+    // Quotes, backslashes and bytes that are not valid UTF-8 are preserved.
+    const cow_string quoted = &"it's \\' \" -- `";
+    const cow_string binary = cow_string("\xBF\x5C\x27\x00", 4);
+    done = aconn.execute_nonblocking_start(&"select ?, ?", { quoted, binary });
+    while(!done) {
+      ::pollfd pfd = { aconn.nonblocking_fd(), POLLIN, 0 };
+      ::poll(&pfd, 1, 1000);
+      done = aconn.execute_nonblocking_continue();
+    }
+
+    POSEIDON_TEST_CHECK(aconn.fetch_row(values) && (values.size() == 2));
+    POSEIDON_TEST_CHECK(values.at(0).as_blob() == quoted);
+    POSEIDON_TEST_CHECK(values.at(1).as_blob() == binary);
+    POSEIDON_TEST_CHECK(aconn.reset());
+
+    // Reset an asynchronous connection without blocking.
+    POSEIDON_TEST_CHECK_CATCH(conn.reset_nonblocking_start());
+    done = aconn.execute_nonblocking_start(&"set @meow = 42", {});
+    while(!done) {
+      ::pollfd pfd = { aconn.nonblocking_fd(), POLLIN, 0 };
+      ::poll(&pfd, 1, 1000);
+      done = aconn.execute_nonblocking_continue();
+    }
+
+    done = aconn.reset_nonblocking_start();
+    while(!done) {
+      ::pollfd pfd = { aconn.nonblocking_fd(), POLLIN, 0 };
+      ::poll(&pfd, 1, 1000);
+      done = aconn.execute_nonblocking_continue();
+    }
+
+    done = aconn.execute_nonblocking_start(&"select @meow", {});
+    while(!done) {
+      ::pollfd pfd = { aconn.nonblocking_fd(), POLLIN, 0 };
+      ::poll(&pfd, 1, 1000);
+      done = aconn.execute_nonblocking_continue();
+    }
+
+    POSEIDON_TEST_CHECK(aconn.fetch_row(values) && values.at(0).is_null());
+    POSEIDON_TEST_CHECK(aconn.reset());
   }
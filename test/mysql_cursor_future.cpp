@@ -0,0 +1,127 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/fiber/mysql_cursor_future.hpp"
+#include "../poseidon/static/mysql_connector.hpp"
+#include "../poseidon/static/task_scheduler.hpp"
+#include "../poseidon/mysql/mysql_connection.hpp"
+#include "../poseidon/base/config_file.hpp"
+#include "../poseidon/base/abstract_task.hpp"
+#include <unistd.h>
+#include <atomic>
+#include <thread>
+using namespace ::poseidon;
+
+static ::std::atomic<bool> stopping;
+
+struct Wake_Task : Abstract_Task
+  {
+    virtual
+    void
+    do_on_abstract_task_execute()
+      override
+      { }
+  };
+
+static
+void
+do_wait(const shptr<MySQL_Cursor_Future>& futr)
+  {
+    task_scheduler.launch(futr);
+
+    for(uint32_t k = 0;  !futr->initialized() && (k != 5000);  ++k)
+      ::usleep(1000);
+
+    POSEIDON_TEST_CHECK(futr->successful());
+  }
+
+static
+int64_t
+do_fetch_all(uint32_t& nbatches, int64_t count)
+  {
+    // Generate `count` rows, numbered from one, and read them in batches of
+    // four rows. The rows of each batch follow those of the previous one.
+    static constexpr char stmt[] =
+        "with recursive `seq` (`n`) as (select 1 union all "
+        "select `n` + 1 from `seq` where `n` < ?) select `n` from `seq`";
+
+    auto futr = new_sh<MySQL_Cursor_Future>(mysql_connector, &stmt, { count }, 4);
+    int64_t total = 0;
+    nbatches = 0;
+
+    for(;;) {
+      do_wait(futr);
+      POSEIDON_TEST_CHECK(futr->result_fields().size() == 1);
+      POSEIDON_TEST_CHECK(futr->result_fields().at(0) == "n");
+      POSEIDON_TEST_CHECK(futr->result_row_count() <= 4);
+      nbatches ++;
+
+      for(const auto& row : futr->result_rows())
+        POSEIDON_TEST_CHECK(row.at(0).as_integer() == ++total);
+
+      if(futr->eof())
+        break;
+
+      POSEIDON_TEST_CHECK(futr->result_row_count() == 4);
+      futr = new_sh<MySQL_Cursor_Future>(futr);
+    }
+
+    POSEIDON_TEST_CHECK_CATCH(new_sh<MySQL_Cursor_Future>(futr));
+    return total;
+  }
+
+int
+main()
+  {
+    char conf_path[] = "/tmp/poseidon_conf_XXXXXX";
+    int fd = ::mkstemp(conf_path);
+    POSEIDON_TEST_CHECK(fd >= 0);
+    static constexpr char conf[] =
+        "mysql {\n"
+        "  default_service_uri = \"root@localhost/mysql\"\n"
+        "  default_password = \"123456\"\n"
+        "  connection_pool_size = 1\n"
+        "}\n";
+    POSEIDON_TEST_CHECK(::write(fd, conf, sizeof(conf) - 1) > 0);
+    ::close(fd);
+
+    Config_File conf_file(cow_string(conf_path));
+    ::unlink(conf_path);
+    mysql_connector.reload(conf_file);
+
+    // Try connecting to localhost. If the server is offline, skip the test.
+    auto conn = mysql_connector.allocate_default_connection();
+    try {
+      conn->execute(&"select 1", {});
+    }
+    catch(exception& e) {
+      ::fprintf(stderr, "could not connect to server: %s\n", e.what());
+      return ::strstr(e.what(), "ERROR 2002:")
+                  ? 77  // skip
+                  :  1; // fail
+    }
+
+    POSEIDON_TEST_CHECK(conn->reset());
+    POSEIDON_TEST_CHECK(mysql_connector.pool_connection(move(conn)));
+
+    ::std::thread task_thread([] { while(!stopping) task_scheduler.thread_loop();  });
+
+    // The last batch is short.
+    uint32_t nbatches;
+    POSEIDON_TEST_CHECK(do_fetch_all(nbatches, 10) == 10);
+    POSEIDON_TEST_CHECK(nbatches == 3);
+
+    // The last batch is full, so the end of data is only known after another
+    // round trip, which yields no row.
+    POSEIDON_TEST_CHECK(do_fetch_all(nbatches, 8) == 8);
+    POSEIDON_TEST_CHECK(nbatches == 3);
+
+    POSEIDON_TEST_CHECK(do_fetch_all(nbatches, 1) == 1);
+    POSEIDON_TEST_CHECK(nbatches == 1);
+
+    // Stop all threads.
+    stopping = true;
+    task_scheduler.launch(new_sh<Wake_Task>());
+    task_thread.join();
+  }
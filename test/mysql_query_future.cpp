@@ -0,0 +1,126 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/static/mysql_connector.hpp"
+#include "../poseidon/static/task_scheduler.hpp"
+#include "../poseidon/fiber/mysql_query_future.hpp"
+#include "../poseidon/mysql/mysql_connection.hpp"
+#include "../poseidon/base/config_file.hpp"
+#include "../poseidon/base/abstract_task.hpp"
+#include <unistd.h>
+#include <atomic>
+#include <thread>
+using namespace ::poseidon;
+
+static ::std::atomic<bool> stopping;
+
+struct Wake_Task : Abstract_Task
+  {
+    virtual
+    void
+    do_on_abstract_task_execute()
+      override
+      { }
+  };
+
+static
+shptr<MySQL_Query_Future>
+do_query(const char* stmt, const cow_vector<MySQL_Value>& args)
+  {
+    auto futr = new_sh<MySQL_Query_Future>(mysql_connector, cow_string(stmt), args);
+    task_scheduler.launch(futr);
+
+    for(uint32_t k = 0;  !futr->initialized() && (k != 5000);  ++k)
+      ::usleep(1000);
+
+    POSEIDON_TEST_CHECK(futr->successful());
+    return futr;
+  }
+
+static
+uniptr<MySQL_Connection>
+do_take_pooled_connection()
+  {
+    // The connection is put back into the pool after the future has become
+    // ready, so wait for it.
+    uniptr<MySQL_Connection> conn;
+    for(uint32_t k = 0;  k != 5000;  ++k) {
+      conn = mysql_connector.allocate_default_connection();
+      if(conn->connected())
+        break;
+
+      ::usleep(1000);
+    }
+
+    POSEIDON_TEST_CHECK(conn->connected());
+    return conn;
+  }
+
+int
+main()
+  {
+    char conf_path[] = "/tmp/poseidon_conf_XXXXXX";
+    int fd = ::mkstemp(conf_path);
+    POSEIDON_TEST_CHECK(fd >= 0);
+    static constexpr char conf[] =
+        "mysql {\n"
+        "  default_service_uri = \"root@localhost/mysql\"\n"
+        "  default_password = \"123456\"\n"
+        "  connection_pool_size = 1\n"
+        "  statement_cache_size = 4\n"
+        "  keep_statements_on_reset = true\n"
+        "}\n";
+    POSEIDON_TEST_CHECK(::write(fd, conf, sizeof(conf) - 1) > 0);
+    ::close(fd);
+
+    Config_File conf_file(cow_string(conf_path));
+    ::unlink(conf_path);
+    mysql_connector.reload(conf_file);
+
+    // Try connecting to localhost. If the server is offline, skip the test.
+    auto conn = mysql_connector.allocate_default_connection();
+    try {
+      conn->execute(&"select 1", {});
+    }
+    catch(exception& e) {
+      ::fprintf(stderr, "could not connect to server: %s\n", e.what());
+      return ::strstr(e.what(), "ERROR 2002:")
+                  ? 77  // skip
+                  :  1; // fail
+    }
+
+    POSEIDON_TEST_CHECK(conn->keep_statements_on_reset());
+    POSEIDON_TEST_CHECK(conn->statement_cache_misses() == 1);
+    POSEIDON_TEST_CHECK(conn->reset());
+    POSEIDON_TEST_CHECK(mysql_connector.pool_connection(move(conn)));
+
+    ::std::thread task_thread([] { while(!stopping) task_scheduler.thread_loop();  });
+
+    // Both futures run on the pooled connection. The statement is prepared by
+    // the first one, and taken from the cache by the second one.
+    auto futr = do_query("select ? + 1", { 41 });
+    POSEIDON_TEST_CHECK(futr->result_row_field(0, 0).as_integer() == 42);
+    conn = do_take_pooled_connection();
+    POSEIDON_TEST_CHECK(conn->statement_cache_hits() == 0);
+    POSEIDON_TEST_CHECK(conn->statement_cache_misses() == 2);
+    POSEIDON_TEST_CHECK(mysql_connector.pool_connection(move(conn)));
+
+    futr = do_query("select ? + 1", { 99 });
+    POSEIDON_TEST_CHECK(futr->result_row_field(0, 0).as_integer() == 100);
+    conn = do_take_pooled_connection();
+    POSEIDON_TEST_CHECK(conn->statement_cache_hits() == 1);
+    POSEIDON_TEST_CHECK(conn->statement_cache_misses() == 2);
+
+    // Transactions don't leak to the next user.
+    conn->execute(&"set autocommit = 0", {});
+    POSEIDON_TEST_CHECK(conn->reset());
+    conn->execute(&"select @@autocommit", {});
+    cow_vector<MySQL_Value> row;
+    POSEIDON_TEST_CHECK(conn->fetch_row(row) && (row.at(0).as_integer() == 1));
+
+    // Stop all threads.
+    stopping = true;
+    task_scheduler.launch(new_sh<Wake_Task>());
+    task_thread.join();
+  }
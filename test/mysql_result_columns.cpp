@@ -0,0 +1,77 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/mysql/mysql_result_columns.hpp"
+using namespace ::poseidon;
+
+int
+main()
+  {
+    MySQL_Result_Columns cols;
+    cols.reset({ &"id", &"score", &"name", &"extra" });
+    POSEIDON_TEST_CHECK(cols.column_count() == 4);
+    POSEIDON_TEST_CHECK(cols.row_count() == 0);
+    POSEIDON_TEST_CHECK(cols.column_type(3) == mysql_value_null);
+
+    // Generate rows, where `extra` is null in most of them.
+    static constexpr size_t count = 1000;
+    cow_vector<cow_vector<MySQL_Value>> rows;
+    cow_vector<MySQL_Value> row;
+    for(size_t k = 0;  k != count;  ++k) {
+      row.clear();
+      row.emplace_back(static_cast<int64_t>(k));
+      row.emplace_back(static_cast<double>(k % 100) / 4);
+      row.emplace_back(&"player");
+      row.mut_back().open_blob().push_back(static_cast<char>('a' + k % 26));
+      if(k % 10 == 9)
+        row.emplace_back(static_cast<int64_t>(k / 10));
+      else
+        row.emplace_back(nullptr);
+
+      cols.append_row(row);
+      rows.push_back(row);
+    }
+
+    POSEIDON_TEST_CHECK(cols.row_count() == count);
+    POSEIDON_TEST_CHECK(cols.column_type(0) == mysql_value_integer);
+    POSEIDON_TEST_CHECK(cols.column_type(1) == mysql_value_double);
+    POSEIDON_TEST_CHECK(cols.column_type(2) == mysql_value_blob);
+    POSEIDON_TEST_CHECK(cols.column_type(3) == mysql_value_integer);
+    POSEIDON_TEST_CHECK(cols.blob(2, 27) == "playerb");
+    POSEIDON_TEST_CHECK(cols.is_null(3, 0));
+    POSEIDON_TEST_CHECK(!cols.is_null(3, 9));
+    POSEIDON_TEST_CHECK(cols.integer_data(3)[0] == 0);
+    POSEIDON_TEST_CHECK(cols.integer_data(3)[19] == 1);
+    POSEIDON_TEST_CHECK(cols.value(3, 0).is_null());
+    POSEIDON_TEST_CHECK(cols.value(2, 1).as_blob() == "playerb");
+    POSEIDON_TEST_CHECK(cols.value(1, 3).as_double() == 0.75);
+
+    // Values of another type are rejected without any effect.
+    row.mut(1) = &"oops";
+    POSEIDON_TEST_CHECK_CATCH(cols.append_row(row));
+    POSEIDON_TEST_CHECK(cols.row_count() == count);
+    POSEIDON_TEST_CHECK_CATCH(cols.double_data(0));
+
+    // Aggregate `score` and `extra`, by visiting each value of each row, and by
+    // scanning arrays. The results shall match.
+    double row_score = 0;
+    int64_t row_extra = 0;
+    for(size_t r = 0;  r != rows.size();  ++r) {
+      row_score += rows[r][1].as_double();
+      if(!rows[r][3].is_null())
+        row_extra += rows[r][3].as_integer();
+    }
+
+    double col_score = 0;
+    int64_t col_extra = 0;
+    const double* scores = cols.double_data(1);
+    const int64_t* extras = cols.integer_data(3);
+    for(size_t r = 0;  r != cols.row_count();  ++r) {
+      col_score += scores[r];
+      col_extra += extras[r];  // nulls are zeroes
+    }
+
+    POSEIDON_TEST_CHECK(row_score == col_score);
+    POSEIDON_TEST_CHECK(row_extra == col_extra);
+  }
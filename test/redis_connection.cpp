@@ -41,5 +41,22 @@ main()
       format(fmt, "  $1\n", value);
     }
 
+    // Send commands in a pipeline. An error reply fails only its own command.
+    cow_vector<cow_vector<cow_string>> cmds;
+    cmds.push_back({ &"set", &"poseidon_test_key", &"42" });
+    cmds.push_back({ &"incr", &"poseidon_test_key" });
+    cmds.push_back({ &"hget", &"poseidon_test_key", &"field" });
+    cmds.push_back({ &"del", &"poseidon_test_key" });
+    conn.execute_pipeline(cmds);
+
+    POSEIDON_TEST_CHECK(conn.fetch_reply(status, value));
+    POSEIDON_TEST_CHECK(status == "OK");
+    POSEIDON_TEST_CHECK(conn.fetch_reply(status, value));
+    POSEIDON_TEST_CHECK(value.as_integer() == 43);
+    POSEIDON_TEST_CHECK_CATCH(conn.fetch_reply(status, value));
+    POSEIDON_TEST_CHECK(conn.fetch_reply(status, value));
+    POSEIDON_TEST_CHECK(value.as_integer() == 1);
+    POSEIDON_TEST_CHECK(conn.fetch_reply(status, value) == false);
+
     ::fprintf(stderr, "reset ==> %d\n", conn.reset());
   }
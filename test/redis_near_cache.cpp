@@ -0,0 +1,121 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/static/redis_connector.hpp"
+#include "../poseidon/redis/redis_value.hpp"
+#include "../poseidon/base/config_file.hpp"
+#include <unistd.h>
+using namespace ::poseidon;
+
+static
+void
+do_reload(const char* options)
+  {
+    char conf_path[] = "/tmp/poseidon_conf_XXXXXX";
+    int fd = ::mkstemp(conf_path);
+    POSEIDON_TEST_CHECK(fd >= 0);
+    cow_string conf = sformat("redis {\n$1}\n", options);
+    POSEIDON_TEST_CHECK(::write(fd, conf.data(), conf.size()) > 0);
+    ::close(fd);
+
+    Config_File conf_file(cow_string(conf_path));
+    ::unlink(conf_path);
+    redis_connector.reload(conf_file);
+  }
+
+static
+bool
+do_lookup(uint64_t& serial, const char* key)
+  {
+    Redis_Value value;
+    return redis_connector.cache_lookup(value, serial, cow_string(key));
+  }
+
+int
+main()
+  {
+    // Each value takes about 1100 bytes, so only two of them fit.
+    do_reload("near_cache_max_size = 2500\nnear_cache_negative_ttl = 60\n");
+
+    cow_string data;
+    data.append(1000, 'x');
+    Redis_Value value;
+    uint64_t serial;
+
+    // LRU eviction
+    POSEIDON_TEST_CHECK(do_lookup(serial, "a") == false);
+    POSEIDON_TEST_CHECK(serial != 0);
+    redis_connector.cache_store(&"a", serial, data);
+    POSEIDON_TEST_CHECK(do_lookup(serial, "b") == false);
+    redis_connector.cache_store(&"b", serial, data);
+
+    POSEIDON_TEST_CHECK(redis_connector.cache_lookup(value, serial, &"a") == true);
+    POSEIDON_TEST_CHECK(serial == 0);
+    POSEIDON_TEST_CHECK(value.as_string() == data);
+
+    POSEIDON_TEST_CHECK(do_lookup(serial, "c") == false);
+    redis_connector.cache_store(&"c", serial, data);
+    POSEIDON_TEST_CHECK(do_lookup(serial, "a") == true);
+    POSEIDON_TEST_CHECK(do_lookup(serial, "c") == true);
+    POSEIDON_TEST_CHECK(do_lookup(serial, "b") == false);
+
+    // Hit and miss counters
+    uint64_t hits = redis_connector.cache_hit_count();
+    uint64_t misses = redis_connector.cache_miss_count();
+    POSEIDON_TEST_CHECK(do_lookup(serial, "a") == true);
+    POSEIDON_TEST_CHECK(do_lookup(serial, "none") == false);
+    POSEIDON_TEST_CHECK(redis_connector.cache_hit_count() == hits + 1);
+    POSEIDON_TEST_CHECK(redis_connector.cache_miss_count() == misses + 1);
+
+    // Negative caching
+    redis_connector.cache_clear();
+    POSEIDON_TEST_CHECK(do_lookup(serial, "missing") == false);
+    redis_connector.cache_store(&"missing", serial, nullptr);
+    value = &"meow";
+    POSEIDON_TEST_CHECK(redis_connector.cache_lookup(value, serial, &"missing") == true);
+    POSEIDON_TEST_CHECK(value.is_nil());
+
+    // A stale value is not stored if the key has been invalidated after the
+    // lookup, nor if it has been looked up again.
+    POSEIDON_TEST_CHECK(do_lookup(serial, "k") == false);
+    uint64_t stale_serial = serial;
+    redis_connector.cache_invalidate(&"k");
+    redis_connector.cache_store(&"k", stale_serial, &"old");
+    POSEIDON_TEST_CHECK(do_lookup(serial, "k") == false);
+    POSEIDON_TEST_CHECK(serial != 0);
+    POSEIDON_TEST_CHECK(serial != stale_serial);
+
+    uint64_t new_serial = serial;
+    redis_connector.cache_store(&"k", stale_serial, &"old");
+    POSEIDON_TEST_CHECK(do_lookup(serial, "k") == false);
+    POSEIDON_TEST_CHECK(serial != new_serial);
+
+    redis_connector.cache_store(&"k", serial, &"new");
+    POSEIDON_TEST_CHECK(redis_connector.cache_lookup(value, serial, &"k") == true);
+    POSEIDON_TEST_CHECK(value.as_string() == "new");
+
+    // Don't cache missing keys.
+    do_reload("near_cache_max_size = 2500\nnear_cache_negative_ttl = 0\n");
+    redis_connector.cache_clear();
+    POSEIDON_TEST_CHECK(do_lookup(serial, "missing") == false);
+    redis_connector.cache_store(&"missing", serial, nullptr);
+    POSEIDON_TEST_CHECK(do_lookup(serial, "missing") == false);
+    POSEIDON_TEST_CHECK(serial != 0);
+
+    // Only keys with these prefixes are cached.
+    do_reload("near_cache_max_size = 2500\nnear_cache_prefixes = [ \"user:\", \"item:\" ]\n");
+    POSEIDON_TEST_CHECK(do_lookup(serial, "guild:1") == false);
+    POSEIDON_TEST_CHECK(serial == 0);
+    POSEIDON_TEST_CHECK(do_lookup(serial, "user:1") == false);
+    POSEIDON_TEST_CHECK(serial != 0);
+    redis_connector.cache_store(&"user:1", serial, &"meow");
+    POSEIDON_TEST_CHECK(do_lookup(serial, "user:1") == true);
+    POSEIDON_TEST_CHECK(do_lookup(serial, "item:") == false);
+    POSEIDON_TEST_CHECK(serial != 0);
+
+    // The near cache is disabled.
+    do_reload("near_cache_max_size = 0\n");
+    POSEIDON_TEST_CHECK(do_lookup(serial, "user:1") == false);
+    POSEIDON_TEST_CHECK(serial == 0);
+  }
@@ -0,0 +1,126 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/redis/redis_reply_parser.hpp"
+using namespace ::poseidon;
+
+int
+main()
+  {
+    Redis_Reply_Parser parser;
+    linear_buffer data;
+
+    // RESP2 types
+    data.puts("+OK\r\n-ERR bad\r\n:-42\r\n$5\r\nhello\r\n$-1\r\n");
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data));
+    POSEIDON_TEST_CHECK(parser.reply_type() == redis_reply_status);
+    POSEIDON_TEST_CHECK(parser.status() == "OK");
+
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data));
+    POSEIDON_TEST_CHECK(parser.reply_type() == redis_reply_error);
+    POSEIDON_TEST_CHECK(parser.status() == "ERR bad");
+
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data));
+    POSEIDON_TEST_CHECK(parser.reply_type() == redis_reply_value);
+    POSEIDON_TEST_CHECK(parser.value().as_integer() == -42);
+
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data));
+    POSEIDON_TEST_CHECK(parser.value().as_string() == "hello");
+
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data));
+    POSEIDON_TEST_CHECK(parser.value().is_nil());
+    POSEIDON_TEST_CHECK(data.size() == 0);
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data) == false);
+
+    // Elements of incomplete replies are consumed, except the last one.
+    data.puts("*2\r\n$3\r\nfoo\r\n$3\r\nba");
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data) == false);
+    POSEIDON_TEST_CHECK(parser.error() == false);
+    POSEIDON_TEST_CHECK(data.size() == 6);
+
+    data.puts("r\r\n");
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data));
+    POSEIDON_TEST_CHECK(parser.value().as_array().size() == 2);
+    POSEIDON_TEST_CHECK(parser.value().as_array().at(1).as_string() == "bar");
+
+    // RESP3 types
+    data.puts("%2\r\n+a\r\n#t\r\n$1\r\nb\r\n,3.5\r\n");
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data));
+    POSEIDON_TEST_CHECK(parser.reply_type() == redis_reply_value);
+    POSEIDON_TEST_CHECK(parser.value().as_array().size() == 4);
+    POSEIDON_TEST_CHECK(parser.value().as_array().at(0).as_string() == "a");
+    POSEIDON_TEST_CHECK(parser.value().as_array().at(1).as_integer() == 1);
+    POSEIDON_TEST_CHECK(parser.value().as_array().at(3).as_string() == "3.5");
+
+    data.puts("|1\r\n+key\r\n+val\r\n=8\r\ntxt:text\r\n");
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data));
+    POSEIDON_TEST_CHECK(parser.value().as_string() == "text");
+
+    data.puts(">3\r\n$7\r\nmessage\r\n$2\r\nch\r\n_\r\n");
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data));
+    POSEIDON_TEST_CHECK(parser.reply_type() == redis_reply_push);
+    POSEIDON_TEST_CHECK(parser.value().as_array().size() == 3);
+    POSEIDON_TEST_CHECK(parser.value().as_array().at(2).is_nil());
+
+    data.puts("!5\r\noops!\r\n");
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data));
+    POSEIDON_TEST_CHECK(parser.reply_type() == redis_reply_error);
+    POSEIDON_TEST_CHECK(parser.status() == "oops!");
+    POSEIDON_TEST_CHECK(data.size() == 0);
+
+    // Replies may be split anywhere.
+    static constexpr char split[] =
+        "*3\r\n%1\r\n+k\r\n*2\r\n:1\r\n$4\r\nab\r\n\r\n|1\r\n+a\r\n+b\r\n#f\r\n$0\r\n\r\n";
+    for(size_t k = 0;  k != sizeof(split) - 2;  ++k) {
+      data.putc(split[k]);
+      POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data) == false);
+      POSEIDON_TEST_CHECK(parser.error() == false);
+      POSEIDON_TEST_CHECK(data.size() <= 10);
+    }
+
+    data.putc(split[sizeof(split) - 2]);
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data));
+    POSEIDON_TEST_CHECK(data.size() == 0);
+    POSEIDON_TEST_CHECK(parser.value().as_array().size() == 3);
+    POSEIDON_TEST_CHECK(parser.value().as_array().at(0).as_array().at(0).as_string() == "k");
+    POSEIDON_TEST_CHECK(parser.value().as_array().at(0).as_array().at(1).as_array().at(1).as_string() == "ab\r\n");
+    POSEIDON_TEST_CHECK(parser.value().as_array().at(1).as_integer() == 0);
+    POSEIDON_TEST_CHECK(parser.value().as_array().at(2).as_string() == "");
+
+    // Push messages may arrive between replies, and in the middle of a reply
+    // that has been split.
+    data.puts("$5\r\nfir");
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data) == false);
+    data.puts("st\r\n>2\r\n$10\r\ninvalidate\r\n*1\r\n$3\r\nkey\r\n:2\r\n>3\r\n");
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data));
+    POSEIDON_TEST_CHECK(parser.reply_type() == redis_reply_value);
+    POSEIDON_TEST_CHECK(parser.value().as_string() == "first");
+
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data));
+    POSEIDON_TEST_CHECK(parser.reply_type() == redis_reply_push);
+    POSEIDON_TEST_CHECK(parser.value().as_array().at(0).as_string() == "invalidate");
+    POSEIDON_TEST_CHECK(parser.value().as_array().at(1).as_array().at(0).as_string() == "key");
+
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data));
+    POSEIDON_TEST_CHECK(parser.reply_type() == redis_reply_value);
+    POSEIDON_TEST_CHECK(parser.value().as_integer() == 2);
+
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data) == false);
+    data.puts("$7\r\nmessage\r\n$2\r\nch\r\n$5\r\nhello\r\n+OK\r\n");
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data));
+    POSEIDON_TEST_CHECK(parser.reply_type() == redis_reply_push);
+    POSEIDON_TEST_CHECK(parser.value().as_array().size() == 3);
+    POSEIDON_TEST_CHECK(parser.value().as_array().at(2).as_string() == "hello");
+
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data));
+    POSEIDON_TEST_CHECK(parser.reply_type() == redis_reply_status);
+    POSEIDON_TEST_CHECK(parser.status() == "OK");
+    POSEIDON_TEST_CHECK(data.size() == 0);
+
+    // Errors are sticky.
+    data.puts("?\r\n+OK\r\n");
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data) == false);
+    POSEIDON_TEST_CHECK(parser.error());
+    POSEIDON_TEST_CHECK(parser.parse_reply_from_stream(data) == false);
+  }
@@ -0,0 +1,82 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/socket/udp_socket.hpp"
+#include <vector>
+using namespace ::poseidon;
+
+struct Test_Socket : UDP_Socket
+  {
+    size_t count = 0;
+    size_t bytes = 0;
+    bool data_ok = true;
+
+    explicit
+    Test_Socket(const IPv6_Address& addr)
+      :
+        UDP_Socket(addr)
+      { }
+
+    Test_Socket()
+      { }
+
+    virtual
+    void
+    do_on_udp_packet(IPv6_Address&& /*addr*/, linear_buffer&& data)
+      override
+      {
+        // Each packet is filled with its index in the batch.
+        if((data.size() == 0) || (data.data()[0] != static_cast<char>(this->count % 64)))
+          this->data_ok = false;
+
+        this->count ++;
+        this->bytes += data.size();
+      }
+
+    void
+    pump()
+      {
+        this->do_abstract_socket_on_readable();
+      }
+  };
+
+int
+main()
+  {
+    auto server = new_sh<Test_Socket>(ipv6_loopback);
+    auto client = new_sh<Test_Socket>();
+    IPv6_Address addr = server->local_address();
+
+    // Prepare small packets, like those of games.
+    static constexpr size_t total = 6400;
+    static constexpr size_t batch = 64;
+    ::std::vector<cow_string> packets;
+    ::std::vector<chars_view> views;
+    for(size_t k = 0;  k != batch;  ++k)
+      packets.emplace_back(64, static_cast<char>(k));
+    for(const auto& packet : packets)
+      views.emplace_back(packet);
+
+    // Send packets one by one.
+    for(size_t n = 0;  n != total;  n += batch) {
+      for(size_t k = 0;  k != batch;  ++k)
+        POSEIDON_TEST_CHECK(client->udp_send(addr, views[k]));
+      server->pump();
+    }
+    POSEIDON_TEST_CHECK(server->count == total);
+    POSEIDON_TEST_CHECK(server->bytes == total * 64);
+    POSEIDON_TEST_CHECK(server->data_ok);
+
+    // Send packets in batches.
+    server->count = 0;
+    server->bytes = 0;
+    for(size_t n = 0;  n != total;  n += batch) {
+      POSEIDON_TEST_CHECK(client->udp_send_batch(addr, views.data(), batch) == batch);
+      server->pump();
+    }
+    POSEIDON_TEST_CHECK(client->udp_dropped_packets() == 0);
+    POSEIDON_TEST_CHECK(server->count == total);
+    POSEIDON_TEST_CHECK(server->bytes == total * 64);
+    POSEIDON_TEST_CHECK(server->data_ok);
+  }
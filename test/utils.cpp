@@ -46,4 +46,27 @@ main()
     POSEIDON_CHECK(decode_and_canonicalize_uri_path("/aa/%41%2F") == "/aa/A/");
     POSEIDON_CHECK(decode_and_canonicalize_uri_path("/aa/%41/%2F") == "/aa/A/");
     POSEIDON_CHECK(decode_and_canonicalize_uri_path("/aa/%41/%2Fb") == "/aa/A/b");
+
+    Network_Reference ref;
+    POSEIDON_TEST_CHECK(parse_request_target(ref, "/") == 1);
+    POSEIDON_TEST_CHECK(ref.path == "/");
+    POSEIDON_TEST_CHECK(ref.host.n == 0);
+
+    ref = Network_Reference();
+    POSEIDON_TEST_CHECK(parse_request_target(ref, "/aa/bb?x=1&y=2#frag") == 19);
+    POSEIDON_TEST_CHECK(ref.path == "/aa/bb");
+    POSEIDON_TEST_CHECK(ref.query == "x=1&y=2");
+    POSEIDON_TEST_CHECK(ref.fragment == "frag");
+    POSEIDON_TEST_CHECK(ref.host.n == 0);
+    POSEIDON_TEST_CHECK(ref.port.n == 0);
+
+    ref = Network_Reference();
+    POSEIDON_TEST_CHECK(parse_request_target(ref, "/a:b@c") == 6);
+    POSEIDON_TEST_CHECK(ref.path == "/a:b@c");
+
+    POSEIDON_TEST_CHECK(parse_request_target(ref, "") == 0);
+    POSEIDON_TEST_CHECK(parse_request_target(ref, "aa/bb") == 0);
+    POSEIDON_TEST_CHECK(parse_request_target(ref, "example.com/") == 0);
+    POSEIDON_TEST_CHECK(parse_request_target(ref, "*") == 0);
+    POSEIDON_TEST_CHECK(parse_request_target(ref, "/aa bb") == 3);
   }
@@ -0,0 +1,106 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/http/http_c_headers.hpp"
+#include "../poseidon/http/http_s_headers.hpp"
+#include "../poseidon/http/websocket_frame_parser.hpp"
+#include "../poseidon/http/websocket_deflator.hpp"
+#include "../poseidon/http/websocket_broadcast_frame.hpp"
+#include <vector>
+using namespace ::poseidon;
+
+int
+main()
+  {
+    // Accept a handshake request with PMCE and context takeover.
+    HTTP_C_Headers req;
+    req.method = http_GET;
+    req.raw_path = &"/chat";
+    req.headers.emplace_back(&"Host", &"server.example.com");
+    req.headers.emplace_back(&"Upgrade", &"websocket");
+    req.headers.emplace_back(&"Connection", &"Upgrade");
+    req.headers.emplace_back(&"Sec-WebSocket-Key", &"dGhlIHNhbXBsZSBub25jZQ==");
+    req.headers.emplace_back(&"Sec-WebSocket-Version", 13);
+    req.headers.emplace_back(&"Sec-WebSocket-Extensions",
+                             &"permessage-deflate; client_max_window_bits");
+
+    WebSocket_Frame_Parser parser;
+    HTTP_S_Headers resp;
+    parser.accept_handshake_request(resp, req);
+    POSEIDON_TEST_CHECK(parser.is_server_mode());
+    POSEIDON_TEST_CHECK(parser.pmce_send_window_bits() != 0);
+
+    // Compose a typical message.
+    cow_string message;
+    while(message.size() < 2000)
+      message += "{\"type\":\"update\",\"id\":12345,\"name\":\"hello world\"}";
+
+    // The payload length takes two extra bytes.
+    WebSocket_Broadcast_Frame frame(ws_TEXT, message);
+    POSEIDON_TEST_CHECK(frame.opcode() == ws_TEXT);
+    POSEIDON_TEST_CHECK(frame.payload_size() == message.size());
+    const cow_string& plain = frame.plain_frame();
+    POSEIDON_TEST_CHECK(plain.size() == message.size() + 4);
+    POSEIDON_TEST_CHECK(static_cast<uint8_t>(plain[0]) == 0x81);
+    POSEIDON_TEST_CHECK(static_cast<uint8_t>(plain[1]) == 126);
+    POSEIDON_TEST_CHECK(static_cast<uint8_t>(plain[2]) == static_cast<uint8_t>(message.size() >> 8));
+    POSEIDON_TEST_CHECK(static_cast<uint8_t>(plain[3]) == static_cast<uint8_t>(message.size()));
+    POSEIDON_TEST_CHECK(::memcmp(plain.data() + 4, message.data(), message.size()) == 0);
+
+    // Control frames are never compressed.
+    WebSocket_Broadcast_Frame ping(ws_PING, "hello");
+    POSEIDON_TEST_CHECK(ping.plain_frame() == "\x89\x05hello");
+    POSEIDON_TEST_CHECK(ping.compressed_frame(15, 6).empty());
+    POSEIDON_TEST_CHECK_CATCH(WebSocket_Broadcast_Frame(ws_PING, cow_string(126, 'x')));
+    POSEIDON_TEST_CHECK_CATCH(WebSocket_Broadcast_Frame(ws_CLOSE, ""));
+
+    // The compressed frame shall be decompressed by the client.
+    cow_string pmce = frame.compressed_frame(parser.pmce_send_window_bits(),
+                                             parser.pmce_compression_level());
+    POSEIDON_TEST_CHECK(pmce.size() > 2);
+    POSEIDON_TEST_CHECK(pmce.size() < plain.size());
+    POSEIDON_TEST_CHECK(static_cast<uint8_t>(pmce[0]) == 0xC1);
+    POSEIDON_TEST_CHECK(pmce == frame.compressed_frame(parser.pmce_send_window_bits(), 1));
+
+    size_t pmce_len = static_cast<uint8_t>(pmce[1]);
+    size_t pmce_hlen = 2;
+    if(pmce_len == 126) {
+      pmce_len = static_cast<uint8_t>(pmce[2]) * 256U + static_cast<uint8_t>(pmce[3]);
+      pmce_hlen = 4;
+    }
+    POSEIDON_TEST_CHECK(pmce.size() == pmce_hlen + pmce_len);
+
+    WebSocket_Deflator client(parser);
+    plain_mutex::unique_lock inf_lock;
+    auto& inf_buf = client.inflate_output_buffer(inf_lock);
+    client.inflate_message_stream(inf_lock, chars_view(pmce.data() + pmce_hlen, pmce_len), UINT32_MAX);
+    client.inflate_message_finish(inf_lock);
+    POSEIDON_TEST_CHECK(inf_buf.size() == message.size());
+    POSEIDON_TEST_CHECK(::memcmp(inf_buf.data(), message.data(), message.size()) == 0);
+    inf_lock.unlock();
+
+    // Fan a message out to many clients. The frame is compressed only once,
+    // and each client gets the same bytes, after which its deflator is reset,
+    // as the shared frame doesn't use context takeover.
+    static constexpr size_t count = 100;
+    ::std::vector<uniptr<WebSocket_Deflator>> deflators;
+    ::std::vector<linear_buffer> queues(count);
+    for(size_t k = 0;  k != count;  ++k)
+      deflators.emplace_back(new_uni<WebSocket_Deflator>(parser));
+
+    WebSocket_Broadcast_Frame bcast(ws_TEXT, message);
+    for(size_t k = 0;  k != count;  ++k) {
+      cow_string data = bcast.compressed_frame(parser.pmce_send_window_bits(),
+                                               parser.pmce_compression_level());
+      plain_mutex::unique_lock def_lock;
+      deflators[k]->deflate_output_buffer(def_lock);
+      queues[k].putn(data.data(), data.size());
+      deflators[k]->deflate_reset(def_lock);
+    }
+
+    for(const auto& queue : queues) {
+      POSEIDON_TEST_CHECK(queue.size() == pmce.size());
+      POSEIDON_TEST_CHECK(::memcmp(queue.data(), pmce.data(), pmce.size()) == 0);
+    }
+  }
@@ -0,0 +1,86 @@
+// This file is part of Poseidon.
+// Copyright (C) 2022-2026 LH_Mouse. All wrongs reserved.
+
+#include "utils.hpp"
+#include "../poseidon/http/http_c_headers.hpp"
+#include "../poseidon/http/http_s_headers.hpp"
+#include "../poseidon/http/websocket_frame_parser.hpp"
+#include "../poseidon/http/websocket_deflator.hpp"
+#include <malloc.h>
+#include <vector>
+using namespace ::poseidon;
+
+static
+size_t
+do_heap_in_use()
+  {
+    return ::mallinfo2().uordblks;
+  }
+
+int
+main()
+  {
+    // Accept a handshake request with PMCE, with context takeover in both
+    // directions, which is the most expensive case.
+    HTTP_C_Headers req;
+    req.method = http_GET;
+    req.raw_path = &"/chat";
+    req.headers.emplace_back(&"Host", &"server.example.com");
+    req.headers.emplace_back(&"Upgrade", &"websocket");
+    req.headers.emplace_back(&"Connection", &"Upgrade");
+    req.headers.emplace_back(&"Sec-WebSocket-Key", &"dGhlIHNhbXBsZSBub25jZQ==");
+    req.headers.emplace_back(&"Sec-WebSocket-Version", 13);
+    req.headers.emplace_back(&"Sec-WebSocket-Extensions",
+                             &"permessage-deflate; client_max_window_bits");
+
+    WebSocket_Frame_Parser parser;
+    HTTP_S_Headers resp;
+    parser.accept_handshake_request(resp, req);
+    POSEIDON_TEST_CHECK(parser.is_server_mode());
+    POSEIDON_TEST_CHECK(parser.pmce_send_window_bits() != 0);
+
+    // Compose a typical message.
+    cow_string message;
+    while(message.size() < 1000)
+      message += "{\"type\":\"update\",\"id\":12345,\"name\":\"hello world\"}";
+
+    // Each connection sends and receives a message, then stays idle.
+    static constexpr size_t counts[] = { 10000, 100000, 200000 };
+    for(size_t count : counts) {
+      ::std::vector<uniptr<WebSocket_Deflator>> deflators;
+      deflators.reserve(count);
+      size_t base = do_heap_in_use();
+      size_t peak = 0;
+
+      for(size_t k = 0;  k != count;  ++k) {
+        auto& d = deflators.emplace_back(new_uni<WebSocket_Deflator>(parser));
+        plain_mutex::unique_lock def_lock, inf_lock;
+
+        auto& def_buf = d->deflate_output_buffer(def_lock);
+        d->deflate_message_stream(def_lock, message);
+        d->deflate_message_finish(def_lock);
+
+        auto& inf_buf = d->inflate_output_buffer(inf_lock);
+        d->inflate_message_stream(inf_lock, def_buf, UINT32_MAX);
+        d->inflate_message_finish(inf_lock);
+        POSEIDON_TEST_CHECK(inf_buf.size() == message.size());
+        def_lock.unlock();
+        inf_lock.unlock();
+
+        if(k == 0)
+          peak = do_heap_in_use() - base;
+
+        // Pretend the idle timeout has elapsed.
+        d->release_idle_streams(steady_clock::now() + 24h);
+      }
+
+      size_t idle = (do_heap_in_use() - base) / count;
+      ::fprintf(stderr,
+          "WebSocket deflator: %zu connections, %zu bytes active, %zu bytes idle per connection\n",
+          count, peak, idle);
+
+      // The sliding window of the inflator, which is no larger than one
+      // message, has to be kept.
+      POSEIDON_TEST_CHECK(idle < message.size() + 2048);
+    }
+  }